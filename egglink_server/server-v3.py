@@ -17,6 +17,9 @@ FIRE_THRESHOLD = 31.0
 app = Flask(__name__)
 
 devices = {}
+link_stats = {}  # uid -> ultimas estatisticas de sequencia (perda/duplicata/ordem)
+topologia = {}   # uid -> ultima aresta do nó na malha (pai, saltos, enlace)
+metricas = {}    # uid do gateway -> ultimo registro de metricas
 _lock = Lock()
 
 # =========================
@@ -433,41 +436,93 @@ def send_to_sheets_thread(data):
 # ROTAS DO FLASK
 # =========================
 
+def store_reading(data):
+    """Normaliza uma leitura e guarda no histórico da placa. Retorna o uid."""
+    raw_e = data.get("e")
+
+    if not raw_e or str(raw_e).strip() == "":
+        uid = "desconhecido"
+    else:
+        uid = str(raw_e)
+    
+    # Resumo de janela do gateway: cada métrica vem como
+    # [min, max, média, variância, tendência/min]; guarda em "agg" e usa a média
+    if isinstance(data.get("t"), list):
+        data["agg"] = {k: data[k] for k in ("t", "uA", "uS", "p") if isinstance(data.get(k), list)}
+        for k, v in data["agg"].items():
+            data[k] = v[2] if len(v) > 2 else 0.0
+
+    for k in ("t", "uA", "uS", "p"):
+        if k in data:
+            try: data[k] = float(data[k])
+            except: data[k] = 0.0
+
+    entry = {
+        "ts": int(time.time()),
+        "data": data
+    }
+
+    with _lock:
+        if uid not in devices:
+            devices[uid] = []
+        devices[uid].append(entry)
+        if len(devices[uid]) > MAX_HISTORY:
+            devices[uid].pop(0)
+
+    return uid
+
+
+def send_batch_to_sheets_thread(items):
+    """Um único thread por lote: envia as leituras ao Sheets em sequência"""
+    for data in items:
+        send_to_sheets_thread(data)
+
+
+def parse_readings():
+    """Aceita um objeto JSON, um array JSON (lote) ou NDJSON (uma leitura por linha)"""
+    ctype = (request.content_type or "").lower()
+    if "ndjson" in ctype:
+        body = request.get_data(as_text=True)
+        return [json.loads(line) for line in body.splitlines() if line.strip()]
+
+    data = request.get_json(force=True)
+    if isinstance(data, list):
+        return data
+    return [data]
+
+
 @app.route("/data", methods=["POST"])
 def receive_data():
     try:
-        data = request.get_json(force=True)
-        raw_e = data.get("e")
-
-        if not raw_e or str(raw_e).strip() == "":
-            uid = "desconhecido"
-        else:
-            uid = str(raw_e)
-        
-        for k in ("t", "uA", "uS", "p"):
-            if k in data:
-                try: data[k] = float(data[k])
-                except: data[k] = 0.0
-
-        entry = {
-            "ts": int(time.time()),
-            "data": data
-        }
-
+        items = [d for d in parse_readings() if isinstance(d, dict)]
+
+        # Itens {"e":..,"q":{..}} sem leitura: estatisticas de sequencia do nó
+        stats = [d for d in items if "q" in d and "t" not in d]
+        items = [d for d in items if not ("q" in d and "t" not in d)]
+        # Itens {"e":..,"topo":{..}}: aresta do nó no retrato da topologia
+        arestas = [d for d in items if isinstance(d.get("topo"), dict)]
+        items = [d for d in items if not isinstance(d.get("topo"), dict)]
+        # Item {"e":..,"m":{..}}: metricas do proprio gateway
+        registros = [d for d in items if isinstance(d.get("m"), dict)]
+        items = [d for d in items if not isinstance(d.get("m"), dict)]
         with _lock:
-            if uid not in devices:
-                devices[uid] = []
-            devices[uid].append(entry)
-            if len(devices[uid]) > MAX_HISTORY:
-                devices[uid].pop(0)
+            for d in stats:
+                link_stats[str(d.get("e") or "desconhecido")] = {"ts": int(time.time()), **d["q"]}
+            for d in arestas:
+                topologia[str(d.get("e") or "desconhecido")] = {"ts": int(time.time()), **d["topo"]}
+            for d in registros:
+                metricas[str(d.get("e") or "desconhecido")] = {"ts": int(time.time()), **d["m"]}
+
+        uids = [store_reading(data) for data in items]
 
         # Envia ao Sheets DE FORMA ASSÍNCRONA (THREAD)
         # Isso libera o ESP32 imediatamente e evita o erro de timeout
-        threading.Thread(target=send_to_sheets_thread, args=(data,)).start()
+        if items:
+            threading.Thread(target=send_batch_to_sheets_thread, args=(items,)).start()
         
-        print(f"📡 [EggLink] Dados recebidos: {uid[-4:]}")
+        print(f"📡 [EggLink] Dados recebidos ({len(uids)}): {', '.join(u[-4:] for u in uids)}")
 
-        return jsonify({"status": "ok"}), 200
+        return jsonify({"status": "ok", "count": len(uids)}), 200
 
     except Exception as e:
         print("Erro no receive:", e)
@@ -527,10 +582,34 @@ def api_history():
     return jsonify(hist_copy)
 
 
+@app.route("/api/link_stats")
+def api_link_stats():
+    """Perda/duplicata/reordenação por nó (enviadas pelo gateway a cada ciclo)"""
+    with _lock:
+        return jsonify(dict(link_stats))
+
+
+@app.route("/api/topologia")
+def api_topologia():
+    """Retrato da malha: uma aresta por nó (RLOC16, pai, saltos, enlace, contadores MAC)"""
+    with _lock:
+        return jsonify(dict(topologia))
+
+
+@app.route("/api/metricas")
+def api_metricas():
+    """Ultimo registro de metricas de cada gateway (contadores, heap, pilhas, latencias)"""
+    with _lock:
+        return jsonify(dict(metricas))
+
+
 @app.route("/clear", methods=["POST"])
 def clear_all():
     with _lock:
         devices.clear()
+        link_stats.clear()
+        topologia.clear()
+        metricas.clear()
     return redirect("/")
 
 
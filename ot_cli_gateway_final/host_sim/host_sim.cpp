@@ -0,0 +1,676 @@
+// ==================== SIMULADOR DO GATEWAY NO HOST ====================
+// Roda a logica do gateway (main/) num processo Linux, com mocks no lugar do
+// ESP-IDF e do OpenThread (mock/). N nós simulados mandam lotes CoAP pelo
+// caminho real (coap_handler, tabela de nós, cadastro, journal) com perda e
+// duplicacao injetadas; a cada ciclo o upload HTTP real vai para um
+// servidor embutido em 127.0.0.1:WEB_PORT. Tudo em relogio virtual: uma
+// hora de malha roda em segundos. Ver README.md.
+
+#include "host_mock.hpp"
+#include "esp_ot_cli.hpp"
+#include "http_request.hpp"
+#include "node_table.hpp"
+#include "cadastro_nodos.hpp"
+#include "sensor_codec.hpp"
+#include "radio_manager.hpp"
+#include "gateway_cli.hpp"
+#include "cJSON.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+// ==================== PARAMETROS ====================
+#define SIM_RETENTATIVAS     3      // COAP_MAX_RETRANSMIT
+#define SIM_NOS_POR_ROTEADOR 16
+#define SIM_ROTEADORES_MAX   62     // o gateway e o roteador 0
+
+struct Parametros {
+    int nodos = 200;
+    int intervalo_s = 30;
+    int lote = 4;
+    double perda = 0;               // por transmissao, em cada sentido
+    double duplicacao = 0;          // lotes reenviados com outra mid
+    double falha_http = 0;          // POSTs respondidos com 503
+    int duracao_s = 3600;
+    int ciclo_s = 60;
+    unsigned semente = 1;
+    bool journal = true;
+    bool verificar = false;
+};
+
+static void uso(const char *programa)
+{
+    fprintf(stderr,
+            "uso: %s [opcoes]\n"
+            "  --nodos N         nós simulados (1..%d, padrao 200)\n"
+            "  --intervalo S     segundos entre amostras de cada nó (padrao 30)\n"
+            "  --lote K          amostras por pedido CoAP (1..%d, padrao 4)\n"
+            "  --perda P         %% de perda por transmissao, pedido e ACK (padrao 0)\n"
+            "  --duplicacao P    %% de lotes reenviados com outra mid (padrao 0)\n"
+            "  --falha-http P    %% de POSTs recusados pelo servidor (padrao 0)\n"
+            "  --duracao S       segundos de relogio virtual (padrao 3600)\n"
+            "  --ciclo S         segundos entre uploads HTTP (padrao 60)\n"
+            "  --semente N       semente do gerador (padrao 1)\n"
+            "  --sem-journal     sem a particao do journal (envio direto dos aneis)\n"
+            "  --verificar       confere a contabilidade; sai com 1 se divergir\n"
+            "  -v                log do gateway em nivel INFO\n",
+            programa, NODE_TABLE_CAPACIDADE, SENSOR_LOTE_MAX);
+}
+
+static bool ler_parametros(int argc, char **argv, Parametros *p)
+{
+    static const struct option opcoes[] = {
+        { "nodos", required_argument, NULL, 'n' },
+        { "intervalo", required_argument, NULL, 'i' },
+        { "lote", required_argument, NULL, 'l' },
+        { "perda", required_argument, NULL, 'p' },
+        { "duplicacao", required_argument, NULL, 'd' },
+        { "falha-http", required_argument, NULL, 'f' },
+        { "duracao", required_argument, NULL, 't' },
+        { "ciclo", required_argument, NULL, 'c' },
+        { "semente", required_argument, NULL, 's' },
+        { "sem-journal", no_argument, NULL, 'J' },
+        { "verificar", no_argument, NULL, 'V' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 },
+    };
+    int c;
+    while ((c = getopt_long(argc, argv, "vh", opcoes, NULL)) != -1) {
+        switch (c) {
+        case 'n': p->nodos = atoi(optarg); break;
+        case 'i': p->intervalo_s = atoi(optarg); break;
+        case 'l': p->lote = atoi(optarg); break;
+        case 'p': p->perda = atof(optarg) / 100.0; break;
+        case 'd': p->duplicacao = atof(optarg) / 100.0; break;
+        case 'f': p->falha_http = atof(optarg) / 100.0; break;
+        case 't': p->duracao_s = atoi(optarg); break;
+        case 'c': p->ciclo_s = atoi(optarg); break;
+        case 's': p->semente = (unsigned)strtoul(optarg, NULL, 10); break;
+        case 'J': p->journal = false; break;
+        case 'V': p->verificar = true; break;
+        case 'v': mock_log_nivel = ESP_LOG_INFO; break;
+        default: return false;
+        }
+    }
+    return p->nodos >= 1 && p->nodos <= NODE_TABLE_CAPACIDADE && p->intervalo_s >= 1 && p->lote >= 1 &&
+           p->lote <= SENSOR_LOTE_MAX && p->perda >= 0 && p->perda < 1 && p->duplicacao >= 0 &&
+           p->duplicacao <= 1 && p->falha_http >= 0 && p->falha_http < 1 && p->duracao_s >= 1 &&
+           p->ciclo_s >= 1;
+}
+
+// ==================== SERVIDOR HTTP (SORVEDOURO) ====================
+// Aceita o POST /data do http_client (keep-alive, Content-Length), conta o
+// que chegou e responde 200 sem corpo (400 se o server-v3.py guardaria lixo
+// como leitura); uma conexao por vez, como o cliente
+struct ContagemServidor {
+    std::atomic<uint32_t> posts{ 0 };
+    std::atomic<uint32_t> recusados{ 0 };
+    std::atomic<uint32_t> invalidos{ 0 };   // POSTs com item que viraria leitura vazia
+    std::atomic<uint32_t> leituras{ 0 };    // itens guardados como leitura
+    std::atomic<uint32_t> sequencias{ 0 };  // itens com "q"
+    std::atomic<uint32_t> topologia{ 0 };   // itens com "topo"
+    std::atomic<uint32_t> metricas{ 0 };    // itens com "m"
+    std::atomic<uint64_t> bytes{ 0 };
+    std::atomic<uint32_t> falha_permil{ 0 };
+};
+
+static ContagemServidor s_servidor;
+
+// Campo de leitura: numero, ou [min, max, media, variancia, tendencia] no resumo
+static bool campo_leitura(const cJSON *item, const char *chave)
+{
+    const cJSON *v = cJSON_GetObjectItem(item, chave);
+    return cJSON_IsNumber(v) || cJSON_IsArray(v);
+}
+
+// Mesma separacao do receive_data do server-v3.py: "q" sem "t", "topo" e
+// "m" vao para as tabelas deles e o resto vira leitura (store_reading).
+// Item que o servidor guardaria como leitura sem ter os campos dela recusa
+// o POST inteiro (400), e a verificacao falha. Conta so os POSTs aceitos.
+static bool contar_corpo(const std::string &corpo)
+{
+    cJSON *raiz = cJSON_ParseWithLength(corpo.data(), corpo.size());
+    uint32_t leituras = 0, sequencias = 0, topologia = 0, metricas = 0;
+    bool ok = cJSON_IsArray(raiz);
+    cJSON *item;
+    cJSON_ArrayForEach(item, raiz) {
+        if (cJSON_GetObjectItem(item, "q") && !cJSON_GetObjectItem(item, "t")) {
+            sequencias++;
+        } else if (cJSON_IsObject(cJSON_GetObjectItem(item, "topo"))) {
+            topologia++;
+        } else if (cJSON_IsObject(cJSON_GetObjectItem(item, "m"))) {
+            metricas++;
+        } else if (campo_leitura(item, "t") && campo_leitura(item, "uA") && campo_leitura(item, "uS") &&
+                   campo_leitura(item, "p")) {
+            leituras++;
+        } else {
+            char *texto = cJSON_PrintUnformatted(item);
+            fprintf(stderr, "sorvedouro: item sem leitura seria guardado como leitura: %s\n", texto ? texto : "?");
+            cJSON_free(texto);
+            ok = false;
+        }
+    }
+    cJSON_Delete(raiz);
+    if (!ok) return false;
+
+    s_servidor.leituras += leituras;
+    s_servidor.sequencias += sequencias;
+    s_servidor.topologia += topologia;
+    s_servidor.metricas += metricas;
+    return true;
+}
+
+// Um pedido da conexao; false quando o cliente fecha
+static bool atender_pedido(int fd, std::string &buf, std::minstd_rand &sorteio)
+{
+    size_t fim_cabecalho;
+    char bloco[4096];
+
+    while ((fim_cabecalho = buf.find("\r\n\r\n")) == std::string::npos) {
+        ssize_t n = recv(fd, bloco, sizeof(bloco), 0);
+        if (n <= 0) return false;
+        buf.append(bloco, (size_t)n);
+    }
+
+    size_t tamanho = 0;
+    std::string cabecalho = buf.substr(0, fim_cabecalho);
+    for (size_t pos = 0; pos < cabecalho.size();) {
+        size_t eol = cabecalho.find("\r\n", pos);
+        if (eol == std::string::npos) eol = cabecalho.size();
+        if (strncasecmp(cabecalho.c_str() + pos, "Content-Length:", 15) == 0) {
+            tamanho = strtoul(cabecalho.c_str() + pos + 15, NULL, 10);
+        }
+        pos = eol + 2;
+    }
+
+    size_t inicio = fim_cabecalho + 4;
+    while (buf.size() < inicio + tamanho) {
+        ssize_t n = recv(fd, bloco, sizeof(bloco), 0);
+        if (n <= 0) return false;
+        buf.append(bloco, (size_t)n);
+    }
+
+    bool recusar = (uint32_t)(sorteio() % 1000) < s_servidor.falha_permil.load();
+    bool invalido = false;
+    if (recusar) {
+        s_servidor.recusados++;
+    } else if (!contar_corpo(buf.substr(inicio, tamanho))) {
+        s_servidor.invalidos++;
+        invalido = true;
+    } else {
+        s_servidor.posts++;
+        s_servidor.bytes += tamanho;
+    }
+    buf.erase(0, inicio + tamanho);
+
+    const char *resposta = invalido
+        ? "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: keep-alive\r\n\r\n"
+        : recusar
+        ? "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: keep-alive\r\n\r\n"
+        : "HTTP/1.1 200 OK\r\nContent-Length: 0\r\nConnection: keep-alive\r\n\r\n";
+    return send(fd, resposta, strlen(resposta), MSG_NOSIGNAL) == (ssize_t)strlen(resposta);
+}
+
+static void servidor_http(int escuta, unsigned semente)
+{
+    std::minstd_rand sorteio(semente);
+    int fd;
+    while ((fd = accept(escuta, NULL, NULL)) >= 0) {
+        std::string buf;
+        while (atender_pedido(fd, buf, sorteio)) {
+        }
+        close(fd);
+    }
+}
+
+static int abrir_servidor()
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int um = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &um, sizeof(um));
+
+    struct sockaddr_in endereco;
+    memset(&endereco, 0, sizeof(endereco));
+    endereco.sin_family = AF_INET;
+    endereco.sin_port = htons((uint16_t)atoi(WEB_PORT));
+    inet_pton(AF_INET, WEB_SERVER, &endereco.sin_addr);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&endereco, sizeof(endereco)) != 0 || listen(fd, 4) != 0) {
+        perror("servidor HTTP em " WEB_SERVER ":" WEB_PORT);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// ==================== NÓS SIMULADOS ====================
+struct NoSimulado {
+    uint8_t eui64[SENSOR_EUI64_TAMANHO];
+    otIp6Address eid;
+    uint16_t id;                    // CADASTRO_SEM_ID ate o 2.04 do cadastro
+    uint16_t mid;
+    uint32_t seq;                   // sequencia da proxima amostra
+    sensor_enlace_t enlace;
+    std::vector<uint8_t> pendentes; // amostras codificadas ainda nao enviadas
+    uint32_t seq_pendentes;         // seq da primeira pendente
+};
+
+// Contabilidade do lado dos nós, para comparar com o que o gateway viu
+struct Contagem {
+    uint64_t geradas = 0;
+    uint64_t unicas = 0;            // amostras que chegaram ao handler ao menos uma vez
+    uint64_t duplicadas = 0;        // amostras que chegaram de novo (reenvio com outra mid)
+    uint64_t nunca_chegaram = 0;    // nó desistiu e o lote nao chegou em nenhuma tentativa
+    uint64_t desistencias = 0;      // lotes sem ACK depois das retentativas
+    uint64_t transmissoes = 0;
+    uint64_t perdidas_no_ar = 0;
+    uint64_t entregues = 0;         // pedidos entregues ao mock (handler ou cache)
+    uint64_t do_cache = 0;
+    uint64_t cadastros = 0;
+    uint64_t recadastros = 0;
+};
+
+struct Simulador {
+    Parametros p;
+    std::vector<NoSimulado> nos;
+    Contagem c;
+    std::mt19937 sorteio;
+    int64_t epoch_inicio_s;
+    std::vector<uint32_t> latencias_ns;   // handler, relogio real
+    uint64_t heap_pico = 0;
+};
+
+static bool sortear(Simulador &sim, double probabilidade)
+{
+    return probabilidade > 0 && std::uniform_real_distribution<double>(0, 1)(sim.sorteio) < probabilidade;
+}
+
+// Uma transmissao (pedido e, se chegar, ACK). Retorna se o ACK voltou.
+static bool transmitir(Simulador &sim, const MockPedidoCoap &pedido, MockRespostaCoap *resposta, bool *chegou)
+{
+    sim.c.transmissoes++;
+    *chegou = false;
+    if (sortear(sim, sim.p.perda)) {
+        sim.c.perdidas_no_ar++;
+        return false;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    mock_coap_entregar(pedido, resposta);
+    auto dt = std::chrono::steady_clock::now() - t0;
+    sim.latencias_ns.push_back((uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(dt).count());
+
+    sim.c.entregues++;
+    if (resposta->do_cache) sim.c.do_cache++;
+    *chegou = resposta->respondeu && !resposta->do_cache;
+    if (sortear(sim, sim.p.perda)) {
+        sim.c.perdidas_no_ar++;
+        return false;
+    }
+    return resposta->respondeu;
+}
+
+// CON com retransmissoes da mesma mid (instantaneas no relogio virtual: o
+// cache de respostas vale por EXCHANGE_LIFETIME, muito mais que o backoff)
+static bool enviar_confirmavel(Simulador &sim, NoSimulado &no, const char *uri, const uint8_t *payload,
+                               uint16_t len, uint32_t seq, MockRespostaCoap *resposta, int *chegadas)
+{
+    uint8_t token[SENSOR_TOKEN_TAMANHO];
+    for (int k = 0; k < SENSOR_TOKEN_SEQ_TAMANHO; k++) token[k] = (uint8_t)(seq >> (8 * k));
+    for (int k = SENSOR_TOKEN_SEQ_TAMANHO; k < SENSOR_TOKEN_TAMANHO; k++) token[k] = (uint8_t)sim.sorteio();
+
+    MockPedidoCoap pedido = { uri, OT_COAP_TYPE_CONFIRMABLE, ++no.mid, token, sizeof(token),
+                              OT_COAP_OPTION_CONTENT_FORMAT_OCTET_STREAM, payload, len, no.eid };
+    *chegadas = 0;
+    for (int tentativa = 0; tentativa <= SIM_RETENTATIVAS; tentativa++) {
+        bool chegou;
+        bool ack = transmitir(sim, pedido, resposta, &chegou);
+        if (chegou) (*chegadas)++;
+        if (ack) return true;
+    }
+    return false;
+}
+
+static void cadastrar(Simulador &sim, NoSimulado &no)
+{
+    uint8_t pedido[SENSOR_CADASTRO_TAMANHO];
+    MockRespostaCoap resposta;
+    int chegadas;
+
+    encode_sensor_cadastro(no.eui64, &no.eid, pedido);
+    if (enviar_confirmavel(sim, no, SENSOR_CADASTRO_RECURSO, pedido, sizeof(pedido), 0, &resposta, &chegadas) &&
+        resposta.codigo == OT_COAP_CODE_CHANGED && resposta.payload_len >= SENSOR_ID_TAMANHO) {
+        no.id = decode_sensor_id(resposta.payload);
+        sim.c.cadastros++;
+    }
+}
+
+// Lote das amostras pendentes (com id; sem id ainda, com o EID) + enlace
+static void enviar_lote(Simulador &sim, NoSimulado &no)
+{
+    uint8_t payload[SENSOR_LOTE_TAMANHO_MAX + SENSOR_ENLACE_TAMANHO];
+    uint8_t n = (uint8_t)(no.pendentes.size() / SENSOR_AMOSTRA_TAMANHO);
+
+    size_t len = encode_sensor_lote_cabecalho(no.id, &no.eid, n, payload, sizeof(payload));
+    memcpy(payload + len, no.pendentes.data(), no.pendentes.size());
+    len += no.pendentes.size();
+    no.enlace.rssi = (int8_t)(-50 - (int)(sim.sorteio() % 40));
+    no.enlace.quadros = (uint16_t)(n + SIM_RETENTATIVAS);
+    encode_sensor_enlace(&no.enlace, payload + len);
+    len += SENSOR_ENLACE_TAMANHO;
+
+    MockRespostaCoap resposta;
+    int chegadas;
+    bool ack = enviar_confirmavel(sim, no, "sensor", payload, (uint16_t)len, no.seq_pendentes, &resposta, &chegadas);
+
+    if (ack && resposta.codigo == OT_COAP_CODE_NOT_FOUND) {
+        // Gateway sem o id (NVS apagada): refaz o cadastro e tenta no proximo
+        no.id = CADASTRO_SEM_ID;
+        sim.c.recadastros++;
+        return;
+    }
+    if (chegadas > 0) {
+        sim.c.unicas += n;
+    } else if (!ack) {
+        sim.c.nunca_chegaram += n;
+    }
+    if (!ack) sim.c.desistencias++;
+
+    // Duplicacao da malha: o mesmo lote de novo, com outra mid
+    if (chegadas > 0 && sortear(sim, sim.p.duplicacao)) {
+        MockPedidoCoap pedido = { "sensor", OT_COAP_TYPE_CONFIRMABLE, ++no.mid, NULL, 0,
+                                  OT_COAP_OPTION_CONTENT_FORMAT_OCTET_STREAM, payload, (uint16_t)len, no.eid };
+        uint8_t token[SENSOR_TOKEN_TAMANHO] = { 0 };
+        for (int k = 0; k < SENSOR_TOKEN_SEQ_TAMANHO; k++) token[k] = (uint8_t)(no.seq_pendentes >> (8 * k));
+        pedido.token = token;
+        pedido.token_len = sizeof(token);
+        bool chegou;
+        transmitir(sim, pedido, &resposta, &chegou);
+        if (chegou) sim.c.duplicadas += n;
+    }
+
+    // Sem ACK o nó desiste: a sequencia ja andou, o gateway ve a lacuna
+    no.pendentes.clear();
+}
+
+static void amostrar(Simulador &sim, NoSimulado &no, uint64_t agora_ms)
+{
+    if (no.pendentes.empty()) no.seq_pendentes = no.seq;
+
+    sensor_data_t dados;
+    memset(&dados, 0, sizeof(dados));
+    dados.epoch_ms = (sim.epoch_inicio_s + (int64_t)(agora_ms / 1000)) * 1000;
+    dados.temperatura = 20.0f + (float)(sim.sorteio() % 1000) / 100.0f;
+    dados.umidadeAr = 40.0f + (float)(sim.sorteio() % 2000) / 100.0f;
+    dados.umidadeSolo = 30.0f + (float)(sim.sorteio() % 3000) / 100.0f;
+    dados.particulas = (float)(sim.sorteio() % 50000) / 100.0f;
+
+    uint8_t amostra[SENSOR_AMOSTRA_TAMANHO];
+    encode_sensor_amostra(&dados, amostra);
+    no.pendentes.insert(no.pendentes.end(), amostra, amostra + sizeof(amostra));
+    no.seq++;
+    sim.c.geradas++;
+
+    if (no.pendentes.size() < (size_t)sim.p.lote * SENSOR_AMOSTRA_TAMANHO) return;
+    if (no.id == CADASTRO_SEM_ID) cadastrar(sim, no);
+    enviar_lote(sim, no);
+}
+
+// Malha: SIM_NOS_POR_ROTEADOR filhos por roteador; os 4 primeiros
+// roteadores sao vizinhos do gateway, os demais chegam por eles
+static void criar_nos(Simulador &sim)
+{
+    int roteadores = (sim.p.nodos + SIM_NOS_POR_ROTEADOR - 1) / SIM_NOS_POR_ROTEADOR;
+    if (roteadores > SIM_ROTEADORES_MAX) roteadores = SIM_ROTEADORES_MAX;
+    for (int r = 1; r <= roteadores; r++) {
+        uint16_t rloc = (uint16_t)(r << 10);
+        uint16_t proximo = r <= 4 ? rloc : (uint16_t)((1 + (r - 1) % 4) << 10);
+        mock_ot_definir_rota(rloc, proximo, (uint8_t)(1 + (r - 1) / 4));
+    }
+
+    sim.nos.resize(sim.p.nodos);
+    for (int k = 0; k < sim.p.nodos; k++) {
+        NoSimulado &no = sim.nos[k];
+        static const uint8_t prefixo[8] = { 0x02, 0x00, 0x00, 0xff, 0xfe, 0x00, 0x00, 0x00 };
+        memcpy(no.eui64, prefixo, sizeof(prefixo));
+        no.eui64[6] = (uint8_t)((k + 2) >> 8);
+        no.eui64[7] = (uint8_t)(k + 2);
+
+        char eid[OT_IP6_ADDRESS_STRING_SIZE];
+        snprintf(eid, sizeof(eid), "fd00::%x:%x", (unsigned)sim.sorteio() & 0xffff, k + 2);
+        otIp6AddressFromString(eid, &no.eid);
+
+        no.id = CADASTRO_SEM_ID;
+        no.mid = (uint16_t)sim.sorteio();
+        no.seq = sim.sorteio();
+        memset(&no.enlace, 0, sizeof(no.enlace));
+        no.enlace.rloc16 = (uint16_t)(((1 + k % roteadores) << 10) | (1 + k / roteadores));
+        no.enlace.margem = 30;
+        no.enlace.qualidade_entrada = 3;
+        no.enlace.qualidade_saida = 3;
+        no.seq_pendentes = no.seq;
+    }
+}
+
+// ==================== RELATORIO ====================
+static void amostrar_heap(Simulador &sim)
+{
+#ifdef __GLIBC__
+#if __GLIBC_PREREQ(2, 33)
+    struct mallinfo2 mi = mallinfo2();
+    uint64_t usado = mi.uordblks + mi.hblkhd;
+#else
+    struct mallinfo mi = mallinfo();
+    uint64_t usado = (uint64_t)(unsigned)mi.uordblks + (unsigned)mi.hblkhd;
+#endif
+    if (usado > sim.heap_pico) sim.heap_pico = usado;
+#else
+    (void)sim;
+#endif
+}
+
+static uint32_t percentil(const std::vector<uint32_t> &ordenado, double p)
+{
+    if (ordenado.empty()) return 0;
+    size_t k = (size_t)(p * (double)(ordenado.size() - 1) + 0.5);
+    return ordenado[k];
+}
+
+static void http_ciclo(Simulador &sim)
+{
+    http_send_all_now();
+    amostrar_heap(sim);
+}
+
+// Soma as estatisticas que o gateway guardou por nó
+struct VisaoGateway {
+    uint64_t recebidas = 0;
+    uint64_t perdidas = 0;
+    uint64_t lacunas = 0;
+    uint64_t duplicadas = 0;
+    uint64_t historico_perdidas = 0;
+    size_t nos = 0;
+};
+
+static VisaoGateway ler_gateway()
+{
+    VisaoGateway v;
+    NodeInfo n;
+    for (size_t i = 0; i < totalNodos(); i++) {
+        v.historico_perdidas += historicoPerdidas(i);
+        if (!lerNodo(i, &n)) continue;
+        v.nos++;
+        v.recebidas += n.seq.recebidas;
+        v.perdidas += n.seq.perdidas;
+        v.lacunas += seqLacunas(n.seq);
+        v.duplicadas += n.seq.duplicadas;
+    }
+    return v;
+}
+
+static bool conferir(const char *o_que, uint64_t esperado, uint64_t visto, bool igual = true)
+{
+    bool ok = igual ? visto == esperado : visto <= esperado;
+    printf("  %s: %s (gateway %llu, simulador %llu)\n", o_que, ok ? "ok" : "FALHOU", (unsigned long long)visto,
+           (unsigned long long)esperado);
+    return ok;
+}
+
+static int relatorio(Simulador &sim, double segundos_reais)
+{
+    const Contagem &c = sim.c;
+    VisaoGateway g = ler_gateway();
+    std::vector<uint32_t> lat = sim.latencias_ns;
+    std::sort(lat.begin(), lat.end());
+
+    uint64_t soma_ns = 0;
+    for (uint32_t ns : lat) soma_ns += ns;
+
+    printf("\n==================== HOST_SIM ====================\n");
+    printf("%d nós, amostra a cada %d s, lote %d, perda %.1f%%, duplicacao %.1f%%, falha HTTP %.1f%%, "
+           "%d s virtuais (%.2f s reais), journal %s\n",
+           sim.p.nodos, sim.p.intervalo_s, sim.p.lote, sim.p.perda * 100, sim.p.duplicacao * 100,
+           sim.p.falha_http * 100, sim.p.duracao_s, segundos_reais, sim.p.journal ? "sim" : "nao");
+
+    printf("\n-- CoAP --\n");
+    printf("transmissoes %llu, perdidas no ar %llu, entregues %llu (%llu pelo cache de respostas)\n",
+           (unsigned long long)c.transmissoes, (unsigned long long)c.perdidas_no_ar,
+           (unsigned long long)c.entregues, (unsigned long long)c.do_cache);
+    printf("handler: %.0f pedidos/s; latencia p50 %u ns, p90 %u, p99 %u, max %u\n",
+           soma_ns ? (double)lat.size() * 1e9 / (double)soma_ns : 0.0, percentil(lat, 0.50),
+           percentil(lat, 0.90), percentil(lat, 0.99), lat.empty() ? 0 : lat.back());
+    printf("cadastros %llu, recadastros (4.04) %llu, lotes sem ACK %llu\n", (unsigned long long)c.cadastros,
+           (unsigned long long)c.recadastros, (unsigned long long)c.desistencias);
+
+    printf("\n-- Amostras --\n");
+    printf("geradas %llu, chegaram %llu, duplicadas %llu, nunca chegaram %llu\n",
+           (unsigned long long)c.geradas, (unsigned long long)c.unicas, (unsigned long long)c.duplicadas,
+           (unsigned long long)c.nunca_chegaram);
+    uint64_t esperadas = g.recebidas + g.perdidas + g.lacunas;
+    printf("perda vista pelo gateway %.2f%% (perdidas + lacunas), real %.2f%%\n",
+           esperadas ? 100.0 * (double)(g.perdidas + g.lacunas) / (double)esperadas : 0.0,
+           c.geradas ? 100.0 * (double)c.nunca_chegaram / (double)c.geradas : 0.0);
+
+    printf("\n-- Upload HTTP --\n");
+    printf("POSTs aceitos %u, recusados %u, invalidos %u, %llu bytes; itens: %u leituras, %u sequencia, "
+           "%u topologia, %u metricas\n",
+           s_servidor.posts.load(), s_servidor.recusados.load(), s_servidor.invalidos.load(),
+           (unsigned long long)s_servidor.bytes.load(),
+           s_servidor.leituras.load(), s_servidor.sequencias.load(), s_servidor.topologia.load(),
+           s_servidor.metricas.load());
+    printf("leituras descartadas pelo gateway: %llu por anel cheio, %u por journal cheio\n",
+           (unsigned long long)g.historico_perdidas, http_journal_perdidas());
+
+    printf("\n-- Memoria --\n");
+    struct rusage uso;
+    getrusage(RUSAGE_SELF, &uso);
+    printf("RSS maximo %ld KB, pico do heap %llu bytes (amostrado a cada ciclo)\n", uso.ru_maxrss,
+           (unsigned long long)sim.heap_pico);
+
+    printf("\n-- Metricas do gateway (comando \"metricas\") --\n");
+    fflush(stdout);
+    mock_cli_executar("metricas");
+    fflush(stdout);
+
+    if (!sim.p.verificar) return 0;
+
+    printf("\n-- Verificacao --\n");
+    bool ok = true;
+    ok &= conferir("nós cadastrados", (uint64_t)sim.p.nodos, cadastro_total());
+    ok &= conferir("nós na tabela", (uint64_t)sim.p.nodos, g.nos);
+    ok &= conferir("amostras unicas recebidas", c.unicas, g.recebidas);
+    ok &= conferir("duplicatas detectadas", c.duplicadas, g.duplicadas);
+    ok &= conferir("perdidas + lacunas (<= nunca chegaram)", c.nunca_chegaram, g.perdidas + g.lacunas, false);
+    ok &= conferir("leituras no servidor + perdidas (aneis, journal)", c.unicas,
+                   s_servidor.leituras.load() + g.historico_perdidas + http_journal_perdidas());
+    ok &= conferir("POSTs com item que o servidor guardaria como leitura vazia", 0, s_servidor.invalidos.load());
+    printf("verificacao %s\n", ok ? "ok" : "FALHOU");
+    return ok ? 0 : 1;
+}
+
+// ==================== MAIN ====================
+int main(int argc, char **argv)
+{
+    Simulador sim;
+    if (!ler_parametros(argc, argv, &sim.p)) {
+        uso(argv[0]);
+        return 2;
+    }
+    sim.sorteio.seed(sim.p.semente);
+    srand(sim.p.semente);
+    sim.epoch_inicio_s = (int64_t)time(NULL);
+    s_servidor.falha_permil = (uint32_t)(sim.p.falha_http * 1000 + 0.5);
+
+    int escuta = abrir_servidor();
+    if (escuta < 0) return 2;
+    std::thread servidor(servidor_http, escuta, sim.p.semente);
+
+    // O que app_main e ot_task_worker fazem antes do mainloop
+    mock_particao_journal(sim.p.journal);
+    global_ot_instance = esp_openthread_get_instance();
+    cadastro_iniciar();
+    radio_iniciar();
+    gateway_cli_iniciar();
+
+    static otCoapResource recurso_sensor = { "sensor", coap_handler, NULL, NULL };
+    static otCoapResource recurso_cadastro = { SENSOR_CADASTRO_RECURSO, coap_cadastro_handler, NULL, NULL };
+    otCoapAddResource(global_ot_instance, &recurso_sensor);
+    otCoapAddResource(global_ot_instance, &recurso_cadastro);
+    otCoapStart(global_ot_instance, OT_DEFAULT_COAP_PORT);
+
+    criar_nos(sim);
+
+    // Eventos em ordem de relogio virtual: (instante, nó); -1 = ciclo HTTP
+    typedef std::pair<uint64_t, int> Evento;
+    std::priority_queue<Evento, std::vector<Evento>, std::greater<Evento>> eventos;
+    uint64_t intervalo_ms = (uint64_t)sim.p.intervalo_s * 1000;
+    uint64_t fim_ms = (uint64_t)sim.p.duracao_s * 1000;
+    for (int k = 0; k < sim.p.nodos; k++) {
+        eventos.push(Evento(sim.sorteio() % intervalo_ms, k));
+    }
+    eventos.push(Evento((uint64_t)sim.p.ciclo_s * 1000, -1));
+
+    auto inicio = std::chrono::steady_clock::now();
+    while (!eventos.empty() && eventos.top().first < fim_ms) {
+        Evento e = eventos.top();
+        eventos.pop();
+        mock_relogio_definir_ms(e.first);
+        if (e.second < 0) {
+            http_ciclo(sim);
+            eventos.push(Evento(e.first + (uint64_t)sim.p.ciclo_s * 1000, -1));
+        } else {
+            amostrar(sim, sim.nos[e.second], e.first);
+            eventos.push(Evento(e.first + intervalo_ms, e.second));
+        }
+    }
+
+    // Fim: o que ficou nos aneis e no journal sobe com o servidor aceitando tudo
+    mock_relogio_definir_ms(fim_ms);
+    s_servidor.falha_permil = 0;
+    http_ciclo(sim);
+    http_ciclo(sim);
+    http_encerrar_conexao();
+    double segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+
+    shutdown(escuta, SHUT_RDWR);
+    close(escuta);
+    servidor.join();
+
+    return relatorio(sim, segundos);
+}
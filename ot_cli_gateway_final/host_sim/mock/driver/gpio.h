@@ -0,0 +1,13 @@
+#pragma once
+#include "esp_err.h"
+typedef enum { GPIO_NUM_15 = 15, GPIO_NUM_18 = 18, GPIO_NUM_19 = 19 } gpio_num_t;
+typedef enum { GPIO_MODE_OUTPUT = 2 } gpio_mode_t;
+#ifdef __cplusplus
+extern "C" {
+#endif
+esp_err_t gpio_reset_pin(gpio_num_t);
+esp_err_t gpio_set_direction(gpio_num_t, gpio_mode_t);
+esp_err_t gpio_set_level(gpio_num_t, uint32_t);
+#ifdef __cplusplus
+}
+#endif
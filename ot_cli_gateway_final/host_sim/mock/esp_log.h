@@ -0,0 +1,45 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+
+// Mock do esp_log para o host_sim: o nivel e decidido antes de formatar,
+// entao os ESP_LOGI do caminho quente nao pesam no benchmark
+#ifdef __cplusplus
+extern "C" {
+#endif
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+extern esp_log_level_t mock_log_nivel;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level);
+uint32_t esp_log_timestamp(void);
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+#ifdef __cplusplus
+}
+#endif
+
+#define MOCK_LOG(nivel, letra, tag, fmt, ...)                                                       \
+    do {                                                                                            \
+        if ((nivel) <= mock_log_nivel) {                                                            \
+            esp_log_write(nivel, tag, letra " (%u) %s: " fmt "\n", (unsigned)esp_log_timestamp(),   \
+                          tag, ##__VA_ARGS__);                                                      \
+        }                                                                                           \
+    } while (0)
+
+#define ESP_LOGE(tag, fmt, ...) MOCK_LOG(ESP_LOG_ERROR, "E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) MOCK_LOG(ESP_LOG_WARN, "W", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) MOCK_LOG(ESP_LOG_INFO, "I", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) MOCK_LOG(ESP_LOG_DEBUG, "D", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGV(tag, fmt, ...) MOCK_LOG(ESP_LOG_VERBOSE, "V", tag, fmt, ##__VA_ARGS__)
@@ -0,0 +1,27 @@
+#pragma once
+#include "esp_err.h"
+#include "esp_event.h"
+#include <stdint.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+typedef struct esp_netif_obj esp_netif_t;
+typedef struct { int x; } esp_netif_config_t;
+typedef struct { uint32_t addr; } esp_ip4_addr_t;
+typedef struct { esp_ip4_addr_t ip, netmask, gw; } esp_netif_ip_info_t;
+typedef struct { esp_netif_t *esp_netif; esp_netif_ip_info_t ip_info; } ip_event_got_ip_t;
+#define IPSTR "%d.%d.%d.%d"
+#define IP2STR(a) 0,0,0,0
+enum { IP_EVENT_STA_GOT_IP, IP_EVENT_STA_LOST_IP };
+esp_err_t esp_netif_init(void);
+esp_netif_t *esp_netif_new(const esp_netif_config_t *);
+void esp_netif_destroy(esp_netif_t *);
+esp_err_t esp_netif_attach(esp_netif_t *, void *);
+esp_err_t esp_netif_set_default_netif(esp_netif_t *);
+esp_err_t esp_netif_set_hostname(esp_netif_t *, const char *);
+esp_netif_t *esp_netif_create_default_wifi_sta(void);
+void esp_netif_destroy_default_wifi(void *);
+#define ESP_NETIF_DEFAULT_OPENTHREAD() {0}
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,16 @@
+#pragma once
+#include "esp_err.h"
+#include "esp_openthread_types.h"
+#include "openthread/instance.h"
+#include "openthread/dataset.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+esp_err_t esp_openthread_init(const esp_openthread_platform_config_t *);
+otInstance *esp_openthread_get_instance(void);
+esp_err_t esp_openthread_launch_mainloop(void);
+esp_err_t esp_openthread_deinit(void);
+esp_err_t esp_openthread_auto_start(otOperationalDatasetTlvs *);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,9 @@
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+void esp_openthread_cli_init(void);
+void esp_openthread_cli_create_task(void);
+#ifdef __cplusplus
+}
+#endif
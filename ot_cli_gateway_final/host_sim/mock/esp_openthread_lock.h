@@ -0,0 +1,10 @@
+#pragma once
+#include "freertos/FreeRTOS.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+bool esp_openthread_lock_acquire(TickType_t);
+void esp_openthread_lock_release(void);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,6 @@
+#pragma once
+#include "esp_openthread_types.h"
+#ifdef __cplusplus
+extern "C"
+#endif
+void *esp_openthread_netif_glue_init(const esp_openthread_platform_config_t *);
@@ -0,0 +1,11 @@
+#pragma once
+#include "sdkconfig.h"
+#include <stdint.h>
+typedef enum { RADIO_MODE_NATIVE, RADIO_MODE_UART_RCP } esp_openthread_radio_mode_t;
+typedef enum { HOST_CONNECTION_MODE_CLI_UART, HOST_CONNECTION_MODE_CLI_USB } esp_openthread_host_connection_mode_t;
+typedef struct { int dummy; } usb_cfg_t;
+#define USB_SERIAL_JTAG_DRIVER_CONFIG_DEFAULT() {0}
+typedef struct { esp_openthread_radio_mode_t radio_mode; } esp_openthread_radio_config_t;
+typedef struct { esp_openthread_host_connection_mode_t host_connection_mode; usb_cfg_t host_usb_config; } esp_openthread_host_connection_config_t;
+typedef struct { const char *storage_partition_name; uint8_t netif_queue_size; uint8_t task_queue_size; } esp_openthread_port_config_t;
+typedef struct { esp_openthread_radio_config_t radio_config; esp_openthread_host_connection_config_t host_config; esp_openthread_port_config_t port_config; } esp_openthread_platform_config_t;
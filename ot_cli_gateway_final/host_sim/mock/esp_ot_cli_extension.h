@@ -0,0 +1,5 @@
+#pragma once
+#ifdef __cplusplus
+extern "C"
+#endif
+void esp_cli_custom_command_init(void);
@@ -0,0 +1,19 @@
+#pragma once
+#include <sys/time.h>
+#include <stdbool.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+#define SNTP_OPMODE_POLL 0
+typedef void (*sntp_sync_time_cb_t)(struct timeval *);
+typedef enum { SNTP_SYNC_STATUS_RESET, SNTP_SYNC_STATUS_COMPLETED, SNTP_SYNC_STATUS_IN_PROGRESS } sntp_sync_status_t;
+void sntp_setoperatingmode(int);
+void sntp_setservername(int, const char *);
+void sntp_init(void);
+void sntp_stop(void);
+bool sntp_enabled(void);
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t);
+sntp_sync_status_t sntp_get_sync_status(void);
+#ifdef __cplusplus
+}
+#endif
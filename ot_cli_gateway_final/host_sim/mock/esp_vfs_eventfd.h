@@ -0,0 +1,8 @@
+#pragma once
+#include "esp_err.h"
+#include <stddef.h>
+typedef struct { size_t max_fds; } esp_vfs_eventfd_config_t;
+#ifdef __cplusplus
+extern "C"
+#endif
+esp_err_t esp_vfs_eventfd_register(const esp_vfs_eventfd_config_t *);
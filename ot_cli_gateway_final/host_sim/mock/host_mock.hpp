@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "openthread/coap.h"
+
+// ==================== CONTROLE DOS MOCKS (HOST_SIM) ====================
+// O que o simulador enxerga dos mocks de ESP-IDF e OpenThread: o relogio
+// virtual, a particao do journal, a entrega de pedidos CoAP aos recursos do
+// gateway e o CLI. Tudo roda numa thread so (a "task do OpenThread").
+
+// ==================== RELOGIO VIRTUAL ====================
+// esp_log_timestamp, esp_timer_get_time e xTaskGetTickCount leem daqui; o
+// relogio so anda quando o simulador manda. Latencias medidas pelo
+// metricas.hpp continuam em tempo real (CLOCK_MONOTONIC).
+uint64_t mock_relogio_ms();
+void mock_relogio_definir_ms(uint64_t ms);
+
+// ==================== FLASH ====================
+// Particao "journal" em RAM (journal_iniciar_particao do host), com a
+// semantica de flash: escrita so zera bits, apagar volta para 0xff.
+// Ausente, o gateway envia direto dos aneis.
+void mock_particao_journal(bool presente);
+
+// ==================== COAP ====================
+struct MockPedidoCoap {
+    const char *uri;
+    otCoapType tipo;
+    uint16_t mid;               // message id: mesma mid = retransmissao
+    const uint8_t *token;
+    uint8_t token_len;
+    int content_format;         // -1 = sem a opcao
+    const uint8_t *payload;
+    uint16_t payload_len;
+    otIp6Address origem;
+};
+
+#define MOCK_RESPOSTA_MAX 64
+
+struct MockRespostaCoap {
+    bool respondeu;             // NON e CON sem ACK nao respondem
+    bool do_cache;              // CON repetido atendido pelo cache de respostas
+    otCoapCode codigo;
+    uint8_t payload[MOCK_RESPOSTA_MAX];
+    uint16_t payload_len;
+};
+
+// Entrega o pedido ao recurso registrado (ou ao handler padrao), como o
+// OpenThread faria; um CON com (origem, mid) ja respondido dentro do
+// EXCHANGE_LIFETIME volta do cache sem chamar o handler
+void mock_coap_entregar(const MockPedidoCoap &pedido, MockRespostaCoap *resposta);
+
+// ==================== MALHA ====================
+// Rota do gateway (lider, RLOC16 0x0000) ate um roteador, devolvida por
+// otThreadGetNextHopAndPathCost; roteador sem rota = RLOC16 invalido
+void mock_ot_definir_rota(uint16_t roteador, uint16_t proximo, uint8_t custo);
+
+// ==================== CLI ====================
+// Executa um comando registrado por otCliSetUserCommands ("nodos", ...);
+// false se o comando nao existe
+bool mock_cli_executar(const char *comando);
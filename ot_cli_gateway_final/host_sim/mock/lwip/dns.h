@@ -0,0 +1,9 @@
+#pragma once
+#include <stdint.h>
+typedef struct { union { struct { uint32_t addr; } ip4; } u_addr; uint8_t type; } ip_addr_t;
+#define IPADDR_TYPE_V4 0
+#define IP4_ADDR(ip, a,b,c,d) ((ip)->addr = 0)
+#ifdef __cplusplus
+extern "C"
+#endif
+void dns_setserver(uint8_t, const ip_addr_t *);
@@ -0,0 +1,421 @@
+#include "host_mock.hpp"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "journal.hpp"
+#include "esp_netif.h"
+#include "esp_sntp.h"
+#include "esp_openthread.h"
+#include "esp_openthread_cli.h"
+#include "esp_openthread_lock.h"
+#include "esp_openthread_netif_glue.h"
+#include "esp_ot_cli_extension.h"
+#include "nvs.h"
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "lwip/dns.h"
+#include "i2cdev.h"
+#include "sensor_gases.h"
+#include "sensor_temp-umiA.h"
+#include "sensor_umiS.h"
+#include <map>
+#include <string>
+#include <vector>
+
+// ==================== RELOGIO VIRTUAL ====================
+static uint64_t s_relogio_ms = 0;
+
+uint64_t mock_relogio_ms()
+{
+    return s_relogio_ms;
+}
+
+void mock_relogio_definir_ms(uint64_t ms)
+{
+    s_relogio_ms = ms;
+}
+
+// ==================== LOG ====================
+esp_log_level_t mock_log_nivel = ESP_LOG_ERROR;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    (void)tag;
+    mock_log_nivel = level;
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return (uint32_t)s_relogio_ms;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    (void)level;
+    (void)tag;
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return (int64_t)s_relogio_ms * 1000;
+}
+
+// ==================== FREERTOS ====================
+// Uma thread so: nao ha outras tasks, esperas voltam na hora
+static int s_task_atual;
+static EventBits_t s_bits_eventos;
+
+void vTaskDelay(TickType_t ticks)
+{
+    (void)ticks;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    (void)task;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)s_relogio_ms;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return &s_task_atual;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t funcao, const char *nome, uint32_t pilha, void *parametro,
+                       UBaseType_t prioridade, TaskHandle_t *handle)
+{
+    (void)funcao;
+    (void)pilha;
+    (void)parametro;
+    (void)prioridade;
+    ESP_LOGW("host_sim", "xTaskCreate(%s) nao suportado no host", nome);
+    if (handle) *handle = NULL;
+    return pdFAIL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t funcao, const char *nome, uint32_t pilha, void *parametro,
+                                   UBaseType_t prioridade, TaskHandle_t *handle, BaseType_t nucleo)
+{
+    (void)nucleo;
+    return xTaskCreate(funcao, nome, pilha, parametro, prioridade, handle);
+}
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    return &s_bits_eventos;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t grupo, EventBits_t bits)
+{
+    return *(EventBits_t *)grupo |= bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t grupo, EventBits_t bits)
+{
+    EventBits_t antes = *(EventBits_t *)grupo;
+    *(EventBits_t *)grupo &= ~bits;
+    return antes;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t grupo, EventBits_t bits, BaseType_t limpar,
+                                BaseType_t todos, TickType_t espera)
+{
+    (void)bits;
+    (void)limpar;
+    (void)todos;
+    (void)espera;
+    return *(EventBits_t *)grupo;
+}
+
+// ==================== NVS ====================
+// Chaves de todos os namespaces num mapa "namespace/chave" em RAM
+static std::vector<std::string> s_nvs_namespaces;
+static std::map<std::string, std::vector<uint8_t>> s_nvs;
+
+static std::string nvs_chave(nvs_handle_t handle, const char *chave)
+{
+    return s_nvs_namespaces[handle] + "/" + chave;
+}
+
+esp_err_t nvs_open(const char *nome, nvs_open_mode_t modo, nvs_handle_t *handle)
+{
+    (void)modo;
+    s_nvs_namespaces.push_back(nome);
+    *handle = (nvs_handle_t)(s_nvs_namespaces.size() - 1);
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    (void)handle;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    (void)handle;
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *chave, void *valor, size_t *tamanho)
+{
+    auto it = s_nvs.find(nvs_chave(handle, chave));
+    if (it == s_nvs.end()) return ESP_ERR_NVS_NOT_FOUND;
+    if (valor) {
+        if (*tamanho < it->second.size()) return ESP_ERR_NVS_INVALID_LENGTH;
+        memcpy(valor, it->second.data(), it->second.size());
+    }
+    *tamanho = it->second.size();
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *chave, const void *valor, size_t tamanho)
+{
+    const uint8_t *bytes = (const uint8_t *)valor;
+    s_nvs[nvs_chave(handle, chave)].assign(bytes, bytes + tamanho);
+    return ESP_OK;
+}
+
+// ==================== PARTICAO DO JOURNAL ====================
+// O journal.cpp so liga a particao no ESP_PLATFORM; aqui a mesma glue fala
+// com um vetor em RAM do tamanho da particao do partitions.csv
+#define MOCK_JOURNAL_TAMANHO 0x60000
+
+static bool s_journal_presente = true;
+static std::vector<uint8_t> s_flash;
+
+void mock_particao_journal(bool presente)
+{
+    s_journal_presente = presente;
+}
+
+static bool flash_ler(void *ctx, size_t offset, void *buf, size_t len)
+{
+    (void)ctx;
+    if (offset + len > s_flash.size()) return false;
+    memcpy(buf, &s_flash[offset], len);
+    return true;
+}
+
+static bool flash_escrever(void *ctx, size_t offset, const void *buf, size_t len)
+{
+    (void)ctx;
+    if (offset + len > s_flash.size()) return false;
+    const uint8_t *bytes = (const uint8_t *)buf;
+    for (size_t k = 0; k < len; k++) {
+        s_flash[offset + k] &= bytes[k];
+    }
+    return true;
+}
+
+static bool flash_apagar(void *ctx, size_t offset)
+{
+    (void)ctx;
+    if (offset % JOURNAL_SETOR_TAMANHO || offset + JOURNAL_SETOR_TAMANHO > s_flash.size()) return false;
+    memset(&s_flash[offset], 0xff, JOURNAL_SETOR_TAMANHO);
+    return true;
+}
+
+bool journal_iniciar_particao(Journal &journal)
+{
+    if (!s_journal_presente) {
+        ESP_LOGW("host_sim", "Particao '%s' nao encontrada; journal desativado", JOURNAL_PARTICAO_NOME);
+        return false;
+    }
+    if (s_flash.empty()) s_flash.assign(MOCK_JOURNAL_TAMANHO, 0xff);
+
+    JournalFlash flash = { NULL, s_flash.size(), flash_ler, flash_escrever, flash_apagar };
+    return journal.montar(flash);
+}
+
+// ==================== SISTEMA ====================
+// O heap do host nao e o do C6: o metricas.hpp so le estes no ESP_PLATFORM
+uint32_t esp_get_free_heap_size(void)
+{
+    return 0;
+}
+
+uint32_t esp_get_minimum_free_heap_size(void)
+{
+    return 0;
+}
+
+uint32_t esp_random(void)
+{
+    return (uint32_t)rand();
+}
+
+// ==================== OPENTHREAD (PLATAFORMA ESP) ====================
+// A pilha em si e o mock_ot.cpp; aqui so o que o ot_task_worker chama
+esp_err_t esp_openthread_init(const esp_openthread_platform_config_t *config)
+{
+    (void)config;
+    return ESP_OK;
+}
+
+esp_err_t esp_openthread_launch_mainloop(void)
+{
+    return ESP_OK;
+}
+
+bool esp_openthread_lock_acquire(TickType_t espera)
+{
+    (void)espera;
+    return true;
+}
+
+void esp_openthread_lock_release(void)
+{
+}
+
+void esp_openthread_cli_init(void)
+{
+}
+
+void esp_openthread_cli_create_task(void)
+{
+}
+
+void esp_cli_custom_command_init(void)
+{
+}
+
+void *esp_openthread_netif_glue_init(const esp_openthread_platform_config_t *config)
+{
+    (void)config;
+    return NULL;
+}
+
+// ==================== REDE E PERIFERICOS ====================
+esp_netif_t *esp_netif_new(const esp_netif_config_t *config)
+{
+    (void)config;
+    return NULL;
+}
+
+void esp_netif_destroy(esp_netif_t *netif)
+{
+    (void)netif;
+}
+
+esp_err_t esp_netif_attach(esp_netif_t *netif, void *glue)
+{
+    (void)netif;
+    (void)glue;
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_set_default_netif(esp_netif_t *netif)
+{
+    (void)netif;
+    return ESP_OK;
+}
+
+void dns_setserver(uint8_t indice, const ip_addr_t *servidor)
+{
+    (void)indice;
+    (void)servidor;
+}
+
+void sntp_setoperatingmode(int modo)
+{
+    (void)modo;
+}
+
+void sntp_setservername(int indice, const char *servidor)
+{
+    (void)indice;
+    (void)servidor;
+}
+
+void sntp_init(void)
+{
+}
+
+bool sntp_enabled(void)
+{
+    return true;
+}
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback)
+{
+    (void)callback;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t pino)
+{
+    (void)pino;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t pino, gpio_mode_t modo)
+{
+    (void)pino;
+    (void)modo;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t pino, uint32_t nivel)
+{
+    (void)pino;
+    (void)nivel;
+    return ESP_OK;
+}
+
+// ==================== SENSORES DO GATEWAY ====================
+// Leituras fixas: o simulador nao roda a amostragem local
+TaskHandle_t AHTTaskHandle = NULL;
+TaskHandle_t SensorGasesTaskHandle = NULL;
+
+esp_err_t i2cdev_init(void)
+{
+    return ESP_OK;
+}
+
+void AHTtask(void *parametro)
+{
+    (void)parametro;
+}
+
+void SensorGasesTask(void *parametro)
+{
+    (void)parametro;
+}
+
+void SensorUmiSTask(void *parametro)
+{
+    (void)parametro;
+}
+
+float AHT_GetTemperature(void)
+{
+    return 25.0f;
+}
+
+float AHT_GetHumidity(void)
+{
+    return 60.0f;
+}
+
+float UmiS_GetTDS(void)
+{
+    return 40.0f;
+}
+
+float gas_get_ppm_estimate(void)
+{
+    return 400.0f;
+}
+
+// ==================== GLOBAIS DO MAIN.CPP ====================
+// Definido pelo main.cpp no firmware (que nao entra no host)
+otInstance *global_ot_instance;
@@ -0,0 +1,412 @@
+#include "host_mock.hpp"
+#include "esp_log.h"
+#include "esp_openthread.h"
+#include "openthread/cli.h"
+#include "openthread/coap.h"
+#include "openthread/dataset.h"
+#include "openthread/ip6.h"
+#include "openthread/link.h"
+#include "openthread/server.h"
+#include "openthread/thread_ftd.h"
+#include <arpa/inet.h>
+#include <map>
+#include <utility>
+#include <vector>
+
+// ==================== INSTANCIA ====================
+// O gateway e o lider da particao: roteador 0, RLOC16 0x0000
+struct otInstance {
+    otStateChangedCallback callback;
+    void *contexto;
+};
+
+static otInstance s_instancia;
+static const otIp6Address s_eid_gateway = { { { 0xfd, 0x00, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01 } } };
+
+otInstance *esp_openthread_get_instance(void)
+{
+    return &s_instancia;
+}
+
+otError otSetStateChangedCallback(otInstance *instancia, otStateChangedCallback callback, void *contexto)
+{
+    instancia->callback = callback;
+    instancia->contexto = contexto;
+    return OT_ERROR_NONE;
+}
+
+otError otDatasetSetActive(otInstance *instancia, const otOperationalDataset *dataset)
+{
+    (void)instancia;
+    (void)dataset;
+    return OT_ERROR_NONE;
+}
+
+otError otIp6SetEnabled(otInstance *instancia, bool habilitar)
+{
+    (void)instancia;
+    (void)habilitar;
+    return OT_ERROR_NONE;
+}
+
+otError otThreadSetEnabled(otInstance *instancia, bool habilitar)
+{
+    (void)instancia;
+    (void)habilitar;
+    return OT_ERROR_NONE;
+}
+
+otError otServerAddService(otInstance *instancia, const otServiceConfig *servico)
+{
+    (void)instancia;
+    (void)servico;
+    return OT_ERROR_NONE;
+}
+
+otError otServerRegister(otInstance *instancia)
+{
+    (void)instancia;
+    return OT_ERROR_NONE;
+}
+
+// ==================== THREAD ====================
+#define MOCK_RLOC16_INVALIDO 0xfffe
+#define MOCK_ROTEADORES      63
+
+struct RotaMock {
+    uint16_t proximo;
+    uint8_t custo;
+};
+
+static RotaMock s_rotas[MOCK_ROTEADORES];
+static bool s_rotas_iniciadas = false;
+
+void mock_ot_definir_rota(uint16_t roteador, uint16_t proximo, uint8_t custo)
+{
+    if (!s_rotas_iniciadas) {
+        for (RotaMock &r : s_rotas) r = { MOCK_RLOC16_INVALIDO, 0 };
+        s_rotas_iniciadas = true;
+    }
+    uint8_t id = roteador >> 10;
+    if (id < MOCK_ROTEADORES) s_rotas[id] = { proximo, custo };
+}
+
+otDeviceRole otThreadGetDeviceRole(otInstance *instancia)
+{
+    (void)instancia;
+    return OT_DEVICE_ROLE_LEADER;
+}
+
+uint16_t otThreadGetRloc16(otInstance *instancia)
+{
+    (void)instancia;
+    return 0x0000;
+}
+
+const otIp6Address *otThreadGetMeshLocalEid(otInstance *instancia)
+{
+    (void)instancia;
+    return &s_eid_gateway;
+}
+
+void otThreadGetNextHopAndPathCost(otInstance *instancia, uint16_t destino, uint16_t *proximo, uint8_t *custo)
+{
+    (void)instancia;
+    uint8_t id = destino >> 10;
+    RotaMock r = (s_rotas_iniciadas && id < MOCK_ROTEADORES) ? s_rotas[id] : RotaMock{ MOCK_RLOC16_INVALIDO, 0 };
+    if (proximo) *proximo = r.proximo;
+    if (custo) *custo = r.custo;
+}
+
+void otLinkGetFactoryAssignedIeeeEui64(otInstance *instancia, otExtAddress *eui64)
+{
+    (void)instancia;
+    static const otExtAddress gateway = { { 0x02, 0x00, 0x00, 0xff, 0xfe, 0x00, 0x00, 0x01 } };
+    *eui64 = gateway;
+}
+
+// ==================== IPv6 ====================
+otError otIp6AddressFromString(const char *texto, otIp6Address *endereco)
+{
+    return inet_pton(AF_INET6, texto, endereco->mFields.m8) == 1 ? OT_ERROR_NONE : OT_ERROR_PARSE;
+}
+
+// Formato do OpenThread: os 8 grupos por extenso, sem compressao de zeros
+void otIp6AddressToString(const otIp6Address *endereco, char *texto, uint16_t tamanho)
+{
+    const uint8_t *b = endereco->mFields.m8;
+    snprintf(texto, tamanho, "%x:%x:%x:%x:%x:%x:%x:%x", (b[0] << 8) | b[1], (b[2] << 8) | b[3],
+             (b[4] << 8) | b[5], (b[6] << 8) | b[7], (b[8] << 8) | b[9], (b[10] << 8) | b[11],
+             (b[12] << 8) | b[13], (b[14] << 8) | b[15]);
+}
+
+// ==================== MENSAGENS ====================
+// Cabecalho CoAP ficticio antes do payload: quem ler do offset 0 em vez
+// de otMessageGetOffset le lixo, como no firmware
+#define MOCK_CABECALHO_COAP 4
+
+struct otMessage {
+    std::vector<uint8_t> bytes;
+    uint16_t offset;
+    otCoapType tipo;
+    otCoapCode codigo;
+    uint16_t mid;
+    uint8_t token[OT_COAP_MAX_TOKEN_LENGTH];
+    uint8_t token_len;
+    int content_format;
+};
+
+otMessage *otCoapNewMessage(otInstance *instancia, const otMessageSettings *ajustes)
+{
+    (void)instancia;
+    (void)ajustes;
+    otMessage *m = new otMessage();
+    m->offset = 0;
+    m->tipo = OT_COAP_TYPE_CONFIRMABLE;
+    m->codigo = OT_COAP_CODE_EMPTY;
+    m->mid = 0;
+    m->token_len = 0;
+    m->content_format = -1;
+    return m;
+}
+
+void otMessageFree(otMessage *mensagem)
+{
+    delete mensagem;
+}
+
+uint16_t otMessageGetLength(const otMessage *mensagem)
+{
+    return (uint16_t)mensagem->bytes.size();
+}
+
+uint16_t otMessageGetOffset(const otMessage *mensagem)
+{
+    return mensagem->offset;
+}
+
+uint16_t otMessageRead(const otMessage *mensagem, uint16_t offset, void *buf, uint16_t tamanho)
+{
+    if (offset >= mensagem->bytes.size()) return 0;
+    uint16_t disponivel = (uint16_t)(mensagem->bytes.size() - offset);
+    if (tamanho > disponivel) tamanho = disponivel;
+    memcpy(buf, &mensagem->bytes[offset], tamanho);
+    return tamanho;
+}
+
+otError otMessageAppend(otMessage *mensagem, const void *dados, uint16_t tamanho)
+{
+    const uint8_t *b = (const uint8_t *)dados;
+    mensagem->bytes.insert(mensagem->bytes.end(), b, b + tamanho);
+    return OT_ERROR_NONE;
+}
+
+// ==================== COAP ====================
+otError otCoapMessageInitResponse(otMessage *resposta, const otMessage *pedido, otCoapType tipo, otCoapCode codigo)
+{
+    resposta->tipo = tipo;
+    resposta->codigo = codigo;
+    resposta->mid = pedido->mid;
+    memcpy(resposta->token, pedido->token, pedido->token_len);
+    resposta->token_len = pedido->token_len;
+    resposta->bytes.assign(MOCK_CABECALHO_COAP + resposta->token_len, 0);
+    resposta->offset = (uint16_t)resposta->bytes.size();
+    return OT_ERROR_NONE;
+}
+
+otError otCoapMessageSetPayloadMarker(otMessage *mensagem)
+{
+    mensagem->bytes.push_back(0xff);
+    mensagem->offset = (uint16_t)mensagem->bytes.size();
+    return OT_ERROR_NONE;
+}
+
+otCoapType otCoapMessageGetType(const otMessage *mensagem)
+{
+    return mensagem->tipo;
+}
+
+uint8_t otCoapMessageGetTokenLength(const otMessage *mensagem)
+{
+    return mensagem->token_len;
+}
+
+const uint8_t *otCoapMessageGetToken(const otMessage *mensagem)
+{
+    return mensagem->token;
+}
+
+// So a opcao Content-Format existe nas mensagens do mock
+otError otCoapOptionIteratorInit(otCoapOptionIterator *it, const otMessage *mensagem)
+{
+    it->mMessage = mensagem;
+    it->mNextOptionOffset = 0;
+    return OT_ERROR_NONE;
+}
+
+const otCoapOption *otCoapOptionIteratorGetFirstOptionMatching(otCoapOptionIterator *it, uint16_t opcao)
+{
+    if (opcao != OT_COAP_OPTION_CONTENT_FORMAT || it->mMessage->content_format < 0) return NULL;
+    it->mOption.mNumber = opcao;
+    it->mOption.mLength = it->mMessage->content_format > 0xff ? 2 : (it->mMessage->content_format ? 1 : 0);
+    return &it->mOption;
+}
+
+otError otCoapOptionIteratorGetOptionUintValue(otCoapOptionIterator *it, uint64_t *valor)
+{
+    if (it->mMessage->content_format < 0) return OT_ERROR_NOT_FOUND;
+    *valor = (uint64_t)it->mMessage->content_format;
+    return OT_ERROR_NONE;
+}
+
+// Recursos registrados e a resposta do pedido em andamento
+static otCoapResource *s_recursos = NULL;
+static otCoapRequestHandler s_handler_padrao = NULL;
+static void *s_contexto_padrao = NULL;
+static MockRespostaCoap *s_resposta_atual = NULL;
+
+// Cache de respostas a CON: (origem, mid) -> resposta, por EXCHANGE_LIFETIME
+#define MOCK_EXCHANGE_LIFETIME_MS 247000u
+
+struct RespostaGuardada {
+    MockRespostaCoap resposta;
+    uint64_t expira_ms;
+};
+
+typedef std::pair<std::vector<uint8_t>, uint16_t> ChaveCache;
+static std::map<ChaveCache, RespostaGuardada> s_cache;
+static uint64_t s_proxima_limpeza_ms = 0;
+
+void otCoapAddResource(otInstance *instancia, otCoapResource *recurso)
+{
+    (void)instancia;
+    recurso->mNext = s_recursos;
+    s_recursos = recurso;
+}
+
+void otCoapSetDefaultHandler(otInstance *instancia, otCoapRequestHandler handler, void *contexto)
+{
+    (void)instancia;
+    s_handler_padrao = handler;
+    s_contexto_padrao = contexto;
+}
+
+otError otCoapStart(otInstance *instancia, uint16_t porta)
+{
+    (void)instancia;
+    (void)porta;
+    return OT_ERROR_NONE;
+}
+
+otError otCoapStop(otInstance *instancia)
+{
+    (void)instancia;
+    return OT_ERROR_NONE;
+}
+
+otError otCoapSendResponseWithParameters(otInstance *instancia, otMessage *resposta, const otMessageInfo *info,
+                                         const otCoapTxParameters *parametros)
+{
+    (void)instancia;
+    (void)info;
+    (void)parametros;
+    if (s_resposta_atual) {
+        MockRespostaCoap *r = s_resposta_atual;
+        uint16_t n = (uint16_t)(resposta->bytes.size() - resposta->offset);
+        r->respondeu = true;
+        r->codigo = resposta->codigo;
+        r->payload_len = n < MOCK_RESPOSTA_MAX ? n : MOCK_RESPOSTA_MAX;
+        memcpy(r->payload, resposta->bytes.data() + resposta->offset, r->payload_len);
+    }
+    otMessageFree(resposta);     // enviada: a pilha fica com a mensagem
+    return OT_ERROR_NONE;
+}
+
+void mock_coap_entregar(const MockPedidoCoap &pedido, MockRespostaCoap *resposta)
+{
+    uint64_t agora = mock_relogio_ms();
+    ChaveCache chave(std::vector<uint8_t>(pedido.origem.mFields.m8, pedido.origem.mFields.m8 + 16), pedido.mid);
+
+    memset(resposta, 0, sizeof(*resposta));
+    if (agora >= s_proxima_limpeza_ms) {
+        for (auto it = s_cache.begin(); it != s_cache.end();) {
+            it = (it->second.expira_ms <= agora) ? s_cache.erase(it) : std::next(it);
+        }
+        s_proxima_limpeza_ms = agora + MOCK_EXCHANGE_LIFETIME_MS;
+    }
+    if (pedido.tipo == OT_COAP_TYPE_CONFIRMABLE) {
+        auto it = s_cache.find(chave);
+        if (it != s_cache.end() && it->second.expira_ms > agora) {
+            *resposta = it->second.resposta;
+            resposta->do_cache = true;
+            return;
+        }
+    }
+
+    otMessage *m = otCoapNewMessage(&s_instancia, NULL);
+    m->tipo = pedido.tipo;
+    m->codigo = OT_COAP_CODE_POST;
+    m->mid = pedido.mid;
+    m->token_len = pedido.token_len;
+    memcpy(m->token, pedido.token, pedido.token_len);
+    m->content_format = pedido.content_format;
+    m->bytes.assign(MOCK_CABECALHO_COAP + pedido.token_len, 0);
+    m->bytes.push_back(0xff);
+    m->offset = (uint16_t)m->bytes.size();
+    otMessageAppend(m, pedido.payload, pedido.payload_len);
+
+    otMessageInfo info;
+    memset(&info, 0, sizeof(info));
+    info.mPeerAddr = pedido.origem;
+    info.mPeerPort = OT_DEFAULT_COAP_PORT;
+    info.mSockAddr = s_eid_gateway;
+    info.mSockPort = OT_DEFAULT_COAP_PORT;
+
+    otCoapResource *r = s_recursos;
+    while (r && strcmp(r->mUriPath, pedido.uri) != 0) r = r->mNext;
+
+    s_resposta_atual = resposta;
+    if (r) {
+        r->mHandler(r->mContext, m, &info);
+    } else if (s_handler_padrao) {
+        s_handler_padrao(s_contexto_padrao, m, &info);
+    }
+    s_resposta_atual = NULL;
+    otMessageFree(m);
+
+    if (pedido.tipo == OT_COAP_TYPE_CONFIRMABLE && resposta->respondeu) {
+        s_cache[chave] = { *resposta, agora + MOCK_EXCHANGE_LIFETIME_MS };
+    }
+}
+
+// ==================== CLI ====================
+static const otCliCommand *s_comandos = NULL;
+static uint8_t s_num_comandos = 0;
+static void *s_contexto_cli = NULL;
+
+otError otCliSetUserCommands(const otCliCommand *comandos, uint8_t n, void *contexto)
+{
+    s_comandos = comandos;
+    s_num_comandos = n;
+    s_contexto_cli = contexto;
+    return OT_ERROR_NONE;
+}
+
+void otCliOutputFormat(const char *formato, ...)
+{
+    va_list args;
+    va_start(args, formato);
+    vprintf(formato, args);
+    va_end(args);
+}
+
+bool mock_cli_executar(const char *comando)
+{
+    for (uint8_t k = 0; k < s_num_comandos; k++) {
+        if (strcmp(s_comandos[k].mName, comando) == 0) {
+            s_comandos[k].mCommand(s_contexto_cli, 0, NULL);
+            return true;
+        }
+    }
+    return false;
+}
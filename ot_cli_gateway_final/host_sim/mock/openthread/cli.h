@@ -0,0 +1,12 @@
+#pragma once
+#include "instance.h"
+#include <stdarg.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+typedef struct otCliCommand { const char *mName; otError (*mCommand)(void *aContext, uint8_t aArgsLength, char *aArgs[]); } otCliCommand;
+otError otCliSetUserCommands(const otCliCommand *, uint8_t, void *);
+void otCliOutputFormat(const char *, ...);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,53 @@
+#pragma once
+#include "instance.h"
+#include "ip6.h"
+#include "message.h"
+#define OT_DEFAULT_COAP_PORT 5683
+#define OT_COAP_MAX_TOKEN_LENGTH 8
+#define OT_COAP_DEFAULT_TOKEN_LENGTH 2
+#ifdef __cplusplus
+extern "C" {
+#endif
+typedef enum { OT_COAP_TYPE_CONFIRMABLE = 0, OT_COAP_TYPE_NON_CONFIRMABLE = 1, OT_COAP_TYPE_ACKNOWLEDGMENT = 2, OT_COAP_TYPE_RESET = 3 } otCoapType;
+typedef enum { OT_COAP_CODE_EMPTY = 0, OT_COAP_CODE_GET = 1, OT_COAP_CODE_POST = 2, OT_COAP_CODE_PUT = 3, OT_COAP_CODE_DELETE = 4,
+  OT_COAP_CODE_CREATED = 65, OT_COAP_CODE_DELETED = 66, OT_COAP_CODE_VALID = 67, OT_COAP_CODE_CHANGED = 68, OT_COAP_CODE_CONTENT = 69,
+  OT_COAP_CODE_BAD_REQUEST = 128, OT_COAP_CODE_NOT_FOUND = 132, OT_COAP_CODE_UNSUPPORTED_FORMAT = 143, OT_COAP_CODE_INTERNAL_ERROR = 160,
+  OT_COAP_CODE_SERVICE_UNAVAILABLE = 163 } otCoapCode;
+typedef enum { OT_COAP_OPTION_CONTENT_FORMAT = 12, OT_COAP_OPTION_URI_PATH = 11 } otCoapOptionType;
+typedef enum { OT_COAP_OPTION_CONTENT_FORMAT_TEXT_PLAIN = 0, OT_COAP_OPTION_CONTENT_FORMAT_OCTET_STREAM = 42,
+  OT_COAP_OPTION_CONTENT_FORMAT_JSON = 50, OT_COAP_OPTION_CONTENT_FORMAT_CBOR = 60 } otCoapOptionContentFormat;
+typedef struct otCoapOption { uint16_t mNumber; uint16_t mLength; } otCoapOption;
+typedef struct otCoapOptionIterator { const otMessage *mMessage; otCoapOption mOption; uint16_t mNextOptionOffset; } otCoapOptionIterator;
+typedef void (*otCoapRequestHandler)(void *, otMessage *, const otMessageInfo *);
+typedef void (*otCoapResponseHandler)(void *, otMessage *, const otMessageInfo *, otError);
+typedef struct otCoapResource { const char *mUriPath; otCoapRequestHandler mHandler; void *mContext; struct otCoapResource *mNext; } otCoapResource;
+typedef struct otCoapTxParameters { uint32_t mAckTimeout; uint8_t mAckRandomFactorNumerator; uint8_t mAckRandomFactorDenominator; uint8_t mMaxRetransmit; } otCoapTxParameters;
+otMessage *otCoapNewMessage(otInstance *, const otMessageSettings *);
+void otCoapMessageInit(otMessage *, otCoapType, otCoapCode);
+otError otCoapMessageInitResponse(otMessage *, const otMessage *, otCoapType, otCoapCode);
+otError otCoapMessageSetToken(otMessage *, const uint8_t *, uint8_t);
+void otCoapMessageGenerateToken(otMessage *, uint8_t);
+otError otCoapMessageAppendUriPathOptions(otMessage *, const char *);
+otError otCoapMessageAppendContentFormatOption(otMessage *, otCoapOptionContentFormat);
+otError otCoapMessageAppendUintOption(otMessage *, uint16_t, uint32_t);
+otError otCoapMessageSetPayloadMarker(otMessage *);
+otCoapType otCoapMessageGetType(const otMessage *);
+otCoapCode otCoapMessageGetCode(const otMessage *);
+uint16_t otCoapMessageGetMessageId(const otMessage *);
+uint8_t otCoapMessageGetTokenLength(const otMessage *);
+const uint8_t *otCoapMessageGetToken(const otMessage *);
+otError otCoapOptionIteratorInit(otCoapOptionIterator *, const otMessage *);
+const otCoapOption *otCoapOptionIteratorGetFirstOptionMatching(otCoapOptionIterator *, uint16_t);
+otError otCoapOptionIteratorGetOptionUintValue(otCoapOptionIterator *, uint64_t *);
+otError otCoapSendRequestWithParameters(otInstance *, otMessage *, const otMessageInfo *, otCoapResponseHandler, void *, const otCoapTxParameters *);
+static inline otError otCoapSendRequest(otInstance *i, otMessage *m, const otMessageInfo *mi, otCoapResponseHandler h, void *c) { return otCoapSendRequestWithParameters(i, m, mi, h, c, NULL); }
+otError otCoapSendResponseWithParameters(otInstance *, otMessage *, const otMessageInfo *, const otCoapTxParameters *);
+static inline otError otCoapSendResponse(otInstance *i, otMessage *m, const otMessageInfo *mi) { return otCoapSendResponseWithParameters(i, m, mi, NULL); }
+otError otCoapStart(otInstance *, uint16_t);
+otError otCoapStop(otInstance *);
+void otCoapAddResource(otInstance *, otCoapResource *);
+void otCoapRemoveResource(otInstance *, otCoapResource *);
+void otCoapSetDefaultHandler(otInstance *, otCoapRequestHandler, void *);
+#ifdef __cplusplus
+}
+#endif
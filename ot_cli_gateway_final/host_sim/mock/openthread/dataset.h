@@ -0,0 +1,26 @@
+#pragma once
+#include "instance.h"
+#define OT_NETWORK_KEY_SIZE 16
+#define OT_NETWORK_NAME_MAX_SIZE 16
+#define OT_OPERATIONAL_DATASET_MAX_LENGTH 254
+#ifdef __cplusplus
+extern "C" {
+#endif
+typedef struct { uint64_t mSeconds; uint16_t mTicks; bool mAuthoritative; } otTimestamp;
+typedef struct { uint8_t m8[OT_NETWORK_KEY_SIZE]; } otNetworkKey;
+typedef struct { char m8[OT_NETWORK_NAME_MAX_SIZE + 1]; } otNetworkName;
+typedef struct { uint8_t m8[8]; } otExtendedPanId;
+typedef struct { uint8_t m8[8]; } otMeshLocalPrefix;
+typedef struct { bool mIsActiveTimestampPresent, mIsPendingTimestampPresent, mIsNetworkKeyPresent, mIsNetworkNamePresent,
+   mIsExtendedPanIdPresent, mIsMeshLocalPrefixPresent, mIsDelayPresent, mIsPanIdPresent, mIsChannelPresent; } otOperationalDatasetComponents;
+typedef struct { otTimestamp mActiveTimestamp; otNetworkKey mNetworkKey; otNetworkName mNetworkName; otExtendedPanId mExtendedPanId;
+   otMeshLocalPrefix mMeshLocalPrefix; uint16_t mPanId; uint16_t mChannel; otOperationalDatasetComponents mComponents; } otOperationalDataset;
+typedef struct { uint8_t mTlvs[OT_OPERATIONAL_DATASET_MAX_LENGTH]; uint8_t mLength; } otOperationalDatasetTlvs;
+otError otDatasetSetActive(otInstance *, const otOperationalDataset *);
+otError otDatasetGetActive(otInstance *, otOperationalDataset *);
+otError otDatasetGetActiveTlvs(otInstance *, otOperationalDatasetTlvs *);
+otError otDatasetSetActiveTlvs(otInstance *, const otOperationalDatasetTlvs *);
+bool otDatasetIsCommissioned(otInstance *);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,10 @@
+#pragma once
+typedef enum {
+    OT_ERROR_NONE = 0, OT_ERROR_FAILED = 1, OT_ERROR_DROP = 2, OT_ERROR_NO_BUFS = 3,
+    OT_ERROR_PARSE = 6, OT_ERROR_ABORT = 11, OT_ERROR_INVALID_ARGS = 7, OT_ERROR_INVALID_STATE = 13,
+    OT_ERROR_NOT_FOUND = 23, OT_ERROR_ALREADY = 24, OT_ERROR_RESPONSE_TIMEOUT = 28,
+} otError;
+#ifdef __cplusplus
+extern "C"
+#endif
+const char *otThreadErrorToString(otError);
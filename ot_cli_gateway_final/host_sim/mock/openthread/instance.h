@@ -0,0 +1,20 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "error.h"
+#define OT_UNUSED_VARIABLE(x) ((void)(x))
+#ifdef __cplusplus
+extern "C" {
+#endif
+typedef struct otInstance otInstance;
+typedef uint32_t otChangedFlags;
+typedef void (*otStateChangedCallback)(otChangedFlags aFlags, void *aContext);
+#define OT_CHANGED_THREAD_ROLE (1U << 2)
+#define OT_CHANGED_THREAD_NETDATA (1U << 9)
+#define OT_CHANGED_THREAD_PARTITION_ID (1U << 10)
+otError otSetStateChangedCallback(otInstance *, otStateChangedCallback, void *);
+void otRemoveStateChangeCallback(otInstance *, otStateChangedCallback, void *);
+#ifdef __cplusplus
+}
+#endif
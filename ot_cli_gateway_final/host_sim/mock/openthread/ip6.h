@@ -0,0 +1,27 @@
+#pragma once
+#include "instance.h"
+#include "message.h"
+#define OT_IP6_ADDRESS_SIZE 16
+#define OT_IP6_ADDRESS_STRING_SIZE 40
+#define OT_IP6_PREFIX_SIZE 8
+#define OT_IP6_IID_SIZE 8
+#ifdef __cplusplus
+extern "C" {
+#endif
+typedef struct otIp6InterfaceIdentifier { union { uint8_t m8[8]; uint16_t m16[4]; uint32_t m32[2]; } mFields; } otIp6InterfaceIdentifier;
+typedef struct otIp6NetworkPrefix { uint8_t m8[OT_IP6_PREFIX_SIZE]; } otIp6NetworkPrefix;
+typedef struct otIp6AddressComponents { otIp6NetworkPrefix mNetworkPrefix; otIp6InterfaceIdentifier mIid; } otIp6AddressComponents;
+typedef struct otIp6Address { union { uint8_t m8[16]; uint16_t m16[8]; uint32_t m32[4]; otIp6AddressComponents mComponents; } mFields; } otIp6Address;
+typedef struct otMessageInfo {
+    otIp6Address mSockAddr; otIp6Address mPeerAddr; uint16_t mSockPort; uint16_t mPeerPort;
+    const void *mLinkInfo; uint8_t mHopLimit; uint8_t mEcn : 2; bool mIsHostInterface : 1;
+    bool mAllowZeroHopLimit : 1; bool mMulticastLoop : 1;
+} otMessageInfo;
+otError otIp6AddressFromString(const char *, otIp6Address *);
+void otIp6AddressToString(const otIp6Address *, char *, uint16_t);
+bool otIp6IsAddressEqual(const otIp6Address *, const otIp6Address *);
+otError otIp6SetEnabled(otInstance *, bool);
+bool otIp6IsEnabled(otInstance *);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,24 @@
+#pragma once
+#include "instance.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+typedef struct otMacCounters { uint32_t mTxTotal, mTxUnicast, mTxBroadcast, mTxAckRequested, mTxAcked, mTxNoAckRequested, mTxData, mTxDataPoll,
+   mTxBeacon, mTxBeaconRequest, mTxOther, mTxRetry, mTxDirectMaxRetryExpiry, mTxIndirectMaxRetryExpiry, mTxErrCca, mTxErrAbort, mTxErrBusyChannel, mRxTotal, mRxUnicast, mRxBroadcast,
+   mRxData, mRxDataPoll, mRxBeacon, mRxBeaconRequest, mRxOther, mRxAddressFiltered, mRxDestAddrFiltered, mRxDuplicated,
+   mRxErrNoFrame, mRxErrUnknownNeighbor, mRxErrInvalidSrcAddr, mRxErrSec, mRxErrFcs, mRxErrOther; } otMacCounters;
+typedef struct otExtAddress { uint8_t m8[8]; } otExtAddress;
+const otMacCounters *otLinkGetCounters(otInstance *);
+void otLinkResetCounters(otInstance *);
+otError otLinkSetPollPeriod(otInstance *, uint32_t);
+uint32_t otLinkGetPollPeriod(otInstance *);
+otError otLinkSetCslPeriod(otInstance *, uint32_t);
+otError otLinkSetCslChannel(otInstance *, uint8_t);
+bool otLinkIsCslSupported(otInstance *);
+bool otLinkIsCslEnabled(otInstance *);
+const otExtAddress *otLinkGetExtendedAddress(otInstance *);
+void otLinkGetFactoryAssignedIeeeEui64(otInstance *, otExtAddress *);
+otError otLinkSetMaxFrameRetriesDirect(otInstance *, uint8_t);
+#ifdef __cplusplus
+}
+#endif
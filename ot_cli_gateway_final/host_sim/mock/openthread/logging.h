@@ -0,0 +1,6 @@
+#pragma once
+#include "instance.h"
+#ifdef __cplusplus
+extern "C"
+#endif
+otError otLoggingSetLevel(int);
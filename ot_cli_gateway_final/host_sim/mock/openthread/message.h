@@ -0,0 +1,16 @@
+#pragma once
+#include "instance.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+typedef struct otMessage otMessage;
+typedef struct otMessageSettings { bool mLinkSecurityEnabled; uint8_t mPriority; } otMessageSettings;
+uint16_t otMessageGetLength(const otMessage *);
+uint16_t otMessageGetOffset(const otMessage *);
+uint16_t otMessageRead(const otMessage *, uint16_t, void *, uint16_t);
+otError otMessageAppend(otMessage *, const void *, uint16_t);
+void otMessageFree(otMessage *);
+int8_t otMessageGetRss(const otMessage *);
+#ifdef __cplusplus
+}
+#endif
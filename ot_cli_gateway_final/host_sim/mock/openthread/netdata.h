@@ -0,0 +1,15 @@
+#pragma once
+#include "instance.h"
+#define OT_SERVICE_DATA_MAX_SIZE 252
+#define OT_SERVER_DATA_MAX_SIZE 248
+#define OT_NETWORK_DATA_ITERATOR_INIT 0
+#ifdef __cplusplus
+extern "C" {
+#endif
+typedef uint32_t otNetworkDataIterator;
+typedef struct otServerConfig { bool mStable : 1; uint8_t mServerDataLength; uint8_t mServerData[OT_SERVER_DATA_MAX_SIZE]; uint16_t mRloc16; } otServerConfig;
+typedef struct otServiceConfig { uint8_t mServiceId; uint32_t mEnterpriseNumber; uint8_t mServiceDataLength; uint8_t mServiceData[OT_SERVICE_DATA_MAX_SIZE]; otServerConfig mServerConfig; } otServiceConfig;
+otError otNetDataGetNextService(otInstance *, otNetworkDataIterator *, otServiceConfig *);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,12 @@
+#pragma once
+#include "instance.h"
+#include "netdata.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+otError otServerAddService(otInstance *, const otServiceConfig *);
+otError otServerRemoveService(otInstance *, uint32_t, const uint8_t *, uint8_t);
+otError otServerRegister(otInstance *);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+#include "instance.h"
+#include "ip6.h"
+#include "dataset.h"
+#include "link.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+typedef enum { OT_DEVICE_ROLE_DISABLED = 0, OT_DEVICE_ROLE_DETACHED = 1, OT_DEVICE_ROLE_CHILD = 2, OT_DEVICE_ROLE_ROUTER = 3, OT_DEVICE_ROLE_LEADER = 4 } otDeviceRole;
+typedef struct otLinkModeConfig { bool mRxOnWhenIdle : 1; bool mDeviceType : 1; bool mNetworkData : 1; } otLinkModeConfig;
+typedef struct otRouterInfo { otExtAddress mExtAddress; uint16_t mRloc16; uint8_t mRouterId; uint8_t mNextHop; uint8_t mPathCost;
+   uint8_t mLinkQualityIn; uint8_t mLinkQualityOut; uint8_t mAge; bool mAllocated : 1; bool mLinkEstablished : 1; uint8_t mVersion; } otRouterInfo;
+otError otThreadSetEnabled(otInstance *, bool);
+otDeviceRole otThreadGetDeviceRole(otInstance *);
+const char *otThreadDeviceRoleToString(otDeviceRole);
+const otIp6Address *otThreadGetMeshLocalEid(otInstance *);
+const otMeshLocalPrefix *otThreadGetMeshLocalPrefix(otInstance *);
+const otIp6Address *otThreadGetRloc(otInstance *);
+uint16_t otThreadGetRloc16(otInstance *);
+otError otThreadSetLinkMode(otInstance *, otLinkModeConfig);
+otLinkModeConfig otThreadGetLinkMode(otInstance *);
+otError otThreadGetParentInfo(otInstance *, otRouterInfo *);
+otError otThreadGetParentAverageRssi(otInstance *, int8_t *);
+otError otThreadGetParentLastRssi(otInstance *, int8_t *);
+otError otThreadBecomeChild(otInstance *);
+uint32_t otThreadGetChildTimeout(otInstance *);
+void otThreadSetChildTimeout(otInstance *, uint32_t);
+#ifdef __cplusplus
+}
+#endif
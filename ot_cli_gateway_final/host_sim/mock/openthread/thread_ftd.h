@@ -0,0 +1,11 @@
+#pragma once
+#include "thread.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+otError otThreadGetRouterInfo(otInstance *, uint16_t, otRouterInfo *);
+void otThreadGetNextHopAndPathCost(otInstance *, uint16_t, uint16_t *, uint8_t *);
+uint8_t otThreadGetRouterIdRange(otInstance *);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,23 @@
+#pragma once
+
+// Configuracao do gateway no host_sim: os defaults do main/Kconfig.projbuild
+// (radio em alternancia, sem agregacao). O CLI existe para o simulador
+// chamar os comandos do gateway_cli.cpp.
+#define CONFIG_OPENTHREAD_CLI 1
+#define CONFIG_LOG_DEFAULT_LEVEL 3
+
+#define CONFIG_GATEWAY_RADIO_ALTERNANCIA 1
+#define CONFIG_GATEWAY_SERVICO_THREAD 1
+#define CONFIG_GATEWAY_HTTP_BATCH 1
+#define CONFIG_GATEWAY_HTTP_LOTE_AMOSTRAS 64
+#define CONFIG_GATEWAY_HTTP_SEQUENCIA 1
+#define CONFIG_GATEWAY_HTTP_TOPOLOGIA 1
+#define CONFIG_GATEWAY_HTTP_METRICAS 1
+#define CONFIG_GATEWAY_JOURNAL 1
+#define CONFIG_GATEWAY_HISTORICO_AMOSTRAS 16
+#define CONFIG_GATEWAY_NODO_STALE_S 300
+#define CONFIG_GATEWAY_NODO_OFFLINE_S 1800
+
+// esp_ot_config.h (configuracao da plataforma no ot_task_worker)
+#define SOC_IEEE802154_SUPPORTED 1
+#define CONFIG_OPENTHREAD_CONSOLE_TYPE_USB_SERIAL_JTAG 1
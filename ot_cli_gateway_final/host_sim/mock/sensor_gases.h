@@ -0,0 +1,12 @@
+#pragma once
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern TaskHandle_t SensorGasesTaskHandle;
+float gas_get_ppm_estimate(void);
+void SensorGasesTask(void *);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,13 @@
+#pragma once
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern TaskHandle_t AHTTaskHandle;
+void AHTtask(void *);
+float AHT_GetTemperature(void);
+float AHT_GetHumidity(void);
+#ifdef __cplusplus
+}
+#endif
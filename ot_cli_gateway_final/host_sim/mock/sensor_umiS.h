@@ -0,0 +1,11 @@
+#pragma once
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+void SensorUmiSTask(void *);
+float UmiS_GetTDS(void);
+#ifdef __cplusplus
+}
+#endif
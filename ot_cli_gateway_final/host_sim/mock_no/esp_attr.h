@@ -0,0 +1,4 @@
+#pragma once
+
+// No host a memoria RTC e uma variavel estatica comum
+#define RTC_DATA_ATTR
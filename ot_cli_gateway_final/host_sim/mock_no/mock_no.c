@@ -0,0 +1,28 @@
+#include "esp_log.h"
+#include <stdarg.h>
+
+// ==================== LOG ====================
+// So o log: os testes do nó chamam o lote e a banda direto, sem relogio
+// nem OpenThread
+esp_log_level_t mock_log_nivel = ESP_LOG_ERROR;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    (void)tag;
+    mock_log_nivel = level;
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return 0;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    (void)level;
+    (void)tag;
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
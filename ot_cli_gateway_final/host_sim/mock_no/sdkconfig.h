@@ -0,0 +1,19 @@
+#pragma once
+
+// Configuracao do nó no host_sim: os defaults do Kconfig.projbuild do
+// ot_cli_nos_final (lote na RTC e banda morta ligados). Vem antes de mock/
+// nos alvos do nó, no lugar do sdkconfig do gateway.
+#define CONFIG_LOG_DEFAULT_LEVEL 3
+
+#define CONFIG_NODE_INTERVALO_AMOSTRA_S 30
+#define CONFIG_NODE_BANDA 1
+#define CONFIG_NODE_BANDA_TEMP 30
+#define CONFIG_NODE_BANDA_UMIDADE_AR 150
+#define CONFIG_NODE_BANDA_UMIDADE_SOLO 500
+#define CONFIG_NODE_BANDA_PARTICULAS 1000
+#define CONFIG_NODE_HEARTBEAT_S 240
+#define CONFIG_NODE_LOTE 1
+#define CONFIG_NODE_LOTE_WAKES 4
+#define CONFIG_NODE_LOTE_LIMITE_TEMP_C 40
+#define CONFIG_NODE_LOTE_LIMITE_UMIS_MIN 0
+#define CONFIG_NODE_LOTE_LIMITE_PPM 0
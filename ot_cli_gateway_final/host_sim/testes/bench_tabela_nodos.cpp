@@ -0,0 +1,114 @@
+// ==================== BENCHMARK DA TABELA DE NÓS ====================
+// Insercao + atualizacao na tabela de nós (registrarNodo pelo id curto,
+// como chegam os lotes depois do cadastro) contra o vetor dinamico de
+// antes, com busca linear pelo endereco em texto. Um tamanho por execucao
+// (a tabela e estatica): bench_tabela_nodos N. Compilado com
+// NODE_TABLE_CAPACIDADE=1024 para caber 1000 nós.
+
+#include "teste.hpp"
+#include "host_mock.hpp"
+#include "node_table.hpp"
+#include "cadastro_nodos.hpp"
+#include "esp_log.h"
+#include <chrono>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+
+#define OPERACOES_POR_MEDIDA 400000
+
+// ==================== TABELA ANTIGA (VETOR) ====================
+// Copia da node_table.cpp original, sem os logs
+struct NodoVetor {
+    std::string endereco;
+    sensor_data_t dados;
+    uint32_t last_update_ms;
+
+    NodoVetor(const std::string &addr, const sensor_data_t &d, uint32_t ts)
+        : endereco(addr), dados(d), last_update_ms(ts) {}
+};
+
+static std::vector<NodoVetor> tabela_vetor;
+
+static void registrar_vetor(const std::string &ipv6, const sensor_data_t &dados)
+{
+    uint32_t agora = esp_log_timestamp();
+    for (auto &n : tabela_vetor) {
+        if (n.endereco == ipv6) {
+            n.dados = dados;
+            n.last_update_ms = agora;
+            return;
+        }
+    }
+    tabela_vetor.emplace_back(ipv6, dados, agora);
+}
+
+// ==================== MEDIDAS ====================
+static otIp6Address eid_do_no(int k)
+{
+    otIp6Address eid;
+    memset(&eid, 0, sizeof(eid));
+    eid.mFields.m8[0] = 0xfd;
+    eid.mFields.m8[14] = (uint8_t)(k >> 8);
+    eid.mFields.m8[15] = (uint8_t)k;
+    return eid;
+}
+
+template <typename F>
+static double ns_por_operacao(int nodos, F registrar)
+{
+    int rodadas = OPERACOES_POR_MEDIDA / nodos;
+    sensor_data_t dados = {};
+    auto inicio = std::chrono::steady_clock::now();
+    for (int r = 0; r < rodadas; r++) {
+        for (int k = 0; k < nodos; k++) {
+            dados.temperatura = (float)(r + k);
+            registrar(k, dados);
+        }
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - inicio).count();
+    return ns / ((double)rodadas * nodos);
+}
+
+int main(int argc, char **argv)
+{
+    int nodos = argc > 1 ? atoi(argv[1]) : 100;
+    if (nodos < 1 || nodos > NODE_TABLE_CAPACIDADE) {
+        fprintf(stderr, "uso: %s N (1..%d)\n", argv[0], NODE_TABLE_CAPACIDADE);
+        return 2;
+    }
+    mock_log_nivel = ESP_LOG_ERROR;
+    mock_relogio_definir_ms(1000);
+    cadastro_iniciar();
+
+    // Cadastro antes de medir: no gateway ele acontece uma vez por nó
+    std::vector<uint16_t> ids(nodos);
+    std::vector<std::string> enderecos(nodos);
+    for (int k = 0; k < nodos; k++) {
+        otIp6Address eid = eid_do_no(k);
+        ids[k] = cadastro_por_eid(eid);
+        char texto[OT_IP6_ADDRESS_STRING_SIZE];
+        otIp6AddressToString(&eid, texto, sizeof(texto));
+        enderecos[k] = texto;
+    }
+
+    double tabela = ns_por_operacao(nodos, [&](int k, const sensor_data_t &d) { registrarNodo(ids[k], d); });
+    double vetor = ns_por_operacao(nodos, [&](int k, const sensor_data_t &d) { registrar_vetor(enderecos[k], d); });
+    printf("%4d nós: tabela %.1f ns/op, vetor %.1f ns/op (insercao + atualizacao)\n", nodos, tabela, vetor);
+
+    // Os dois guardaram todos os nós com a ultima leitura
+    CONFERIR(totalNodos() == (size_t)nodos);
+    CONFERIR(tabela_vetor.size() == (size_t)nodos);
+    int rodadas = OPERACOES_POR_MEDIDA / nodos;
+    for (int k = 0; k < nodos; k++) {
+        NodeInfo n;
+        CONFERIR(lerNodo(k, &n));
+        CONFERIR(n.id == ids[k]);
+        CONFERIR(n.dados.temperatura == (float)(rodadas - 1 + k));
+        CONFERIR(tabela_vetor[k].dados.temperatura == n.dados.temperatura);
+    }
+    // A busca linear cresce com N, o indice nao; com 1000 nós a folga e
+    // larga o bastante para nao depender da maquina
+    if (nodos >= 1000) CONFERIR(tabela < vetor);
+    return teste_fim();
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include "teste.hpp"
+#include "host_mock.hpp"
+#include "esp_ot_cli.hpp"
+#include "http_request.hpp"
+#include "cadastro_nodos.hpp"
+#include "sensor_codec.hpp"
+#include "cJSON.h"
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+// ==================== GATEWAY E NÓS PARA OS TESTES ====================
+// O gateway como o host_sim o monta (recursos CoAP reais sobre os mocks),
+// nós de teste que falam com ele por mock_coap_entregar e um coletor HTTP
+// em WEB_SERVER:WEB_PORT que guarda os corpos dos POSTs. Testes que usam
+// o coletor disputam a porta com o host_sim: RUN_SERIAL no ctest.
+
+static inline void gateway_teste_iniciar()
+{
+    global_ot_instance = esp_openthread_get_instance();
+    cadastro_iniciar();
+
+    static otCoapResource recurso_sensor = { "sensor", coap_handler, NULL, NULL };
+    static otCoapResource recurso_cadastro = { SENSOR_CADASTRO_RECURSO, coap_cadastro_handler, NULL, NULL };
+    otCoapAddResource(global_ot_instance, &recurso_sensor);
+    otCoapAddResource(global_ot_instance, &recurso_cadastro);
+    otCoapStart(global_ot_instance, OT_DEFAULT_COAP_PORT);
+}
+
+// ==================== NÓ DE TESTE ====================
+struct NoTeste {
+    uint8_t eui64[SENSOR_EUI64_TAMANHO];
+    otIp6Address eid;
+    uint16_t id;
+    uint16_t mid;
+};
+
+// k-esimo nó: EUI-64 e EID derivados de k
+static inline NoTeste no_teste(uint32_t k)
+{
+    NoTeste no;
+    memset(&no, 0, sizeof(no));
+    for (int b = 0; b < SENSOR_EUI64_TAMANHO; b++) no.eui64[b] = (uint8_t)(k >> (8 * (b % 4)) ^ (0x10 * b));
+    no.eid.mFields.m8[0] = 0xfd;
+    no.eid.mFields.m8[12] = (uint8_t)(k >> 24);
+    no.eid.mFields.m8[13] = (uint8_t)(k >> 16);
+    no.eid.mFields.m8[14] = (uint8_t)(k >> 8);
+    no.eid.mFields.m8[15] = (uint8_t)k;
+    no.id = CADASTRO_SEM_ID;
+    return no;
+}
+
+// CON com token de sequencia (SENSOR_TOKEN_TAMANHO bytes), mid nova
+static inline void no_teste_pedir(NoTeste &no, const char *uri, const uint8_t *payload, uint16_t len, uint32_t seq,
+                                  MockRespostaCoap *resposta)
+{
+    uint8_t token[SENSOR_TOKEN_TAMANHO] = { 0 };
+    for (int k = 0; k < SENSOR_TOKEN_SEQ_TAMANHO; k++) token[k] = (uint8_t)(seq >> (8 * k));
+    MockPedidoCoap pedido = { uri, OT_COAP_TYPE_CONFIRMABLE, ++no.mid, token, sizeof(token),
+                              OT_COAP_OPTION_CONTENT_FORMAT_OCTET_STREAM, payload, len, no.eid };
+    mock_coap_entregar(pedido, resposta);
+}
+
+// Cadastro: guarda o id do 2.04; retorna o codigo da resposta
+static inline otCoapCode no_teste_cadastrar(NoTeste &no, MockRespostaCoap *resposta)
+{
+    uint8_t pedido[SENSOR_CADASTRO_TAMANHO];
+    encode_sensor_cadastro(no.eui64, &no.eid, pedido);
+    no_teste_pedir(no, SENSOR_CADASTRO_RECURSO, pedido, sizeof(pedido), 0, resposta);
+    if (resposta->respondeu && resposta->codigo == OT_COAP_CODE_CHANGED && resposta->payload_len >= SENSOR_ID_TAMANHO) {
+        no.id = decode_sensor_id(resposta->payload);
+    }
+    return resposta->codigo;
+}
+
+// Lote de n amostras (com o id, ou com o EID se o nó nao tem id) e, se
+// 'enlace', o bloco de enlace no fim; seq e a da primeira amostra
+static inline otCoapCode no_teste_enviar(NoTeste &no, const sensor_data_t *amostras, uint8_t n, uint32_t seq,
+                                         const sensor_enlace_t *enlace, MockRespostaCoap *resposta)
+{
+    uint8_t payload[SENSOR_LOTE_TAMANHO_MAX + SENSOR_ENLACE_TAMANHO];
+    size_t len = encode_sensor_lote_cabecalho(no.id, &no.eid, n, payload, sizeof(payload));
+    for (uint8_t k = 0; k < n; k++, len += SENSOR_AMOSTRA_TAMANHO) {
+        encode_sensor_amostra(&amostras[k], payload + len);
+    }
+    if (enlace) {
+        encode_sensor_enlace(enlace, payload + len);
+        len += SENSOR_ENLACE_TAMANHO;
+    }
+    no_teste_pedir(no, "sensor", payload, (uint16_t)len, seq, resposta);
+    return resposta->codigo;
+}
+
+// ==================== COLETOR HTTP ====================
+// Responde 200 a todo POST e guarda o corpo; uma conexao por vez
+struct ColetorHttp {
+    int escuta = -1;
+    std::thread thread;
+    std::mutex trava;
+    std::vector<std::string> corpos;
+};
+
+static inline bool coletor_pedido(ColetorHttp &c, int fd, std::string &buf)
+{
+    size_t fim;
+    char bloco[4096];
+    while ((fim = buf.find("\r\n\r\n")) == std::string::npos) {
+        ssize_t r = recv(fd, bloco, sizeof(bloco), 0);
+        if (r <= 0) return false;
+        buf.append(bloco, (size_t)r);
+    }
+    size_t tamanho = 0;
+    for (size_t pos = 0; pos < fim;) {
+        size_t eol = buf.find("\r\n", pos);
+        if (strncasecmp(buf.c_str() + pos, "Content-Length:", 15) == 0) {
+            tamanho = strtoul(buf.c_str() + pos + 15, NULL, 10);
+        }
+        pos = eol + 2;
+    }
+    while (buf.size() < fim + 4 + tamanho) {
+        ssize_t r = recv(fd, bloco, sizeof(bloco), 0);
+        if (r <= 0) return false;
+        buf.append(bloco, (size_t)r);
+    }
+    {
+        std::lock_guard<std::mutex> g(c.trava);
+        c.corpos.push_back(buf.substr(fim + 4, tamanho));
+    }
+    buf.erase(0, fim + 4 + tamanho);
+    const char *ok = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\nConnection: keep-alive\r\n\r\n";
+    return send(fd, ok, strlen(ok), MSG_NOSIGNAL) == (ssize_t)strlen(ok);
+}
+
+static inline bool coletor_abrir(ColetorHttp &c)
+{
+    c.escuta = socket(AF_INET, SOCK_STREAM, 0);
+    int um = 1;
+    setsockopt(c.escuta, SOL_SOCKET, SO_REUSEADDR, &um, sizeof(um));
+    struct sockaddr_in end;
+    memset(&end, 0, sizeof(end));
+    end.sin_family = AF_INET;
+    end.sin_port = htons((uint16_t)atoi(WEB_PORT));
+    inet_pton(AF_INET, WEB_SERVER, &end.sin_addr);
+    if (bind(c.escuta, (struct sockaddr *)&end, sizeof(end)) != 0 || listen(c.escuta, 4) != 0) {
+        perror("coletor HTTP em " WEB_SERVER ":" WEB_PORT);
+        close(c.escuta);
+        return false;
+    }
+    c.thread = std::thread([&c]() {
+        int fd;
+        while ((fd = accept(c.escuta, NULL, NULL)) >= 0) {
+            struct timeval timeout = { 3, 0 };
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            std::string buf;
+            while (coletor_pedido(c, fd, buf)) {
+            }
+            close(fd);
+        }
+    });
+    return true;
+}
+
+// Fecha a conexao do gateway e o coletor (os corpos ficam)
+static inline void coletor_encerrar(ColetorHttp &c)
+{
+    http_encerrar_conexao();
+    shutdown(c.escuta, SHUT_RDWR);
+    close(c.escuta);
+    c.thread.join();
+}
+
+// Itens (de todos os POSTs) que tem a chave 'chave' com um objeto; o
+// chamador libera com cJSON_Delete
+static inline cJSON *coletor_itens(ColetorHttp &c, const char *chave)
+{
+    cJSON *saida = cJSON_CreateArray();
+    std::lock_guard<std::mutex> g(c.trava);
+    for (const std::string &corpo : c.corpos) {
+        cJSON *raiz = cJSON_ParseWithLength(corpo.data(), corpo.size());
+        cJSON *item;
+        cJSON_ArrayForEach(item, raiz) {
+            if (cJSON_IsObject(cJSON_GetObjectItem(item, chave))) {
+                cJSON_AddItemToArray(saida, cJSON_Duplicate(item, true));
+            }
+        }
+        cJSON_Delete(raiz);
+    }
+    return saida;
+}
+
+// Item de 'itens' do nó com o EID em texto de 'id'
+static inline cJSON *item_do_nodo(cJSON *itens, uint16_t id)
+{
+    char eid[OT_IP6_ADDRESS_STRING_SIZE];
+    cadastro_eid_texto(id, eid, sizeof(eid));
+    cJSON *item;
+    cJSON_ArrayForEach(item, itens) {
+        const char *e = cJSON_GetStringValue(cJSON_GetObjectItem(item, "e"));
+        if (e && strcmp(e, eid) == 0) return item;
+    }
+    return NULL;
+}
+
+// Campo numerico de um objeto (-1 se ausente)
+static inline double numero(const cJSON *objeto, const char *chave)
+{
+    const cJSON *n = cJSON_GetObjectItem(objeto, chave);
+    return cJSON_IsNumber(n) ? n->valuedouble : -1;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdio.h>
+
+// ==================== APOIO AOS TESTES DO HOST ====================
+// Cada teste e um executavel (ctest): CONFERIR anota a falha e segue, e o
+// main termina com return teste_fim() (1 se algo falhou).
+
+static int s_teste_falhas = 0;
+
+#define CONFERIR(condicao)                                                                     \
+    do {                                                                                       \
+        if (!(condicao)) {                                                                     \
+            fprintf(stderr, "%s:%d: falhou: %s\n", __FILE__, __LINE__, #condicao);             \
+            s_teste_falhas++;                                                                  \
+        }                                                                                      \
+    } while (0)
+
+static inline int teste_fim()
+{
+    if (s_teste_falhas) {
+        fprintf(stderr, "%d verificacao(oes) falharam\n", s_teste_falhas);
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,216 @@
+// ==================== TESTE DA AGREGACAO POR JANELA ====================
+// Nós mandando leituras com intervalo irregular (inclusive silencios de
+// banda morta, que criam o ponto interpolado no inicio da janela, e
+// silencios acima do stale, que nao criam) pelo registrarNodo real. Cada
+// janela fechada (e a vencida sem fechamento, no fim) e comparada com o
+// calculo ingenuo em duas passadas, em double, sobre os mesmos pontos.
+// Compilado com CONFIG_GATEWAY_AGREGACAO=1.
+
+#include "teste.hpp"
+#include "host_mock.hpp"
+#include "agregacao.hpp"
+#include "node_table.hpp"
+#include "cadastro_nodos.hpp"
+#include "esp_log.h"
+#include <float.h>
+#include <math.h>
+#include <random>
+#include <vector>
+
+#define NOS      8
+#define LEITURAS 400
+
+// ==================== MODELO INGENUO ====================
+struct Ponto {
+    uint32_t ms;
+    double x[METRICA_TOTAL];
+};
+
+struct JanelaModelo {
+    uint32_t inicio_ms = 0;
+    uint32_t interpolados = 0;
+    std::vector<Ponto> pontos;
+};
+
+struct NoModelo {
+    uint16_t id;
+    size_t posicao;
+    JanelaModelo atual;
+    bool com_ultimo = false;
+    double ultimo[METRICA_TOTAL];
+    uint32_t ultimo_ms = 0;
+    uint32_t janelas = 0;
+};
+
+static uint32_t s_janelas_conferidas = 0;
+static uint32_t s_interpolacoes = 0;
+
+static bool perto(double visto, double esperado, double tolerancia)
+{
+    return fabs(visto - esperado) <= tolerancia * (1.0 + fabs(esperado));
+}
+
+// Duas passadas sobre os pontos da janela
+static void conferir_resumo(const JanelaModelo &j, const ResumoJanela &r)
+{
+    size_t n = j.pontos.size();
+    CONFERIR(r.amostras == n - j.interpolados);
+    CONFERIR(r.inicio_ms == j.inicio_ms);
+    CONFERIR(r.duracao_ms == j.pontos.back().ms - j.pontos.front().ms);
+
+    double media_t = 0;
+    for (const Ponto &p : j.pontos) media_t += (p.ms - j.inicio_ms) / 1000.0;
+    media_t /= n;
+    double m2_t = 0;
+    for (const Ponto &p : j.pontos) m2_t += pow((p.ms - j.inicio_ms) / 1000.0 - media_t, 2);
+
+    for (int k = 0; k < METRICA_TOTAL; k++) {
+        double min = INFINITY, max = -INFINITY, media = 0;
+        for (const Ponto &p : j.pontos) {
+            min = fmin(min, p.x[k]);
+            max = fmax(max, p.x[k]);
+            media += p.x[k];
+        }
+        media /= n;
+        double m2 = 0, cov = 0;
+        for (const Ponto &p : j.pontos) {
+            m2 += pow(p.x[k] - media, 2);
+            cov += ((p.ms - j.inicio_ms) / 1000.0 - media_t) * (p.x[k] - media);
+        }
+        double variancia = n > 1 ? m2 / (n - 1) : 0;
+        double tendencia = m2_t > 0 ? cov / m2_t * 60.0 : 0;
+
+        const ResumoMetrica &m = r.m[k];
+        CONFERIR(m.min == (float)min && m.max == (float)max);
+        CONFERIR(perto(m.media, media, 1e-5));
+        CONFERIR(perto(m.variancia, variancia, 1e-3));
+        // Duas leituras a poucos ms uma da outra: o arredondamento do valor
+        // em float ja move a inclinacao, na escala de 1/sqrt(m2_t)
+        double folga = m2_t > 0 ? 60.0 * 4 * FLT_EPSILON * fmax(fabs(min), fabs(max)) * sqrt(n / m2_t) : 0;
+        CONFERIR(fabs(m.tendencia - tendencia) <= folga + 1e-3 * (1.0 + fabs(tendencia)));
+    }
+    s_janelas_conferidas++;
+}
+
+// A janela do nó acabou de fechar (ou venceu): o pendente tem de ser ela
+static void conferir_pendente(NoModelo &no, uint32_t agora_ms)
+{
+    ResumoJanela r;
+    CONFERIR(agregacao_resumo_pendente(no.posicao, agora_ms, &r));
+    CONFERIR(r.seq == no.janelas);
+    conferir_resumo(no.atual, r);
+    agregacao_confirmar(no.posicao, r.seq);
+    CONFERIR(!agregacao_resumo_pendente(no.posicao, agora_ms, &r) || r.seq > no.janelas);
+}
+
+// Mesma regra do agregacao_registrar, sobre o modelo
+static void registrar_modelo(NoModelo &no, uint32_t agora_ms, const double x[METRICA_TOTAL])
+{
+    JanelaModelo &j = no.atual;
+    uint32_t inicio = agora_ms - agora_ms % AGREGACAO_JANELA_MS;
+    if (!j.pontos.empty() && inicio != j.inicio_ms) {
+        j = JanelaModelo();
+    }
+    if (j.pontos.empty()) {
+        no.janelas++;
+        j.inicio_ms = inicio;
+        uint32_t parado = agora_ms - no.ultimo_ms;
+        if (no.com_ultimo && parado > 0 && parado < NODO_STALE_MS && (int32_t)(inicio - no.ultimo_ms) > 0) {
+            // Mesmas contas do gateway (float), para min/max baterem exatos
+            float f = (float)(inicio - no.ultimo_ms) / (float)parado;
+            Ponto p = { inicio, {} };
+            for (int k = 0; k < METRICA_TOTAL; k++) {
+                p.x[k] = (float)no.ultimo[k] + f * ((float)x[k] - (float)no.ultimo[k]);
+            }
+            j.pontos.push_back(p);
+            j.interpolados++;
+            s_interpolacoes++;
+        }
+    }
+    Ponto p = { agora_ms, {} };
+    for (int k = 0; k < METRICA_TOTAL; k++) p.x[k] = x[k];
+    j.pontos.push_back(p);
+    memcpy(no.ultimo, x, sizeof(no.ultimo));
+    no.ultimo_ms = agora_ms;
+    no.com_ultimo = true;
+}
+
+int main()
+{
+    mock_log_nivel = ESP_LOG_ERROR;
+    std::mt19937 sorteio(5);
+    cadastro_iniciar();
+
+    std::vector<NoModelo> nos(NOS);
+    std::vector<uint32_t> proxima(NOS);
+    for (int k = 0; k < NOS; k++) {
+        otIp6Address eid;
+        memset(&eid, 0, sizeof(eid));
+        eid.mFields.m8[0] = 0xfd;
+        eid.mFields.m8[15] = (uint8_t)(k + 1);
+        nos[k].id = cadastro_por_eid(eid);
+        proxima[k] = 1000 + sorteio() % 30000;
+    }
+
+    double base[METRICA_TOTAL] = { 24.0, 60.0, 40.0, 400.0 };
+    uint32_t agora = 0;
+    for (int leitura = 0; leitura < LEITURAS * NOS; leitura++) {
+        // Proximo nó a falar, em ordem de relogio
+        int k = 0;
+        for (int q = 1; q < NOS; q++) {
+            if (proxima[q] < proxima[k]) k = q;
+        }
+        agora = proxima[k];
+        mock_relogio_definir_ms(agora);
+        NoModelo &no = nos[k];
+
+        // Metricas com deriva, ruido e de vez em quando um salto; valores
+        // exatos em float para o modelo usar os mesmos numeros
+        sensor_data_t d = {};
+        d.nodo = no.id;
+        double x[METRICA_TOTAL];
+        for (int m = 0; m < METRICA_TOTAL; m++) {
+            double ruido = (double)(sorteio() % 2001) / 1000.0 - 1.0;
+            double salto = (sorteio() % 50 == 0) ? 20.0 : 0.0;
+            x[m] = (float)(base[m] + m * 0.001 * agora / 1000.0 + ruido * (m + 1) + salto);
+        }
+        d.temperatura = (float)x[0];
+        d.umidadeAr = (float)x[1];
+        d.umidadeSolo = (float)x[2];
+        d.particulas = (float)x[3];
+
+        uint32_t janela_antes = no.atual.inicio_ms;
+        bool fecha = !no.atual.pontos.empty() && agora - agora % AGREGACAO_JANELA_MS != janela_antes;
+        if (fecha) {
+            // Antes da leitura que fecha: a janela vencida ja sai como definitiva
+            conferir_pendente(no, agora);
+        }
+        CONFERIR(registrarNodo(no.id, d));
+        if (leitura < NOS) {
+            NodeInfo n;
+            for (size_t i = 0; i < totalNodos(); i++) {
+                if (lerNodo(i, &n) && n.id == no.id) no.posicao = i;
+            }
+        }
+        registrar_modelo(no, agora, x);
+
+        // Intervalo: normal, silencio de banda morta (interpola) ou acima do
+        // stale (nao interpola); sempre abaixo do despejo
+        uint32_t sorte = sorteio() % 20;
+        uint32_t intervalo = sorte == 0 ? 320000 + sorteio() % 100000
+                           : sorte < 4 ? 130000 + sorteio() % 150000
+                           : 15000 + sorteio() % 30000;
+        proxima[k] = agora + intervalo;
+    }
+
+    // Janelas em andamento vencem sem nova leitura
+    agora += 2 * AGREGACAO_JANELA_MS;
+    mock_relogio_definir_ms(agora);
+    for (NoModelo &no : nos) conferir_pendente(no, agora);
+
+    printf("%u janelas conferidas, %u pontos interpolados (gateway: %u)\n", (unsigned)s_janelas_conferidas,
+           (unsigned)s_interpolacoes, (unsigned)agregacao_interpolados());
+    CONFERIR(agregacao_interpolados() == s_interpolacoes);
+    CONFERIR(s_interpolacoes > 0);
+    return teste_fim();
+}
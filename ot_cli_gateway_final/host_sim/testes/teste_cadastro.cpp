@@ -0,0 +1,134 @@
+// ==================== TESTE DO CADASTRO E DA TABELA CHEIA ====================
+// Handshake do id curto pelo coap_cadastro_handler e pelo coap_handler
+// reais: o 2.04 traz o id (o mesmo para a mesma EUI-64, mesmo com outro
+// EID), lote com id desconhecido recebe 4.04 e lote com EID ganha id pelo
+// EID. O cadastro tem o dobro de ids da tabela de nós: com a tabela cheia o
+// cadastro ainda responde 2.04, mas o lote (com id ou EID) e o registro
+// legado recebem 5.03 e nada entra na tabela; depois do despejo dos nós
+// offline o mesmo lote entra. Cadastro cheio recebe 5.03, sem payload.
+
+#include "gateway_teste.hpp"
+#include "node_table.hpp"
+#include "esp_log.h"
+
+static uint64_t s_relogio_ms = 1000;
+
+static otCoapCode enviar(NoTeste &no, MockRespostaCoap *resposta)
+{
+    s_relogio_ms += 10;
+    mock_relogio_definir_ms(s_relogio_ms);
+    sensor_data_t d = {};
+    d.temperatura = 22.0f;
+    d.umidadeAr = 50.0f;
+    return no_teste_enviar(no, &d, 1, 0, NULL, resposta);
+}
+
+// Registro legado (SENSOR_REGISTRO_VERSAO): so o EID, sem cadastro
+static otCoapCode enviar_registro(NoTeste &no, MockRespostaCoap *resposta)
+{
+    sensor_data_t d = {};
+    d.temperatura = 23.0f;
+    uint8_t registro[SENSOR_REGISTRO_TAMANHO];
+    encode_sensor_record(&d, &no.eid, registro, sizeof(registro));
+    no_teste_pedir(no, "sensor", registro, sizeof(registro), 0, resposta);
+    return resposta->codigo;
+}
+
+static bool eid_do_id(uint16_t id, const otIp6Address &eid)
+{
+    char esperado[OT_IP6_ADDRESS_STRING_SIZE], visto[OT_IP6_ADDRESS_STRING_SIZE];
+    otIp6AddressToString(&eid, esperado, sizeof(esperado));
+    cadastro_eid_texto(id, visto, sizeof(visto));
+    return strcmp(esperado, visto) == 0;
+}
+
+int main()
+{
+    mock_log_nivel = ESP_LOG_NONE;
+    mock_relogio_definir_ms(s_relogio_ms);
+    gateway_teste_iniciar();
+    uint32_t k_no = 1;
+
+    // ==================== HANDSHAKE ====================
+    {
+        MockRespostaCoap resposta;
+        NoTeste a = no_teste(k_no++);
+        NoTeste b = no_teste(k_no++);
+        CONFERIR(no_teste_cadastrar(a, &resposta) == OT_COAP_CODE_CHANGED);
+        CONFERIR(resposta.payload_len >= SENSOR_ID_TAMANHO);
+        CONFERIR(no_teste_cadastrar(b, &resposta) == OT_COAP_CODE_CHANGED);
+        CONFERIR(a.id != CADASTRO_SEM_ID && b.id != CADASTRO_SEM_ID && a.id != b.id);
+
+        // Mesma EUI-64 com outro EID (nó que trocou de rede): mesmo id, EID novo
+        uint16_t id_a = a.id;
+        a.eid.mFields.m8[8] ^= 0x5a;
+        CONFERIR(no_teste_cadastrar(a, &resposta) == OT_COAP_CODE_CHANGED);
+        CONFERIR(a.id == id_a && eid_do_id(a.id, a.eid));
+
+        CONFERIR(enviar(a, &resposta) == OT_COAP_CODE_CHANGED);
+        CONFERIR(buscarNodo(a.id) != NULL);
+
+        // Id que o gateway nao conhece (NVS apagada): 4.04, o nó refaz o cadastro
+        NoTeste perdido = no_teste(k_no++);
+        perdido.id = CADASTRO_CAPACIDADE;
+        CONFERIR(enviar(perdido, &resposta) == OT_COAP_CODE_NOT_FOUND);
+        CONFERIR(buscarNodo(CADASTRO_CAPACIDADE) == NULL);
+
+        // Lote com EID (cadastro pendente): o id sai do cadastro pelo EID
+        NoTeste sem_id = no_teste(k_no++);
+        CONFERIR(enviar(sem_id, &resposta) == OT_COAP_CODE_CHANGED);
+        uint16_t id = cadastro_buscar_eid(sem_id.eid);
+        CONFERIR(id != CADASTRO_SEM_ID && buscarNodo(id) != NULL);
+    }
+
+    // ==================== TABELA DE NÓS CHEIA ====================
+    std::vector<NoTeste> nos;
+    while (totalNodos() < NODE_TABLE_CAPACIDADE) {
+        MockRespostaCoap resposta;
+        nos.push_back(no_teste(k_no++));
+        CONFERIR(no_teste_cadastrar(nos.back(), &resposta) == OT_COAP_CODE_CHANGED);
+        CONFERIR(enviar(nos.back(), &resposta) == OT_COAP_CODE_CHANGED);
+    }
+    {
+        MockRespostaCoap resposta;
+        NoTeste excedente = no_teste(k_no++);
+        CONFERIR(no_teste_cadastrar(excedente, &resposta) == OT_COAP_CODE_CHANGED);
+        CONFERIR(enviar(excedente, &resposta) == OT_COAP_CODE_SERVICE_UNAVAILABLE);
+        CONFERIR(resposta.payload_len == 0);
+        CONFERIR(buscarNodo(excedente.id) == NULL);
+
+        NoTeste so_eid = no_teste(k_no++);
+        CONFERIR(enviar(so_eid, &resposta) == OT_COAP_CODE_SERVICE_UNAVAILABLE);
+        NoTeste legado = no_teste(k_no++);
+        CONFERIR(enviar_registro(legado, &resposta) == OT_COAP_CODE_SERVICE_UNAVAILABLE);
+        CONFERIR(buscarNodo(cadastro_buscar_eid(so_eid.eid)) == NULL);
+        CONFERIR(buscarNodo(cadastro_buscar_eid(legado.eid)) == NULL);
+        CONFERIR(totalNodos() == NODE_TABLE_CAPACIDADE);
+
+        // Todos offline: o despejo libera as posicoes e o lote guardado entra
+        s_relogio_ms += NODO_OFFLINE_MS + 60000;
+        CONFERIR(enviar(excedente, &resposta) == OT_COAP_CODE_CHANGED);
+        CONFERIR(buscarNodo(excedente.id) != NULL);
+        CONFERIR(enviar(nos[0], &resposta) == OT_COAP_CODE_CHANGED);
+        CONFERIR(enviar_registro(legado, &resposta) == OT_COAP_CODE_CHANGED);
+    }
+
+    // ==================== CADASTRO CHEIO ====================
+    {
+        MockRespostaCoap resposta;
+        uint32_t novos = 0;
+        for (;;) {
+            NoTeste no = no_teste(k_no++);
+            if (no_teste_cadastrar(no, &resposta) != OT_COAP_CODE_CHANGED) break;
+            novos++;
+        }
+        CONFERIR(resposta.codigo == OT_COAP_CODE_SERVICE_UNAVAILABLE && resposta.payload_len == 0);
+        CONFERIR(cadastro_total() == CADASTRO_CAPACIDADE);
+        // Quem ja tem id continua recebendo o seu
+        uint16_t id = nos[1].id;
+        CONFERIR(no_teste_cadastrar(nos[1], &resposta) == OT_COAP_CODE_CHANGED && nos[1].id == id);
+        printf("%u nós na tabela, %u ids no cadastro (%u no fim)\n", (unsigned)NODE_TABLE_CAPACIDADE,
+               (unsigned)CADASTRO_CAPACIDADE, (unsigned)novos);
+    }
+    return teste_fim();
+}
@@ -0,0 +1,151 @@
+// ==================== TESTE DA HORA DA REDE ====================
+// A hora do gateway no payload dos ACKs 2.04, pelo coap_handler e pelo
+// coap_cadastro_handler reais: o cadastro traz o id seguido dela, o lote so
+// ela, e respostas de erro nao trazem nada. Amostra sem hora (nó recem
+// ligado) e carimbada com a chegada; com hora (nó ja acertado pelo ACK)
+// guarda a do nó, em segundos. O instante so vira texto no upload: o "d"
+// de cada item volta ao epoch da amostra (em segundos: o upload passa pelo
+// journal). O relogio de parede do gateway e
+// o do host (sincronizado), o virtual so separa as mids.
+
+#include "gateway_teste.hpp"
+#include "node_table.hpp"
+#include "esp_log.h"
+#include <map>
+#include <time.h>
+
+#define NOS          3
+#define AMOSTRAS     6
+
+static uint64_t s_relogio_ms = 1000;
+
+// Hora do ACK dentro do intervalo do pedido
+static int64_t hora_do_ack(const MockRespostaCoap &r, uint16_t antes, int64_t de, int64_t ate)
+{
+    CONFERIR(r.payload_len == antes + SENSOR_HORA_TAMANHO);
+    if (r.payload_len != antes + SENSOR_HORA_TAMANHO) return 0;
+    int64_t hora = decode_sensor_hora(r.payload + antes);
+    CONFERIR(hora >= de && hora <= ate);
+    return hora;
+}
+
+static otCoapCode enviar(NoTeste &no, const sensor_data_t *amostras, uint8_t n, MockRespostaCoap *resposta)
+{
+    static uint32_t seq = 0;
+    s_relogio_ms += 10;
+    mock_relogio_definir_ms(s_relogio_ms);
+    otCoapCode codigo = no_teste_enviar(no, amostras, n, seq, NULL, resposta);
+    seq += n;
+    return codigo;
+}
+
+int main()
+{
+    mock_log_nivel = ESP_LOG_NONE;
+    // O texto do upload e na hora local: fixa em UTC para comparar
+    setenv("TZ", "UTC0", 1);
+    tzset();
+    mock_relogio_definir_ms(s_relogio_ms);
+    gateway_teste_iniciar();
+
+    // Codec: int64 little-endian, acima dos 32 bits (ms de 2026)
+    {
+        uint8_t buf[SENSOR_HORA_TAMANHO];
+        int64_t hora = 1790000000123LL;
+        encode_sensor_hora(hora, buf);
+        CONFERIR(buf[0] == (uint8_t)hora && buf[4] == (uint8_t)(hora >> 32) && buf[7] == 0);
+        CONFERIR(decode_sensor_hora(buf) == hora);
+    }
+
+    // Cadastro: id e hora
+    std::vector<NoTeste> nos;
+    for (int k = 0; k < NOS; k++) {
+        MockRespostaCoap resposta;
+        nos.push_back(no_teste(k + 1));
+        int64_t de = sensor_agora_ms();
+        CONFERIR(no_teste_cadastrar(nos[k], &resposta) == OT_COAP_CODE_CHANGED);
+        hora_do_ack(resposta, SENSOR_ID_TAMANHO, de, sensor_agora_ms());
+        CONFERIR(nos[k].id != CADASTRO_SEM_ID);
+    }
+
+    // Nó 0 recem ligado: amostras sem hora valem a da chegada; o ACK acerta
+    // o relogio dele
+    std::map<uint16_t, std::vector<int64_t>> esperadas;
+    int64_t relogio_no = 0;
+    {
+        sensor_data_t d[2] = {};
+        d[0].temperatura = d[1].temperatura = 21.5f;
+        MockRespostaCoap resposta;
+        int64_t de = sensor_agora_ms();
+        CONFERIR(enviar(nos[0], d, 2, &resposta) == OT_COAP_CODE_CHANGED);
+        int64_t ate = sensor_agora_ms();
+        relogio_no = hora_do_ack(resposta, 0, de, ate);
+        const NodeInfo *n = buscarNodo(nos[0].id);
+        CONFERIR(n && n->dados.epoch_ms >= de && n->dados.epoch_ms <= ate);
+        // O upload passa pelo journal, que grava o registro binario (segundos)
+        if (n) esperadas[nos[0].id].assign(2, n->dados.epoch_ms / 1000 * 1000);
+    }
+
+    // Nós ja acertados: cada amostra leva o proprio instante (segundos no
+    // codec), inclusive um relogio de nó atrasado em relacao ao gateway
+    for (int k = 0; k < NOS; k++) {
+        sensor_data_t d[AMOSTRAS] = {};
+        for (int a = 0; a < AMOSTRAS; a++) {
+            d[a].temperatura = 20.0f + a;
+            d[a].epoch_ms = relogio_no - (int64_t)(AMOSTRAS - a) * 30000 - 86400000LL * k + 417;
+        }
+        MockRespostaCoap resposta;
+        int64_t de = sensor_agora_ms();
+        CONFERIR(enviar(nos[k], d, AMOSTRAS, &resposta) == OT_COAP_CODE_CHANGED);
+        hora_do_ack(resposta, 0, de, sensor_agora_ms());
+        const NodeInfo *n = buscarNodo(nos[k].id);
+        CONFERIR(n && n->dados.epoch_ms == d[AMOSTRAS - 1].epoch_ms / 1000 * 1000);
+        for (int a = 0; a < AMOSTRAS; a++) esperadas[nos[k].id].push_back(d[a].epoch_ms / 1000 * 1000);
+    }
+
+    // Erros sem hora: id desconhecido (4.04) e lote truncado (4.00)
+    {
+        MockRespostaCoap resposta;
+        NoTeste estranho = no_teste(99);
+        estranho.id = 777;
+        sensor_data_t d = {};
+        CONFERIR(enviar(estranho, &d, 1, &resposta) == OT_COAP_CODE_NOT_FOUND);
+        CONFERIR(resposta.payload_len == 0);
+
+        uint8_t truncado[SENSOR_LOTE_CABECALHO_ID];
+        encode_sensor_lote_cabecalho(nos[1].id, NULL, 3, truncado, sizeof(truncado));
+        s_relogio_ms += 10;
+        mock_relogio_definir_ms(s_relogio_ms);
+        no_teste_pedir(nos[1], "sensor", truncado, sizeof(truncado), 0, &resposta);
+        CONFERIR(resposta.codigo == OT_COAP_CODE_BAD_REQUEST && resposta.payload_len == 0);
+    }
+
+    // Upload: o "d" de cada leitura, em ordem por nó, volta ao epoch da amostra
+    ColetorHttp coletor;
+    if (!coletor_abrir(coletor)) return 2;
+    http_send_all_now();
+    coletor_encerrar(coletor);
+
+    std::map<uint16_t, std::vector<int64_t>> vistas;
+    for (const std::string &corpo : coletor.corpos) {
+        cJSON *raiz = cJSON_ParseWithLength(corpo.data(), corpo.size());
+        cJSON *item;
+        cJSON_ArrayForEach(item, raiz) {
+            if (!cJSON_IsNumber(cJSON_GetObjectItem(item, "t"))) continue;
+            const char *texto = cJSON_GetStringValue(cJSON_GetObjectItem(item, "d"));
+            const char *e = cJSON_GetStringValue(cJSON_GetObjectItem(item, "e"));
+            CONFERIR(texto && e);
+            if (!texto || !e) continue;
+            for (const NoTeste &no : nos) {
+                char eid[OT_IP6_ADDRESS_STRING_SIZE];
+                cadastro_eid_texto(no.id, eid, sizeof(eid));
+                if (strcmp(e, eid) == 0) vistas[no.id].push_back(texto_para_epoch_ms(texto));
+            }
+        }
+        cJSON_Delete(raiz);
+    }
+    for (const NoTeste &no : nos) CONFERIR(vistas[no.id] == esperadas[no.id]);
+
+    printf("%d nós, relogio acertado em %lld ms\n", NOS, (long long)relogio_no);
+    return teste_fim();
+}
@@ -0,0 +1,296 @@
+// ==================== TESTE DO CLIENTE HTTP ====================
+// HttpCliente contra um servidor local roteirizado (uma thread por
+// cenario): reuso da conexao keep-alive, pipelining com as respostas
+// coladas num write so, enquadramento por Content-Length com corpos
+// quebrados em pedacos arbitrarios e reconexao quando o servidor fecha.
+
+#include "teste.hpp"
+#include "http_client.hpp"
+#include "esp_log.h"
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+// ==================== SERVIDOR ROTEIRIZADO ====================
+struct Servidor {
+    int escuta = -1;
+    char porta[8] = {0};
+    std::thread thread;
+    std::vector<std::string> corpos;    // corpos recebidos, em ordem
+    int conexoes = 0;
+    std::atomic<bool> fechou{false};    // o roteiro fechou a conexao
+};
+
+// Um cenario que falha nao trava o teste: accept e recv desistem
+#define SERVIDOR_TIMEOUT_S 3
+
+static void definir_timeout(int fd)
+{
+    struct timeval timeout = {SERVIDOR_TIMEOUT_S, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+}
+
+static bool abrir(Servidor &s)
+{
+    s.escuta = socket(AF_INET, SOCK_STREAM, 0);
+    definir_timeout(s.escuta);
+    struct sockaddr_in end;
+    memset(&end, 0, sizeof(end));
+    end.sin_family = AF_INET;
+    end.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    end.sin_port = 0;   // porta livre qualquer
+    socklen_t len = sizeof(end);
+    if (bind(s.escuta, (struct sockaddr *)&end, sizeof(end)) != 0 || listen(s.escuta, 4) != 0 ||
+        getsockname(s.escuta, (struct sockaddr *)&end, &len) != 0) {
+        perror("servidor");
+        return false;
+    }
+    snprintf(s.porta, sizeof(s.porta), "%u", (unsigned)ntohs(end.sin_port));
+    return true;
+}
+
+static int aceitar(Servidor &s)
+{
+    int fd = accept(s.escuta, NULL, NULL);
+    if (fd >= 0) {
+        definir_timeout(fd);
+        s.conexoes++;
+    }
+    return fd;
+}
+
+// Le um pedido completo (cabecalho + Content-Length bytes); buf guarda o
+// que ja chegou do proximo. false se a conexao fechou antes.
+static bool ler_pedido(Servidor &s, int fd, std::string &buf)
+{
+    size_t fim;
+    char bloco[512];
+    while ((fim = buf.find("\r\n\r\n")) == std::string::npos) {
+        ssize_t r = recv(fd, bloco, sizeof(bloco), 0);
+        if (r <= 0) return false;
+        buf.append(bloco, r);
+    }
+    size_t cl = buf.find("Content-Length:");
+    size_t tamanho = (cl != std::string::npos && cl < fim) ? strtoul(buf.c_str() + cl + 15, NULL, 10) : 0;
+    while (buf.size() < fim + 4 + tamanho) {
+        ssize_t r = recv(fd, bloco, sizeof(bloco), 0);
+        if (r <= 0) return false;
+        buf.append(bloco, r);
+    }
+    s.corpos.push_back(buf.substr(fim + 4, tamanho));
+    buf.erase(0, fim + 4 + tamanho);
+    return true;
+}
+
+static void escrever(int fd, const std::string &dados)
+{
+    size_t enviado = 0;
+    while (enviado < dados.size()) {
+        ssize_t n = send(fd, dados.data() + enviado, dados.size() - enviado, MSG_NOSIGNAL);
+        if (n <= 0) return;
+        enviado += n;
+    }
+}
+
+static std::string resposta(int status, const std::string &corpo, const char *extra = "")
+{
+    char cab[160];
+    snprintf(cab, sizeof(cab), "HTTP/1.1 %d X\r\nContent-Length: %u\r\n%s\r\n", status,
+             (unsigned)corpo.size(), extra);
+    return cab + corpo;
+}
+
+static void iniciar(Servidor &s, std::function<void(Servidor &)> roteiro)
+{
+    s.thread = std::thread([&s, roteiro]() { roteiro(s); });
+}
+
+static void encerrar(Servidor &s)
+{
+    s.thread.join();
+    close(s.escuta);
+}
+
+// ==================== CENARIOS ====================
+static void keep_alive()
+{
+    Servidor s;
+    if (!abrir(s)) return;
+    iniciar(s, [](Servidor &s) {
+        int fd = aceitar(s);
+        std::string buf;
+        for (int k = 0; k < 3 && ler_pedido(s, fd, buf); k++) {
+            escrever(fd, resposta(200, "ok"));
+        }
+        close(fd);
+    });
+
+    HttpCliente cliente("127.0.0.1", s.porta);
+    int status = 0;
+    CONFERIR(cliente.post("/x", "{\"a\":1}", "gw", "application/json", &status));
+    CONFERIR(status == 200);
+    CONFERIR(cliente.post("/x", "{\"a\":2}", "gw"));
+    CONFERIR(cliente.post("/x", "{\"a\":3}", "gw"));
+    const HttpEstatisticas &e = cliente.estatisticas();
+    CONFERIR(e.conexoes_novas == 1);
+    CONFERIR(e.conexoes_reusadas == 2);
+    CONFERIR(e.dns_consultas == 1);
+    CONFERIR(e.requisicoes == 3 && e.falhas == 0);
+    cliente.fechar();
+    encerrar(s);
+
+    CONFERIR(s.conexoes == 1);
+    CONFERIR(s.corpos.size() == 3 && s.corpos[2] == "{\"a\":3}");
+}
+
+// Todas as respostas num write so: o cliente separa pelo Content-Length
+static void pipeline()
+{
+    const size_t n = HTTP_MAX_PIPELINE + 4;     // dois lotes
+    Servidor s;
+    if (!abrir(s)) return;
+    iniciar(s, [n](Servidor &s) {
+        int fd = aceitar(s);
+        std::string buf;
+        size_t atendidos = 0;
+        while (atendidos < n) {
+            // Le o lote inteiro antes de responder (o cliente nao espera)
+            size_t lote = std::min((size_t)HTTP_MAX_PIPELINE, n - atendidos);
+            std::string respostas;
+            for (size_t k = 0; k < lote && ler_pedido(s, fd, buf); k++) {
+                // Um 503 no meio nao desalinha as demais
+                respostas += resposta(atendidos + k == 5 ? 503 : 200, "corpo-" + std::to_string(atendidos + k));
+            }
+            escrever(fd, respostas);
+            atendidos += lote;
+        }
+        close(fd);
+    });
+
+    std::vector<std::string> corpos;
+    std::vector<const char *> ponteiros;
+    for (size_t k = 0; k < n; k++) corpos.push_back("{\"k\":" + std::to_string(k) + "}");
+    for (auto &c : corpos) ponteiros.push_back(c.c_str());
+
+    HttpCliente cliente("127.0.0.1", s.porta);
+    size_t aceitos = cliente.post_pipeline("/x", ponteiros.data(), n, "gw");
+    CONFERIR(aceitos == n - 1);
+    CONFERIR(cliente.estatisticas().conexoes_novas == 1);
+    CONFERIR(cliente.estatisticas().falhas == 1);
+    cliente.fechar();
+    encerrar(s);
+
+    CONFERIR(s.corpos == corpos);
+}
+
+// Respostas quebradas em pedacos de 1..7 bytes, com o fim de uma e o
+// comeco da proxima no mesmo pedaco
+static void content_length()
+{
+    const int n = 6;
+    Servidor s;
+    if (!abrir(s)) return;
+    iniciar(s, [](Servidor &s) {
+        int fd = aceitar(s);
+        std::string buf;
+        std::string respostas;
+        for (int k = 0; k < n && ler_pedido(s, fd, buf); k++) {
+            std::string corpo(k * 97, (char)('a' + k));   // 0 .. 485 bytes
+            respostas += resposta(k == 3 ? 404 : 201, corpo, "Connection: keep-alive\r\n");
+        }
+        size_t pos = 0, passo = 1;
+        while (pos < respostas.size()) {
+            size_t len = std::min(passo, respostas.size() - pos);
+            escrever(fd, respostas.substr(pos, len));
+            pos += len;
+            passo = passo % 7 + 1;
+            usleep(50);
+        }
+        // Conexao segue aberta: um corpo lido a mais travaria aqui
+        ler_pedido(s, fd, buf);
+        escrever(fd, resposta(200, ""));
+        close(fd);
+    });
+
+    std::vector<std::string> corpos(n, "{}");
+    std::vector<const char *> ponteiros;
+    for (auto &c : corpos) ponteiros.push_back(c.c_str());
+
+    HttpCliente cliente("127.0.0.1", s.porta);
+    CONFERIR(cliente.post_pipeline("/x", ponteiros.data(), n, "gw") == n - 1);
+    int status = 0;
+    CONFERIR(cliente.post("/x", "{}", "gw", "application/json", &status));
+    CONFERIR(status == 200);
+    CONFERIR(cliente.estatisticas().conexoes_novas == 1);
+    cliente.fechar();
+    encerrar(s);
+}
+
+// O servidor fecha a conexao ociosa (sem avisar) e depois com
+// "Connection: close": o cliente reconecta e reenvia uma vez
+static void reconexao()
+{
+    Servidor s;
+    if (!abrir(s)) return;
+    iniciar(s, [](Servidor &s) {
+        std::string buf;
+        int fd = aceitar(s);
+        ler_pedido(s, fd, buf);
+        escrever(fd, resposta(200, "ok"));
+        close(fd);
+        s.fechou = true;
+
+        fd = aceitar(s);
+        buf.clear();
+        ler_pedido(s, fd, buf);
+        escrever(fd, resposta(200, "ok", "Connection: close\r\n"));
+        // O cliente precisa fechar sozinho: nada mais chega aqui
+        char c;
+        CONFERIR(recv(fd, &c, 1, 0) == 0);
+        close(fd);
+
+        fd = aceitar(s);
+        buf.clear();
+        ler_pedido(s, fd, buf);
+        escrever(fd, resposta(200, "ok"));
+        close(fd);
+    });
+
+    HttpCliente cliente("127.0.0.1", s.porta);
+    CONFERIR(cliente.post("/x", "{\"n\":1}", "gw"));
+    for (int k = 0; k < 1000 && !s.fechou; k++) usleep(1000);
+    usleep(10000);      // o FIN chega ao socket do cliente
+
+    // Conexao reusada morta: reenvio numa nova
+    CONFERIR(cliente.post("/x", "{\"n\":2}", "gw"));
+    // Depois do Connection: close, conexao nova sem tentativa perdida
+    CONFERIR(cliente.post("/x", "{\"n\":3}", "gw"));
+    const HttpEstatisticas &e = cliente.estatisticas();
+    CONFERIR(e.conexoes_novas == 3);
+    CONFERIR(e.requisicoes == 3 && e.falhas == 0);
+    CONFERIR(e.dns_consultas == 1);
+    cliente.fechar();
+    encerrar(s);
+
+    CONFERIR(s.conexoes == 3);
+    CONFERIR(s.corpos.size() == 3 && s.corpos[1] == "{\"n\":2}");
+}
+
+int main()
+{
+    mock_log_nivel = ESP_LOG_NONE;
+    keep_alive();
+    pipeline();
+    content_length();
+    reconexao();
+    return teste_fim();
+}
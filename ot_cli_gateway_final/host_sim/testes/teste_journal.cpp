@@ -0,0 +1,243 @@
+// ==================== TESTE DO JOURNAL COM QUEDAS DE ENERGIA ====================
+// O Journal sobre uma flash em RAM (escrita so zera bits, apagar volta para
+// 0xff) que "desliga" no meio de uma escrita ou de um apagamento, depois de
+// um numero sorteado de bytes. Cada vida anexa amostras e simula envios
+// (aceitos ou recusados pelo servidor) ate a queda; a seguinte remonta a
+// mesma flash. Confere:
+//  - nada some em silencio: amostra anexada com sucesso foi entregue ou
+//    esta nas perdidas contadas pelo journal;
+//  - confirmacao gravada nao volta: amostra confirmada nao e entregue de novo;
+//  - ordem de escrita e conteudo intacto (slots cortados ficam de fora);
+//  - sem quedas, perdidas exatas (log cheio com o servidor recusando).
+
+#include "teste.hpp"
+#include "journal.hpp"
+#include "esp_log.h"
+#include <random>
+#include <set>
+#include <vector>
+#include <string.h>
+
+#define SETORES       4             // log pequeno: da a volta varias vezes
+#define VIDAS         400
+#define PASSOS_SEM_QUEDA 20000
+
+// ==================== FLASH QUE DESLIGA ====================
+struct FlashTeste {
+    std::vector<uint8_t> dados;
+    size_t orcamento;       // bytes que ainda podem ser gravados/apagados
+    bool desligada;
+    std::minstd_rand *sorteio;
+};
+
+// Gasta o orcamento; retorna quantos dos len bytes chegam a flash
+static size_t consumir(FlashTeste &f, size_t len)
+{
+    if (f.desligada) return 0;
+    if (len <= f.orcamento) {
+        f.orcamento -= len;
+        return len;
+    }
+    size_t feitos = f.orcamento;
+    f.orcamento = 0;
+    f.desligada = true;
+    return feitos;
+}
+
+static bool flash_ler(void *ctx, size_t offset, void *buf, size_t len)
+{
+    FlashTeste &f = *(FlashTeste *)ctx;
+    if (f.desligada || offset + len > f.dados.size()) return false;
+    memcpy(buf, &f.dados[offset], len);
+    return true;
+}
+
+static bool flash_escrever(void *ctx, size_t offset, const void *buf, size_t len)
+{
+    FlashTeste &f = *(FlashTeste *)ctx;
+    if (offset + len > f.dados.size()) return false;
+    size_t feitos = consumir(f, len);
+    const uint8_t *p = (const uint8_t *)buf;
+    for (size_t i = 0; i < feitos; i++) {
+        f.dados[offset + i] &= p[i];
+    }
+    return feitos == len;
+}
+
+// Apagamento cortado: so um prefixo sorteado do setor volta a 0xff
+static bool flash_apagar(void *ctx, size_t offset)
+{
+    FlashTeste &f = *(FlashTeste *)ctx;
+    if (f.desligada || offset % JOURNAL_SETOR_TAMANHO || offset + JOURNAL_SETOR_TAMANHO > f.dados.size()) {
+        return false;
+    }
+    size_t feitos = JOURNAL_SETOR_TAMANHO;
+    if (consumir(f, JOURNAL_SETOR_TAMANHO) < JOURNAL_SETOR_TAMANHO) {
+        feitos = (*f.sorteio)() % JOURNAL_SETOR_TAMANHO;
+    }
+    memset(&f.dados[offset], 0xff, feitos);
+    return feitos == JOURNAL_SETOR_TAMANHO;
+}
+
+static JournalFlash flash_de(FlashTeste &f)
+{
+    JournalFlash j = { &f, f.dados.size(), flash_ler, flash_escrever, flash_apagar };
+    return j;
+}
+
+// ==================== AMOSTRAS E CONTABILIDADE ====================
+// Registro com o id da amostra nos 4 primeiros bytes e o resto derivado dele
+static void registro_de(uint32_t id, uint8_t *r)
+{
+    memcpy(r, &id, sizeof(id));
+    for (size_t k = sizeof(id); k < SENSOR_REGISTRO_TAMANHO; k++) {
+        r[k] = (uint8_t)(id * 31 + k);
+    }
+}
+
+struct Contabilidade {
+    uint32_t proximo_id = 0;
+    std::set<uint32_t> anexadas;        // anexar() retornou true
+    std::set<uint32_t> tentadas;        // inclui as cortadas no meio
+    std::set<uint32_t> entregues;       // aceitas pelo "servidor"
+    std::set<uint32_t> confirmadas;     // confirmar() gravou depois da entrega
+    uint32_t reentregas = 0;
+    uint32_t perdidas = 0;              // soma das estatisticas de cada vida
+    uint32_t corrompidos = 0;
+};
+
+static void anexar(Journal &j, Contabilidade &c)
+{
+    uint8_t r[SENSOR_REGISTRO_TAMANHO];
+    uint32_t id = c.proximo_id++;
+    registro_de(id, r);
+    c.tentadas.insert(id);
+    if (j.anexar(r)) c.anexadas.insert(id);
+}
+
+// Um envio: le ate max pendentes; se o servidor aceita, entrega e confirma
+static size_t enviar(Journal &j, Contabilidade &c, size_t max, bool aceito)
+{
+    static uint8_t lote[64][SENSOR_REGISTRO_TAMANHO];
+    uint32_t ate = 0;
+    size_t n = j.ler_pendentes(lote, max, &ate);
+    if (n == 0 || !aceito) return n;
+
+    std::vector<uint32_t> ids;
+    for (size_t k = 0; k < n; k++) {
+        uint32_t id;
+        uint8_t esperado[SENSOR_REGISTRO_TAMANHO];
+        memcpy(&id, lote[k], sizeof(id));
+        registro_de(id, esperado);
+        CONFERIR(memcmp(lote[k], esperado, sizeof(esperado)) == 0);
+        CONFERIR(c.tentadas.count(id) == 1);
+        CONFERIR(c.confirmadas.count(id) == 0);
+        if (k > 0) CONFERIR(id > ids.back());
+        if (!c.entregues.insert(id).second) c.reentregas++;
+        ids.push_back(id);
+    }
+    if (j.confirmar(ate)) {
+        c.confirmadas.insert(ids.begin(), ids.end());
+    }
+    return n;
+}
+
+// Amostras anexadas que nunca chegaram ao servidor
+static uint32_t faltando(const Contabilidade &c)
+{
+    uint32_t n = 0;
+    for (uint32_t id : c.anexadas) {
+        if (!c.entregues.count(id)) n++;
+    }
+    return n;
+}
+
+static void esvaziar(Journal &j, Contabilidade &c)
+{
+    while (enviar(j, c, 64, true) > 0) {}
+    CONFERIR(j.pendentes() == 0);
+}
+
+// ==================== CENARIOS ====================
+// Poucos envios e o servidor recusando 80% deles: o log enche e recicla setores com
+// amostras pendentes e com leituras em aberto. Sem quedas a conta fecha exata.
+static void log_cheio_sem_quedas()
+{
+    std::minstd_rand sorteio(7);
+    FlashTeste f = { std::vector<uint8_t>(SETORES * JOURNAL_SETOR_TAMANHO, 0xff), SIZE_MAX, false, &sorteio };
+    Journal j;
+    Contabilidade c;
+    CONFERIR(j.montar(flash_de(f)));
+
+    for (int passo = 0; passo < PASSOS_SEM_QUEDA; passo++) {
+        if (sorteio() % 20 != 0) anexar(j, c);
+        else enviar(j, c, 1 + sorteio() % 64, sorteio() % 5 == 0);
+    }
+    esvaziar(j, c);
+
+    const JournalEstatisticas &e = j.estatisticas();
+    CONFERIR(c.anexadas.size() == c.tentadas.size());
+    CONFERIR(e.perdidas > 0);
+    CONFERIR(c.reentregas == 0);
+    CONFERIR(e.perdidas == faltando(c));
+    CONFERIR(c.entregues.size() + e.perdidas == c.anexadas.size());
+}
+
+static void quedas_de_energia()
+{
+    std::minstd_rand sorteio(11);
+    FlashTeste f = { std::vector<uint8_t>(SETORES * JOURNAL_SETOR_TAMANHO, 0xff), 0, false, &sorteio };
+    Contabilidade c;
+
+    for (int vida = 0; vida <= VIDAS; vida++) {
+        // A ultima vida nao cai: esvazia o que sobrou
+        bool ultima = vida == VIDAS;
+        f.desligada = false;
+        f.orcamento = ultima ? SIZE_MAX : 1 + sorteio() % (6 * JOURNAL_SETOR_TAMANHO);
+
+        Journal j;
+        bool montou = j.montar(flash_de(f));
+        if (montou) {
+            c.corrompidos += j.estatisticas().slots_corrompidos;
+            // Quem ja foi confirmado nao pode voltar como pendente
+            if (!c.confirmadas.empty()) {
+                uint8_t r[1][SENSOR_REGISTRO_TAMANHO];
+                uint32_t ate;
+                if (j.ler_pendentes(r, 1, &ate) == 1) {
+                    uint32_t id;
+                    memcpy(&id, r[0], sizeof(id));
+                    CONFERIR(c.confirmadas.count(id) == 0);
+                }
+            }
+            if (ultima) {
+                esvaziar(j, c);
+            } else {
+                while (!f.desligada) {
+                    if (sorteio() % 10 != 0) anexar(j, c);
+                    else enviar(j, c, 1 + sorteio() % 16, sorteio() % 2 == 0);
+                }
+            }
+        } else {
+            CONFERIR(f.desligada);  // so falha montar se caiu durante a formatacao
+        }
+        c.perdidas += j.estatisticas().perdidas;
+    }
+
+    printf("quedas: %d vidas, %zu anexadas, %zu entregues, %u reentregas, %u perdidas, %u slots cortados\n",
+           VIDAS, c.anexadas.size(), c.entregues.size(), (unsigned)c.reentregas, (unsigned)c.perdidas,
+           (unsigned)c.corrompidos);
+
+    // Sem perda silenciosa: o que falta foi contado (a contagem pode passar:
+    // uma queda antes do apagamento deixa na flash o que ja foi contado)
+    CONFERIR(faltando(c) <= c.perdidas);
+    CONFERIR(c.corrompidos > 0);
+    CONFERIR(c.confirmadas.size() > 0);
+}
+
+int main()
+{
+    mock_log_nivel = ESP_LOG_NONE;
+    log_cheio_sem_quedas();
+    quedas_de_energia();
+    return teste_fim();
+}
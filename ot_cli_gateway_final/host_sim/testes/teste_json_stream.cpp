@@ -0,0 +1,339 @@
+// ==================== TESTE DO DECODIFICADOR JSON INCREMENTAL ====================
+// DecodificadorJsonSensor (sensor_json_stream) contra o cJSON:
+//  - diferencial: payloads validos gerados (chaves em qualquer ordem,
+//    chaves desconhecidas com valores aninhados, numeros em varios
+//    formatos, strings longas) entregues em pedacos de tamanho sorteado;
+//    campos, valores e o "e"/"d" truncados tem de bater com o cJSON;
+//  - mutacoes: bytes trocados, trechos apagados/duplicados e cortes, so
+//    para nao estourar nada (o alvo compila com ASan/UBSan);
+//  - casos de borda: aninhamento acima do limite, numero longo demais,
+//    payload maior que o buffer antigo de 256 bytes.
+// Com --vazao mede us/mensagem do decodificador (pedacos de 32 bytes, como
+// o otMessageRead do handler) contra cJSON_Parse + busca dos campos.
+
+#include "teste.hpp"
+#include "sensor_json_stream.hpp"
+#include "sensor_codec.hpp"
+#include "cJSON.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <string.h>
+
+#define DIFERENCIAIS 50000
+#define MUTACOES     100000
+#define VAZAO_MENSAGENS 500000
+
+static std::mt19937 s_sorteio(2024);
+static volatile float s_descarte;   // segura os resultados da medida de vazao
+
+static uint32_t sortear(uint32_t n)
+{
+    return s_sorteio() % n;
+}
+
+// ==================== GERADOR ====================
+static std::string espacos()
+{
+    static const char *opcoes[] = { "", "", "", " ", "\n", "\t ", "\r\n  " };
+    return opcoes[sortear(7)];
+}
+
+static std::string numero()
+{
+    char buf[48];
+    switch (sortear(6)) {
+    case 0: snprintf(buf, sizeof(buf), "%d", (int)sortear(2000) - 1000); break;
+    case 1: snprintf(buf, sizeof(buf), "%.*f", 1 + (int)sortear(6), (sortear(200000) - 100000) / 997.0); break;
+    case 2: snprintf(buf, sizeof(buf), "%.3e", (sortear(200000) - 100000) / 13.0); break;
+    case 3: snprintf(buf, sizeof(buf), "%dE-%u", (int)sortear(99999), sortear(4)); break;
+    case 4: snprintf(buf, sizeof(buf), "%u.%02ue+%u", sortear(100), sortear(100), sortear(3)); break;
+    default: snprintf(buf, sizeof(buf), "-0.%06u", sortear(1000000)); break;
+    }
+    return buf;
+}
+
+// Conteudo de string sem escapes que o decodificador guarda diferente do
+// cJSON (\n, \uXXXX viram a letra); \" \\ \/ sao iguais nos dois
+static std::string texto(size_t max)
+{
+    static const char alfabeto[] = "abcdef0123456789:-.TZ ";
+    std::string s;
+    size_t n = sortear((uint32_t)max + 1);
+    for (size_t k = 0; k < n; k++) {
+        switch (sortear(40)) {
+        case 0: s += "\\\""; break;
+        case 1: s += "\\\\"; break;
+        case 2: s += "\\/"; break;
+        default: s += alfabeto[sortear(sizeof(alfabeto) - 1)]; break;
+        }
+    }
+    return s;
+}
+
+static std::string valor_qualquer(int profundidade)
+{
+    switch (sortear(profundidade < 5 ? 7 : 4)) {
+    case 0: return numero();
+    case 1: return "\"" + texto(30) + (sortear(2) ? "\\n\\u00e9\\t" : "") + "\"";
+    case 2: { static const char *l[] = { "true", "false", "null" }; return l[sortear(3)]; }
+    case 3: return "\"" + texto(300) + "\"";
+    case 4:
+    case 5: {
+        std::string s = "[" + espacos();
+        uint32_t n = sortear(4);
+        for (uint32_t k = 0; k < n; k++) {
+            if (k) s += "," + espacos();
+            s += valor_qualquer(profundidade + 1);
+        }
+        return s + espacos() + "]";
+    }
+    default: {
+        std::string s = "{" + espacos();
+        uint32_t n = sortear(4);
+        for (uint32_t k = 0; k < n; k++) {
+            if (k) s += "," + espacos();
+            s += "\"k" + std::to_string(k) + "\"" + espacos() + ":" + espacos() + valor_qualquer(profundidade + 1);
+        }
+        return s + espacos() + "}";
+    }
+    }
+}
+
+// Valor de outro tipo para uma chave conhecida (ignorado pelos dois)
+static std::string valor_tipo_errado(bool numerica)
+{
+    switch (sortear(4)) {
+    case 0: return numerica ? "\"" + texto(10) + "\"" : numero();
+    case 1: { static const char *l[] = { "true", "false", "null" }; return l[sortear(3)]; }
+    case 2: return "[" + valor_qualquer(3) + "]";
+    default: return "{\"k\":" + valor_qualquer(3) + "}";
+    }
+}
+
+static std::string data_hora()
+{
+    char buf[48];
+    if (sortear(8) == 0) return texto(40);     // lixo ou longo demais
+    snprintf(buf, sizeof(buf), "%04u-%02u-%02uT%02u:%02u:%02u.%03uZ", 1970 + sortear(100), 1 + sortear(12),
+             1 + sortear(28), sortear(24), sortear(60), sortear(60), sortear(1000));
+    return buf;
+}
+
+static std::string gerar_payload()
+{
+    static const char *conhecidas[] = { "e", "d", "t", "uA", "uS", "p" };
+    static const char *desconhecidas[] = { "x", "tt", "T", "uAr", "ee", "temp", "a\\\"b", "q", "m" };
+
+    std::vector<std::string> membros;
+    for (const char *c : conhecidas) {
+        if (sortear(5) == 0) continue;
+        std::string v;
+        bool numerica = strcmp(c, "e") != 0 && strcmp(c, "d") != 0;
+        if (sortear(15) == 0) v = valor_tipo_errado(numerica);
+        else if (numerica) v = numero();
+        else if (c[0] == 'd') v = "\"" + data_hora() + "\"";
+        else v = "\"" + (sortear(6) ? std::string("fd00::") + texto(20) : texto(60)) + "\"";
+        membros.push_back("\"" + std::string(c) + "\"" + espacos() + ":" + espacos() + v);
+    }
+    uint32_t extras = sortear(4);
+    for (uint32_t k = 0; k < extras; k++) {
+        membros.push_back("\"" + std::string(desconhecidas[sortear(9)]) + std::to_string(k) + "\"" + espacos() +
+                          ":" + espacos() + valor_qualquer(0));
+    }
+    std::shuffle(membros.begin(), membros.end(), s_sorteio);
+
+    std::string s = espacos() + "{" + espacos();
+    for (size_t k = 0; k < membros.size(); k++) {
+        if (k) s += espacos() + "," + espacos();
+        s += membros[k];
+    }
+    return s + espacos() + "}" + espacos();
+}
+
+// Alimenta em pedacos de 1..max bytes
+static bool alimentar_picado(DecodificadorJsonSensor &d, const std::string &s, size_t max)
+{
+    bool ok = true;
+    for (size_t pos = 0; pos < s.size();) {
+        size_t n = std::min((size_t)1 + sortear((uint32_t)max), s.size() - pos);
+        ok = d.alimentar(s.data() + pos, n);
+        pos += n;
+    }
+    return ok;
+}
+
+// ==================== DIFERENCIAL ====================
+static bool mesmo_float(float a, double esperado)
+{
+    float b = (float)esperado;
+    return a == b || fabsf(a - b) <= 1e-6f * fabsf(b);
+}
+
+static std::string truncado(const char *s, size_t cap)
+{
+    return std::string(s).substr(0, cap - 1);
+}
+
+static void diferencial(const std::string &payload)
+{
+    cJSON *raiz = cJSON_Parse(payload.c_str());
+    CONFERIR(raiz != NULL);
+    if (!raiz) return;
+
+    sensor_data_t dados;
+    DecodificadorJsonSensor d(&dados);
+    bool ok = alimentar_picado(d, payload, 1 + sortear(64));
+    CONFERIR(ok && d.concluir());
+
+    struct { const char *chave; uint32_t campo; float *valor; } numericos[] = {
+        { "t", JSON_CAMPO_TEMPERATURA, &dados.temperatura },
+        { "uA", JSON_CAMPO_UMIDADE_AR, &dados.umidadeAr },
+        { "uS", JSON_CAMPO_UMIDADE_SOLO, &dados.umidadeSolo },
+        { "p", JSON_CAMPO_PARTICULAS, &dados.particulas },
+    };
+    uint32_t esperados = 0;
+    bool iguais = true;
+    for (auto &n : numericos) {
+        const cJSON *item = cJSON_GetObjectItemCaseSensitive(raiz, n.chave);
+        if (cJSON_IsNumber(item)) {
+            esperados |= n.campo;
+            iguais &= mesmo_float(*n.valor, item->valuedouble);
+        }
+    }
+    const cJSON *e = cJSON_GetObjectItemCaseSensitive(raiz, "e");
+    if (cJSON_IsString(e)) {
+        esperados |= JSON_CAMPO_ENDERECO;
+        iguais &= truncado(e->valuestring, OT_IP6_ADDRESS_STRING_SIZE) == d.endereco();
+    }
+    const cJSON *dh = cJSON_GetObjectItemCaseSensitive(raiz, "d");
+    if (cJSON_IsString(dh)) {
+        esperados |= JSON_CAMPO_DATA_HORA;
+        iguais &= texto_para_epoch_ms(truncado(dh->valuestring, 32).c_str()) == dados.epoch_ms;
+    }
+    CONFERIR(d.campos() == esperados);
+    CONFERIR(iguais);
+    if (d.campos() != esperados || !iguais) fprintf(stderr, "payload: %s\n", payload.c_str());
+    cJSON_Delete(raiz);
+}
+
+// ==================== MUTACOES ====================
+static void mutar(std::string &s)
+{
+    static const char sintaxe[] = "{}[]\",:\\-.eE0123456789 tfn";
+    uint32_t n = 1 + sortear(4);
+    for (uint32_t k = 0; k < n && !s.empty(); k++) {
+        size_t pos = sortear((uint32_t)s.size());
+        switch (sortear(5)) {
+        case 0: s[pos] = (char)sortear(256); break;
+        case 1: s[pos] = sintaxe[sortear(sizeof(sintaxe) - 1)]; break;
+        case 2: s.erase(pos, 1 + sortear(8)); break;
+        case 3: s.insert(pos, s.substr(pos, 1 + sortear(16))); break;
+        default: s.resize(pos); break;
+        }
+    }
+}
+
+static void mutacao(const std::string &payload)
+{
+    std::string s = payload;
+    mutar(s);
+    sensor_data_t dados;
+    DecodificadorJsonSensor d(&dados);
+    bool ok = alimentar_picado(d, s, 1 + sortear(64));
+    // Erro e definitivo e os textos sempre terminam dentro do campo
+    if (!ok) CONFERIR(!d.alimentar("}", 1) && !d.concluir());
+    CONFERIR(strlen(d.endereco()) < OT_IP6_ADDRESS_STRING_SIZE);
+}
+
+// ==================== CASOS DE BORDA ====================
+static void casos_de_borda()
+{
+    sensor_data_t dados;
+
+    // Aninhamento no limite passa, acima dele e erro
+    std::string fundo(JSON_PROFUNDIDADE_MAX, '['), fecha(JSON_PROFUNDIDADE_MAX, ']');
+    DecodificadorJsonSensor limite(&dados);
+    std::string ok = "{\"x\":" + fundo + fecha + ",\"t\":1.5}";
+    CONFERIR(limite.alimentar(ok.data(), ok.size()) && limite.concluir() && dados.temperatura == 1.5f);
+    DecodificadorJsonSensor acima(&dados);
+    std::string fundo_demais = "{\"x\":" + fundo + "[]" + fecha + "}";
+    CONFERIR(!acima.alimentar(fundo_demais.data(), fundo_demais.size()));
+
+    // Numero maior que o buffer de digitos
+    DecodificadorJsonSensor longo(&dados);
+    std::string n = "{\"t\":1." + std::string(40, '5') + "}";
+    CONFERIR(!longo.alimentar(n.data(), n.size()));
+
+    // Antes, o payload era copiado para 256 bytes e truncado
+    DecodificadorJsonSensor grande(&dados);
+    std::string g = "{\"x\":\"" + std::string(1000, 'a') + "\",\"e\":\"fd00::1\",\"uS\":40.25}";
+    CONFERIR(grande.alimentar(g.data(), g.size()) && grande.concluir());
+    CONFERIR(grande.campos() == (JSON_CAMPO_ENDERECO | JSON_CAMPO_UMIDADE_SOLO));
+    CONFERIR(strcmp(grande.endereco(), "fd00::1") == 0 && dados.umidadeSolo == 40.25f);
+
+    // Data fora da faixa vira 0 (o ano ia estourar a conta dos dias)
+    DecodificadorJsonSensor data(&dados);
+    const char *d = "{\"d\":\"50855-13-01T00:00:00\"}";
+    CONFERIR(data.alimentar(d, strlen(d)) && data.concluir() && dados.epoch_ms == 0);
+
+    // Lixo depois do objeto
+    DecodificadorJsonSensor resto(&dados);
+    CONFERIR(!resto.alimentar("{} x", 4));
+}
+
+// ==================== VAZAO ====================
+static int vazao()
+{
+    static const char payload[] =
+        "{\"e\":\"fd00:0:0:0:1234:5678:9abc:def0\",\"d\":\"2025-03-01T12:34:56.789Z\","
+        "\"t\":23.45,\"uA\":61.2,\"uS\":40.5,\"p\":412.7}";
+    const size_t len = sizeof(payload) - 1;
+    sensor_data_t dados;
+    float soma = 0;
+
+    auto inicio = std::chrono::steady_clock::now();
+    for (int k = 0; k < VAZAO_MENSAGENS; k++) {
+        DecodificadorJsonSensor d(&dados);
+        for (size_t pos = 0; pos < len; pos += 32) {
+            d.alimentar(payload + pos, std::min((size_t)32, len - pos));
+        }
+        soma += dados.temperatura;
+    }
+    double stream_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - inicio).count();
+
+    inicio = std::chrono::steady_clock::now();
+    for (int k = 0; k < VAZAO_MENSAGENS; k++) {
+        cJSON *raiz = cJSON_Parse(payload);
+        static const char *chaves[] = { "e", "d", "t", "uA", "uS", "p" };
+        for (const char *c : chaves) {
+            const cJSON *item = cJSON_GetObjectItemCaseSensitive(raiz, c);
+            if (cJSON_IsNumber(item)) soma += (float)item->valuedouble;
+        }
+        cJSON_Delete(raiz);
+    }
+    double cjson_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - inicio).count();
+
+    s_descarte = soma;
+    printf("payload de %zu bytes: decodificador %.3f us/msg, cJSON %.3f us/msg\n", len,
+           stream_us / VAZAO_MENSAGENS, cjson_us / VAZAO_MENSAGENS);
+    CONFERIR(dados.temperatura == 23.45f && dados.particulas == 412.7f);
+    return teste_fim();
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "--vazao") == 0) return vazao();
+
+    casos_de_borda();
+    for (int k = 0; k < DIFERENCIAIS; k++) {
+        diferencial(gerar_payload());
+    }
+    for (int k = 0; k < MUTACOES; k++) {
+        mutacao(gerar_payload());
+    }
+    return teste_fim();
+}
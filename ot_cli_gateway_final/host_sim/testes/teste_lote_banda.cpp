@@ -0,0 +1,288 @@
+// ==================== TESTE DO LOTE NA RTC E DA BANDA MORTA DO NÓ ====================
+// lote.c, banda.c e sensor_codec.c do ot_cli_nos_final com o sdkconfig
+// padrao do nó (mock_no/), no mesmo caminho do coap_amostrar: banda_avaliar,
+// e fora da banda (ou no heartbeat) banda_aceitar + lote_registrar. Sinais
+// estaveis, com deriva, com saltos e cruzando o alarme de temperatura, e um
+// gateway que some por longos trechos (anel cheio sobrescreve). Conferido:
+//  - o motivo de cada wake e a decisao de enviar contra o modelo;
+//  - a amostra suprimida esta dentro da banda da ultima aceita e nunca
+//    passa um heartbeat sem amostra aceita;
+//  - o payload do lote decodifica nas amostras pendentes, em ordem, com a
+//    sequencia da mais antiga;
+//  - toda sequencia gerada chega uma vez ao gateway ou foi sobrescrita.
+
+#include "teste.hpp"
+extern "C" {
+#include "esp_log.h"
+#include "lote.h"
+#include "banda.h"
+#include "sensor_codec.h"
+#include "sdkconfig.h"
+}
+#include <deque>
+#include <math.h>
+#include <random>
+#include <set>
+#include <string.h>
+
+#define WAKES             200000
+#define INTERVALO_MS      (CONFIG_NODE_INTERVALO_AMOSTRA_S * 1000)
+#define WAKES_HEARTBEAT   (CONFIG_NODE_HEARTBEAT_S / CONFIG_NODE_INTERVALO_AMOSTRA_S)
+#define ID_NO             7
+
+static const float BANDAS[4] = {
+    CONFIG_NODE_BANDA_TEMP / 100.0f,
+    CONFIG_NODE_BANDA_UMIDADE_AR / 100.0f,
+    CONFIG_NODE_BANDA_UMIDADE_SOLO / 100.0f,
+    CONFIG_NODE_BANDA_PARTICULAS / 100.0f,
+};
+
+static std::mt19937 s_sorteio(19);
+
+// ==================== MODELO ====================
+struct Pendente {
+    uint32_t seq;
+    sensor_data_t dados;
+};
+
+struct Modelo {
+    bool com_referencia = false;
+    float referencia[4] = {};
+    uint32_t desde_s = 0;
+    uint32_t amostras = 0;
+    uint32_t suprimidas = 0;
+
+    std::deque<Pendente> pendentes;
+    uint32_t wakes = 0;             // registradas desde o ultimo ACK
+    bool em_alarme = false;
+    uint32_t sobrescritas = 0;
+    uint32_t proxima_seq = 1;
+
+    std::set<uint32_t> entregues;
+    uint32_t envios = 0;
+    uint32_t heartbeats = 0;
+    uint32_t alarmes = 0;
+    uint32_t sem_aceite = 0;        // wakes seguidos sem amostra aceita
+};
+
+static Modelo s_modelo;
+
+static void valores(const sensor_data_t &d, float x[4])
+{
+    x[0] = d.temperatura;
+    x[1] = d.umidadeAr;
+    x[2] = d.umidadeSolo;
+    x[3] = d.particulas;
+}
+
+// O que o gateway recebe: centesimos e segundos
+static float centesimos(float v)
+{
+    return (float)lroundf(v * 100.0f) / 100.0f;
+}
+
+static MotivoBanda motivo_modelo(const sensor_data_t &d)
+{
+    Modelo &m = s_modelo;
+    m.amostras++;
+    m.desde_s += CONFIG_NODE_INTERVALO_AMOSTRA_S;
+    if (!m.com_referencia) return BANDA_MUDOU;
+    float x[4];
+    valores(d, x);
+    for (int k = 0; k < 4; k++) {
+        if (fabsf(x[k] - m.referencia[k]) > BANDAS[k]) return BANDA_MUDOU;
+    }
+    return m.desde_s >= CONFIG_NODE_HEARTBEAT_S ? BANDA_HEARTBEAT : BANDA_ESTAVEL;
+}
+
+// Registro no anel; true se o lote sai (limite de wakes ou borda do alarme)
+static bool registrar_modelo(const sensor_data_t &d)
+{
+    Modelo &m = s_modelo;
+    if (m.pendentes.size() == SENSOR_LOTE_MAX) {
+        m.pendentes.pop_front();
+        m.sobrescritas++;
+    }
+    m.pendentes.push_back({ m.proxima_seq++, d });
+    m.wakes++;
+    bool alarme = d.temperatura >= CONFIG_NODE_LOTE_LIMITE_TEMP_C;
+    bool cruzou = alarme != m.em_alarme;
+    m.em_alarme = alarme;
+    if (cruzou) m.alarmes++;
+    return cruzou || m.wakes >= CONFIG_NODE_LOTE_WAKES;
+}
+
+// ==================== ENVIO ====================
+// O lote que sai agora tem de ser o anel do modelo; com o gateway no ar
+// ele confirma e o anel esvazia
+static void enviar(bool gateway_no_ar, bool com_id)
+{
+    Modelo &m = s_modelo;
+    otIp6Address eid;
+    memset(&eid, 0, sizeof(eid));
+    eid.mFields.m8[0] = 0xfd;
+    eid.mFields.m8[15] = ID_NO;
+
+    uint8_t buf[SENSOR_LOTE_TAMANHO_MAX];
+    uint32_t primeira = 0;
+    uint8_t n = 0;
+    size_t len = lote_codificar(com_id ? ID_NO : 0, &eid, buf, sizeof(buf), &primeira, &n);
+    size_t cabecalho = com_id ? SENSOR_LOTE_CABECALHO_ID : SENSOR_LOTE_CABECALHO;
+    CONFERIR(n == m.pendentes.size());
+    CONFERIR(len == cabecalho + (size_t)n * SENSOR_AMOSTRA_TAMANHO);
+    CONFERIR(lote_pendentes() == m.pendentes.size());
+    if (len == 0 || m.pendentes.empty()) return;
+    CONFERIR(primeira == m.pendentes.front().seq);
+
+    uint16_t nodo = 0xffff;
+    otIp6Address eid_lido;
+    uint8_t n_lido = 0;
+    CONFERIR(decode_sensor_lote_cabecalho(buf, len, &nodo, &eid_lido, &n_lido) == cabecalho);
+    CONFERIR(n_lido == n);
+    if (com_id) {
+        CONFERIR(nodo == ID_NO);
+    } else {
+        CONFERIR(nodo == 0 && memcmp(&eid_lido, &eid, sizeof(eid)) == 0);
+    }
+    for (uint8_t k = 0; k < n && k < m.pendentes.size(); k++) {
+        sensor_data_t lido;
+        decode_sensor_amostra(buf + cabecalho + k * SENSOR_AMOSTRA_TAMANHO, &lido);
+        const sensor_data_t &d = m.pendentes[k].dados;
+        CONFERIR(lido.epoch_ms == d.epoch_ms / 1000 * 1000);
+        CONFERIR(lido.temperatura == centesimos(d.temperatura));
+        CONFERIR(lido.umidadeAr == centesimos(d.umidadeAr));
+        CONFERIR(lido.umidadeSolo == centesimos(d.umidadeSolo));
+        CONFERIR(lido.particulas == centesimos(d.particulas));
+    }
+    m.envios++;
+
+    if (!gateway_no_ar) return;
+    lote_confirmar(n);
+    for (uint32_t k = 0; k < n; k++) {
+        // Cada sequencia chega ao gateway uma vez so
+        CONFERIR(m.entregues.insert(primeira + k).second);
+    }
+    m.pendentes.clear();
+    m.wakes = 0;
+    CONFERIR(lote_pendentes() == 0);
+}
+
+// ==================== UM WAKE ====================
+// Mesma ordem do coap_amostrar com NODE_LOTE e NODE_BANDA
+static void wake(const sensor_data_t &d, bool gateway_no_ar, bool com_id)
+{
+    Modelo &m = s_modelo;
+    MotivoBanda esperado = motivo_modelo(d);
+    MotivoBanda motivo = banda_avaliar(&d);
+    CONFERIR(motivo == esperado);
+
+    if (motivo == BANDA_ESTAVEL) {
+        // Suprimida: o gateway segura a referencia, que esta dentro da banda
+        float x[4];
+        valores(d, x);
+        for (int k = 0; k < 4; k++) CONFERIR(fabsf(x[k] - m.referencia[k]) <= BANDAS[k]);
+        m.suprimidas++;
+        m.sem_aceite++;
+        CONFERIR(m.sem_aceite < WAKES_HEARTBEAT);
+        return;
+    }
+    if (motivo == BANDA_HEARTBEAT) m.heartbeats++;
+    m.sem_aceite = 0;
+
+    banda_aceitar(&d);
+    valores(d, m.referencia);
+    m.com_referencia = true;
+    m.desde_s = 0;
+
+    bool esperado_enviar = registrar_modelo(d) || motivo == BANDA_HEARTBEAT;
+    bool enviar_agora = lote_registrar(&d, m.proxima_seq - 1) || motivo == BANDA_HEARTBEAT;
+    CONFERIR(enviar_agora == esperado_enviar);
+    if (enviar_agora) enviar(gateway_no_ar, com_id);
+}
+
+static sensor_data_t amostra(uint32_t wake_n, const float x[4])
+{
+    sensor_data_t d = {};
+    d.nodo = ID_NO;
+    d.epoch_ms = 1700000000000LL + (int64_t)wake_n * INTERVALO_MS + s_sorteio() % 1000;
+    d.temperatura = x[0];
+    d.umidadeAr = x[1];
+    d.umidadeSolo = x[2];
+    d.particulas = x[3];
+    return d;
+}
+
+static float ruido(float amplitude)
+{
+    return amplitude * ((float)(s_sorteio() % 2001) / 1000.0f - 1.0f);
+}
+
+int main()
+{
+    mock_log_nivel = ESP_LOG_NONE;
+    uint32_t n_wake = 0;
+
+    // Boot a frio com sinal constante: a primeira entra no anel e depois so
+    // o heartbeat aceita (e envia), a cada WAKES_HEARTBEAT wakes
+    float x[4] = { 25.0f, 60.0f, 40.0f, 300.0f };
+    for (int k = 0; k < 4 * WAKES_HEARTBEAT; k++) wake(amostra(n_wake++, x), true, false);
+    CONFERIR(s_modelo.envios == 3);
+    CONFERIR(s_modelo.heartbeats == 3);
+    CONFERIR(banda_suprimidas() == 4 * WAKES_HEARTBEAT - 4);
+
+    // Borda do alarme: sai na hora, sem esperar os NODE_LOTE_WAKES
+    uint32_t envios = s_modelo.envios;
+    x[0] = CONFIG_NODE_LOTE_LIMITE_TEMP_C + 1.0f;
+    wake(amostra(n_wake++, x), true, true);
+    CONFERIR(s_modelo.envios == envios + 1);
+    x[0] = 25.0f;
+    wake(amostra(n_wake++, x), true, true);
+    CONFERIR(s_modelo.envios == envios + 2);
+
+    // Trechos aleatorios: estavel, deriva, saltos ou rondando o alarme; o
+    // gateway as vezes some por mais de SENSOR_LOTE_MAX amostras
+    float base[4] = { 25.0f, 60.0f, 40.0f, 300.0f };
+    while (n_wake < WAKES) {
+        uint32_t tipo = s_sorteio() % 4;
+        uint32_t duracao = 20 + s_sorteio() % 200;
+        bool no_ar = s_sorteio() % 5 != 0;
+        bool com_id = s_sorteio() % 3 != 0;
+        float deriva[4];
+        for (int k = 0; k < 4; k++) deriva[k] = tipo == 1 ? ruido(BANDAS[k] / 3) : 0.0f;
+        if (tipo == 3) {
+            base[0] = CONFIG_NODE_LOTE_LIMITE_TEMP_C - 0.5f;
+        } else if (base[0] > CONFIG_NODE_LOTE_LIMITE_TEMP_C - 5) {
+            base[0] = 25.0f;
+        }
+
+        for (uint32_t w = 0; w < duracao && n_wake < WAKES; w++) {
+            for (int k = 0; k < 4; k++) {
+                base[k] += deriva[k];
+                if (tipo == 2 && s_sorteio() % 6 == 0) base[k] += ruido(4 * BANDAS[k]);
+                float amplitude = tipo == 3 && k == 0 ? 1.0f : BANDAS[k] / 2;
+                x[k] = base[k] + ruido(amplitude);
+            }
+            // Dentro da faixa do codec (centesimos em 16 bits)
+            x[0] = fminf(fmaxf(x[0], -20.0f), 80.0f);
+            for (int k = 1; k < 3; k++) x[k] = fminf(fmaxf(x[k], 0.0f), 100.0f);
+            x[3] = fminf(fmaxf(x[3], 0.0f), 5000.0f);
+            for (int k = 0; k < 4; k++) base[k] = fminf(fmaxf(base[k], 0.0f), k == 3 ? 5000.0f : 80.0f);
+            wake(amostra(n_wake++, x), no_ar, com_id);
+        }
+    }
+
+    // Gateway de volta: o que sobrou sai; nada some sem ter sido sobrescrito
+    if (!s_modelo.pendentes.empty()) enviar(true, true);
+    Modelo &m = s_modelo;
+    CONFERIR(lote_pendentes() == 0);
+    CONFERIR(m.entregues.size() + m.sobrescritas == m.proxima_seq - 1);
+    CONFERIR(banda_amostras() == m.amostras && banda_amostras() == WAKES);
+    CONFERIR(banda_suprimidas() == m.suprimidas);
+    CONFERIR(m.sobrescritas > 0 && m.alarmes > 2 && m.heartbeats > 3);
+
+    printf("%u wakes: %u suprimidas, %u registradas, %u lotes (%u heartbeats, %u bordas de alarme), "
+           "%u sobrescritas\n",
+           (unsigned)m.amostras, (unsigned)m.suprimidas, (unsigned)(m.proxima_seq - 1), (unsigned)m.envios,
+           (unsigned)m.heartbeats, (unsigned)m.alarmes, (unsigned)m.sobrescritas);
+    return teste_fim();
+}
@@ -0,0 +1,213 @@
+// ==================== TESTE DE CONCORRENCIA DO SEQLOCK ====================
+// Um escritor (a "task do OpenThread": registrarNodo + registrarEnlace) e
+// leitores concorrentes: tres fazendo lerNodo sem parar e um fazendo o papel
+// da task de envio (historico e resumos da agregacao). Toda copia tem de ser
+// inteira, de uma unica escrita: os campos de cada leitura sao derivados do
+// mesmo contador. Compilado com -fsanitize=thread (acesso nao atomico a um
+// dado compartilhado vira falha do TSan) e com CONFIG_GATEWAY_AGREGACAO=1.
+
+#include "teste.hpp"
+#include "host_mock.hpp"
+#include "node_table.hpp"
+#include "cadastro_nodos.hpp"
+#include "agregacao.hpp"
+#include "seqlock.hpp"
+#include "esp_log.h"
+#include <atomic>
+#include <math.h>
+#include <thread>
+#include <vector>
+
+#define NOS                16
+#define ESCRITAS_POR_NO    5000     // particulas = contador, exato em centesimos
+#define LEITORES           3
+#define PALAVRAS_BRUTAS    32
+
+static std::atomic<bool> s_fim{false};
+static std::atomic<uint32_t> s_relogio{0};   // copia do relogio virtual para o envio
+static std::atomic<uint32_t> s_falhas_concorrentes{0};
+
+// CONFERIR nao e seguro entre threads: os leitores so contam
+#define CONFERIR_LEITOR(cond) \
+    do { if (!(cond)) s_falhas_concorrentes++; } while (0)
+
+// ==================== SEQLOCK PURO ====================
+// Palavras todas iguais a versao: copia rasgada aparece como palavras diferentes
+struct Bloco {
+    uint32_t p[PALAVRAS_BRUTAS];
+};
+
+static void seqlock_puro()
+{
+    static SeqLock versao;
+    static Bloco compartilhado;
+    const uint32_t escritas = 50000;
+
+    std::vector<std::thread> leitores;
+    std::atomic<bool> fim{false};
+    for (int k = 0; k < LEITORES; k++) {
+        leitores.emplace_back([&]() {
+            uint32_t anterior = 0;
+            while (!fim.load()) {
+                Bloco b;
+                versao.ler(&b, &compartilhado);
+                for (int w = 1; w < PALAVRAS_BRUTAS; w++) CONFERIR_LEITOR(b.p[w] == b.p[0]);
+                CONFERIR_LEITOR(b.p[0] >= anterior);
+                anterior = b.p[0];
+            }
+        });
+    }
+    for (uint32_t v = 1; v <= escritas; v++) {
+        Bloco b;
+        for (int w = 0; w < PALAVRAS_BRUTAS; w++) b.p[w] = v;
+        versao.escrever(&compartilhado, b);
+    }
+    fim = true;
+    for (auto &t : leitores) t.join();
+}
+
+// ==================== TABELA DE NÓS ====================
+// Leitura v do nó: todos os campos saem de v
+static sensor_data_t leitura(uint16_t id, uint32_t v)
+{
+    sensor_data_t d = {};
+    d.nodo = id;
+    d.epoch_ms = (int64_t)v * 1000;
+    d.temperatura = (float)(v % 300);
+    d.umidadeAr = (float)(v % 300 + 1);
+    d.umidadeSolo = (float)(v % 300 + 2);
+    d.particulas = (float)v;
+    return d;
+}
+
+static void conferir_copia(const NodeInfo &n, uint32_t &anterior)
+{
+    uint32_t v = (uint32_t)n.dados.particulas;
+    CONFERIR_LEITOR(n.dados.temperatura == (float)(v % 300));
+    CONFERIR_LEITOR(n.dados.umidadeAr == (float)(v % 300 + 1));
+    CONFERIR_LEITOR(n.dados.umidadeSolo == (float)(v % 300 + 2));
+    CONFERIR_LEITOR(n.dados.epoch_ms == (int64_t)v * 1000);
+    CONFERIR_LEITOR(n.hist_escritas == v);
+    CONFERIR_LEITOR(n.seq.maior == v && n.seq.recebidas == v);
+    // O enlace e outra publicacao: pode estar uma leitura atras
+    const EnlaceNodo &e = n.enlace;
+    CONFERIR_LEITOR(e.relatos == v || e.relatos + 1 == v);
+    CONFERIR_LEITOR(e.quadros == e.relatos && e.ultimo.rloc16 == (uint16_t)e.relatos);
+    CONFERIR_LEITOR(v >= anterior);
+    anterior = v;
+}
+
+static void leitor_tabela()
+{
+    uint32_t anterior[NODE_TABLE_CAPACIDADE] = {0};
+    NodeInfo n;
+    while (!s_fim.load()) {
+        size_t total = totalNodos();
+        for (size_t i = 0; i < total; i++) {
+            if (lerNodo(i, &n)) conferir_copia(n, anterior[i]);
+        }
+    }
+}
+
+// Uma passada da task de envio: amostras do anel e resumos vencidos
+struct Envio {
+    uint32_t recebidas[NODE_TABLE_CAPACIDADE] = {0};
+    uint32_t resumos = 0;
+};
+
+static void enviar(Envio &env)
+{
+    NodeInfo n;
+    size_t total = totalNodos();
+    for (size_t i = 0; i < total; i++) {
+        if (!lerNodo(i, &n)) continue;
+
+        uint32_t de, ate;
+        historicoPendente(i, n, &de, &ate);
+        for (uint32_t s = de; s != ate; s++) {
+            sensor_data_t d;
+            if (!historicoAmostra(i, s, n.id, &d)) continue;
+            // Amostra s (a partir de 0) e a leitura s + 1 do nó
+            CONFERIR_LEITOR(d.particulas == (float)(s + 1));
+            CONFERIR_LEITOR(d.temperatura == (float)((s + 1) % 300));
+            CONFERIR_LEITOR(d.umidadeSolo == (float)((s + 1) % 300 + 2));
+            CONFERIR_LEITOR(d.epoch_ms == (int64_t)(s + 1) * 1000);
+            env.recebidas[i]++;
+        }
+        confirmarHistorico(i, ate);
+
+        ResumoJanela r;
+        while (agregacao_resumo_pendente(i, s_relogio.load(), &r)) {
+            // Cada ponto (inclusive o interpolado) tem umidadeAr = temperatura + 1
+            const ResumoMetrica &t = r.m[METRICA_TEMPERATURA];
+            const ResumoMetrica &u = r.m[METRICA_UMIDADE_AR];
+            CONFERIR_LEITOR(r.amostras > 0);
+            CONFERIR_LEITOR(fabsf(u.min - t.min - 1) < 0.01f && fabsf(u.max - t.max - 1) < 0.01f);
+            CONFERIR_LEITOR(fabsf(u.media - t.media - 1) < 0.01f);
+            agregacao_confirmar(i, r.seq);
+            env.resumos++;
+        }
+    }
+}
+
+static void tabela_de_nos()
+{
+    cadastro_iniciar();
+    std::vector<uint16_t> ids(NOS);
+    for (int k = 0; k < NOS; k++) {
+        otIp6Address eid;
+        memset(&eid, 0, sizeof(eid));
+        eid.mFields.m8[0] = 0xfd;
+        eid.mFields.m8[15] = (uint8_t)(k + 1);
+        ids[k] = cadastro_por_eid(eid);
+    }
+
+    std::vector<std::thread> leitores;
+    for (int k = 0; k < LEITORES; k++) leitores.emplace_back(leitor_tabela);
+    Envio env;
+    std::thread envio([&env]() {
+        while (!s_fim.load()) enviar(env);
+    });
+
+    // Escritor: 5 ms virtuais por leitura, janelas da agregacao fecham no meio
+    uint32_t relogio = 1000;
+    for (uint32_t v = 1; v <= ESCRITAS_POR_NO; v++) {
+        for (int k = 0; k < NOS; k++) {
+            relogio += 5;
+            mock_relogio_definir_ms(relogio);
+            s_relogio.store(relogio);
+            CONFERIR(registrarNodo(ids[k], leitura(ids[k], v), true, v));
+            sensor_enlace_t enlace = {};
+            enlace.rloc16 = (uint16_t)v;
+            enlace.quadros = 1;
+            CONFERIR(registrarEnlace(ids[k], enlace, 1, 1));
+        }
+    }
+    s_fim = true;
+    for (auto &t : leitores) t.join();
+    envio.join();
+
+    // Sem escritor: o resto sai inteiro; nada some sem entrar nas perdidas
+    s_relogio.store(relogio + 2 * AGREGACAO_JANELA_MS);
+    enviar(env);
+    uint32_t perdidas = 0;
+    for (size_t i = 0; i < NOS; i++) {
+        CONFERIR(env.recebidas[i] + historicoPerdidas(i) == ESCRITAS_POR_NO);
+        perdidas += historicoPerdidas(i);
+    }
+    CONFERIR(env.resumos > 0);
+    printf("%u leituras, %u perdidas no anel, %u resumos\n", (unsigned)(NOS * ESCRITAS_POR_NO),
+           (unsigned)perdidas, (unsigned)env.resumos);
+}
+
+int main()
+{
+    mock_log_nivel = ESP_LOG_NONE;
+    seqlock_puro();
+    tabela_de_nos();
+    if (s_falhas_concorrentes) {
+        printf("%u copias inconsistentes\n", (unsigned)s_falhas_concorrentes.load());
+        s_teste_falhas += s_falhas_concorrentes;
+    }
+    return teste_fim();
+}
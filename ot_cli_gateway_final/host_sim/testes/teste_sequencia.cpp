@@ -0,0 +1,183 @@
+// ==================== TESTE DAS ESTATISTICAS DE SEQUENCIA ====================
+// Amostras com a sequencia no token CoAP, pelo coap_handler real, atraves
+// de um canal que perde, duplica e troca a ordem, cruzando a volta dos 32
+// bits. Os contadores do nó (recebidas, duplicadas, reordenadas, perdidas +
+// lacunas, reinicios) sao comparados com o que o canal de fato fez, e o
+// item {"e":..,"q":{..}} do upload com os contadores e a perda em permil.
+
+#include "gateway_teste.hpp"
+#include "node_table.hpp"
+#include "esp_log.h"
+#include <random>
+#include <set>
+
+#define AMOSTRAS       200000
+#define NOS            4
+
+// O que o canal fez com as amostras de um nó
+struct Verdade {
+    std::set<uint32_t> chegaram;
+    uint32_t geradas = 0;
+    uint32_t duplicadas = 0;
+    uint32_t reordenadas = 0;
+    uint32_t reinicios = 0;
+    bool com_maior = false;
+    uint32_t maior = 0;
+};
+
+static sensor_data_t amostra(uint32_t seq)
+{
+    sensor_data_t d = {};
+    d.temperatura = (float)(seq % 100);
+    d.umidadeAr = 50;
+    d.umidadeSolo = 40;
+    d.particulas = 10;
+    return d;
+}
+
+// 10 ms virtuais por pedido: a mid (16 bits) da a volta bem depois do
+// EXCHANGE_LIFETIME, senao o cache de respostas atenderia no lugar do handler
+static uint64_t s_relogio_ms = 1000;
+
+static void entregar(NoTeste &no, Verdade &v, uint32_t seq)
+{
+    MockRespostaCoap resposta;
+    s_relogio_ms += 10;
+    mock_relogio_definir_ms(s_relogio_ms);
+    sensor_data_t d = amostra(seq);
+    CONFERIR(no_teste_enviar(no, &d, 1, seq, NULL, &resposta) == OT_COAP_CODE_CHANGED);
+
+    if (!v.chegaram.insert(seq).second) {
+        v.duplicadas++;
+        return;
+    }
+    if (v.com_maior && (int32_t)(seq - v.maior) < 0) {
+        v.reordenadas++;
+    } else {
+        v.maior = seq;
+        v.com_maior = true;
+    }
+}
+
+// Perda p, duplicacao d (logo em seguida) e troca t (a amostra sai depois
+// da seguinte), em permil
+static void canal(NoTeste &no, Verdade &v, uint32_t inicio, uint32_t n, int p, int d, int t, std::mt19937 &sorteio)
+{
+    bool segurando = false;
+    uint32_t segurada = 0;
+    for (uint32_t k = 0; k < n; k++) {
+        uint32_t seq = inicio + k;
+        v.geradas++;
+        if ((int)(sorteio() % 1000) < p) continue;
+        if (!segurando && (int)(sorteio() % 1000) < t) {
+            segurando = true;
+            segurada = seq;
+            continue;
+        }
+        entregar(no, v, seq);
+        if ((int)(sorteio() % 1000) < d) entregar(no, v, seq);
+        if (segurando) {
+            entregar(no, v, segurada);
+            segurando = false;
+        }
+    }
+    if (segurando) entregar(no, v, segurada);
+}
+
+static uint32_t nunca_chegaram(const Verdade &v)
+{
+    return v.geradas - (uint32_t)v.chegaram.size();
+}
+
+static void conferir_nodo(const NoTeste &no, const Verdade &v)
+{
+    const NodeInfo *n = buscarNodo(no.id);
+    CONFERIR(n != NULL);
+    if (!n) return;
+    const EstatisticasSequencia &s = n->seq;
+    CONFERIR(s.recebidas == v.chegaram.size());
+    CONFERIR(s.duplicadas == v.duplicadas);
+    CONFERIR(s.reordenadas == v.reordenadas);
+    CONFERIR(s.perdidas + seqLacunas(s) == nunca_chegaram(v));
+    CONFERIR(s.reinicios == v.reinicios);
+}
+
+int main()
+{
+    mock_log_nivel = ESP_LOG_NONE;
+    mock_relogio_definir_ms(s_relogio_ms);
+    gateway_teste_iniciar();
+    std::mt19937 sorteio(13);
+
+    std::vector<NoTeste> nos;
+    std::vector<Verdade> verdades(NOS);
+    for (int k = 0; k < NOS; k++) {
+        MockRespostaCoap resposta;
+        nos.push_back(no_teste(k + 1));
+        CONFERIR(no_teste_cadastrar(nos[k], &resposta) == OT_COAP_CODE_CHANGED);
+    }
+
+    // Nó 0: canal ruim cruzando 0xffffffff
+    canal(nos[0], verdades[0], 0xffffffffu - AMOSTRAS / 2, AMOSTRAS, 50, 20, 30, sorteio);
+    conferir_nodo(nos[0], verdades[0]);
+
+    // Nó 1: rajada de perdas maior que a janela, depois uma que chega atrasada
+    canal(nos[1], verdades[1], 1000, 100, 0, 0, 0, sorteio);
+    verdades[1].geradas += SEQ_JANELA * 3 + 1;
+    entregar(nos[1], verdades[1], 1100 + SEQ_JANELA * 3);
+    entregar(nos[1], verdades[1], 1100 + 5);     // fora da janela: deixa de ser perdida
+    conferir_nodo(nos[1], verdades[1]);
+
+    // Nó 2: reinicio (salto maior que SEQ_SALTO_REINICIO); a contagem recomeca
+    canal(nos[2], verdades[2], 500, 1000, 20, 0, 0, sorteio);
+    uint32_t salto = 500 + 1000 + SEQ_SALTO_REINICIO + 77;
+    canal(nos[2], verdades[2], salto, 1000, 20, 0, 0, sorteio);
+    {
+        const NodeInfo *n = buscarNodo(nos[2].id);
+        CONFERIR(n && n->seq.reinicios == 1);
+        CONFERIR(n && n->seq.recebidas == verdades[2].chegaram.size());
+        // A lacuna do salto nao e perda; as lacunas da janela antiga somem com ela
+        uint32_t faltando = n ? n->seq.perdidas + seqLacunas(n->seq) : 0;
+        CONFERIR(faltando <= nunca_chegaram(verdades[2]) && faltando + SEQ_JANELA >= nunca_chegaram(verdades[2]));
+        verdades[2].reinicios = 1;
+    }
+
+    // Nó 3: canal limpo
+    canal(nos[3], verdades[3], 7, 300, 0, 0, 0, sorteio);
+    conferir_nodo(nos[3], verdades[3]);
+
+    // Upload: um item "q" por nó, com os contadores da tabela
+    ColetorHttp coletor;
+    if (!coletor_abrir(coletor)) return 2;
+    http_send_all_now();
+    coletor_encerrar(coletor);
+
+    cJSON *itens = coletor_itens(coletor, "q");
+    for (int k = 0; k < NOS; k++) {
+        const NodeInfo *n = buscarNodo(nos[k].id);
+        cJSON *item = item_do_nodo(itens, nos[k].id);
+        CONFERIR(item != NULL);
+        if (!item || !n) continue;
+        const cJSON *q = cJSON_GetObjectItem(item, "q");
+        const EstatisticasSequencia &s = n->seq;
+        CONFERIR(numero(q, "rx") == s.recebidas);
+        CONFERIR(numero(q, "perd") == s.perdidas);
+        CONFERIR(numero(q, "lac") == seqLacunas(s));
+        CONFERIR(numero(q, "dup") == s.duplicadas);
+        CONFERIR(numero(q, "reord") == s.reordenadas);
+        CONFERIR(numero(q, "reini") == s.reinicios);
+        const Verdade &v = verdades[k];
+        uint32_t faltando = nunca_chegaram(v);
+        if (k != 2) {
+            CONFERIR(numero(q, "perda") == (uint32_t)((uint64_t)faltando * 1000 / (v.chegaram.size() + faltando)));
+        }
+        // Sem leitura no mesmo item: o servidor separa pelo "q"
+        CONFERIR(!cJSON_GetObjectItem(item, "uA"));
+    }
+    printf("nó 0: %zu recebidas, %u duplicadas, %u reordenadas, %u nunca chegaram\n",
+           verdades[0].chegaram.size(), (unsigned)verdades[0].duplicadas, (unsigned)verdades[0].reordenadas,
+           (unsigned)nunca_chegaram(verdades[0]));
+    CONFERIR(cJSON_GetArraySize(itens) == NOS);
+    cJSON_Delete(itens);
+    return teste_fim();
+}
@@ -0,0 +1,147 @@
+// ==================== TESTE DO RETRATO DA TOPOLOGIA ====================
+// Nós mandando lotes com o bloco de enlace pelo coap_handler real, em
+// posicoes diferentes da malha (roteador vizinho, filho, roteador a varios
+// saltos, roteador sem rota, filho do proprio gateway, sem pai). O item
+// {"e":..,"topo":{..}} do upload de cada nó e comparado com o ultimo bloco
+// (RLOC16, pai, RSSI, margem, qualidade), os saltos e o custo pela rota do
+// mock e os contadores MAC somados; payload repetido (duplicata) nao soma,
+// e nó sem bloco nao tem item. A chave nao e "t": o item nao tem leitura.
+
+#include "gateway_teste.hpp"
+#include "node_table.hpp"
+#include "esp_log.h"
+#include <random>
+
+#define RELATOS 40
+
+struct NoMalha {
+    uint16_t rloc16;
+    bool sem_pai;
+    int saltos;                 // -1 = sem rota
+    int custo;
+};
+
+struct Somas {
+    uint32_t quadros = 0, retentativas = 0, sem_ack = 0, cca = 0;
+    sensor_enlace_t ultimo = {};
+    uint64_t atualizado_ms = 0;
+};
+
+static uint64_t s_relogio_ms = 1000;
+
+static otCoapCode enviar(NoTeste &no, uint32_t seq, const sensor_enlace_t *enlace, MockRespostaCoap *resposta)
+{
+    s_relogio_ms += 250;
+    mock_relogio_definir_ms(s_relogio_ms);
+    sensor_data_t d = {};
+    d.temperatura = 24.0f;
+    return no_teste_enviar(no, &d, 1, seq, enlace, resposta);
+}
+
+int main()
+{
+    mock_log_nivel = ESP_LOG_NONE;
+    mock_relogio_definir_ms(s_relogio_ms);
+    gateway_teste_iniciar();
+    std::mt19937 sorteio(23);
+
+    // Rotas do gateway (lider, 0x0000): 0x0400 vizinho, 0x0800 a 3 de custo
+    // por 0x0400, 0x0c00 sem rota
+    mock_ot_definir_rota(0x0400, 0x0400, 1);
+    mock_ot_definir_rota(0x0800, 0x0400, 3);
+    const NoMalha malha[] = {
+        { 0x0400, false, 1, 1 },    // roteador vizinho
+        { 0x0401, false, 2, 1 },    // filho do vizinho
+        { 0x0803, false, 4, 3 },    // filho de um roteador a 3
+        { 0x0c00, false, -1, 0 },   // roteador sem rota
+        { 0x0002, false, 1, 0 },    // filho do gateway
+        { 0x0402, true, 2, 1 },     // sem pai no momento
+    };
+    const int NOS = sizeof(malha) / sizeof(malha[0]);
+
+    std::vector<NoTeste> nos;
+    std::vector<Somas> somas(NOS);
+    for (int k = 0; k <= NOS; k++) {
+        MockRespostaCoap resposta;
+        nos.push_back(no_teste(k + 1));
+        CONFERIR(no_teste_cadastrar(nos[k], &resposta) == OT_COAP_CODE_CHANGED);
+    }
+
+    for (uint32_t r = 0; r < RELATOS; r++) {
+        for (int k = 0; k < NOS; k++) {
+            sensor_enlace_t e = {};
+            e.rloc16 = malha[k].rloc16;
+            e.rssi = malha[k].sem_pai ? SENSOR_RSSI_INVALIDO : (int8_t)(-40 - (int)(sorteio() % 50));
+            e.margem = (uint8_t)(sorteio() % 60);
+            e.qualidade_entrada = (uint8_t)(sorteio() % 4);
+            e.qualidade_saida = (uint8_t)(sorteio() % 4);
+            e.quadros = (uint16_t)(1 + sorteio() % 20);
+            e.retentativas = (uint16_t)(sorteio() % 5);
+            e.sem_ack = (uint16_t)(sorteio() % 2);
+            e.cca = (uint16_t)(sorteio() % 3);
+
+            MockRespostaCoap resposta;
+            CONFERIR(enviar(nos[k], r, &e, &resposta) == OT_COAP_CODE_CHANGED);
+            Somas &s = somas[k];
+            s.quadros += e.quadros;
+            s.retentativas += e.retentativas;
+            s.sem_ack += e.sem_ack;
+            s.cca += e.cca;
+            s.ultimo = e;
+            s.atualizado_ms = s_relogio_ms;
+
+            // Retransmissao vista como nova (mid nova, mesma sequencia): duplicata,
+            // o bloco ja foi somado
+            if (sorteio() % 4 == 0) {
+                sensor_enlace_t outro = e;
+                outro.quadros = 999;
+                CONFERIR(enviar(nos[k], r, &outro, &resposta) == OT_COAP_CODE_CHANGED);
+            }
+        }
+        // Ultimo nó sem bloco de enlace
+        MockRespostaCoap resposta;
+        CONFERIR(enviar(nos[NOS], r, NULL, &resposta) == OT_COAP_CODE_CHANGED);
+    }
+
+    s_relogio_ms += 7000;
+    mock_relogio_definir_ms(s_relogio_ms);
+    ColetorHttp coletor;
+    if (!coletor_abrir(coletor)) return 2;
+    http_send_all_now();
+    coletor_encerrar(coletor);
+
+    cJSON *itens = coletor_itens(coletor, "topo");
+    for (int k = 0; k < NOS; k++) {
+        cJSON *item = item_do_nodo(itens, nos[k].id);
+        CONFERIR(item != NULL);
+        if (!item) continue;
+        CONFERIR(!cJSON_GetObjectItem(item, "t") && !cJSON_GetObjectItem(item, "uA"));
+        const cJSON *topo = cJSON_GetObjectItem(item, "topo");
+        const Somas &s = somas[k];
+        const NoMalha &m = malha[k];
+
+        CONFERIR(numero(topo, "rloc") == m.rloc16);
+        uint16_t roteador = sensor_rloc16_roteador(m.rloc16);
+        CONFERIR(numero(topo, "pai") == (roteador != m.rloc16 ? roteador : -1));
+        CONFERIR(numero(topo, "saltos") == m.saltos);
+        CONFERIR(numero(topo, "custo") == (m.saltos < 0 ? -1 : m.custo));
+        if (m.sem_pai) {
+            CONFERIR(numero(topo, "rssi") == -1 && numero(topo, "margem") == -1 && numero(topo, "lqi") == -1);
+        } else {
+            CONFERIR(numero(topo, "rssi") == s.ultimo.rssi);
+            CONFERIR(numero(topo, "margem") == s.ultimo.margem);
+            CONFERIR(numero(topo, "lqi") == s.ultimo.qualidade_entrada);
+            CONFERIR(numero(topo, "lqo") == s.ultimo.qualidade_saida);
+        }
+        CONFERIR(numero(topo, "tx") == s.quadros);
+        CONFERIR(numero(topo, "retx") == s.retentativas);
+        CONFERIR(numero(topo, "semack") == s.sem_ack);
+        CONFERIR(numero(topo, "cca") == s.cca);
+        CONFERIR(numero(topo, "idade") == (double)((s_relogio_ms - s.atualizado_ms) / 1000));
+    }
+    CONFERIR(item_do_nodo(itens, nos[NOS].id) == NULL);
+    CONFERIR(cJSON_GetArraySize(itens) == NOS);
+    printf("%d arestas conferidas, %u relatos por nó\n", NOS, (unsigned)RELATOS);
+    cJSON_Delete(itens);
+    return teste_fim();
+}
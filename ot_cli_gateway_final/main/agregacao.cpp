@@ -0,0 +1,215 @@
+#include "agregacao.hpp"
+#include "node_table.hpp"
+#include "seqlock.hpp"
+#include "esp_log.h"
+#include <string.h>
+
+// Sem a agregacao nada daqui entra no binario (a arena tem um agregado por
+// posicao da tabela de nós)
+#if CONFIG_GATEWAY_AGREGACAO
+
+static const char *TAG_AGREGACAO = "AGREGACAO";
+
+static const char *NOMES_METRICA[METRICA_TOTAL] = { "t", "uA", "uS", "p" };
+
+// Acumulador de uma metrica na janela em andamento
+struct AcumuladorMetrica {
+    float min;
+    float max;
+    float media;
+    float m2;       // soma dos quadrados dos desvios (Welford)
+    float cov;      // soma de (t - media_t) * (x - media_x)
+};
+
+struct AcumuladorJanela {
+    uint32_t seq;   // numero da janela do nó (1, 2, ...)
+    uint32_t inicio_ms;
+    uint32_t primeira_ms;
+    uint32_t ultima_ms;
+    uint32_t n;
+    uint32_t interpolados;  // pontos virtuais no inicio (ver agregacao_registrar)
+    float media_t;  // segundos desde inicio_ms
+    float m2_t;
+    AcumuladorMetrica m[METRICA_TOTAL];
+};
+
+// Parte escrita com o lock do OpenThread (publicada pelo seqlock)
+struct EstadoAgregado {
+    AcumuladorJanela atual;
+    ResumoJanela fechada;       // seq 0 = nenhuma ainda
+    uint32_t janelas;           // janelas abertas desde o boot
+    float ultimo[METRICA_TOTAL];// ultima leitura do nó (valor segurado)
+    uint32_t ultimo_ms;
+    uint32_t com_ultimo;
+};
+
+struct AgregadoNodo {
+    EstadoAgregado estado;
+    SeqLock versao;
+    uint32_t enviada_seq;       // cursor do envio (so a task de envio escreve)
+};
+
+// Um agregado por posicao da tabela de nós (arena estática)
+static AgregadoNodo agregados[NODE_TABLE_CAPACIDADE];
+static uint32_t janelas_sobrescritas = 0;
+static uint32_t pontos_interpolados = 0;
+
+const char *agregacao_nome_metrica(int m)
+{
+    return NOMES_METRICA[m];
+}
+
+static inline uint32_t inicio_da_janela(uint32_t agora_ms)
+{
+    return agora_ms - (agora_ms % AGREGACAO_JANELA_MS);
+}
+
+static void resumir(const AcumuladorJanela &j, ResumoJanela *r)
+{
+    r->seq = j.seq;
+    r->inicio_ms = j.inicio_ms;
+    r->duracao_ms = j.ultima_ms - j.primeira_ms;
+    r->amostras = j.n - j.interpolados;
+    r->fim_epoch = time(NULL);
+
+    for (int k = 0; k < METRICA_TOTAL; k++) {
+        const AcumuladorMetrica &m = j.m[k];
+        r->m[k].min = m.min;
+        r->m[k].max = m.max;
+        r->m[k].media = m.media;
+        r->m[k].variancia = (j.n > 1) ? m.m2 / (float)(j.n - 1) : 0.0f;
+        r->m[k].tendencia = (j.m2_t > 0.0f) ? (m.cov / j.m2_t) * 60.0f : 0.0f;
+    }
+}
+
+static void fechar_janela(AgregadoNodo &a, EstadoAgregado &e)
+{
+    uint32_t enviada = __atomic_load_n(&a.enviada_seq, __ATOMIC_RELAXED);
+    if (e.fechada.seq > enviada) {
+        // A anterior nao foi enviada a tempo (janela menor que o ciclo de envio)
+        janelas_sobrescritas++;
+        ESP_LOGW(TAG_AGREGACAO, "Janela nao enviada sobrescrita (total %u)", (unsigned)janelas_sobrescritas);
+    }
+
+    resumir(e.atual, &e.fechada);
+    memset(&e.atual, 0, sizeof(e.atual));
+}
+
+// O(1): Welford para media/variancia e covariancia online para a inclinacao
+static void acumular(AcumuladorJanela &j, uint32_t instante_ms, const float x[METRICA_TOTAL])
+{
+    if (j.n == 0) {
+        j.primeira_ms = instante_ms;
+        for (int k = 0; k < METRICA_TOTAL; k++) {
+            j.m[k].min = x[k];
+            j.m[k].max = x[k];
+        }
+    }
+
+    j.n++;
+    j.ultima_ms = instante_ms;
+
+    float t = (float)(instante_ms - j.inicio_ms) / 1000.0f;
+    float dt = t - j.media_t;
+    j.media_t += dt / (float)j.n;
+    j.m2_t += dt * (t - j.media_t);
+
+    for (int k = 0; k < METRICA_TOTAL; k++) {
+        AcumuladorMetrica &m = j.m[k];
+        if (x[k] < m.min) m.min = x[k];
+        if (x[k] > m.max) m.max = x[k];
+
+        float dx = x[k] - m.media;
+        m.media += dx / (float)j.n;
+        m.m2 += dx * (x[k] - m.media);
+        m.cov += dt * (x[k] - m.media);
+    }
+}
+
+void agregacao_registrar(size_t i, const sensor_data_t &dados, uint32_t agora_ms)
+{
+    AgregadoNodo &a = agregados[i];
+    EstadoAgregado e = a.estado;    // unico escritor: le direto
+    AcumuladorJanela &j = e.atual;
+
+    if (j.n > 0 && inicio_da_janela(agora_ms) != j.inicio_ms) {
+        fechar_janela(a, e);
+    }
+
+    const float x[METRICA_TOTAL] = { dados.temperatura, dados.umidadeAr, dados.umidadeSolo, dados.particulas };
+
+    if (j.n == 0) {
+        j.seq = ++e.janelas;
+        j.inicio_ms = inicio_da_janela(agora_ms);
+
+        // Nó com banda morta fica calado enquanto nada muda: se ele estava
+        // online, a janela comeca no valor interpolado entre a ultima leitura
+        // (segurada ate aqui) e esta, em vez de so na chegada desta
+        uint32_t parado = agora_ms - e.ultimo_ms;
+        if (e.com_ultimo && parado > 0 && parado < NODO_STALE_MS &&
+            (int32_t)(j.inicio_ms - e.ultimo_ms) > 0) {
+            float f = (float)(j.inicio_ms - e.ultimo_ms) / (float)parado;
+            float v[METRICA_TOTAL];
+            for (int k = 0; k < METRICA_TOTAL; k++) {
+                v[k] = e.ultimo[k] + f * (x[k] - e.ultimo[k]);
+            }
+            acumular(j, j.inicio_ms, v);
+            j.interpolados++;
+            __atomic_store_n(&pontos_interpolados, pontos_interpolados + 1, __ATOMIC_RELAXED);
+        }
+    }
+
+    acumular(j, agora_ms, x);
+
+    memcpy(e.ultimo, x, sizeof(e.ultimo));
+    e.ultimo_ms = agora_ms;
+    e.com_ultimo = 1;
+
+    a.versao.escrever(&a.estado, e);
+}
+
+uint32_t agregacao_interpolados()
+{
+    return __atomic_load_n(&pontos_interpolados, __ATOMIC_RELAXED);
+}
+
+void agregacao_reiniciar(size_t i)
+{
+    AgregadoNodo &a = agregados[i];
+    EstadoAgregado e;
+
+    memset(&e, 0, sizeof(e));       // o valor segurado era do nó anterior
+    e.janelas = a.estado.janelas;   // seq > enviada_seq so para janelas do nó novo
+    a.versao.escrever(&a.estado, e);
+}
+
+bool agregacao_resumo_pendente(size_t i, uint32_t agora_ms, ResumoJanela *saida)
+{
+    AgregadoNodo &a = agregados[i];
+    EstadoAgregado e;
+    a.versao.ler(&e, &a.estado);
+
+    if (e.fechada.seq > a.enviada_seq) {
+        *saida = e.fechada;
+        return true;
+    }
+
+    // Janela vencida que ainda nao foi fechada (o nó nao mandou nada depois):
+    // nao recebe mais amostras, entao o resumo ja e o definitivo
+    if (e.atual.n > 0 && e.atual.seq > a.enviada_seq &&
+        e.atual.inicio_ms != inicio_da_janela(agora_ms)) {
+        resumir(e.atual, saida);
+        return true;
+    }
+    return false;
+}
+
+void agregacao_confirmar(size_t i, uint32_t seq)
+{
+    AgregadoNodo &a = agregados[i];
+    if (seq > a.enviada_seq) {
+        __atomic_store_n(&a.enviada_seq, seq, __ATOMIC_RELAXED);
+    }
+}
+
+#endif // CONFIG_GATEWAY_AGREGACAO
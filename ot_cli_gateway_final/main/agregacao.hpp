@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "sdkconfig.h"
+#include "sensor_data.hpp"
+
+// ==================== AGREGACAO POR JANELA ====================
+// Para cada nó e metrica, mantem min/max/media/variancia/tendencia de uma
+// janela fixa (tumbling) de CONFIG_GATEWAY_AGREGACAO_JANELA_S segundos,
+// atualizados em O(1) por amostra (Welford para media/variancia e
+// covariancia tempo x valor para a inclinacao). O tempo e o de recepcao
+// no gateway, entao funciona mesmo com o relogio do nó errado.
+//
+// Cada nó guarda a janela em andamento e a ultima janela fechada; com a
+// janela >= intervalo de envio nada se perde. Nós com banda morta ficam
+// calados enquanto nada muda: o agregado segura a ultima leitura e a janela
+// seguinte comeca no valor interpolado entre ela e a nova (um ponto virtual
+// no inicio da janela, fora da contagem de amostras).
+// So quem tem o lock do OpenThread
+// escreve; o envio le copias pelo seqlock do nó e guarda o proprio cursor.
+
+#ifdef CONFIG_GATEWAY_AGREGACAO_JANELA_S
+#define AGREGACAO_JANELA_MS ((uint32_t)CONFIG_GATEWAY_AGREGACAO_JANELA_S * 1000u)
+#else
+#define AGREGACAO_JANELA_MS (120u * 1000u)
+#endif
+
+// Ordem das metricas nos vetores abaixo (e no JSON de resumo)
+enum MetricaSensor {
+    METRICA_TEMPERATURA = 0,
+    METRICA_UMIDADE_AR,
+    METRICA_UMIDADE_SOLO,
+    METRICA_PARTICULAS,
+    METRICA_TOTAL
+};
+
+struct ResumoMetrica {
+    float min;
+    float max;
+    float media;
+    float variancia;    // amostral (n-1); 0 com uma amostra
+    float tendencia;    // inclinacao da reta minima quadrada, unidades por minuto
+};
+
+struct ResumoJanela {
+    uint32_t seq;           // numero da janela do nó (para confirmar)
+    uint32_t inicio_ms;     // relogio do gateway (esp_log_timestamp)
+    uint32_t duracao_ms;    // da primeira a ultima amostra
+    uint32_t amostras;
+    time_t fim_epoch;       // hora do gateway no fechamento (para o "d" do upload)
+    ResumoMetrica m[METRICA_TOTAL];
+};
+
+// Alimenta a janela do nó na posicao i (chamado por registrarNodo)
+void agregacao_registrar(size_t i, const sensor_data_t &dados, uint32_t agora_ms);
+
+// Posicao i reusada por outro nó: descarta as janelas (a numeracao continua)
+void agregacao_reiniciar(size_t i);
+
+// Janela mais antiga do nó i ainda nao enviada: a ultima fechada ou, se o
+// nó nao mandou nada depois do fim dela, a em andamento ja vencida
+bool agregacao_resumo_pendente(size_t i, uint32_t agora_ms, ResumoJanela *saida);
+// Marca como enviadas as janelas ate seq (apos um POST aceito)
+void agregacao_confirmar(size_t i, uint32_t seq);
+
+// Pontos virtuais criados por interpolacao desde o boot
+uint32_t agregacao_interpolados();
+
+// Nome curto da metrica (chave do JSON)
+const char *agregacao_nome_metrica(int m);
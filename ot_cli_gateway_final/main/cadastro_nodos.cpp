@@ -0,0 +1,190 @@
+#include "cadastro_nodos.hpp"
+#include "seqlock.hpp"
+#include "nvs.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG_CADASTRO = "CADASTRO";
+
+#define CADASTRO_NVS_NAMESPACE "cadastro"
+
+struct EntradaCadastro {
+    uint8_t eui64[SENSOR_EUI64_TAMANHO];    // zeros = so conhecido pelo EID
+    otIp6Address eid;
+};
+
+// Posicao k = id k + 1 (arena estática); so as [0, s_total) existem
+static EntradaCadastro s_entradas[CADASTRO_CAPACIDADE];
+static SeqLock s_versao[CADASTRO_CAPACIDADE];
+static uint16_t s_total = 0;
+
+static nvs_handle_t s_nvs;
+static bool s_nvs_aberta = false;
+
+static const uint8_t EUI64_VAZIA[SENSOR_EUI64_TAMANHO] = { 0 };
+
+static inline void chave_nvs(uint16_t id, char chave[8])
+{
+    snprintf(chave, 8, "n%u", (unsigned)id);
+}
+
+static inline bool mesmo_eid(const otIp6Address &a, const otIp6Address &b)
+{
+    return memcmp(a.mFields.m8, b.mFields.m8, sizeof(a.mFields.m8)) == 0;
+}
+
+void cadastro_iniciar()
+{
+    esp_err_t err = nvs_open(CADASTRO_NVS_NAMESPACE, NVS_READWRITE, &s_nvs);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG_CADASTRO, "Falha ao abrir a NVS (%d): ids so ate o proximo reinicio", err);
+        return;
+    }
+    s_nvs_aberta = true;
+
+    // Ids sao dados em ordem: o primeiro que falta encerra o cadastro
+    uint16_t n = 0;
+    while (n < CADASTRO_CAPACIDADE) {
+        char chave[8];
+        size_t len = sizeof(EntradaCadastro);
+        chave_nvs(n + 1, chave);
+        if (nvs_get_blob(s_nvs, chave, &s_entradas[n], &len) != ESP_OK || len != sizeof(EntradaCadastro)) break;
+        n++;
+    }
+    __atomic_store_n(&s_total, n, __ATOMIC_RELEASE);
+    ESP_LOGI(TAG_CADASTRO, "%u nós no cadastro (capacidade %d)", (unsigned)n, CADASTRO_CAPACIDADE);
+}
+
+// ==================== ESCRITA (COM O LOCK DO OPENTHREAD) ====================
+static void gravar(uint16_t id, const EntradaCadastro &e)
+{
+    s_versao[id - 1].escrever(&s_entradas[id - 1], e);
+    if (!s_nvs_aberta) return;
+
+    char chave[8];
+    chave_nvs(id, chave);
+    if (nvs_set_blob(s_nvs, chave, &e, sizeof(e)) != ESP_OK || nvs_commit(s_nvs) != ESP_OK) {
+        ESP_LOGW(TAG_CADASTRO, "Falha ao gravar o id %u na NVS", (unsigned)id);
+    }
+}
+
+static uint16_t criar(const uint8_t eui64[SENSOR_EUI64_TAMANHO], const otIp6Address &eid)
+{
+    if (s_total >= CADASTRO_CAPACIDADE) {
+        ESP_LOGW(TAG_CADASTRO, "Cadastro cheio (%d ids)", CADASTRO_CAPACIDADE);
+        return CADASTRO_SEM_ID;
+    }
+
+    EntradaCadastro e;
+    memcpy(e.eui64, eui64, sizeof(e.eui64));
+    e.eid = eid;
+
+    uint16_t id = s_total + 1;
+    gravar(id, e);
+    // Entrada pronta antes de aparecer em cadastro_total()
+    __atomic_store_n(&s_total, id, __ATOMIC_RELEASE);
+
+    char texto[OT_IP6_ADDRESS_STRING_SIZE];
+    otIp6AddressToString(&eid, texto, sizeof(texto));
+    ESP_LOGI(TAG_CADASTRO, "Nó %s cadastrado com id %u", texto, (unsigned)id);
+    return id;
+}
+
+// Linear, mas so no cadastro e nos payloads com EID (o caminho comum ja
+// chega com o id)
+uint16_t cadastro_por_eui64(const uint8_t eui64[SENSOR_EUI64_TAMANHO], const otIp6Address &eid)
+{
+    uint16_t pelo_eid = CADASTRO_SEM_ID;
+
+    for (uint16_t k = 0; k < s_total; k++) {
+        EntradaCadastro &e = s_entradas[k];     // unico escritor: le direto
+        if (memcmp(e.eui64, eui64, sizeof(e.eui64)) == 0) {
+            if (!mesmo_eid(e.eid, eid)) {
+                // Outra rede (prefixo mesh-local novo): mesmo nó, mesmo id
+                EntradaCadastro nova = e;
+                nova.eid = eid;
+                gravar(k + 1, nova);
+            }
+            return k + 1;
+        }
+        if (pelo_eid == CADASTRO_SEM_ID && mesmo_eid(e.eid, eid) &&
+            memcmp(e.eui64, EUI64_VAZIA, sizeof(e.eui64)) == 0) {
+            pelo_eid = k + 1;
+        }
+    }
+
+    if (pelo_eid != CADASTRO_SEM_ID) {
+        // Nó que ja mandava amostras com o EID: fica com o id que tinha
+        EntradaCadastro nova = s_entradas[pelo_eid - 1];
+        memcpy(nova.eui64, eui64, sizeof(nova.eui64));
+        gravar(pelo_eid, nova);
+        return pelo_eid;
+    }
+    return criar(eui64, eid);
+}
+
+uint16_t cadastro_por_eid(const otIp6Address &eid)
+{
+    for (uint16_t k = 0; k < s_total; k++) {
+        if (mesmo_eid(s_entradas[k].eid, eid)) return k + 1;
+    }
+    return criar(EUI64_VAZIA, eid);
+}
+
+// ==================== LEITURA (QUALQUER TASK) ====================
+uint16_t cadastro_total()
+{
+    return __atomic_load_n(&s_total, __ATOMIC_ACQUIRE);
+}
+
+bool cadastro_valido(uint16_t id)
+{
+    return id != CADASTRO_SEM_ID && id <= cadastro_total();
+}
+
+static bool ler_entrada(uint16_t id, EntradaCadastro *e)
+{
+    if (!cadastro_valido(id)) return false;
+    s_versao[id - 1].ler(e, &s_entradas[id - 1]);
+    return true;
+}
+
+uint16_t cadastro_buscar_eid(const otIp6Address &eid)
+{
+    EntradaCadastro e;
+    uint16_t total = cadastro_total();
+    for (uint16_t id = 1; id <= total; id++) {
+        if (ler_entrada(id, &e) && mesmo_eid(e.eid, eid)) return id;
+    }
+    return CADASTRO_SEM_ID;
+}
+
+bool cadastro_eid(uint16_t id, otIp6Address *eid)
+{
+    EntradaCadastro e;
+    if (!ler_entrada(id, &e)) return false;
+    *eid = e.eid;
+    return true;
+}
+
+void cadastro_eid_texto(uint16_t id, char *buf, size_t len)
+{
+    otIp6Address eid;
+    if (!cadastro_eid(id, &eid)) {
+        if (len > 0) buf[0] = '\0';
+        return;
+    }
+    otIp6AddressToString(&eid, buf, len);
+}
+
+void cadastro_eui64_texto(uint16_t id, char *buf, size_t len)
+{
+    EntradaCadastro e;
+    if (!ler_entrada(id, &e) || memcmp(e.eui64, EUI64_VAZIA, sizeof(e.eui64)) == 0) {
+        snprintf(buf, len, "-");
+        return;
+    }
+    snprintf(buf, len, "%02x%02x%02x%02x%02x%02x%02x%02x", e.eui64[0], e.eui64[1], e.eui64[2],
+             e.eui64[3], e.eui64[4], e.eui64[5], e.eui64[6], e.eui64[7]);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "openthread/ip6.h"
+#include "sensor_codec.hpp"
+#include "node_table.hpp"
+
+// ==================== CADASTRO DOS NÓS (ID CURTO) ====================
+// Tabela lateral id -> {EUI-64, EID} (ver ID CURTO DO NÓ em sensor_codec.hpp).
+// O id e a chave da tabela de nós e o que vai nos payloads; EUI-64 e EID so
+// saem daqui na fronteira do uplink. Ids vao de 1 a CADASTRO_CAPACIDADE em
+// ordem, nunca sao reaproveitados (nó despejado volta com o mesmo id) e
+// ficam em NVS, um blob por id, entao sobrevivem a reinicios do gateway.
+// Escrita so com o lock do OpenThread; leitura de qualquer task (seqlock
+// por id, sem bloquear quem cadastra).
+
+// Nós distintos ao longo da vida do gateway (o dobro da tabela de nós)
+#define CADASTRO_CAPACIDADE (2 * NODE_TABLE_CAPACIDADE)
+#define CADASTRO_SEM_ID     0
+
+static_assert(CADASTRO_CAPACIDADE <= UINT16_MAX, "id curto tem 16 bits");
+
+// Carrega o cadastro da NVS (depois do nvs_flash_init)
+void cadastro_iniciar();
+
+// ==================== ESCRITA (COM O LOCK DO OPENTHREAD) ====================
+// Pedido de cadastro: id da EUI-64 (o EID e atualizado se mudou). Adota a
+// entrada criada antes pelo EID, se houver. CADASTRO_SEM_ID se cheio.
+uint16_t cadastro_por_eui64(const uint8_t eui64[SENSOR_EUI64_TAMANHO], const otIp6Address &eid);
+
+// Payload com EID (nó sem id ou firmware antigo): id do EID, criado na
+// primeira vez sem EUI-64. CADASTRO_SEM_ID se cheio.
+uint16_t cadastro_por_eid(const otIp6Address &eid);
+
+// ==================== LEITURA (QUALQUER TASK) ====================
+bool cadastro_valido(uint16_t id);
+
+// Id ja cadastrado para o EID, sem criar (CADASTRO_SEM_ID se nao houver)
+uint16_t cadastro_buscar_eid(const otIp6Address &eid);
+
+// false se o id nao existe
+bool cadastro_eid(uint16_t id, otIp6Address *eid);
+// EID em texto para o JSON/HTTP ("" se o id nao existe)
+void cadastro_eid_texto(uint16_t id, char *buf, size_t len);
+// EUI-64 em hexadecimal ("-" se o nó nunca mandou o cadastro)
+void cadastro_eui64_texto(uint16_t id, char *buf, size_t len);
+
+uint16_t cadastro_total();
@@ -2,9 +2,17 @@
 #include "sensor_collect.hpp"
 #include "esp_ot_cli.hpp"
 #include "node_table.hpp"
+#include "cadastro_nodos.hpp"
+#include "sensor_codec.hpp"
+#include "sensor_json_stream.hpp"
+#include "radio_manager.hpp"
+#include "gateway_cli.hpp"
+#include "metricas.hpp"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h" 
 #include "driver/gpio.h"
+#include "openthread/link.h"
+#include "openthread/thread_ftd.h"
 #include <string.h>
 
 using namespace std;
@@ -16,64 +24,115 @@ otInstance *instance = NULL;
 extern sensor_data_t sensor_data;
 
 TaskHandle_t ot_task_handle = NULL;
-TaskHandle_t coap_send_task_handle = NULL;
+TaskHandle_t amostragem_task_handle = NULL;
 esp_netif_t *openthread_netif;
 
 bool s_ot_active = false;
 volatile bool ot_shutdown_requested = false;
-volatile bool coap_send_shutdown_requested = false;
+volatile bool amostragem_shutdown_requested = false;
+
+// Pedido confirmavel (CON): responde com ACK + codigo embutido. O nó so
+// dorme depois dele; retransmissoes do mesmo CON sao respondidas pelo
+// cache de respostas do OpenThread, sem passar de novo por aqui. O 2.04
+// leva 'dados' (ex.: o id do cadastro) seguido da hora do gateway
+// (sensor_codec.hpp), se ja sincronizada por SNTP.
+static void responder_confirmavel(otMessage *pedido, const otMessageInfo *messageInfo, otCoapCode codigo,
+                                  const uint8_t *dados = NULL, uint16_t dadosLen = 0)
+{
+    if (otCoapMessageGetType(pedido) != OT_COAP_TYPE_CONFIRMABLE) return;
+
+    otInstance *inst = esp_openthread_get_instance();
+    otMessage *resposta = otCoapNewMessage(inst, NULL);
+    if (resposta == NULL) {
+        ESP_LOGW("CoAP", "Sem buffer para o ACK");
+        return;
+    }
+    if (otCoapMessageInitResponse(resposta, pedido, OT_COAP_TYPE_ACKNOWLEDGMENT, codigo) != OT_ERROR_NONE) {
+        otMessageFree(resposta);
+        return;
+    }
+
+    int64_t agora_ms = sensor_agora_ms();
+    if (codigo == OT_COAP_CODE_CHANGED && (dadosLen > 0 || agora_ms != 0)) {
+        uint8_t hora[SENSOR_HORA_TAMANHO];
+        encode_sensor_hora(agora_ms, hora);
+        if (otCoapMessageSetPayloadMarker(resposta) != OT_ERROR_NONE ||
+            (dadosLen > 0 && otMessageAppend(resposta, dados, dadosLen) != OT_ERROR_NONE) ||
+            (agora_ms != 0 && otMessageAppend(resposta, hora, sizeof(hora)) != OT_ERROR_NONE)) {
+            otMessageFree(resposta);
+            return;
+        }
+    }
+
+    if (otCoapSendResponse(inst, resposta, messageInfo) != OT_ERROR_NONE) {
+        otMessageFree(resposta);
+    }
+}
+
+// ==================== POLITICA DE TRAFEGO ====================
+// O gateway e o sorvedouro: a propria leitura vai direto para a tabela de
+// nós, sem passar pela malha (antes era um multicast ff03::1 a cada 10 s que
+// acordava e fazia cada nó interpretar JSON). Os contadores mostram o
+// trafego que deixou de existir e o que ainda chega sem recurso.
+static uint32_t s_amostras_locais = 0;
+static uint32_t s_pedidos_sem_recurso = 0;
+static uint16_t s_gateway_id = CADASTRO_SEM_ID;
+
+// Pedido para recurso que o gateway nao serve: conta e, se CON, responde 4.04
+static void coap_sem_recurso(void *aContext, otMessage *message, const otMessageInfo *messageInfo)
+{
+    OT_UNUSED_VARIABLE(aContext);
+    s_pedidos_sem_recurso++;
+    responder_confirmavel(message, messageInfo, OT_COAP_CODE_NOT_FOUND);
+}
+
+uint16_t gateway_id()
+{
+    return __atomic_load_n(&s_gateway_id, __ATOMIC_RELAXED);
+}
 
-// Envia mensagem via CoAP
-void coap_send_task(void *pvParameters) {
+void registrar_estatisticas_trafego()
+{
+    ESP_LOGI(TAG_CLI, "Trafego: %u leituras do gateway gravadas localmente (0 multicast), "
+             "%u pedidos CoAP sem recurso", (unsigned)s_amostras_locais, (unsigned)s_pedidos_sem_recurso);
+}
+
+// Amostra os sensores do gateway e grava na tabela como um nó local (com
+// id proprio no cadastro, pela EUI-64 de fabrica, como qualquer nó)
+void amostragem_task(void *pvParameters) {
     otInstance *instance = (otInstance *)pvParameters;
+    otExtAddress eui64;
+    // Copia propria: o ciclo de envio (main.cpp) coleta na dele, sem o lock
+    sensor_data_t leitura;
 
     // Salva handle
-    coap_send_task_handle = xTaskGetCurrentTaskHandle();
-
-    while(!coap_send_shutdown_requested) { 
-        // Coleta dados atualizadps       
-        collect_sensor_data(instance, &sensor_data); // Cria JSON        
-        
-        //Cria JSON
-        char* jsonPayload = create_sensor_json(&sensor_data);
-        if (jsonPayload == NULL) {
-            ESP_LOGE(TAG_CLI, "Falha ao criar JSON");
-            break;
-        } 
-        ESP_LOGI(TAG_CLI, "Enviando JSON: %s", jsonPayload);
-        ESP_LOGI(TAG_CLI, "");
-
-        otMessage *msg = otCoapNewMessage(instance, NULL);
-        if(msg) {
-            otCoapMessageInit(msg, OT_COAP_TYPE_NON_CONFIRMABLE, OT_COAP_CODE_POST);
-            otCoapMessageSetToken(msg, (const uint8_t *)"tk", 2);
-
-            // 1 - Define o URI do recurso do servidor envio
-            otCoapMessageAppendUriPathOptions(msg, "sensor");
-            
-            // 2 - Payload Marker
-            otCoapMessageSetPayloadMarker(msg); // <--- ESSENCIAL
-
-            // 3 - Anexa o Payload: 1 byte com o contador
-            //const char *payload = "aquiEstouMaisUmDia";            
-            //otMessageAppend(msg, payload, strlen(payload));                     
-            otMessageAppend(msg, jsonPayload, strlen(jsonPayload));
-            
-            // 4 - Define o destino - ENDERECO            
-            otMessageInfo msgInfo;
-            memset(&msgInfo, 0, sizeof(msgInfo));
-            // "fdde:ad00:beef:0:0:ff:fe00:3c00"            
-            otIp6AddressFromString("ff03::1", &msgInfo.mPeerAddr); 
-            // IPv6 do outro nó            
-            msgInfo.mPeerPort = OT_DEFAULT_COAP_PORT;
-            
-            otCoapSendRequest(instance, msg, &msgInfo, NULL, NULL);
+    amostragem_task_handle = xTaskGetCurrentTaskHandle();
+
+    while(!amostragem_shutdown_requested) { 
+        // A tabela tem um unico escritor por vez: com o lock, exclui o coap_handler
+        esp_openthread_lock_acquire(portMAX_DELAY);
+        collect_sensor_data(&leitura);
+        const otIp6Address *eid = otThreadGetMeshLocalEid(instance);
+        if (eid) {
+            otLinkGetFactoryAssignedIeeeEui64(instance, &eui64);
+            leitura.nodo = cadastro_por_eui64(eui64.m8, *eid);
+            if (leitura.nodo != CADASTRO_SEM_ID) {
+                __atomic_store_n(&s_gateway_id, leitura.nodo, __ATOMIC_RELAXED);
+                registrarNodo(leitura.nodo, leitura);
+                // Raiz da topologia: so o RLOC16, a zero saltos
+                sensor_enlace_t enlace;
+                memset(&enlace, 0, sizeof(enlace));
+                enlace.rloc16 = otThreadGetRloc16(instance);
+                enlace.rssi = SENSOR_RSSI_INVALIDO;
+                registrarEnlace(leitura.nodo, enlace, 0, 0);
+                s_amostras_locais++;
+            }
         }
-
-        free(jsonPayload);
+        esp_openthread_lock_release();
+        metricas_pilha(MT_AMOSTRAGEM);
 
         // delay, mas saí rapidamente se solicitado
-        for (int i = 0; i < 100 && !coap_send_shutdown_requested; ++i) {
+        for (int i = 0; i < 100 && !amostragem_shutdown_requested; ++i) {
             vTaskDelay(pdMS_TO_TICKS(100));
         }
     }
@@ -81,7 +140,7 @@ void coap_send_task(void *pvParameters) {
     // Cleanup antes de sair
     sensors_disable();
 
-    coap_send_task_handle = NULL;
+    amostragem_task_handle = NULL;
     vTaskDelete(NULL); // encerra a si mesma
 }
 
@@ -135,6 +194,190 @@ void configure_thread_network(otInstance *instance)
 }
 
 // ==================== HANDLER  COAP ====================
+// Retorna o Content-Format da mensagem ou -1 se a opcao nao veio
+static int obter_content_format(const otMessage *message)
+{
+    otCoapOptionIterator it;
+    uint64_t formato;
+
+    if (otCoapOptionIteratorInit(&it, message) != OT_ERROR_NONE) return -1;
+    if (otCoapOptionIteratorGetFirstOptionMatching(&it, OT_COAP_OPTION_CONTENT_FORMAT) == NULL) return -1;
+    if (otCoapOptionIteratorGetOptionUintValue(&it, &formato) != OT_ERROR_NONE) return -1;
+    return (int)formato;
+}
+
+// Payload binario (sensor_codec.hpp) — sem heap, buffer fixo na pilha
+static bool decodificar_binario(const otMessage *message, uint16_t offset, uint16_t payloadLen,
+                                sensor_data_t *dados, otIp6Address *eid)
+{
+    uint8_t registro[SENSOR_REGISTRO_TAMANHO];
+
+    if (payloadLen < sizeof(registro)) {
+        ESP_LOGE("CoAP", "Registro binario curto (%d bytes)", payloadLen);
+        return false;
+    }
+
+    otMessageRead(message, offset, registro, sizeof(registro));
+    if (!decode_sensor_record(registro, sizeof(registro), dados, eid)) {
+        ESP_LOGE("CoAP", "Registro binario invalido (versao %d)", registro[0]);
+        return false;
+    }
+
+    ESP_LOGI("CoAP", "Registro v%d: T=%.2f UA=%.2f US=%.2f P=%.2f", registro[0],
+             dados->temperatura, dados->umidadeAr, dados->umidadeSolo, dados->particulas);
+    return true;
+}
+
+// Amostra sem hora (nó ainda sem relogio acertado): vale a da chegada
+static inline void carimbar_chegada(sensor_data_t *dados)
+{
+    if (dados->epoch_ms == 0) {
+        dados->epoch_ms = sensor_agora_ms();
+    }
+}
+
+// ==================== ENLACE NA MALHA ====================
+#define RLOC16_INVALIDO 0xfffe
+
+// Saltos do nó ate este gateway: 1 do filho ao pai (nenhum se o nó e
+// roteador) mais o caminho entre roteadores. Vizinho direto e um salto; mais
+// longe vale o custo de rota do OpenThread, que e 1 por enlace bom (com
+// enlaces ruins, um teto para os saltos)
+static uint8_t saltos_ate(otInstance *inst, uint16_t rloc16, uint8_t *custo)
+{
+    uint16_t roteador = sensor_rloc16_roteador(rloc16);
+    uint8_t acesso = (rloc16 != roteador) ? 1 : 0;
+    uint16_t proximo;
+
+    *custo = 0;
+    if (otThreadGetDeviceRole(inst) < OT_DEVICE_ROLE_ROUTER) return ENLACE_SALTOS_DESCONHECIDO;
+    if (roteador == otThreadGetRloc16(inst)) return acesso;
+
+    otThreadGetNextHopAndPathCost(inst, roteador, &proximo, custo);
+    if (proximo == RLOC16_INVALIDO) return ENLACE_SALTOS_DESCONHECIDO;
+    return acesso + (proximo == roteador ? 1 : *custo);
+}
+
+// Bloco de enlace no fim do payload (sensor_codec.hpp), se sobraram
+// exatamente os bytes dele depois das amostras
+static void registrar_enlace(const otMessage *message, uint16_t offset, uint16_t restante, uint16_t id)
+{
+    uint8_t bloco[SENSOR_ENLACE_TAMANHO];
+    sensor_enlace_t enlace;
+    uint8_t custo;
+
+    if (restante != sizeof(bloco) || otMessageRead(message, offset, bloco, sizeof(bloco)) != sizeof(bloco)) {
+        return;
+    }
+    decode_sensor_enlace(bloco, &enlace);
+    uint8_t saltos = saltos_ate(esp_openthread_get_instance(), enlace.rloc16, &custo);
+    registrarEnlace(id, enlace, saltos, custo);
+}
+
+// Duplicatas ja contadas para o id: o bloco de enlace de um payload so com
+// amostras repetidas ja foi somado quando o original chegou
+static uint32_t duplicadas_do_id(uint16_t id)
+{
+    const NodeInfo *n = buscarNodo(id);
+    return n ? n->seq.duplicadas : 0;
+}
+
+// Resultado do registro de um payload de amostras (codigo da resposta)
+enum ResultadoAmostras {
+    AMOSTRAS_OK = 0,
+    AMOSTRAS_INVALIDAS,         // 4.00
+    AMOSTRAS_ID_DESCONHECIDO,   // 4.04: o nó refaz o cadastro
+    AMOSTRAS_SEM_ESPACO,        // 5.03: cadastro ou tabela de nós cheios
+};
+
+// Lote de amostras do mesmo nó (sensor_codec.hpp), com id ou com EID: cada
+// amostra entra na tabela com a sua sequencia e o seu instante original,
+// como se tivesse chegado sozinha
+static ResultadoAmostras registrar_lote(const otMessage *message, uint16_t offset, uint16_t payloadLen,
+                                        bool com_seq, uint32_t seq)
+{
+    uint8_t cabecalho[SENSOR_LOTE_CABECALHO];
+    uint16_t lidos = payloadLen < sizeof(cabecalho) ? payloadLen : sizeof(cabecalho);
+    otIp6Address eid;
+    uint16_t id = CADASTRO_SEM_ID;
+    uint8_t n = 0;
+
+    size_t cabecalhoLen = (otMessageRead(message, offset, cabecalho, lidos) == lidos)
+                              ? decode_sensor_lote_cabecalho(cabecalho, lidos, &id, &eid, &n) : 0;
+    if (cabecalhoLen == 0 || payloadLen < cabecalhoLen + (size_t)n * SENSOR_AMOSTRA_TAMANHO) {
+        ESP_LOGE("CoAP", "Lote invalido (%d bytes)", payloadLen);
+        return AMOSTRAS_INVALIDAS;
+    }
+
+    if (id == CADASTRO_SEM_ID) {
+        // Lote com EID: nó ainda sem id
+        id = cadastro_por_eid(eid);
+        if (id == CADASTRO_SEM_ID) return AMOSTRAS_SEM_ESPACO;
+    } else if (!cadastro_valido(id)) {
+        ESP_LOGW("CoAP", "Lote do id %u desconhecido: pedindo novo cadastro", (unsigned)id);
+        return AMOSTRAS_ID_DESCONHECIDO;
+    }
+    ESP_LOGI("CoAP", "Lote de %u amostras do id %u", (unsigned)n, (unsigned)id);
+
+    uint32_t duplicadas = duplicadas_do_id(id);
+    uint16_t fim = offset + payloadLen;
+    offset += cabecalhoLen;
+    for (uint8_t k = 0; k < n; k++, offset += SENSOR_AMOSTRA_TAMANHO) {
+        uint8_t amostra[SENSOR_AMOSTRA_TAMANHO];
+        sensor_data_t dados;
+
+        otMessageRead(message, offset, amostra, sizeof(amostra));
+        decode_sensor_amostra(amostra, &dados);
+        dados.nodo = id;
+        carimbar_chegada(&dados);
+        if (!registrarNodo(id, dados, com_seq, seq + k)) {
+            // Tabela de nós cheia (o cadastro tem mais ids que ela): sem o
+            // 2.04 o nó guarda o lote e tenta de novo
+            return AMOSTRAS_SEM_ESPACO;
+        }
+    }
+    if (duplicadas_do_id(id) - duplicadas < n) {
+        registrar_enlace(message, offset, fim - offset, id);
+    }
+    return AMOSTRAS_OK;
+}
+
+// Tamanho do pedaco lido do otMessage por vez (buffer na pilha)
+#define COAP_PEDACO_LEITURA 32
+
+// Payload JSON legado (nós antigos): lido do otMessage em pedacos pelo
+// decodificador incremental, direto para o sensor_data_t — sem heap e
+// sem limite de tamanho do payload
+static bool decodificar_json(const otMessage *message, uint16_t offset, uint16_t payloadLen,
+                             sensor_data_t *dados, otIp6Address *eid, const otMessageInfo *messageInfo)
+{
+    DecodificadorJsonSensor decodificador(dados);
+    char pedaco[COAP_PEDACO_LEITURA];
+
+    while (payloadLen > 0) {
+        uint16_t n = payloadLen < sizeof(pedaco) ? payloadLen : sizeof(pedaco);
+        uint16_t lidos = otMessageRead(message, offset, pedaco, n);
+        if (lidos == 0 || !decodificador.alimentar(pedaco, lidos)) break;
+        offset += lidos;
+        payloadLen -= lidos;
+    }
+
+    if (!decodificador.concluir()) {
+        ESP_LOGE("CoAP", "JSON invalido ou incompleto");
+        return false;
+    }
+
+    ESP_LOGI("CoAP", "JSON de %s: T=%.2f UA=%.2f US=%.2f P=%.2f (campos 0x%02x)",
+             decodificador.endereco(), dados->temperatura, dados->umidadeAr, dados->umidadeSolo,
+             dados->particulas, (unsigned)decodificador.campos());
+
+    // EID do payload; se invalido, usa o remetente
+    if (otIp6AddressFromString(decodificador.endereco(), eid) != OT_ERROR_NONE) {
+        *eid = messageInfo->mPeerAddr;
+    }
+    return true;
+}
+
 void coap_handler(void *aContext, otMessage *message, const otMessageInfo *messageInfo)
 {
     OT_UNUSED_VARIABLE(aContext);
@@ -144,6 +387,10 @@ void coap_handler(void *aContext, otMessage *message, const otMessageInfo *messa
 
     ESP_LOGI("CoAP", "Mensagem recebida de [%s]:%u", addrString, messageInfo->mPeerPort);
 
+    MetricaCronometro cronometro(MH_COAP_HANDLER);
+    metricas_contar(MC_COAP_RX);
+    metricas_pilha(MT_OPENTHREAD);
+
     // Lê todo o payload
     uint16_t offset = otMessageGetOffset(message);
     uint16_t msgLength = otMessageGetLength(message);
@@ -151,64 +398,113 @@ void coap_handler(void *aContext, otMessage *message, const otMessageInfo *messa
 
     if (payloadLen == 0) {
         ESP_LOGE("CoAP", "Mensagem vazia");
+        metricas_contar(MC_COAP_REJEITADOS);
+        responder_confirmavel(message, messageInfo, OT_COAP_CODE_BAD_REQUEST);
         return;
     }
 
-    // Lê o conteúdo
-    char buffer[256]; // tamanho razoável pro seu JSON
-    if (payloadLen >= sizeof(buffer)) payloadLen = sizeof(buffer) - 1;
+    // Negociacao de formato: Content-Format explicito ou, na falta dele,
+    // o primeiro byte ('{' para JSON, versao para registro/lote binario)
+    uint8_t primeiro = 0;
+    otMessageRead(message, offset, &primeiro, 1);
+    int formato = obter_content_format(message);
+    if (formato < 0) {
+        formato = (primeiro == SENSOR_REGISTRO_VERSAO || primeiro == SENSOR_LOTE_VERSAO ||
+                   primeiro == SENSOR_LOTE_VERSAO_ID)
+                      ? OT_COAP_OPTION_CONTENT_FORMAT_OCTET_STREAM
+                      : OT_COAP_OPTION_CONTENT_FORMAT_JSON;
+    }
+
+    // Token comeca pela sequencia da (primeira) amostra (nós antigos mandam "tk")
+    uint32_t seq = 0;
+    bool com_seq = token_para_seq(otCoapMessageGetToken(message),
+                                  otCoapMessageGetTokenLength(message), &seq);
 
-    uint16_t bytesRead = otMessageRead(message, offset, buffer, payloadLen);
-    buffer[bytesRead] = '\0';
+    sensor_data_t dados;
+    otIp6Address eid;
+    ResultadoAmostras resultado;
 
-    ESP_LOGI("CoAP", "Payload recebido (%d bytes): %s", bytesRead, buffer);
+    if (formato == OT_COAP_OPTION_CONTENT_FORMAT_OCTET_STREAM && primeiro != SENSOR_REGISTRO_VERSAO) {
+        resultado = registrar_lote(message, offset, payloadLen, com_seq, seq);
+    } else {
+        bool ok;
+        if (formato == OT_COAP_OPTION_CONTENT_FORMAT_OCTET_STREAM) {
+            ok = decodificar_binario(message, offset, payloadLen, &dados, &eid);
+        } else {
+            ok = decodificar_json(message, offset, payloadLen, &dados, &eid, messageInfo);
+        }
+        // Formatos com EID (nós antigos): o id sai do cadastro
+        dados.nodo = ok ? cadastro_por_eid(eid) : CADASTRO_SEM_ID;
+        if (!ok) {
+            resultado = AMOSTRAS_INVALIDAS;
+        } else if (dados.nodo == CADASTRO_SEM_ID) {
+            resultado = AMOSTRAS_SEM_ESPACO;
+        } else {
+            carimbar_chegada(&dados);
+            uint32_t duplicadas = duplicadas_do_id(dados.nodo);
+            if (!registrarNodo(dados.nodo, dados, com_seq, seq)) {
+                // Tabela de nós cheia, como no lote
+                resultado = AMOSTRAS_SEM_ESPACO;
+            } else {
+                if (formato == OT_COAP_OPTION_CONTENT_FORMAT_OCTET_STREAM &&
+                    duplicadas_do_id(dados.nodo) == duplicadas) {
+                    registrar_enlace(message, offset + SENSOR_REGISTRO_TAMANHO,
+                                     payloadLen - SENSOR_REGISTRO_TAMANHO, dados.nodo);
+                }
+                resultado = AMOSTRAS_OK;
+            }
+        }
+    }
 
-    // ==================== Interpretando JSON ====================
-    cJSON *root = cJSON_Parse(buffer);
-    if (!root) {
-        ESP_LOGE("CoAP", "Erro ao fazer parse do JSON");
-        return;
+    if (resultado != AMOSTRAS_OK) {
+        metricas_contar(MC_COAP_REJEITADOS);
     }
 
-    // Extrai campos
-    const cJSON *endereco = cJSON_GetObjectItemCaseSensitive(root, "e");
-    const cJSON *dataHora = cJSON_GetObjectItemCaseSensitive(root, "d");
-    const cJSON *temperatura = cJSON_GetObjectItemCaseSensitive(root, "t");
-    const cJSON *umidadeAr = cJSON_GetObjectItemCaseSensitive(root, "uA");
-    const cJSON *umidadeSolo = cJSON_GetObjectItemCaseSensitive(root, "uS");
-    const cJSON *particulas = cJSON_GetObjectItemCaseSensitive(root, "p");
-
-    // Verifica e imprime se existir
-    if (cJSON_IsString(endereco) && cJSON_IsString(dataHora)) {
-        ESP_LOGI("JSON", "Endereço: %s", endereco->valuestring);
-        ESP_LOGI("JSON", "Data/Hora: %s", dataHora->valuestring);
-    }
-    if (cJSON_IsNumber(temperatura))
-        ESP_LOGI("JSON", "Temperatura: %.2f", temperatura->valuedouble);
-    if (cJSON_IsNumber(umidadeAr))
-        ESP_LOGI("JSON", "Umidade do Ar: %.2f", umidadeAr->valuedouble);
-    if (cJSON_IsNumber(umidadeSolo))
-        ESP_LOGI("JSON", "Umidade do Solo: %.2f", umidadeSolo->valuedouble);
-    if (cJSON_IsNumber(particulas))
-        ESP_LOGI("JSON", "Particulas: %.2f", particulas->valuedouble);
+    switch (resultado) {
+    case AMOSTRAS_OK:
+        radio_coap_recebido();
+        responder_confirmavel(message, messageInfo, OT_COAP_CODE_CHANGED);
+        break;
+    case AMOSTRAS_ID_DESCONHECIDO:
+        responder_confirmavel(message, messageInfo, OT_COAP_CODE_NOT_FOUND);
+        break;
+    case AMOSTRAS_SEM_ESPACO:
+        responder_confirmavel(message, messageInfo, OT_COAP_CODE_SERVICE_UNAVAILABLE);
+        break;
+    default:
+        responder_confirmavel(message, messageInfo, OT_COAP_CODE_BAD_REQUEST);
+        break;
+    }
+}
 
-    sensor_data_t dados;
-    memset(&dados, 0, sizeof(dados));  // limpa tudo
+// Cadastro (sensor_codec.hpp): EUI-64 + EID -> id curto, no payload do 2.04
+void coap_cadastro_handler(void *aContext, otMessage *message, const otMessageInfo *messageInfo)
+{
+    OT_UNUSED_VARIABLE(aContext);
 
-    // Copia strings recebidas
-    strncpy(dados.endereco, endereco->valuestring, sizeof(dados.endereco)-1);
-    strncpy(dados.dataHora, dataHora->valuestring, sizeof(dados.dataHora)-1);
+    uint8_t pedido[SENSOR_CADASTRO_TAMANHO];
+    uint8_t eui64[SENSOR_EUI64_TAMANHO];
+    otIp6Address eid;
+    uint16_t offset = otMessageGetOffset(message);
+    uint16_t payloadLen = otMessageGetLength(message) - offset;
 
-    // Copia números recebidos
-    dados.temperatura  = cJSON_IsNumber(temperatura)   ? temperatura->valuedouble : 0;
-    dados.umidadeAr    = cJSON_IsNumber(umidadeAr)     ? umidadeAr->valuedouble : 0;
-    dados.umidadeSolo  = cJSON_IsNumber(umidadeSolo)   ? umidadeSolo->valuedouble : 0;
-    dados.particulas   = cJSON_IsNumber(particulas)    ? particulas->valuedouble : 0;
+    if (payloadLen < sizeof(pedido) ||
+        otMessageRead(message, offset, pedido, sizeof(pedido)) != sizeof(pedido)) {
+        ESP_LOGE("CoAP", "Cadastro invalido");
+        responder_confirmavel(message, messageInfo, OT_COAP_CODE_BAD_REQUEST);
+        return;
+    }
+    decode_sensor_cadastro(pedido, eui64, &eid);
 
-    // Registra (usar endereço como key)
-    registrarNodo(string(dados.endereco), dados);
+    uint16_t id = cadastro_por_eui64(eui64, eid);
+    if (id == CADASTRO_SEM_ID) {
+        responder_confirmavel(message, messageInfo, OT_COAP_CODE_SERVICE_UNAVAILABLE);
+        return;
+    }
 
-    cJSON_Delete(root);
+    uint8_t resposta[SENSOR_ID_TAMANHO];
+    encode_sensor_id(id, resposta);
+    responder_confirmavel(message, messageInfo, OT_COAP_CODE_CHANGED, resposta, sizeof(resposta));
 }
 
 // ==================== FUNÇÃO PARA INICIAR THREAD ====================
@@ -218,29 +514,62 @@ void start_thread_network(otInstance *instance)
     gpio_set_direction(PINO_COAP, GPIO_MODE_OUTPUT);
     gpio_set_level(PINO_COAP, 1);
 
-    // Método mais simples - apenas habilita a Thread
+    // Apenas habilita a Thread: o attach so progride depois que o mainloop
+    // roda, entao quem precisa esperar usa RADIO_BIT_THREAD_ATIVO
     otThreadSetEnabled(instance, true);
-        
-    // Aguarda um pouco para inicialização
-    vTaskDelay(pdMS_TO_TICKS(3000));
-    
-    // Verifica o estado
-    otDeviceRole role = otThreadGetDeviceRole(instance);
-    
-    // Se ainda estiver detached, tenta forçar
-    if (role == OT_DEVICE_ROLE_DETACHED) {
-        otThreadSetEnabled(instance, false);
-        vTaskDelay(pdMS_TO_TICKS(1000));
-        otThreadSetEnabled(instance, true);
-        
-        // Aguarda mais um pouco
-        vTaskDelay(pdMS_TO_TICKS(5000));
+}
+
+// Acompanha o papel na rede para medir quanto tempo a malha fica surda
+static void ot_estado_alterado(otChangedFlags flags, void *aContext)
+{
+    if (!(flags & OT_CHANGED_THREAD_ROLE)) return;
+
+    otDeviceRole role = otThreadGetDeviceRole((otInstance *)aContext);
+    if (role == OT_DEVICE_ROLE_DISABLED) {
+        radio_definir_estado(RADIO_THREAD, RADIO_DESLIGADO);
+    } else if (role == OT_DEVICE_ROLE_DETACHED) {
+        radio_definir_estado(RADIO_THREAD, RADIO_SUBINDO);
+    } else {
+        radio_definir_estado(RADIO_THREAD, RADIO_ATIVO);
+    }
+}
+
+#if CONFIG_GATEWAY_SERVICO_THREAD
+// Anuncia o /sensor nos dados de rede (ver sensor_codec.hpp). O OpenThread
+// reenvia ao lider sozinho a cada attach, e outros gateways com o mesmo
+// service data viram servidores do mesmo ALOC.
+static void publicar_servico_sensor(otInstance *instance)
+{
+    otServiceConfig servico;
+    memset(&servico, 0, sizeof(servico));
+
+    servico.mEnterpriseNumber = SENSOR_SERVICO_ENTERPRISE;
+    servico.mServiceDataLength = sizeof(SENSOR_SERVICO_DADOS) - 1;
+    memcpy(servico.mServiceData, SENSOR_SERVICO_DADOS, servico.mServiceDataLength);
+
+    // Estavel: filhos sonolentos so recebem a parte estavel dos dados de rede
+    servico.mServerConfig.mStable = true;
+    servico.mServerConfig.mServerDataLength = 2;
+    servico.mServerConfig.mServerData[0] = (uint8_t)(OT_DEFAULT_COAP_PORT >> 8);
+    servico.mServerConfig.mServerData[1] = (uint8_t)(OT_DEFAULT_COAP_PORT & 0xff);
+
+    otError err = otServerAddService(instance, &servico);
+    if (err == OT_ERROR_NONE || err == OT_ERROR_ALREADY) {
+        err = otServerRegister(instance);
+    }
+    if (err == OT_ERROR_NONE) {
+        ESP_LOGI(TAG_CLI, "Servico \"%s\" publicado nos dados de rede", SENSOR_SERVICO_DADOS);
+    } else {
+        ESP_LOGE(TAG_CLI, "Falha ao publicar servico: %d", err);
     }
 }
+#endif
 
 // ==================== TASK WORKER ====================
 void ot_task_worker(void *aContext)
 {
+    OT_UNUSED_VARIABLE(aContext);
+
     esp_openthread_platform_config_t config = {
         .radio_config = ESP_OPENTHREAD_DEFAULT_RADIO_CONFIG(),
         .host_config = ESP_OPENTHREAD_DEFAULT_HOST_CONFIG(),
@@ -253,6 +582,8 @@ void ot_task_worker(void *aContext)
     instance = esp_openthread_get_instance();
     global_ot_instance = instance; // Inicializa o global_ot_instance
 
+    otSetStateChangedCallback(instance, ot_estado_alterado, instance);
+
     // Configura a rede Thread
     configure_thread_network(instance);  
     
@@ -269,6 +600,15 @@ void ot_task_worker(void *aContext)
     otCoapAddResource(instance, &coap_resource);
     ESP_LOGI(TAG_CLI, "Recurso /sensor adicionado");
 
+    static otCoapResource cadastro_resource;
+    memset(&cadastro_resource, 0, sizeof(cadastro_resource));
+
+    cadastro_resource.mUriPath = SENSOR_CADASTRO_RECURSO;
+    cadastro_resource.mHandler = coap_cadastro_handler;
+    cadastro_resource.mContext = NULL;
+    otCoapAddResource(instance, &cadastro_resource);
+    otCoapSetDefaultHandler(instance, coap_sem_recurso, NULL);
+
     otError err = otCoapStart(instance, OT_DEFAULT_COAP_PORT);
     if(err == OT_ERROR_NONE) {    
         ESP_LOGI(TAG_CLI, "Servidor CoAP iniciado, recurso /sensor/dados");
@@ -276,12 +616,19 @@ void ot_task_worker(void *aContext)
         ESP_LOGE(TAG_CLI, "Falha ao iniciar CoAP: %d", err);    
     }
 
-    // cria task de envio
-    xTaskCreate(coap_send_task, "coap_send_task", 4096, instance, 5, NULL);
+#if CONFIG_GATEWAY_SERVICO_THREAD
+    publicar_servico_sensor(instance);
+#endif
+
+    // cria task de amostragem local
+    xTaskCreate(amostragem_task, "amostragem_task", 4096, instance, 5, NULL);
 
     // Initialize the esp_netif bindings
     openthread_netif = init_openthread_netif(&config);
+#if !CONFIG_GATEWAY_RADIO_COEXISTENCIA
+    // Em coexistencia a rota padrao (IPv4 para o servidor) fica com o Wi-Fi
     esp_netif_set_default_netif(openthread_netif);
+#endif
 
 #if CONFIG_OPENTHREAD_STATE_INDICATOR_ENABLE
     ESP_ERROR_CHECK(esp_openthread_state_indicator_init(esp_openthread_get_instance()));
@@ -299,6 +646,10 @@ void ot_task_worker(void *aContext)
     esp_cli_custom_command_init();
 #endif
 
+#if CONFIG_OPENTHREAD_CLI
+    gateway_cli_iniciar();
+#endif
+
 #if CONFIG_OPENTHREAD_CLI
     esp_openthread_cli_create_task();
 #endif
@@ -312,6 +663,7 @@ void ot_task_worker(void *aContext)
     // ============ MAINLOOP COM CONTROLE MANUAL ============
     ot_task_handle = xTaskGetCurrentTaskHandle();
     s_ot_active = true;
+    radio_sinalizar(RADIO_BIT_OT_RODANDO);
     ESP_LOGI(TAG_CLI, "OpenThread iniciado - usando mainloop automático");
 
     // Esta função é BLOQUEANTE - só retorna quando OpenThread finalizar
@@ -322,14 +674,14 @@ void ot_task_worker(void *aContext)
     // ======================================================
 
     // Cleanup pós-mainloop
-    coap_send_shutdown_requested = true;
+    amostragem_shutdown_requested = true;
     
     // Aguarda task de CoAP finalizar brevemente
     vTaskDelay(pdMS_TO_TICKS(500));
     
-    if (coap_send_task_handle != NULL) {
-        vTaskDelete(coap_send_task_handle);
-        coap_send_task_handle = NULL;
+    if (amostragem_task_handle != NULL) {
+        vTaskDelete(amostragem_task_handle);
+        amostragem_task_handle = NULL;
     }
 
     // Limpa variáveis globais
@@ -337,8 +689,10 @@ void ot_task_worker(void *aContext)
     openthread_netif = NULL;
     ot_task_handle = NULL;
     s_ot_active = false;
-    coap_send_shutdown_requested = false;
+    amostragem_shutdown_requested = false;
 
+    radio_limpar(RADIO_BIT_OT_RODANDO);
+    radio_sinalizar(RADIO_BIT_OT_PARADO);
     vTaskDelete(NULL);
 }
 
@@ -349,7 +703,9 @@ void ot_enable(void) {
     }
 
     ot_shutdown_requested = false;
-    coap_send_shutdown_requested = false;
+    amostragem_shutdown_requested = false;
+    radio_definir_estado(RADIO_THREAD, RADIO_SUBINDO);
+    radio_limpar(RADIO_BIT_OT_RODANDO | RADIO_BIT_OT_PARADO);
 
     // ==================== INICIALIZAÇÃO OPENTHREAD ====================    
     // Cria tarefa do OpenThread (comunicação mesh)
@@ -363,12 +719,8 @@ void ot_enable(void) {
         return;
     }                 
     
-    // aguarda até a task setar s_ot_active (ou timeout)
-    const TickType_t timeout = pdMS_TO_TICKS(3000);
-    TickType_t t0 = xTaskGetTickCount();
-    while (!s_ot_active && (xTaskGetTickCount() - t0) < timeout) {
-        vTaskDelay(pdMS_TO_TICKS(50));
-    }
+    // aguarda a task entrar no mainloop (ou timeout)
+    radio_aguardar(FASE_OT_INICIAR, RADIO_BIT_OT_RODANDO, 3000);
 
     // Executa mainloop (em task própria normalmente)
     ESP_LOGI(TAG_CLI, "OpenThread ativado.");
@@ -379,13 +731,15 @@ void ot_disable(void)
 {
     if (!s_ot_active) return;
 
+    radio_definir_estado(RADIO_THREAD, RADIO_DESLIGADO);
+
     // 1) Para CoAP primeiro
     if (instance) {
         otCoapStop(instance);
     }
 
     // 2) Sinaliza para task de envio CoAP parar
-    coap_send_shutdown_requested = true;
+    amostragem_shutdown_requested = true;
 
     // 3) **FORMA CORRETA NO ESP-IDF v5: Desabilita a Thread**
     if (instance) {
@@ -397,8 +751,8 @@ void ot_disable(void)
     // No ESP-IDF v5, o mainloop termina quando a Thread é desabilitada
     // O cleanup é feito automaticamente quando o mainloop retorna
 
-    // 5) Aguarda um pouco para o mainloop terminar
-    vTaskDelay(pdMS_TO_TICKS(1000));
+    // 5) Aguarda o mainloop terminar (ou timeout)
+    radio_aguardar(FASE_OT_PARAR, RADIO_BIT_OT_PARADO, 1000);
 
     // 6) Força finalização se necessário
     if (ot_task_handle != NULL) {
@@ -407,9 +761,9 @@ void ot_disable(void)
     }
 
     // 7) Limpa task de CoAP se ainda existir
-    if (coap_send_task_handle != NULL) {
-        vTaskDelete(coap_send_task_handle);
-        coap_send_task_handle = NULL;
+    if (amostragem_task_handle != NULL) {
+        vTaskDelete(amostragem_task_handle);
+        amostragem_task_handle = NULL;
     }
 
     // 8) Destrói netif
@@ -421,6 +775,6 @@ void ot_disable(void)
     // 9) Reseta estado
     instance = NULL;
     s_ot_active = false;
-    coap_send_shutdown_requested = false;
+    amostragem_shutdown_requested = false;
     gpio_set_level(PINO_COAP, 0);
 }
\ No newline at end of file
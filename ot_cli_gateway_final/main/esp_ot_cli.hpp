@@ -29,6 +29,7 @@
 #include "openthread/coap.h"
 #include "openthread/message.h"
 #include "openthread/thread.h"
+#include "openthread/server.h"
 
 #include "sdkconfig.h" // se usar algo do tipo CONFIG precisa ter
 
@@ -40,12 +41,16 @@
 #endif // CONFIG_OPENTHREAD_CLI_ESP_EXTENSION
 
 extern otInstance *global_ot_instance;
-extern sensor_data_t sensor_data;
 
-void coap_send_task(void *pvParameters);
+void amostragem_task(void *pvParameters);
+// Id do proprio gateway no cadastro (CADASTRO_SEM_ID ate a primeira
+// amostragem); qualquer task le
+uint16_t gateway_id();
+void registrar_estatisticas_trafego();
 esp_netif_t *init_openthread_netif(const esp_openthread_platform_config_t *config);
 void configure_thread_network(otInstance *instance);
 void coap_handler(void *aContext, otMessage *message, const otMessageInfo *messageInfo);
+void coap_cadastro_handler(void *aContext, otMessage *message, const otMessageInfo *messageInfo);
 void ot_task_worker(void *aContext);
 void ot_enable(void);
 void ot_disable(void);
\ No newline at end of file
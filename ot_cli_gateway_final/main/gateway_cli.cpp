@@ -0,0 +1,164 @@
+#include "gateway_cli.hpp"
+#include "node_table.hpp"
+#include "cadastro_nodos.hpp"
+#include "metricas.hpp"
+#include "esp_log.h"
+#include "openthread/cli.h"
+#include <stdio.h>
+
+static const char *TAG_GW_CLI = "GATEWAY_CLI";
+
+static otError cmd_nodos(void *aContext, uint8_t aArgsLength, char *aArgs[])
+{
+    (void)aContext;
+    (void)aArgsLength;
+    (void)aArgs;
+
+    char ip[OT_IP6_ADDRESS_STRING_SIZE];
+    NodeInfo n;
+    size_t total = totalNodos();
+    uint32_t agora = esp_log_timestamp();
+
+    otCliOutputFormat("| # | id | endereco | estado | idade s | rx | perd | lac | dup | reord | reini | perda %%o |\r\n");
+    for (size_t i = 0; i < total; i++) {
+        if (!lerNodo(i, &n)) continue;
+
+        cadastro_eid_texto(n.id, ip, sizeof(ip));
+        const EstatisticasSequencia &s = n.seq;
+        if (!s.iniciada) {
+            otCliOutputFormat("| %u | %u | %s | %s | %u | sem sequencia |\r\n", (unsigned)i, (unsigned)n.id, ip,
+                              estadoNodoNome(estadoNodo(n, agora)),
+                              (unsigned)((agora - n.last_update_ms) / 1000));
+            continue;
+        }
+        otCliOutputFormat("| %u | %u | %s | %s | %u | %u | %u | %u | %u | %u | %u | %u |\r\n", (unsigned)i,
+                          (unsigned)n.id, ip,
+                          estadoNodoNome(estadoNodo(n, agora)),
+                          (unsigned)((agora - n.last_update_ms) / 1000),
+                          (unsigned)s.recebidas, (unsigned)s.perdidas, (unsigned)seqLacunas(s),
+                          (unsigned)s.duplicadas, (unsigned)s.reordenadas, (unsigned)s.reinicios,
+                          (unsigned)seqPerdaPermil(s));
+    }
+
+    EstatisticasNodos e;
+    estatisticasNodos(agora, &e);
+    otCliOutputFormat("%u online, %u stale, %u offline; %u posicoes; +%u novos -%u despejados\r\n",
+                      (unsigned)e.online, (unsigned)e.stale, (unsigned)e.offline,
+                      (unsigned)e.posicoes, (unsigned)e.novos, (unsigned)e.despejados);
+    return OT_ERROR_NONE;
+}
+
+// Cadastro completo (inclusive nós despejados da tabela): id, EUI-64 e EID
+static otError cmd_cadastro(void *aContext, uint8_t aArgsLength, char *aArgs[])
+{
+    (void)aContext;
+    (void)aArgsLength;
+    (void)aArgs;
+
+    char ip[OT_IP6_ADDRESS_STRING_SIZE];
+    char eui64[2 * SENSOR_EUI64_TAMANHO + 1];
+    uint16_t total = cadastro_total();
+
+    otCliOutputFormat("| id | eui64 | endereco |\r\n");
+    for (uint16_t id = 1; id <= total; id++) {
+        cadastro_eui64_texto(id, eui64, sizeof(eui64));
+        cadastro_eid_texto(id, ip, sizeof(ip));
+        otCliOutputFormat("| %u | %s | %s |\r\n", (unsigned)id, eui64, ip);
+    }
+    otCliOutputFormat("%u de %d ids usados\r\n", (unsigned)total, CADASTRO_CAPACIDADE);
+    return OT_ERROR_NONE;
+}
+
+// Topologia da malha: RLOC16 e pai de cada nó, saltos ate o gateway,
+// enlace com o pai e contadores MAC (- = sem dado)
+static otError cmd_topologia(void *aContext, uint8_t aArgsLength, char *aArgs[])
+{
+    (void)aContext;
+    (void)aArgsLength;
+    (void)aArgs;
+
+    NodeInfo n;
+    size_t total = totalNodos();
+    uint32_t agora = esp_log_timestamp();
+
+    otCliOutputFormat("| id | rloc16 | pai | saltos | custo | rssi | margem | lq in/out | tx | retx | sem ack | cca | idade s |\r\n");
+    for (size_t i = 0; i < total; i++) {
+        if (!lerNodo(i, &n) || n.enlace.relatos == 0) continue;
+
+        const EnlaceNodo &e = n.enlace;
+        char pai[8] = "-";
+        char saltos[8] = "-";
+        char rssi[8] = "-";
+        uint16_t roteador = sensor_rloc16_roteador(e.ultimo.rloc16);
+        if (roteador != e.ultimo.rloc16) snprintf(pai, sizeof(pai), "%04x", roteador);
+        if (e.saltos != ENLACE_SALTOS_DESCONHECIDO) snprintf(saltos, sizeof(saltos), "%u", (unsigned)e.saltos);
+        if (e.ultimo.rssi != SENSOR_RSSI_INVALIDO) snprintf(rssi, sizeof(rssi), "%d", (int)e.ultimo.rssi);
+
+        otCliOutputFormat("| %u | %04x | %s | %s | %u | %s | %u | %u/%u | %u | %u | %u | %u | %u |\r\n",
+                          (unsigned)n.id, (unsigned)e.ultimo.rloc16, pai, saltos, (unsigned)e.custo, rssi,
+                          (unsigned)e.ultimo.margem, (unsigned)e.ultimo.qualidade_entrada,
+                          (unsigned)e.ultimo.qualidade_saida, (unsigned)e.quadros, (unsigned)e.retentativas,
+                          (unsigned)e.sem_ack, (unsigned)e.cca, (unsigned)((agora - e.atualizado_ms) / 1000));
+    }
+    return OT_ERROR_NONE;
+}
+
+// Registro de metricas: contadores (total e por minuto desde o boot),
+// histogramas de latencia, heap e menor folga de pilha por task
+static otError cmd_metricas(void *aContext, uint8_t aArgsLength, char *aArgs[])
+{
+    (void)aContext;
+    (void)aArgsLength;
+    (void)aArgs;
+
+    metricas_pilha(MT_CLI);
+    uint32_t agora = esp_log_timestamp();
+
+    otCliOutputFormat("| contador | total | por min |\r\n");
+    for (int c = 0; c < MC_TOTAL; c++) {
+        MetricaTaxa desde_boot = { 0, 0 };
+        uint32_t taxa = metricas_taxa_minuto((MetricaContador)c, &desde_boot, agora);
+        otCliOutputFormat("| %s | %u | %u |\r\n", metricas_contador_nome((MetricaContador)c),
+                          (unsigned)desde_boot.valor, (unsigned)taxa);
+    }
+
+    otCliOutputFormat("| histograma | unid | n | media | p50 | p90 | p99 | max |\r\n");
+    for (int h = 0; h < MH_TOTAL; h++) {
+        MetricaResumo r;
+        metricas_resumo((MetricaHistograma)h, &r);
+        if (r.n == 0) continue;
+        otCliOutputFormat("| %s | %s | %u | %u | %u | %u | %u | %u |\r\n",
+                          metricas_histograma_nome((MetricaHistograma)h),
+                          metricas_histograma_unidade((MetricaHistograma)h), (unsigned)r.n,
+                          (unsigned)(r.soma / r.n), (unsigned)r.p50, (unsigned)r.p90, (unsigned)r.p99,
+                          (unsigned)r.max);
+    }
+
+    uint32_t livre, minimo;
+    metricas_heap(&livre, &minimo);
+    otCliOutputFormat("heap: %u bytes livres, minimo %u\r\n", (unsigned)livre, (unsigned)minimo);
+
+    otCliOutputFormat("| task | folga minima de pilha (bytes) |\r\n");
+    for (int t = 0; t < MT_TOTAL; t++) {
+        uint32_t folga = metricas_pilha_minima((MetricaTask)t);
+        if (folga == METRICAS_PILHA_NUNCA) continue;
+        otCliOutputFormat("| %s | %u |\r\n", metricas_task_nome((MetricaTask)t), (unsigned)folga);
+    }
+    return OT_ERROR_NONE;
+}
+
+static const otCliCommand comandos[] = {
+    { "nodos", cmd_nodos },
+    { "cadastro", cmd_cadastro },
+    { "topologia", cmd_topologia },
+    { "metricas", cmd_metricas },
+};
+
+void gateway_cli_iniciar()
+{
+    otError err = otCliSetUserCommands(comandos, sizeof(comandos) / sizeof(comandos[0]), NULL);
+    if (err != OT_ERROR_NONE) {
+        // OPENTHREAD_CONFIG_CLI_MAX_USER_CMD_ENTRIES esgotado pela extensao
+        ESP_LOGW(TAG_GW_CLI, "Falha ao registrar comandos do gateway: %d", err);
+    }
+}
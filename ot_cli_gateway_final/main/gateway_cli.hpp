@@ -0,0 +1,14 @@
+#pragma once
+
+// ==================== COMANDOS DE CLI DO GATEWAY ====================
+// Comandos proprios registrados no CLI do OpenThread (ao lado dos da
+// extensao da Espressif):
+//
+//   nodos     tabela de nós: estado, idade e estatisticas de sequencia
+//             (recebidas, perdidas, lacunas, duplicadas, reordenadas,
+//             reinicios e perda estimada)
+//   metricas  contadores, histogramas de latencia, heap e pilhas
+//             (metricas.hpp)
+
+// Registra os comandos (chamar depois de esp_openthread_cli_init)
+void gateway_cli_iniciar();
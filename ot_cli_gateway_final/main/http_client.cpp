@@ -0,0 +1,355 @@
+#include "http_client.hpp"
+#include "metricas.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netdb.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "esp_log.h"
+
+#define TAG_HTTPC "http_client"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+// ==================== AUXILIARES ====================
+static uint32_t agora_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000u + ts.tv_nsec / 1000000u);
+}
+
+// Procura "\r\n\r\n" (fim do cabecalho) nos primeiros len bytes
+static const char *fim_cabecalho(const char *buf, size_t len)
+{
+    for (size_t i = 0; i + 3 < len; i++) {
+        if (buf[i] == '\r' && buf[i + 1] == '\n' && buf[i + 2] == '\r' && buf[i + 3] == '\n') {
+            return buf + i;
+        }
+    }
+    return NULL;
+}
+
+static inline bool status_ok(int status)
+{
+    return status >= 200 && status < 300;
+}
+
+// ==================== CICLO DE VIDA ====================
+HttpCliente::HttpCliente(const char *host, const char *porta)
+    : m_dns_valido(false), m_dns_expira_ms(0), m_sock(-1),
+      m_fechar_apos_resposta(false), m_rx_len(0), m_ultimo_status(-1)
+{
+    strncpy(m_host, host, sizeof(m_host) - 1);
+    m_host[sizeof(m_host) - 1] = '\0';
+    strncpy(m_porta, porta, sizeof(m_porta) - 1);
+    m_porta[sizeof(m_porta) - 1] = '\0';
+    memset(&m_endereco, 0, sizeof(m_endereco));
+    memset(&m_est, 0, sizeof(m_est));
+}
+
+HttpCliente::~HttpCliente()
+{
+    fechar();
+}
+
+void HttpCliente::fechar()
+{
+    if (m_sock >= 0) {
+        close(m_sock);
+        m_sock = -1;
+    }
+    m_rx_len = 0;
+    m_fechar_apos_resposta = false;
+}
+
+void HttpCliente::iniciar_ciclo()
+{
+    memset(&m_est, 0, sizeof(m_est));
+}
+
+void HttpCliente::registrar_estatisticas(const char *tag) const
+{
+    uint32_t total = m_est.requisicoes + m_est.falhas;
+    ESP_LOGI(tag, "HTTP ciclo: %u ok / %u falhas | TCP %u novas, %u reusadas | DNS %u consultas, %u cache",
+             (unsigned)m_est.requisicoes, (unsigned)m_est.falhas,
+             (unsigned)m_est.conexoes_novas, (unsigned)m_est.conexoes_reusadas,
+             (unsigned)m_est.dns_consultas, (unsigned)m_est.dns_cache);
+    ESP_LOGI(tag, "HTTP ciclo: %u bytes enviados, %u recebidos | latencia media %u ms, max %u ms",
+             (unsigned)m_est.bytes_enviados, (unsigned)m_est.bytes_recebidos,
+             (unsigned)(total ? m_est.latencia_total_ms / total : 0), (unsigned)m_est.latencia_max_ms);
+}
+
+// ==================== DNS E CONEXAO ====================
+bool HttpCliente::resolver()
+{
+    if (m_dns_valido && (int32_t)(m_dns_expira_ms - agora_ms()) > 0) {
+        m_est.dns_cache++;
+        return true;
+    }
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo *res = NULL;
+    m_est.dns_consultas++;
+    int err = getaddrinfo(m_host, m_porta, &hints, &res);
+    if (err != 0 || res == NULL) {
+        ESP_LOGE(TAG_HTTPC, "DNS lookup failed err=%d res=%p", err, res);
+        m_dns_valido = false;
+        return false;
+    }
+
+    memcpy(&m_endereco, res->ai_addr, sizeof(m_endereco));
+    freeaddrinfo(res);
+
+    m_dns_valido = true;
+    m_dns_expira_ms = agora_ms() + HTTP_DNS_TTL_MS;
+    ESP_LOGI(TAG_HTTPC, "DNS lookup succeeded. IP=%s", inet_ntoa(m_endereco.sin_addr));
+    return true;
+}
+
+bool HttpCliente::conectar()
+{
+    if (m_sock >= 0) {
+        m_est.conexoes_reusadas++;
+        return true;
+    }
+
+    uint32_t inicio_us = metricas_agora_us();
+    if (!resolver()) return false;
+
+    m_sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (m_sock < 0) {
+        ESP_LOGE(TAG_HTTPC, "Falha ao criar socket.");
+        return false;
+    }
+
+    if (connect(m_sock, (struct sockaddr *)&m_endereco, sizeof(m_endereco)) != 0) {
+        ESP_LOGE(TAG_HTTPC, "Falha ao conectar ao servidor.");
+        fechar();
+        m_dns_valido = false;   // o IP pode ter mudado: resolve de novo na proxima
+        return false;
+    }
+
+    struct timeval timeout = {HTTP_TIMEOUT_S, 0};
+    setsockopt(m_sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(m_sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    // Cabecalho e corpo vao em writes separados: sem Nagle para nao atrasar o corpo
+    int um = 1;
+    setsockopt(m_sock, IPPROTO_TCP, TCP_NODELAY, &um, sizeof(um));
+
+    m_rx_len = 0;
+    m_fechar_apos_resposta = false;
+    m_est.conexoes_novas++;
+    metricas_registrar(MH_HTTP_CONECTAR, metricas_agora_us() - inicio_us);
+    return true;
+}
+
+// ==================== E/S ====================
+bool HttpCliente::escrever_tudo(const char *buf, size_t len)
+{
+    while (len > 0) {
+        int n = send(m_sock, buf, len, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        m_est.bytes_enviados += n;
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+int HttpCliente::receber(char *buf, size_t len)
+{
+    int r = recv(m_sock, buf, len, 0);
+    if (r > 0) m_est.bytes_recebidos += r;
+    return r;
+}
+
+bool HttpCliente::enviar_requisicao(const char *path, const char *corpo, size_t corpo_len,
+                                    const char *origem, const char *content_type)
+{
+    char cabecalho[256];
+    int len = snprintf(cabecalho, sizeof(cabecalho),
+             "POST %s HTTP/1.1\r\n"
+             "Host: %s\r\n"
+             "User-Agent: ESP32-Gateway\r\n"
+             "Connection: keep-alive\r\n"
+             "Content-Type: %s\r\n"
+             "Content-Length: %u\r\n"
+             "X-Origem: %s\r\n"
+             "\r\n",
+             path, m_host, content_type, (unsigned)corpo_len, origem ? origem : "");
+
+    if (len < 0 || len >= (int)sizeof(cabecalho)) {
+        ESP_LOGE(TAG_HTTPC, "Cabecalho HTTP nao coube no buffer");
+        return false;
+    }
+
+    MetricaCronometro cronometro(MH_HTTP_ENVIAR);
+    return escrever_tudo(cabecalho, len) && escrever_tudo(corpo, corpo_len);
+}
+
+// Le uma resposta completa, usando Content-Length para saber onde ela termina.
+// Bytes que ja pertencem a proxima resposta (pipelining) ficam em m_rx.
+bool HttpCliente::ler_resposta(int *status)
+{
+    const char *fim;
+    while ((fim = fim_cabecalho(m_rx, m_rx_len)) == NULL) {
+        if (m_rx_len == sizeof(m_rx)) {
+            ESP_LOGE(TAG_HTTPC, "Cabecalho de resposta maior que %d bytes", HTTP_RX_BUFFER);
+            return false;
+        }
+        int r = receber(m_rx + m_rx_len, sizeof(m_rx) - m_rx_len);
+        if (r <= 0) return false;
+        m_rx_len += r;
+    }
+
+    size_t cab_len = (size_t)(fim - m_rx) + 4;
+
+    // Linha de status: "HTTP/1.x NNN ..."
+    int maior = 1, menor = 0, codigo = -1;
+    if (sscanf(m_rx, "HTTP/%d.%d %d", &maior, &menor, &codigo) != 3) {
+        ESP_LOGE(TAG_HTTPC, "Linha de status invalida");
+        return false;
+    }
+
+    // Cabecalhos relevantes
+    long content_length = -1;
+    bool fechar_conexao = (maior == 1 && menor == 0);  // HTTP/1.0 fecha por padrao
+    for (const char *linha = strstr(m_rx, "\r\n") + 2; linha < fim; linha = strstr(linha, "\r\n") + 2) {
+        if (strncasecmp(linha, "Content-Length:", 15) == 0) {
+            content_length = strtol(linha + 15, NULL, 10);
+        } else if (strncasecmp(linha, "Connection:", 11) == 0) {
+            const char *valor = linha + 11;
+            while (*valor == ' ') valor++;
+            if (strncasecmp(valor, "close", 5) == 0) fechar_conexao = true;
+            else if (strncasecmp(valor, "keep-alive", 10) == 0) fechar_conexao = false;
+        }
+    }
+
+    // Descarta o corpo
+    size_t no_buffer = m_rx_len - cab_len;
+    if (content_length >= 0) {
+        size_t consumido = (no_buffer < (size_t)content_length) ? no_buffer : (size_t)content_length;
+        memmove(m_rx, m_rx + cab_len + consumido, no_buffer - consumido);
+        m_rx_len = no_buffer - consumido;
+
+        long falta = content_length - (long)consumido;
+        char descarte[128];
+        while (falta > 0) {
+            int r = receber(descarte, (falta < (long)sizeof(descarte)) ? (size_t)falta : sizeof(descarte));
+            if (r <= 0) return false;
+            falta -= r;
+        }
+    } else {
+        // Sem Content-Length: o corpo vai ate o servidor fechar
+        char descarte[128];
+        while (receber(descarte, sizeof(descarte)) > 0) {}
+        m_rx_len = 0;
+        fechar_conexao = true;
+    }
+
+    m_fechar_apos_resposta = fechar_conexao;
+    if (status) *status = codigo;
+    return true;
+}
+
+// ==================== API ====================
+bool HttpCliente::post(const char *path, const char *corpo, const char *origem,
+                       const char *content_type, int *status)
+{
+    const char *corpos[1] = {corpo};
+
+    // post_pipeline ja cuida do reenvio numa conexao nova se a antiga caiu
+    m_ultimo_status = -1;
+    size_t aceitos = post_pipeline(path, corpos, 1, origem, content_type);
+
+    if (status) *status = m_ultimo_status;
+    return aceitos == 1;
+}
+
+size_t HttpCliente::post_pipeline(const char *path, const char *const *corpos, size_t n,
+                                  const char *origem, const char *content_type)
+{
+    size_t aceitos = 0;
+    size_t i = 0;
+    bool reenviou = false;
+
+    while (i < n) {
+        bool reusada = (m_sock >= 0);
+        if (!conectar()) break;
+
+        size_t lote = n - i;
+        if (lote > HTTP_MAX_PIPELINE) lote = HTTP_MAX_PIPELINE;
+
+        // 1) Escreve todas as requisicoes do lote sem esperar respostas
+        uint32_t t0 = agora_ms();
+        uint32_t t0_us = metricas_agora_us();
+        size_t enviados = 0;
+        while (enviados < lote &&
+               enviar_requisicao(path, corpos[i + enviados], strlen(corpos[i + enviados]), origem, content_type)) {
+            enviados++;
+        }
+
+        // 2) Le as respostas na mesma ordem
+        size_t respondidos = 0;
+        while (respondidos < enviados) {
+            int status = -1;
+            if (!ler_resposta(&status)) break;
+            m_ultimo_status = status;
+
+            uint32_t lat = agora_ms() - t0;
+            m_est.latencia_total_ms += lat;
+            if (lat > m_est.latencia_max_ms) m_est.latencia_max_ms = lat;
+            metricas_registrar(MH_HTTP_RESPOSTA, metricas_agora_us() - t0_us);
+
+            if (status_ok(status)) {
+                aceitos++;
+                m_est.requisicoes++;
+                metricas_contar(MC_HTTP_OK);
+            } else {
+                ESP_LOGW(TAG_HTTPC, "POST %s respondeu %d", path, status);
+                m_est.falhas++;
+                metricas_contar(MC_HTTP_FALHAS);
+            }
+            respondidos++;
+
+            if (m_fechar_apos_resposta) break;
+        }
+
+        i += respondidos;
+
+        if (respondidos < lote || m_fechar_apos_resposta) {
+            fechar();
+        }
+
+        if (respondidos == 0) {
+            // Conexao keep-alive antiga pode ter sido encerrada pelo servidor:
+            // tenta uma unica vez numa conexao nova
+            if (reusada && !reenviou) {
+                reenviou = true;
+                continue;
+            }
+            break;
+        }
+    }
+
+    if (i < n) {
+        ESP_LOGE(TAG_HTTPC, "%u de %u POSTs sem resposta", (unsigned)(n - i), (unsigned)n);
+        m_est.falhas += n - i;
+        metricas_contar(MC_HTTP_FALHAS, n - i);
+    }
+    return aceitos;
+}
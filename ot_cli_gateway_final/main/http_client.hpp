@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <netinet/in.h>
+
+// Tempo de vida do endereco resolvido (o getaddrinfo do lwIP nao expõe o TTL real)
+#define HTTP_DNS_TTL_MS      (10 * 60 * 1000)
+#define HTTP_TIMEOUT_S       5
+#define HTTP_RX_BUFFER       512
+#define HTTP_MAX_PIPELINE    16
+
+// Contadores de um ciclo de envio (zerados por iniciar_ciclo)
+struct HttpEstatisticas {
+    uint32_t requisicoes;        // POSTs com resposta 2xx
+    uint32_t falhas;             // POSTs sem resposta ou com status != 2xx
+    uint32_t conexoes_novas;     // handshakes TCP feitos
+    uint32_t conexoes_reusadas;  // envios que aproveitaram a conexao aberta
+    uint32_t dns_consultas;      // getaddrinfo efetivamente chamados
+    uint32_t dns_cache;          // resolucoes atendidas pelo cache
+    uint32_t bytes_enviados;     // bytes de aplicacao escritos no socket
+    uint32_t bytes_recebidos;    // bytes de aplicacao lidos do socket
+    uint32_t latencia_total_ms;  // soma (envio -> fim da resposta) por POST
+    uint32_t latencia_max_ms;
+};
+
+// Cliente HTTP/1.1 minimo com keep-alive, cache de DNS e pipelining.
+// Usa apenas a API BSD de sockets, entao compila tanto no ESP-IDF (lwIP)
+// quanto no host, para testes contra um servidor local.
+class HttpCliente {
+public:
+    HttpCliente(const char *host, const char *porta);
+    ~HttpCliente();
+
+    // Um POST; status recebe o codigo HTTP (ou -1 se nao houve resposta)
+    bool post(const char *path, const char *corpo, const char *origem,
+              const char *content_type = "application/json", int *status = nullptr);
+
+    // Varios POSTs escritos de uma vez na mesma conexao; as respostas sao
+    // lidas em ordem. Retorna quantos foram aceitos (2xx).
+    size_t post_pipeline(const char *path, const char *const *corpos, size_t n, const char *origem,
+                         const char *content_type = "application/json");
+
+    void fechar();
+    void iniciar_ciclo();
+    void registrar_estatisticas(const char *tag) const;
+    const HttpEstatisticas &estatisticas() const { return m_est; }
+
+private:
+    bool resolver();
+    bool conectar();
+    bool enviar_requisicao(const char *path, const char *corpo, size_t corpo_len,
+                           const char *origem, const char *content_type);
+    bool ler_resposta(int *status);
+    bool escrever_tudo(const char *buf, size_t len);
+    int receber(char *buf, size_t len);
+
+    char m_host[64];
+    char m_porta[8];
+
+    struct sockaddr_in m_endereco;
+    bool m_dns_valido;
+    uint32_t m_dns_expira_ms;
+
+    int m_sock;
+    bool m_fechar_apos_resposta;
+
+    // Bytes ja lidos e ainda nao consumidos (inicio da proxima resposta)
+    char m_rx[HTTP_RX_BUFFER];
+    size_t m_rx_len;
+
+    int m_ultimo_status;
+    HttpEstatisticas m_est;
+};
@@ -1,6 +1,11 @@
 #include "http_request.hpp"
 #include "esp_ot_cli.hpp"
 #include "node_table.hpp"
+#include "http_client.hpp"
+#include "journal.hpp"
+#include "agregacao.hpp"
+#include "cadastro_nodos.hpp"
+#include "metricas.hpp"
 #include <string>
 #include <sstream>
 #include <string.h>
@@ -14,139 +19,560 @@ TaskHandle_t http_task_handle = NULL;
 bool s_http_active = false;
 volatile bool http_shutdown_requested = false;
 
+// Destino do upload (o host_sim troca pelo servidor local na compilacao)
+#ifndef WEB_SERVER
 #define WEB_SERVER "cmindustries.loca.lt"
+#endif
+#ifndef WEB_PORT
 #define WEB_PORT "80"
+#endif
 #define POST_PATH "/data"
 
-void http_send_all_now()
+// Cliente HTTP/1.1 persistente: DNS em cache e conexao keep-alive entre envios
+static HttpCliente s_cliente(WEB_SERVER, WEB_PORT);
+
+// X-Origem: EID do gateway, pelo id que a amostragem local cadastrou
+// (so a task de envio usa)
+static const char *origem_gateway()
 {
-    ESP_LOGI(TAG_HTTP, "Iniciando envio HTTP síncrono...");
+    static char origem[OT_IP6_ADDRESS_STRING_SIZE];
+    cadastro_eid_texto(gateway_id(), origem, sizeof(origem));
+    return origem;
+}
 
-    // ==========================
-    // 1) Envia SEU próprio nó
-    // ==========================
-    extern sensor_data_t sensor_data;
+#if CONFIG_GATEWAY_HTTP_BATCH
+#if CONFIG_GATEWAY_UPLOAD_RESUMO
+// Resumo de janela de um nó incluido no lote em montagem
+struct ResumoLote {
+    size_t nodo;
+    uint32_t seq;
+};
 
-    char* json_me = create_sensor_json(&sensor_data);
-    if (json_me) {
-        ESP_LOGI(TAG_HTTP, "Enviando meu próprio nó...");
-        enviar_uma_requisicao_http(sensor_data.endereco, json_me);
-        free(json_me);
+static bool enviar_lote_resumos(cJSON *lote, const ResumoLote *incluidos, size_t n)
+{
+    char *json = cJSON_PrintUnformatted(lote);
+    if (!json) {
+        ESP_LOGE(TAG_HTTP, "Falha ao montar lote de resumos");
+        return false;
     }
 
-    // ==========================
-    // 2) Envia TODOS os nós do vector
-    // ==========================
-    const auto& tabela = getTabelaNodos();
-    ESP_LOGI(TAG_HTTP, "Enviando %d nós do vector...", (int)tabela.size());
+    bool ok = enviar_uma_requisicao_http(origem_gateway(), json);
+    free(json);
 
-    for (const auto& entry : tabela) {
+    if (ok) {
+        for (size_t k = 0; k < n; k++) {
+            agregacao_confirmar(incluidos[k].nodo, incluidos[k].seq);
+        }
+    }
+    return ok;
+}
 
-        char* json = create_sensor_json(&entry.dados);
-        if (json) {
-            ESP_LOGI(TAG_HTTP, "Enviando nó: %s", entry.endereco.c_str());
-            enviar_uma_requisicao_http(entry.endereco.c_str(), json);
-            free(json);
+// Sobe um resumo por nó e janela (em vez de cada leitura); o gateway e um
+// nó da tabela. Resumo recusado continua pendente para o proximo ciclo.
+static void enviar_resumos_em_lotes()
+{
+    static ResumoLote incluidos[CONFIG_GATEWAY_HTTP_LOTE_AMOSTRAS];
+    size_t n = 0;
+    size_t enviados = 0;
+    ResumoJanela resumo;
+    NodeInfo nodo;
+    uint32_t agora = esp_log_timestamp();
+
+    cJSON *lote = cJSON_CreateArray();
+    if (!lote) return;
+
+    size_t total = totalNodos();
+    for (size_t i = 0; i < total; i++) {
+        if (!lerNodo(i, &nodo)) continue;
+
+        // As leituras brutas ja entraram no agregado; o anel so e descartado
+        uint32_t de, ate;
+        historicoPendente(i, nodo, &de, &ate);
+        confirmarHistorico(i, ate);
+
+        if (!agregacao_resumo_pendente(i, agora, &resumo)) continue;
+
+        cJSON *item = create_resumo_json_object(nodo.id, &resumo);
+        if (!item) break;
+        cJSON_AddItemToArray(lote, item);
+        incluidos[n++] = { i, resumo.seq };
+
+        if (n >= CONFIG_GATEWAY_HTTP_LOTE_AMOSTRAS) {
+            bool ok = enviar_lote_resumos(lote, incluidos, n);
+            cJSON_Delete(lote);
+            if (!ok) {
+                ESP_LOGW(TAG_HTTP, "Lote de resumos recusado; %d ja enviados", (int)enviados);
+                return;
+            }
+            enviados += n;
+            n = 0;
+            lote = cJSON_CreateArray();
+            if (!lote) return;
         }
     }
 
-    ESP_LOGI(TAG_HTTP, "Envio HTTP síncrono concluído!");
+    if (cJSON_GetArraySize(lote) > 0 && enviar_lote_resumos(lote, incluidos, n)) {
+        enviados += n;
+    }
+    cJSON_Delete(lote);
+
+    ESP_LOGI(TAG_HTTP, "Resumos: %d janelas enviadas, %u pontos interpolados desde o boot",
+             (int)enviados, (unsigned)agregacao_interpolados());
 }
+#else
+// Trecho do historico de um nó incluido no lote em montagem
+struct TrechoLote {
+    size_t nodo;
+    uint32_t ate;
+};
+
+// Envia o lote montado e, se aceito, confirma os trechos de historico incluidos
+static bool enviar_lote(cJSON *lote, const TrechoLote *trechos, size_t n_trechos)
+{
+    char *json = cJSON_PrintUnformatted(lote);
+    if (!json) {
+        ESP_LOGE(TAG_HTTP, "Falha ao montar lote JSON");
+        return false;
+    }
 
-void enviar_uma_requisicao_http(const char *origem, const char *payload) {
-    const struct addrinfo hints = {
-        .ai_family = AF_INET,
-        .ai_socktype = SOCK_STREAM,
-    };
-    struct addrinfo *res;
-    struct in_addr *addr;
-    int s, r;
-    char recv_buf[128];
-
-    // 1. INCREASE BUFFER SIZE (Just in case payload grows)
-    char req_buffer[1024]; 
-
-    // 2. CRITICAL: CLEAR MEMORY BEFORE USE
-    // This ensures no "garbage" bytes (like 0x8b) exist in the buffer
-    memset(req_buffer, 0, sizeof(req_buffer));
-
-    // 3. Format the HTTP Request
-    // Note: We check the result of snprintf to ensure we didn't truncate the message
-    int len = snprintf(req_buffer, sizeof(req_buffer),
-             "POST %s HTTP/1.0\r\n"
-             "Host: %s\r\n"
-             "User-Agent: ESP32-Gateway\r\n"
-             "Content-Type: application/json\r\n"
-             "Content-Length: %d\r\n"
-             "X-Origem: %s\r\n"
-             "\r\n"
-             "%s",
-             POST_PATH, WEB_SERVER, (int)strlen(payload), origem, payload);
-
-    // Safety check: Did the message fit in the buffer?
-    if (len < 0 || len >= sizeof(req_buffer)) {
-        ESP_LOGE(TAG_HTTP, "Error: Request buffer too small for payload!");
-        return;
+    bool ok = enviar_uma_requisicao_http(origem_gateway(), json);
+    free(json);
+
+    if (ok) {
+        for (size_t k = 0; k < n_trechos; k++) {
+            confirmarHistorico(trechos[k].nodo, trechos[k].ate);
+        }
     }
+    return ok;
+}
 
-    // --- DNS Lookup ---
-    int err = getaddrinfo(WEB_SERVER, WEB_PORT, &hints, &res);
-    if (err != 0 || res == NULL) {
-        ESP_LOGE(TAG_HTTP, "DNS lookup failed err=%d res=%p", err, res);
-        vTaskDelay(1000 / portTICK_PERIOD_MS);
-        return;
+// Drena o historico de todos os nós (o gateway inclusive) em lotes de ate
+// GATEWAY_HTTP_LOTE_AMOSTRAS leituras. Se um lote for recusado, ele e os
+// seguintes continuam no anel e vao no proximo ciclo.
+static void enviar_historico_em_lotes()
+{
+    static TrechoLote trechos[CONFIG_GATEWAY_HTTP_LOTE_AMOSTRAS];
+    size_t n_trechos = 0;
+    size_t n_amostras = 0;
+    size_t enviadas = 0;
+    size_t perdidas = 0;
+    sensor_data_t leitura;
+
+    cJSON *lote = cJSON_CreateArray();
+    if (!lote) return;
+
+    NodeInfo nodo;
+    size_t total = totalNodos();
+    for (size_t i = 0; i < total; i++) {
+        uint32_t de, ate;
+        uint32_t perdidas_antes = historicoPerdidas(i);
+        if (!lerNodo(i, &nodo) || historicoPendente(i, nodo, &de, &ate) == 0) continue;
+
+        for (uint32_t seq = de; seq != ate; seq++) {
+            if (!historicoAmostra(i, seq, nodo.id, &leitura)) continue;
+            cJSON *item = create_sensor_json_object(&leitura);
+            if (!item) break;
+            cJSON_AddItemToArray(lote, item);
+            n_amostras++;
+
+            // Fecha o trecho deste nó ate a amostra atual
+            if (n_trechos > 0 && trechos[n_trechos - 1].nodo == i) {
+                trechos[n_trechos - 1].ate = seq + 1;
+            } else {
+                trechos[n_trechos++] = { i, seq + 1 };
+            }
+
+            if (n_amostras >= CONFIG_GATEWAY_HTTP_LOTE_AMOSTRAS) {
+                bool ok = enviar_lote(lote, trechos, n_trechos);
+                cJSON_Delete(lote);
+                if (!ok) {
+                    // Servidor fora: o resto fica no anel para o proximo ciclo
+                    ESP_LOGW(TAG_HTTP, "Lote recusado; %d leituras ja enviadas", (int)enviadas);
+                    return;
+                }
+                enviadas += n_amostras;
+                lote = cJSON_CreateArray();
+                n_amostras = 0;
+                n_trechos = 0;
+                if (!lote) return;
+            }
+        }
+        perdidas += historicoPerdidas(i) - perdidas_antes;
     }
 
-    addr = &((struct sockaddr_in *)res->ai_addr)->sin_addr;
-    ESP_LOGI(TAG_HTTP, "DNS lookup succeeded. IP=%s", inet_ntoa(*addr));
+    if (n_amostras > 0 && enviar_lote(lote, trechos, n_trechos)) {
+        enviadas += n_amostras;
+    }
+    cJSON_Delete(lote);
 
-    s = socket(res->ai_family, res->ai_socktype, 0);
-    if (s < 0) {
-        ESP_LOGE(TAG_HTTP, "Falha ao criar socket.");
-        freeaddrinfo(res);
-        vTaskDelay(1000 / portTICK_PERIOD_MS);
-        return;
+    ESP_LOGI(TAG_HTTP, "Historico: %d leituras enviadas, %d perdidas por anel cheio",
+             (int)enviadas, (int)perdidas);
+}
+
+#if CONFIG_GATEWAY_JOURNAL
+// Journal em flash: sobrevive a quedas do uplink e a reinicios
+static Journal s_journal;
+static bool s_journal_iniciado = false;
+static uint8_t s_registros[CONFIG_GATEWAY_HTTP_LOTE_AMOSTRAS][SENSOR_REGISTRO_TAMANHO];
+
+// Move os aneis dos nós (o gateway inclusive) para o journal (escrita sequencial)
+static void gravar_historico_no_journal()
+{
+    uint8_t registro[SENSOR_REGISTRO_TAMANHO];
+    sensor_data_t leitura;
+    otIp6Address eid;
+
+    NodeInfo nodo;
+    size_t total = totalNodos();
+    for (size_t i = 0; i < total; i++) {
+        uint32_t de, ate, seq;
+        if (!lerNodo(i, &nodo) || historicoPendente(i, nodo, &de, &ate) == 0) continue;
+        // O registro na flash leva o EID: independe do cadastro na NVS
+        if (!cadastro_eid(nodo.id, &eid)) continue;
+
+        for (seq = de; seq != ate; seq++) {
+            if (!historicoAmostra(i, seq, nodo.id, &leitura)) continue;
+            if (!encode_sensor_record(&leitura, &eid, registro, sizeof(registro)) ||
+                !s_journal.anexar(registro)) {
+                break;
+            }
+        }
+        // So sai do anel o que ja esta na flash
+        confirmarHistorico(i, seq);
+    }
+}
+
+// Reenvia o journal em ordem, um lote por POST; para no primeiro lote recusado
+static void reproduzir_journal()
+{
+    sensor_data_t leitura;
+    otIp6Address eid;
+    size_t enviadas = 0;
+    uint32_t ate;
+    size_t n;
+
+    while ((n = s_journal.ler_pendentes(s_registros, CONFIG_GATEWAY_HTTP_LOTE_AMOSTRAS, &ate)) > 0) {
+        cJSON *lote = cJSON_CreateArray();
+        if (!lote) break;
+
+        for (size_t k = 0; k < n; k++) {
+            if (!decode_sensor_record(s_registros[k], SENSOR_REGISTRO_TAMANHO, &leitura, &eid)) continue;
+            leitura.nodo = cadastro_buscar_eid(eid);
+            cJSON *item = create_sensor_json_object(&leitura);
+            if (!item) continue;
+            if (leitura.nodo == CADASTRO_SEM_ID) {
+                // EID que o nó ja trocou (outra rede): vai o da gravacao
+                char endereco[OT_IP6_ADDRESS_STRING_SIZE];
+                otIp6AddressToString(&eid, endereco, sizeof(endereco));
+                cJSON_AddStringToObject(item, "e", endereco);
+            }
+            cJSON_AddItemToArray(lote, item);
+        }
+
+        char *json = cJSON_PrintUnformatted(lote);
+        cJSON_Delete(lote);
+        if (!json) break;
+
+        bool ok = enviar_uma_requisicao_http(origem_gateway(), json);
+        free(json);
+        if (!ok || !s_journal.confirmar(ate)) break;
+        enviadas += n;
+    }
+
+    const JournalEstatisticas &est = s_journal.estatisticas();
+    ESP_LOGI(TAG_HTTP, "Journal: %d leituras enviadas, %u pendentes, %u perdidas por log cheio",
+             (int)enviadas, (unsigned)s_journal.pendentes(), (unsigned)est.perdidas);
+}
+#endif
+#endif
+#endif
+
+#if CONFIG_GATEWAY_HTTP_SEQUENCIA || CONFIG_GATEWAY_HTTP_TOPOLOGIA
+#ifdef CONFIG_GATEWAY_HTTP_LOTE_AMOSTRAS
+#define ITENS_POR_POST CONFIG_GATEWAY_HTTP_LOTE_AMOSTRAS
+#else
+#define ITENS_POR_POST HTTP_MAX_PIPELINE
+#endif
+
+// Item {"e":..,<chave>:{..}} de um nó; NULL se faltar memoria
+static cJSON *criar_item_nodo(const NodeInfo &nodo, const char *chave, cJSON **objeto)
+{
+    cJSON *item = cJSON_CreateObject();
+    if (!item) return NULL;
+
+    char endereco[OT_IP6_ADDRESS_STRING_SIZE];
+    cadastro_eid_texto(nodo.id, endereco, sizeof(endereco));
+    cJSON_AddStringToObject(item, "e", endereco);
+    *objeto = cJSON_AddObjectToObject(item, chave);
+    return item;
+}
+
+// Um item por nó aceito por 'incluir', sem leituras, em POSTs de ate
+// ITENS_POR_POST depois dos dados; para no primeiro POST recusado
+static void enviar_itens_por_nodo(bool (*incluir)(const NodeInfo &), cJSON *(*criar)(const NodeInfo &))
+{
+    NodeInfo nodo;
+    size_t total = totalNodos();
+    size_t n = 0;
+    cJSON *lote = NULL;
+
+    for (size_t i = 0; i <= total; i++) {
+        if (lote && (n == ITENS_POR_POST || i == total)) {
+            char *json = cJSON_PrintUnformatted(lote);
+            cJSON_Delete(lote);
+            lote = NULL;
+            n = 0;
+            bool ok = json && enviar_uma_requisicao_http(origem_gateway(), json);
+            free(json);
+            if (!ok) return;
+        }
+        if (i == total) break;
+        if (!lerNodo(i, &nodo) || !incluir(nodo)) continue;
+
+        if (!lote && !(lote = cJSON_CreateArray())) return;
+        cJSON *item = criar(nodo);
+        if (item) {
+            cJSON_AddItemToArray(lote, item);
+            n++;
+        }
+    }
+}
+#endif
+
+#if CONFIG_GATEWAY_HTTP_SEQUENCIA
+static bool com_sequencia(const NodeInfo &nodo)
+{
+    return nodo.seq.iniciada != 0;
+}
+
+static cJSON *criar_json_sequencia(const NodeInfo &nodo)
+{
+    const EstatisticasSequencia &s = nodo.seq;
+    cJSON *q;
+    cJSON *item = criar_item_nodo(nodo, "q", &q);
+    if (item && q) {
+        cJSON_AddNumberToObject(q, "rx", s.recebidas);
+        cJSON_AddNumberToObject(q, "perd", s.perdidas);
+        cJSON_AddNumberToObject(q, "lac", seqLacunas(s));
+        cJSON_AddNumberToObject(q, "dup", s.duplicadas);
+        cJSON_AddNumberToObject(q, "reord", s.reordenadas);
+        cJSON_AddNumberToObject(q, "reini", s.reinicios);
+        cJSON_AddNumberToObject(q, "perda", seqPerdaPermil(s));
+    }
+    return item;
+}
+#endif
+
+#if CONFIG_GATEWAY_HTTP_TOPOLOGIA
+static bool com_enlace(const NodeInfo &nodo)
+{
+    return nodo.enlace.relatos != 0;
+}
+
+// Aresta do nó na malha: RLOC16 (e o do pai, se filho), saltos ate o
+// gateway, qualidade do enlace com o pai e os contadores MAC somados. A
+// chave e "topo": "t" e a temperatura, e o servidor separa os itens por ela
+static cJSON *criar_json_topologia(const NodeInfo &nodo)
+{
+    const EnlaceNodo &e = nodo.enlace;
+    uint16_t roteador = sensor_rloc16_roteador(e.ultimo.rloc16);
+    cJSON *topo;
+    cJSON *item = criar_item_nodo(nodo, "topo", &topo);
+    if (!item || !topo) return item;
+
+    cJSON_AddNumberToObject(topo, "rloc", e.ultimo.rloc16);
+    if (roteador != e.ultimo.rloc16) {
+        cJSON_AddNumberToObject(topo, "pai", roteador);
+    }
+    if (e.saltos != ENLACE_SALTOS_DESCONHECIDO) {
+        cJSON_AddNumberToObject(topo, "saltos", e.saltos);
+        cJSON_AddNumberToObject(topo, "custo", e.custo);
     }
+    if (e.ultimo.rssi != SENSOR_RSSI_INVALIDO) {
+        cJSON_AddNumberToObject(topo, "rssi", e.ultimo.rssi);
+        cJSON_AddNumberToObject(topo, "margem", e.ultimo.margem);
+        cJSON_AddNumberToObject(topo, "lqi", e.ultimo.qualidade_entrada);
+        cJSON_AddNumberToObject(topo, "lqo", e.ultimo.qualidade_saida);
+    }
+    cJSON_AddNumberToObject(topo, "tx", e.quadros);
+    cJSON_AddNumberToObject(topo, "retx", e.retentativas);
+    cJSON_AddNumberToObject(topo, "semack", e.sem_ack);
+    cJSON_AddNumberToObject(topo, "cca", e.cca);
+    cJSON_AddNumberToObject(topo, "idade", (esp_log_timestamp() - e.atualizado_ms) / 1000);
+    return item;
+}
+#endif
 
-    if (connect(s, res->ai_addr, res->ai_addrlen) != 0) {
-        ESP_LOGE(TAG_HTTP, "Falha ao conectar ao servidor.");
-        close(s);
-        freeaddrinfo(res);
-        vTaskDelay(1000 / portTICK_PERIOD_MS);
+#if CONFIG_GATEWAY_HTTP_METRICAS
+// Item {"e":..,"m":{..}} com o registro de metricas do gateway; a taxa de
+// CoAP e por minuto desde o upload anterior
+static void enviar_metricas()
+{
+    static MetricaTaxa taxa_coap = { 0, 0 };
+
+    cJSON *lote = cJSON_CreateArray();
+    cJSON *item = lote ? cJSON_CreateObject() : NULL;
+    if (!item) {
+        cJSON_Delete(lote);
         return;
     }
-    freeaddrinfo(res);
-
-    // 4. SEND DATA
-    // Use the length calculated by snprintf, not strlen(req_buffer)
-    // This is slightly more efficient and safer.
-    if (write(s, req_buffer, len) < 0) {
-        ESP_LOGE(TAG_HTTP, "Erro ao enviar POST.");
-        close(s);
-        vTaskDelay(1000 / portTICK_PERIOD_MS);
+    cJSON_AddItemToArray(lote, item);
+    cJSON_AddStringToObject(item, "e", origem_gateway());
+    cJSON *m = cJSON_AddObjectToObject(item, "m");
+    cJSON *h = m ? cJSON_AddObjectToObject(m, "h") : NULL;
+    cJSON *pilha = m ? cJSON_AddObjectToObject(m, "pilha") : NULL;
+    if (!h || !pilha) {
+        cJSON_Delete(lote);
         return;
     }
 
-    // Set timeout
-    struct timeval receiving_timeout = {5, 0};
-    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &receiving_timeout, sizeof(receiving_timeout));
-
-    // Read Response
-    ESP_LOGI(TAG_HTTP, "Lendo resposta...");
-    do {
-        bzero(recv_buf, sizeof(recv_buf));
-        r = read(s, recv_buf, sizeof(recv_buf)-1);
-        for (int i = 0; i < r; i++) {
-            putchar(recv_buf[i]);
+    uint32_t agora = esp_log_timestamp();
+    uint32_t livre, minimo;
+    metricas_heap(&livre, &minimo);
+
+    cJSON_AddNumberToObject(m, "uptime", agora / 1000);
+    cJSON_AddNumberToObject(m, "coap_min", metricas_taxa_minuto(MC_COAP_RX, &taxa_coap, agora));
+    for (int c = 0; c < MC_TOTAL; c++) {
+        cJSON_AddNumberToObject(m, metricas_contador_nome((MetricaContador)c),
+                                metricas_contador((MetricaContador)c));
+    }
+    cJSON_AddNumberToObject(m, "heap", livre);
+    cJSON_AddNumberToObject(m, "heap_min", minimo);
+
+    for (int i = 0; i < MH_TOTAL; i++) {
+        MetricaResumo r;
+        metricas_resumo((MetricaHistograma)i, &r);
+        if (r.n == 0) continue;
+        cJSON *resumo = cJSON_AddObjectToObject(h, metricas_histograma_nome((MetricaHistograma)i));
+        if (!resumo) continue;
+        cJSON_AddNumberToObject(resumo, "n", r.n);
+        cJSON_AddNumberToObject(resumo, "media", r.soma / r.n);
+        cJSON_AddNumberToObject(resumo, "p50", r.p50);
+        cJSON_AddNumberToObject(resumo, "p90", r.p90);
+        cJSON_AddNumberToObject(resumo, "p99", r.p99);
+        cJSON_AddNumberToObject(resumo, "max", r.max);
+    }
+    for (int t = 0; t < MT_TOTAL; t++) {
+        uint32_t folga = metricas_pilha_minima((MetricaTask)t);
+        if (folga == METRICAS_PILHA_NUNCA) continue;
+        cJSON_AddNumberToObject(pilha, metricas_task_nome((MetricaTask)t), folga);
+    }
+
+    char *json = cJSON_PrintUnformatted(lote);
+    cJSON_Delete(lote);
+    if (json) enviar_uma_requisicao_http(origem_gateway(), json);
+    free(json);
+}
+#endif
+
+void http_send_all_now()
+{
+    ESP_LOGI(TAG_HTTP, "Iniciando envio HTTP síncrono...");
+
+    s_cliente.iniciar_ciclo();
+
+#if CONFIG_GATEWAY_HTTP_BATCH
+    // ==========================
+    // Lote: historico de TODOS os nós (gateway incluso), em poucas requisicoes
+    // na mesma conexao (cada leitura recebida desde o ultimo envio)
+    // ==========================
+    ESP_LOGI(TAG_HTTP, "Enviando historico de %d nós...", (int)totalNodos());
+
+#if CONFIG_GATEWAY_UPLOAD_RESUMO
+    // Agregacao ligada: um resumo por nó e janela no lugar das leituras
+    enviar_resumos_em_lotes();
+#else
+    bool via_journal = false;
+#if CONFIG_GATEWAY_JOURNAL
+    // Tudo passa pela flash antes de subir: se o POST falhar ou o gateway
+    // reiniciar, as leituras sao reenviadas (em ordem) no proximo ciclo
+    if (!s_journal_iniciado) {
+        s_journal_iniciado = true;
+        journal_iniciar_particao(s_journal);
+    }
+    via_journal = s_journal.montado();
+    if (via_journal) {
+        gravar_historico_no_journal();
+        reproduzir_journal();
+    }
+#endif
+    if (!via_journal) {
+        enviar_historico_em_lotes();
+    }
+#endif
+#else
+    // ==========================
+    // Um POST por nó (gateway incluso), todos em pipeline na mesma conexao
+    // ==========================
+    size_t total = totalNodos();
+    NodeInfo nodo;
+    uint32_t agora = esp_log_timestamp();
+    ESP_LOGI(TAG_HTTP, "Enviando %d nós em pipeline...", (int)total);
+
+    char *jsons[HTTP_MAX_PIPELINE];
+    size_t n = 0;
+
+    for (size_t i = 0; i <= total; i++) {
+        // Lote cheio (ou fim da tabela): envia e libera
+        if (n == HTTP_MAX_PIPELINE || (i == total && n > 0)) {
+            s_cliente.post_pipeline(POST_PATH, jsons, n, origem_gateway());
+            for (size_t k = 0; k < n; k++) free(jsons[k]);
+            n = 0;
         }
-    } while (r > 0);
+        if (i == total) break;
+        // So nós com leitura recente: stale/offline repetiriam o ultimo valor
+        if (!lerNodo(i, &nodo) || estadoNodo(nodo, agora) != NODO_ONLINE) continue;
 
-    ESP_LOGI(TAG_HTTP, "\n... leitura concluída.");
-    close(s);
+        jsons[n] = create_sensor_json(&nodo.dados);
+        if (jsons[n]) n++;
+    }
+#endif
+
+#if CONFIG_GATEWAY_HTTP_SEQUENCIA
+    // Perda, duplicata e ordem na malha por nó
+    enviar_itens_por_nodo(com_sequencia, criar_json_sequencia);
+#endif
+#if CONFIG_GATEWAY_HTTP_TOPOLOGIA
+    // Retrato da topologia: uma aresta por nó, o gateway como raiz
+    enviar_itens_por_nodo(com_enlace, criar_json_topologia);
+#endif
+#if CONFIG_GATEWAY_HTTP_METRICAS
+    // Por ultimo: ja inclui a latencia dos POSTs deste ciclo
+    enviar_metricas();
+#endif
+
+    s_cliente.registrar_estatisticas(TAG_HTTP);
+    registrarEstatisticasNodos();
+    registrar_estatisticas_trafego();
+    ESP_LOGI(TAG_HTTP, "Envio HTTP síncrono concluído!");
+}
+
+bool enviar_uma_requisicao_http(const char *origem, const char *payload) {
+    int status = -1;
+    bool ok = s_cliente.post(POST_PATH, payload, origem, "application/json", &status);
+
+    ESP_LOGI(TAG_HTTP, "POST %s -> %d", POST_PATH, status);
+    return ok;
+}
+
+uint32_t http_journal_perdidas()
+{
+#if CONFIG_GATEWAY_HTTP_BATCH && !CONFIG_GATEWAY_UPLOAD_RESUMO && CONFIG_GATEWAY_JOURNAL
+    return s_journal.estatisticas().perdidas;
+#else
+    return 0;
+#endif
+}
+
+// Fecha a conexao keep-alive (chamar antes de desligar o Wi-Fi)
+void http_encerrar_conexao()
+{
+    s_cliente.fechar();
 }
 
 void http_post_task(void *pvParameters)
 {
+    (void)pvParameters;
     ESP_LOGI(TAG_HTTP, "HTTP task iniciada");
 
     http_task_handle = xTaskGetCurrentTaskHandle();
@@ -157,27 +583,9 @@ void http_post_task(void *pvParameters)
 
     while (!http_shutdown_requested) {
 
-        // ==========================
-        // 1) Envia SEU próprio nó
-        // ==========================
-        extern sensor_data_t sensor_data;   // já existe no seu projeto
-        char* json_me = create_sensor_json(&sensor_data);
-
-        if (json_me) {
-            enviar_uma_requisicao_http(sensor_data.endereco, json_me);
-            free(json_me);
-        }
-
-        // ==========================
-        // 2) Envia TODOS os nós do vector
-        // ==========================
-        for (const auto& entry : getTabelaNodos()) {
-            char* json = create_sensor_json(&entry.dados);
-            if (json) {
-                enviar_uma_requisicao_http(entry.endereco.c_str(), json);
-                free(json);
-            }
-        }
+        // Envia os nós (em lote ou um a um, conforme a configuracao)
+        http_send_all_now();
+        metricas_pilha(MT_HTTP);
 
         // Envia a cada X segundos
         for (int i = 0; i < 100 && !http_shutdown_requested; i++)
@@ -254,6 +662,7 @@ void http_disable(void) {
     }
 
     // 5) Reseta estado
+    http_encerrar_conexao();
     s_http_active = false;
     http_shutdown_requested = false;
 
@@ -29,4 +29,7 @@ void http_send_all_now();
 void http_post_task(void *pvParameters);
 void http_enable(void);
 void http_disable(void);
-void enviar_uma_requisicao_http(const char *origem, const char *payload);
\ No newline at end of file
+bool enviar_uma_requisicao_http(const char *origem, const char *payload);
+// Amostras descartadas pelo journal cheio desde o boot (0 sem journal)
+uint32_t http_journal_perdidas();
+void http_encerrar_conexao();
\ No newline at end of file
@@ -0,0 +1,374 @@
+#include "journal.hpp"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG_JOURNAL = "JOURNAL";
+
+#define JOURNAL_MAGIC 0x314A4745u   // "EGJ1"
+
+// ==================== AUXILIARES ====================
+static inline void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// CRC-16/CCITT-FALSE, bit a bit (slots pequenos, sem tabela)
+static uint16_t crc16(const uint8_t *p, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+    while (len--) {
+        crc ^= (uint16_t)(*p++) << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static bool todo_apagado(const uint8_t *p, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (p[i] != 0xFF) return false;
+    }
+    return true;
+}
+
+// CRC do slot calculado com o proprio campo de CRC zerado
+static uint16_t crc_slot(const uint8_t *slot)
+{
+    uint8_t copia[JOURNAL_SLOT_TAMANHO];
+    memcpy(copia, slot, sizeof(copia));
+    copia[2] = copia[3] = 0;
+    return crc16(copia, sizeof(copia));
+}
+
+// ==================== ACESSO A FLASH ====================
+Journal::Journal()
+    : m_flash(), m_num_setores(0), m_montado(false),
+      m_cabeca{0, 0}, m_seq_setor(0), m_proxima_seq(0), m_confirmado(0),
+      m_leitura{0, 0}, m_leitura_prox{0, 0}, m_leitura_ate(0), m_est()
+{
+}
+
+size_t Journal::offset_slot(Posicao p) const
+{
+    return offset_setor(p.setor) + JOURNAL_CABECALHO_TAMANHO + (size_t)p.slot * JOURNAL_SLOT_TAMANHO;
+}
+
+bool Journal::ler_cabecalho(uint16_t setor, uint32_t *seq_setor)
+{
+    uint8_t cab[JOURNAL_CABECALHO_TAMANHO];
+    if (!m_flash.ler(m_flash.ctx, offset_setor(setor), cab, sizeof(cab))) return false;
+    if (get_u32(&cab[0]) != JOURNAL_MAGIC) return false;
+    if (get_u16(&cab[8]) != crc16(cab, 8)) return false;
+
+    *seq_setor = get_u32(&cab[4]);
+    return true;
+}
+
+bool Journal::ler_slot(Posicao p, uint8_t *slot, bool *vazio)
+{
+    *vazio = false;
+    if (!m_flash.ler(m_flash.ctx, offset_slot(p), slot, JOURNAL_SLOT_TAMANHO)) return false;
+
+    if (todo_apagado(slot, JOURNAL_SLOT_TAMANHO)) {
+        *vazio = true;
+        return false;
+    }
+    return get_u16(&slot[2]) == crc_slot(slot);
+}
+
+bool Journal::escrever_slot(uint8_t tipo, uint32_t seq, const uint8_t *registro)
+{
+    if (m_cabeca.slot >= JOURNAL_SLOTS_POR_SETOR && !abrir_proximo_setor()) {
+        return false;
+    }
+
+    uint8_t slot[JOURNAL_SLOT_TAMANHO];
+    slot[0] = tipo;
+    slot[1] = 0;
+    put_u16(&slot[2], 0);
+    put_u32(&slot[4], seq);
+    if (registro) {
+        memcpy(&slot[8], registro, SENSOR_REGISTRO_TAMANHO);
+    } else {
+        memset(&slot[8], 0, SENSOR_REGISTRO_TAMANHO);
+    }
+    put_u16(&slot[2], crc_slot(slot));
+
+    // Mesmo se a escrita falhar o slot e consumido: pode ter ficado pela metade
+    Posicao p = m_cabeca;
+    m_cabeca.slot++;
+    return m_flash.escrever(m_flash.ctx, offset_slot(p), slot, sizeof(slot));
+}
+
+// Apaga o proximo setor do rodizio e o torna a nova cabeca do log
+bool Journal::abrir_proximo_setor()
+{
+    uint16_t prox = (uint16_t)((m_cabeca.setor + 1) % m_num_setores);
+
+    // Log cheio: o setor mais antigo vai ser reutilizado; o que ainda nao
+    // foi enviado dele e perdido (e contabilizado)
+    uint32_t seq_antigo;
+    if (ler_cabecalho(prox, &seq_antigo)) {
+        uint8_t slot[JOURNAL_SLOT_TAMANHO];
+        bool vazio;
+        uint32_t perdidas = 0;
+        uint32_t fim = m_confirmado;
+
+        for (uint16_t i = 0; i < JOURNAL_SLOTS_POR_SETOR; i++) {
+            if (ler_slot({prox, i}, slot, &vazio) && slot[0] == JOURNAL_TIPO_AMOSTRA) {
+                uint32_t seq = get_u32(&slot[4]);
+                if (seq >= m_confirmado) {
+                    perdidas++;
+                    fim = seq + 1;
+                }
+            } else if (vazio) {
+                break;
+            }
+        }
+
+        if (perdidas > 0) {
+            ESP_LOGW(TAG_JOURNAL, "Log cheio: descartando %u amostras nao enviadas", (unsigned)perdidas);
+            m_est.perdidas += perdidas;
+            m_confirmado = fim;
+        }
+    }
+
+    if (!m_flash.apagar_setor(m_flash.ctx, offset_setor(prox))) {
+        ESP_LOGE(TAG_JOURNAL, "Falha ao apagar setor %u", prox);
+        return false;
+    }
+    m_est.setores_apagados++;
+
+    uint8_t cab[JOURNAL_CABECALHO_TAMANHO];
+    memset(cab, 0xFF, sizeof(cab));
+    put_u32(&cab[0], JOURNAL_MAGIC);
+    put_u32(&cab[4], m_seq_setor + 1);
+    put_u16(&cab[8], crc16(cab, 8));
+    if (!m_flash.escrever(m_flash.ctx, offset_setor(prox), cab, sizeof(cab))) {
+        ESP_LOGE(TAG_JOURNAL, "Falha ao gravar cabecalho do setor %u", prox);
+        return false;
+    }
+
+    m_seq_setor++;
+    m_cabeca = {prox, 0};
+
+    // A leitura nunca pode apontar para dentro do setor reaproveitado
+    if (m_leitura.setor == prox) {
+        m_leitura = {(uint16_t)((prox + 1) % m_num_setores), 0};
+    }
+    m_leitura_ate = 0;
+
+    // Repete a confirmacao vigente: o setor que a continha pode ser o proximo a ser apagado
+    return escrever_slot(JOURNAL_TIPO_CONFIRMACAO, m_confirmado, NULL);
+}
+
+// ==================== MONTAGEM ====================
+bool Journal::montar(const JournalFlash &flash)
+{
+    m_flash = flash;
+    m_num_setores = (uint16_t)(flash.tamanho / JOURNAL_SETOR_TAMANHO);
+    m_montado = false;
+    m_est = JournalEstatisticas();
+
+    if (m_num_setores < 2) {
+        ESP_LOGE(TAG_JOURNAL, "Area muito pequena (%u bytes)", (unsigned)flash.tamanho);
+        return false;
+    }
+
+    // 1) Cabecalhos: setor mais novo (cabeca) e mais antigo
+    bool algum = false;
+    uint16_t setor_novo = 0, setor_antigo = 0;
+    uint32_t seq_novo = 0, seq_antigo = 0;
+
+    for (uint16_t s = 0; s < m_num_setores; s++) {
+        uint32_t seq;
+        if (!ler_cabecalho(s, &seq)) continue;
+
+        if (!algum || seq > seq_novo) { seq_novo = seq; setor_novo = s; }
+        if (!algum || seq < seq_antigo) { seq_antigo = seq; setor_antigo = s; }
+        algum = true;
+    }
+
+    m_proxima_seq = 0;
+    m_confirmado = 0;
+    m_leitura_ate = 0;
+
+    if (!algum) {
+        // Particao nova (ou apagada): comeca no setor 0
+        ESP_LOGI(TAG_JOURNAL, "Journal vazio, formatando (%u setores)", m_num_setores);
+        m_seq_setor = 0;
+        m_cabeca = {(uint16_t)(m_num_setores - 1), JOURNAL_SLOTS_POR_SETOR};
+        m_leitura = {0, 0};
+        m_montado = abrir_proximo_setor();
+        return m_montado;
+    }
+
+    // 2) Varre os setores em ordem de escrita (do mais antigo ate a cabeca)
+    uint8_t slot[JOURNAL_SLOT_TAMANHO];
+    m_cabeca = {setor_novo, JOURNAL_SLOTS_POR_SETOR};
+    m_seq_setor = seq_novo;
+
+    uint16_t s = setor_antigo;
+    for (;;) {
+        uint32_t seq_setor;
+        if (ler_cabecalho(s, &seq_setor)) {
+            for (uint16_t i = 0; i < JOURNAL_SLOTS_POR_SETOR; i++) {
+                bool vazio;
+                if (ler_slot({s, i}, slot, &vazio)) {
+                    uint32_t seq = get_u32(&slot[4]);
+                    if (slot[0] == JOURNAL_TIPO_AMOSTRA && seq + 1 > m_proxima_seq) {
+                        m_proxima_seq = seq + 1;
+                    } else if (slot[0] == JOURNAL_TIPO_CONFIRMACAO && seq > m_confirmado) {
+                        m_confirmado = seq;
+                    }
+                } else if (vazio) {
+                    // Primeiro slot livre do setor mais novo = cabeca
+                    if (s == setor_novo) m_cabeca.slot = i;
+                    break;
+                } else {
+                    m_est.slots_corrompidos++;
+                }
+            }
+        }
+
+        if (s == setor_novo) break;
+        s = (uint16_t)((s + 1) % m_num_setores);
+    }
+
+    if (m_confirmado > m_proxima_seq) m_confirmado = m_proxima_seq;
+    m_leitura = {setor_antigo, 0};
+    m_montado = true;
+
+    ESP_LOGI(TAG_JOURNAL, "Journal montado: %u setores, cabeca %u/%u, %u pendentes, %u slots corrompidos",
+             m_num_setores, m_cabeca.setor, m_cabeca.slot, (unsigned)pendentes(),
+             (unsigned)m_est.slots_corrompidos);
+    return true;
+}
+
+// ==================== ANEXAR / REPRODUZIR ====================
+bool Journal::anexar(const uint8_t *registro)
+{
+    if (!m_montado) return false;
+
+    if (!escrever_slot(JOURNAL_TIPO_AMOSTRA, m_proxima_seq, registro)) {
+        return false;
+    }
+    m_proxima_seq++;
+    m_est.gravadas++;
+    return true;
+}
+
+size_t Journal::ler_pendentes(uint8_t (*registros)[SENSOR_REGISTRO_TAMANHO], size_t max, uint32_t *ate)
+{
+    if (!m_montado) return 0;
+
+    uint8_t slot[JOURNAL_SLOT_TAMANHO];
+    Posicao p = m_leitura;
+    size_t n = 0;
+    uint32_t ultima = 0;
+
+    while (n < max && !(p.setor == m_cabeca.setor && p.slot >= m_cabeca.slot)) {
+        if (p.slot >= JOURNAL_SLOTS_POR_SETOR) {
+            p = {(uint16_t)((p.setor + 1) % m_num_setores), 0};
+            continue;
+        }
+
+        bool vazio;
+        if (ler_slot(p, slot, &vazio)) {
+            uint32_t seq = get_u32(&slot[4]);
+            if (slot[0] == JOURNAL_TIPO_AMOSTRA && seq >= m_confirmado) {
+                memcpy(registros[n++], &slot[8], SENSOR_REGISTRO_TAMANHO);
+                ultima = seq;
+            }
+        } else if (vazio) {
+            // Resto do setor nunca foi escrito: segue para o proximo
+            p.slot = JOURNAL_SLOTS_POR_SETOR;
+            continue;
+        }
+        p.slot++;
+    }
+
+    if (n == 0) {
+        // So havia confirmacoes/amostras ja enviadas ate aqui
+        m_leitura = p;
+        m_leitura_ate = 0;
+        return 0;
+    }
+
+    m_leitura_prox = p;
+    m_leitura_ate = ultima + 1;
+    *ate = m_leitura_ate;
+    return n;
+}
+
+bool Journal::confirmar(uint32_t ate)
+{
+    if (!m_montado) return false;
+    if ((int32_t)(ate - m_confirmado) <= 0) return true;
+
+    // Confirma na RAM antes de gravar: se o slot abrir um setor novo, o
+    // setor reciclado nao conta como perdidas as amostras recem-enviadas
+    // (abrir_proximo_setor so pode adiantar a confirmacao e zera
+    // m_leitura_ate, invalidando a leitura em aberto)
+    m_confirmado = ate;
+    if (!escrever_slot(JOURNAL_TIPO_CONFIRMACAO, ate, NULL)) {
+        return false;
+    }
+
+    if (ate == m_leitura_ate) {
+        m_leitura = m_leitura_prox;
+    }
+    m_leitura_ate = 0;
+    return true;
+}
+
+// ==================== PARTICAO (ESP-IDF) ====================
+#ifdef ESP_PLATFORM
+#include "esp_partition.h"
+
+static bool particao_ler(void *ctx, size_t offset, void *buf, size_t len)
+{
+    return esp_partition_read((const esp_partition_t *)ctx, offset, buf, len) == ESP_OK;
+}
+
+static bool particao_escrever(void *ctx, size_t offset, const void *buf, size_t len)
+{
+    return esp_partition_write((const esp_partition_t *)ctx, offset, buf, len) == ESP_OK;
+}
+
+static bool particao_apagar(void *ctx, size_t offset)
+{
+    return esp_partition_erase_range((const esp_partition_t *)ctx, offset, JOURNAL_SETOR_TAMANHO) == ESP_OK;
+}
+
+bool journal_iniciar_particao(Journal &journal)
+{
+    const esp_partition_t *part = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)JOURNAL_PARTICAO_SUBTIPO, JOURNAL_PARTICAO_NOME);
+
+    if (!part) {
+        ESP_LOGW(TAG_JOURNAL, "Particao '%s' nao encontrada; journal desativado", JOURNAL_PARTICAO_NOME);
+        return false;
+    }
+
+    JournalFlash flash = { (void *)part, part->size, particao_ler, particao_escrever, particao_apagar };
+    return journal.montar(flash);
+}
+#endif
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "sensor_codec.hpp"
+
+// ==================== JOURNAL DE AMOSTRAS EM FLASH ====================
+// Log circular, somente-anexo, na particao "journal" (partitions.csv).
+// Cada setor de 4 KB comeca com um cabecalho (magic + sequencia do setor)
+// e e preenchido em ordem com slots de JOURNAL_SLOT_TAMANHO bytes:
+//
+//  off  tam  campo
+//   0    1   tipo (JOURNAL_TIPO_AMOSTRA / JOURNAL_TIPO_CONFIRMACAO)
+//   1    1   reservado (0)
+//   2    2   crc16 do slot (com este campo zerado)
+//   4    4   seq da amostra (ou, na confirmacao, seq ate onde ja foi enviado)
+//   8   32   registro binario do sensor (sensor_codec.hpp)
+//
+// Os setores sao reutilizados em rodizio (desgaste uniforme); o mais antigo
+// e apagado quando o log enche. Um slot cortado por falta de energia falha
+// no CRC e e ignorado. A confirmacao vigente e repetida no inicio de cada
+// setor novo, entao nunca se perde ao apagar o setor onde foi escrita.
+#define JOURNAL_SETOR_TAMANHO     4096
+#define JOURNAL_CABECALHO_TAMANHO 16
+#define JOURNAL_SLOT_TAMANHO      (8 + SENSOR_REGISTRO_TAMANHO)
+#define JOURNAL_SLOTS_POR_SETOR   ((JOURNAL_SETOR_TAMANHO - JOURNAL_CABECALHO_TAMANHO) / JOURNAL_SLOT_TAMANHO)
+
+// Particao de dados com subtipo customizado (ver partitions.csv)
+#define JOURNAL_PARTICAO_NOME     "journal"
+#define JOURNAL_PARTICAO_SUBTIPO  0x40
+
+#define JOURNAL_TIPO_AMOSTRA      0x01
+#define JOURNAL_TIPO_CONFIRMACAO  0x02
+
+// Operacoes de flash usadas pelo journal (esp_partition no alvo; um
+// vetor em RAM num teste no host). Offsets relativos ao inicio da area.
+struct JournalFlash {
+    void *ctx;
+    size_t tamanho;
+    bool (*ler)(void *ctx, size_t offset, void *buf, size_t len);
+    bool (*escrever)(void *ctx, size_t offset, const void *buf, size_t len);
+    bool (*apagar_setor)(void *ctx, size_t offset);
+};
+
+struct JournalEstatisticas {
+    uint32_t gravadas;           // amostras anexadas desde o boot
+    uint32_t perdidas;           // amostras nao enviadas apagadas por log cheio
+    uint32_t setores_apagados;
+    uint32_t slots_corrompidos;  // encontrados na montagem (escrita interrompida)
+};
+
+class Journal {
+public:
+    Journal();
+
+    // Varre a flash e reconstroi o estado (cabeca, sequencias, confirmacao)
+    bool montar(const JournalFlash &flash);
+    bool montado() const { return m_montado; }
+
+    // Anexa um registro binario (SENSOR_REGISTRO_TAMANHO bytes)
+    bool anexar(const uint8_t *registro);
+
+    // Copia ate max registros pendentes, em ordem, sem consumi-los.
+    // ate recebe a seq a passar para confirmar() depois do envio.
+    size_t ler_pendentes(uint8_t (*registros)[SENSOR_REGISTRO_TAMANHO], size_t max, uint32_t *ate);
+
+    // Marca como enviadas todas as amostras com seq < ate
+    bool confirmar(uint32_t ate);
+
+    uint32_t pendentes() const { return m_proxima_seq - m_confirmado; }
+    const JournalEstatisticas &estatisticas() const { return m_est; }
+
+private:
+    struct Posicao {
+        uint16_t setor;
+        uint16_t slot;
+    };
+
+    size_t offset_setor(uint16_t setor) const { return (size_t)setor * JOURNAL_SETOR_TAMANHO; }
+    size_t offset_slot(Posicao p) const;
+    bool ler_cabecalho(uint16_t setor, uint32_t *seq_setor);
+    bool ler_slot(Posicao p, uint8_t *slot, bool *vazio);
+    bool escrever_slot(uint8_t tipo, uint32_t seq, const uint8_t *registro);
+    bool abrir_proximo_setor();
+
+    JournalFlash m_flash;
+    uint16_t m_num_setores;
+    bool m_montado;
+
+    Posicao m_cabeca;            // proximo slot livre
+    uint32_t m_seq_setor;        // sequencia do setor da cabeca
+
+    uint32_t m_proxima_seq;      // seq da proxima amostra
+    uint32_t m_confirmado;       // todas as seq < m_confirmado ja foram enviadas
+
+    Posicao m_leitura;           // nada pendente antes desta posicao
+    Posicao m_leitura_prox;      // fim da ultima leitura (adotado em confirmar)
+    uint32_t m_leitura_ate;      // 0 = nenhuma leitura em aberto
+
+    JournalEstatisticas m_est;
+};
+
+// Monta o journal na particao "journal" (retorna false se ela nao existir)
+bool journal_iniciar_particao(Journal &journal);
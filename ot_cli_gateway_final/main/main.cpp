@@ -23,6 +23,9 @@
 #include "sensor_data.hpp"
 #include "sensor_collect.hpp"
 #include "http_request.hpp"
+#include "radio_manager.hpp"
+#include "cadastro_nodos.hpp"
+#include "metricas.hpp"
 
 // Declarações de funções
 void ot_task_worker(void *aContext);
@@ -33,48 +36,107 @@ void ot_disable();
 void sensors_enable(otInstance *instance, sensor_data_t *data);
 void sensors_disable(void);
 void http_send_all_now();
+void http_encerrar_conexao();
 void debug_tabela_nodos();
 
 otInstance *global_ot_instance;
-sensor_data_t sensor_data;
 
 // Timer para alternância periódica
 TimerHandle_t alternancia_timer;
 
 static const gpio_num_t PINO_INICIALIZACAO = GPIO_NUM_18;
 
-// Task de alternância
+// Timeouts das fases do ciclo (cada fase avanca assim que o evento chega)
+#define TIMEOUT_WIFI_IP_MS    15000
+#define TIMEOUT_SNTP_MS        5000
+#define TIMEOUT_OT_ATTACH_MS  20000
+
+// Coleta do gateway: sensors_enable ja espera os sensores ficarem prontos
+// (leitura local: a amostragem_task grava a dela na tabela com o lock)
+static void coletar_gateway()
+{
+    sensor_data_t leitura = {};
+    uint32_t t0 = esp_log_timestamp();
+    sensors_enable(global_ot_instance, &leitura);
+    sensors_disable();
+    radio_fase_concluida(FASE_SENSORES, t0, sensors_are_ready(&leitura));
+}
+
+static void enviar_http()
+{
+    uint32_t t0 = esp_log_timestamp();
+    http_send_all_now();
+    radio_fase_concluida(FASE_HTTP, t0, true);
+}
+
+#if CONFIG_GATEWAY_RADIO_COEXISTENCIA
+// Task do ciclo de envio (coexistencia): Thread e Wi-Fi continuam no ar,
+// a malha nao fica surda durante o upload
 void alternancia_task(void *pvParameters)
 {
+    radio_iniciar_ciclo();
+    ESP_LOGI(TAG, "Ciclo: coletando e enviando (Thread e Wi-Fi ativos)");
+
+    // 1. Coleta dados do gateway
+    coletar_gateway();
+
+    // 2. Envia dados (gateway + nós); sem IP os dados ficam para o proximo ciclo
+    if (radio_estado(RADIO_WIFI) == RADIO_ATIVO) {
+        enviar_http();
+    } else {
+        ESP_LOGW(TAG, "Ciclo: Wi-Fi sem IP, envio adiado");
+    }
+
+    radio_registrar_estatisticas();
+    metricas_pilha(MT_CICLO);
+    vTaskDelete(NULL);
+}
+#else
+// Task de alternância: cada fase espera o seu evento (com timeout)
+void alternancia_task(void *pvParameters)
+{
+    radio_iniciar_ciclo();
     ESP_LOGI(TAG, "Alternância: Desativando Thread para envio WiFi");
     
-    // 1. Desativa Thread
+    // 1. Desativa Thread (ot_disable espera o mainloop terminar)
     ot_disable();
-    vTaskDelay(pdMS_TO_TICKS(1000)); // Espera um pouco para liberar o rádio
     
-    // 2. Ativa WiFi
+    // 2. Ativa WiFi e espera o IP
     wifi_enable();
-    vTaskDelay(pdMS_TO_TICKS(5000)); // Espera conectar
+    bool com_ip = radio_aguardar(FASE_WIFI_IP, RADIO_BIT_WIFI_IP, TIMEOUT_WIFI_IP_MS);
+
+    // 3. Hora: so espera o SNTP se ainda nao houver hora valida
+    if (com_ip && !sntp_hora_valida()) {
+        radio_aguardar(FASE_SNTP, RADIO_BIT_SNTP, TIMEOUT_SNTP_MS);
+    }
     
-    // 3. Coleta dados do gateway (se tiver sensores)
-    sensors_enable(global_ot_instance, &sensor_data); // Se quiser coletar do gateway
-    vTaskDelay(pdMS_TO_TICKS(2000));
-    sensors_disable();
+    // 4. Coleta dados do gateway (se tiver sensores)
+    coletar_gateway();
     
-    // 4. Envia dados (gateway + nós)
-    http_send_all_now();
+    // 5. Envia dados (gateway + nós); sem IP ficam no journal/aneis
+    if (com_ip) {
+        enviar_http();
+        http_encerrar_conexao();
+    } else {
+        ESP_LOGW(TAG, "Alternância: Wi-Fi sem IP, envio adiado");
+    }
     
-    // 5. Desativa WiFi
+    // 6. Desativa WiFi (esp_wifi_stop e sincrono)
+    uint32_t t0 = esp_log_timestamp();
     wifi_disable();
-    vTaskDelay(pdMS_TO_TICKS(1000)); // Espera desligar o rádio
+    radio_fase_concluida(FASE_WIFI_PARAR, t0, true);
     
-    // 6. Reativa Thread
+    // 7. Reativa Thread e mede o tempo ate a malha voltar
     ot_enable();
+    radio_aguardar(FASE_OT_ATTACH, RADIO_BIT_THREAD_ATIVO, TIMEOUT_OT_ATTACH_MS);
     
     ESP_LOGI(TAG, "Alternância: Concluída, Thread reativada");
+    radio_registrar_estatisticas();
+    metricas_pilha(MT_CICLO);
     
     vTaskDelete(NULL);
 }
+#endif
 
 // Callback do timer
 static void timer_callback(TimerHandle_t xTimer)
@@ -91,6 +153,7 @@ extern "C" void app_main(void)
 
     // Configura e inicializa netif e eventos
     ESP_ERROR_CHECK(nvs_flash_init());
+    cadastro_iniciar();     // ids dos nós antes do primeiro CoAP
     esp_log_level_set("wifi", ESP_LOG_VERBOSE);  // Logs detalhados do WiFi
     esp_log_level_set("*", ESP_LOG_INFO);        // Logs normais para outros componentes
     ESP_ERROR_CHECK(esp_netif_init());
@@ -101,9 +164,20 @@ extern "C" void app_main(void)
     };
     ESP_ERROR_CHECK(esp_vfs_eventfd_register(&eventfd_config));
 
+    // Event group de conectividade (usado pelas fases do ciclo)
+    radio_iniciar();
+
     // Inicia Open Thread
     ot_enable();
 
+#if CONFIG_GATEWAY_RADIO_COEXISTENCIA
+    // Wi-Fi fica ligado junto com a Thread; o coex arbitra a antena
+    wifi_enable();
+    radio_coexistencia_iniciar();
+    radio_aguardar(FASE_WIFI_IP, RADIO_BIT_WIFI_IP, TIMEOUT_WIFI_IP_MS);
+#endif
+    radio_aguardar(FASE_OT_ATTACH, RADIO_BIT_THREAD_ATIVO, TIMEOUT_OT_ATTACH_MS);
+
     // Cria um timer periodico a cada 5 minutos (300000 ms)
     alternancia_timer = xTimerCreate(
         "AlternanciaTimer",
@@ -0,0 +1,178 @@
+#include "metricas.hpp"
+
+#ifdef ESP_PLATFORM
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
+
+static const char *NOMES_CONTADOR[MC_TOTAL] = {
+    "coap_rx", "coap_rejeitados", "http_ok", "http_falhas"
+};
+static const char *NOMES_HISTOGRAMA[MH_TOTAL] = {
+    "coap_handler", "nodo_atualizar", "http_conectar", "http_enviar", "http_resposta",
+    "fase_ot_parar", "fase_ot_iniciar", "fase_ot_attach", "fase_wifi_ip",
+    "fase_sntp", "fase_sensores", "fase_http", "fase_wifi_parar"
+};
+static const char *NOMES_TASK[MT_TOTAL] = {
+    "openthread", "amostragem", "http", "ciclo", "cli"
+};
+
+struct Histograma {
+    uint32_t baldes[METRICAS_BALDES];
+    uint32_t n;
+    uint32_t soma;
+    uint32_t max;
+};
+
+static uint32_t s_contadores[MC_TOTAL];
+static Histograma s_histogramas[MH_TOTAL];
+static uint32_t s_pilhas[MT_TOTAL] = {
+    METRICAS_PILHA_NUNCA, METRICAS_PILHA_NUNCA, METRICAS_PILHA_NUNCA,
+    METRICAS_PILHA_NUNCA, METRICAS_PILHA_NUNCA
+};
+
+// ==================== AUXILIARES ====================
+// Balde de um valor: numero de bits significativos, limitado ao ultimo
+static inline size_t balde_de(uint32_t valor)
+{
+    size_t k = valor ? (size_t)(32 - __builtin_clz(valor)) : 0;
+    return k < METRICAS_BALDES ? k : METRICAS_BALDES - 1;
+}
+
+// Maior valor que cai no balde k
+static inline uint32_t limite_do_balde(size_t k)
+{
+    if (k == 0) return 0;
+    if (k >= METRICAS_BALDES - 1) return UINT32_MAX;
+    return (1u << k) - 1;
+}
+
+static inline uint32_t ler(const uint32_t *p)
+{
+    return __atomic_load_n(p, __ATOMIC_RELAXED);
+}
+
+// Troca *p por valor enquanto 'menor' decidir que ele e melhor
+static inline void atualizar_extremo(uint32_t *p, uint32_t valor, bool menor)
+{
+    uint32_t atual = ler(p);
+    while (menor ? valor < atual : valor > atual) {
+        if (__atomic_compare_exchange_n(p, &atual, valor, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+    }
+}
+
+// ==================== NOMES ====================
+const char *metricas_contador_nome(MetricaContador c)
+{
+    return NOMES_CONTADOR[c];
+}
+
+const char *metricas_histograma_nome(MetricaHistograma h)
+{
+    return NOMES_HISTOGRAMA[h];
+}
+
+const char *metricas_histograma_unidade(MetricaHistograma h)
+{
+    return h >= MH_FASE_RADIO ? "ms" : "us";
+}
+
+const char *metricas_task_nome(MetricaTask t)
+{
+    return NOMES_TASK[t];
+}
+
+// ==================== CONTADORES ====================
+void metricas_contar(MetricaContador c, uint32_t n)
+{
+    __atomic_fetch_add(&s_contadores[c], n, __ATOMIC_RELAXED);
+}
+
+uint32_t metricas_contador(MetricaContador c)
+{
+    return ler(&s_contadores[c]);
+}
+
+uint32_t metricas_taxa_minuto(MetricaContador c, MetricaTaxa *t, uint32_t agora_ms)
+{
+    uint32_t valor = metricas_contador(c);
+    uint32_t eventos = valor - t->valor;
+    uint32_t dt = agora_ms - t->instante_ms;
+
+    t->valor = valor;
+    t->instante_ms = agora_ms;
+    return dt ? (uint32_t)((uint64_t)eventos * 60000u / dt) : 0;
+}
+
+// ==================== HISTOGRAMAS ====================
+void metricas_registrar(MetricaHistograma h, uint32_t valor)
+{
+    Histograma &hist = s_histogramas[h];
+    __atomic_fetch_add(&hist.baldes[balde_de(valor)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&hist.n, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&hist.soma, valor, __ATOMIC_RELAXED);
+    atualizar_extremo(&hist.max, valor, false);
+}
+
+uint32_t metricas_balde(MetricaHistograma h, size_t balde)
+{
+    return balde < METRICAS_BALDES ? ler(&s_histogramas[h].baldes[balde]) : 0;
+}
+
+void metricas_resumo(MetricaHistograma h, MetricaResumo *r)
+{
+    const Histograma &hist = s_histogramas[h];
+    uint32_t baldes[METRICAS_BALDES];
+    uint32_t n = 0;
+
+    // Percentis sobre a copia dos baldes (n pode andar enquanto se le)
+    for (size_t k = 0; k < METRICAS_BALDES; k++) {
+        baldes[k] = ler(&hist.baldes[k]);
+        n += baldes[k];
+    }
+    r->n = n;
+    r->soma = ler(&hist.soma);
+    r->max = ler(&hist.max);
+
+    const uint32_t permil[3] = { 500, 900, 990 };
+    uint32_t *saida[3] = { &r->p50, &r->p90, &r->p99 };
+    uint32_t acumulado = 0;
+    size_t k = 0;
+    for (int p = 0; p < 3; p++) {
+        uint64_t alvo = ((uint64_t)n * permil[p] + 999) / 1000;
+        while (k < METRICAS_BALDES - 1 && acumulado + baldes[k] < alvo) {
+            acumulado += baldes[k++];
+        }
+        // O limite do balde nunca passa do maior valor visto
+        uint32_t limite = limite_do_balde(k);
+        *saida[p] = !n ? 0 : (limite < r->max ? limite : r->max);
+    }
+}
+
+// ==================== PILHA E HEAP ====================
+void metricas_pilha(MetricaTask t)
+{
+#ifdef ESP_PLATFORM
+    // No ESP-IDF a marca d'agua ja vem em bytes
+    atualizar_extremo(&s_pilhas[t], (uint32_t)uxTaskGetStackHighWaterMark(NULL), true);
+#else
+    (void)t;
+#endif
+}
+
+uint32_t metricas_pilha_minima(MetricaTask t)
+{
+    return ler(&s_pilhas[t]);
+}
+
+void metricas_heap(uint32_t *livre, uint32_t *minimo)
+{
+#ifdef ESP_PLATFORM
+    *livre = esp_get_free_heap_size();
+    *minimo = esp_get_minimum_free_heap_size();
+#else
+    *livre = 0;
+    *minimo = 0;
+#endif
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include "radio_manager.hpp"
+
+// ==================== METRICAS DO GATEWAY ====================
+// Registro estatico de contadores e histogramas de latencia, sem lock:
+// cada registro e um __atomic relaxado, entao a task do OpenThread, a do
+// HTTP e a do ciclo gravam sem se bloquear. O leitor (comando "metricas"
+// e upload) ve cada valor inteiro, mas nao um retrato atomico do conjunto.
+//
+// Histogramas tem baldes fixos em potencias de 2: o balde k (k > 0) conta
+// valores em [2^(k-1), 2^k); o ultimo acumula tudo acima. Percentis saem
+// como o limite superior do balde, o que basta para ver caudas de latencia.
+
+#define METRICAS_BALDES        24
+#define METRICAS_PILHA_NUNCA   UINT32_MAX
+
+enum MetricaContador {
+    MC_COAP_RX = 0,          // pedidos ao recurso de sensores
+    MC_COAP_REJEITADOS,      // respondidos com erro (4.xx/5.xx)
+    MC_HTTP_OK,              // POSTs com resposta 2xx
+    MC_HTTP_FALHAS,          // POSTs sem resposta ou com status != 2xx
+    MC_TOTAL
+};
+
+enum MetricaHistograma {
+    MH_COAP_HANDLER = 0,     // us, coap_handler inteiro: payload, tabela e ACK
+    MH_NODO_ATUALIZAR,       // us, registrarNodo
+    MH_HTTP_CONECTAR,        // us, DNS + handshake TCP (so conexoes novas)
+    MH_HTTP_ENVIAR,          // us, escrita de uma requisicao no socket
+    MH_HTTP_RESPOSTA,        // us, do envio do lote a cada resposta lida
+    MH_FASE_RADIO,           // ms, uma por RadioFase (MH_FASE_RADIO + fase)
+    MH_TOTAL = MH_FASE_RADIO + FASE_TOTAL
+};
+
+// Tasks cuja pilha e acompanhada (cada uma mede a propria)
+enum MetricaTask {
+    MT_OPENTHREAD = 0,
+    MT_AMOSTRAGEM,
+    MT_HTTP,
+    MT_CICLO,
+    MT_CLI,
+    MT_TOTAL
+};
+
+struct MetricaResumo {
+    uint32_t n;
+    uint32_t soma;           // da a volta em sessoes muito longas
+    uint32_t max;
+    uint32_t p50, p90, p99;  // limite superior do balde
+};
+
+// Estado de quem calcula uma taxa: zerado = desde o boot
+struct MetricaTaxa {
+    uint32_t valor;
+    uint32_t instante_ms;
+};
+
+const char *metricas_contador_nome(MetricaContador c);
+const char *metricas_histograma_nome(MetricaHistograma h);
+const char *metricas_histograma_unidade(MetricaHistograma h);
+const char *metricas_task_nome(MetricaTask t);
+
+void metricas_contar(MetricaContador c, uint32_t n = 1);
+uint32_t metricas_contador(MetricaContador c);
+
+void metricas_registrar(MetricaHistograma h, uint32_t valor);
+void metricas_resumo(MetricaHistograma h, MetricaResumo *r);
+uint32_t metricas_balde(MetricaHistograma h, size_t balde);
+
+// Eventos do contador por minuto desde a chamada anterior com o mesmo 't'
+uint32_t metricas_taxa_minuto(MetricaContador c, MetricaTaxa *t, uint32_t agora_ms);
+
+// Menor folga de pilha (bytes) ja vista pela task corrente, registrada como 't'
+void metricas_pilha(MetricaTask t);
+uint32_t metricas_pilha_minima(MetricaTask t);
+
+// Heap livre agora e o menor valor desde o boot (0 fora do ESP-IDF)
+void metricas_heap(uint32_t *livre, uint32_t *minimo);
+
+// Relogio monotonico em us para os cronometros
+inline uint32_t metricas_agora_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000u + ts.tv_nsec / 1000u);
+}
+
+// Registra em 'h' os us ate sair do escopo (cobre todos os returns)
+class MetricaCronometro {
+public:
+    explicit MetricaCronometro(MetricaHistograma h) : m_h(h), m_inicio(metricas_agora_us()) {}
+    ~MetricaCronometro() { metricas_registrar(m_h, metricas_agora_us() - m_inicio); }
+
+private:
+    MetricaHistograma m_h;
+    uint32_t m_inicio;
+};
@@ -1,15 +1,75 @@
 // node_info.hpp
 #pragma once
 
-#include <string>
+#include "openthread/ip6.h"
 #include "sensor_data.hpp"
 
+// Amostra guardada no historico do nó (mesma escala do registro binario)
+struct AmostraSensor {
+    uint32_t epoch;             // instante da leitura (segundos UTC, 0 = sem hora)
+    int16_t  temperatura;       // 0.01 °C
+    uint16_t umidadeAr;         // 0.01 %
+    uint16_t umidadeSolo;       // 0.01 %
+    uint16_t milissegundos;     // fracao do instante
+    uint32_t particulas;        // 0.01 ppm
+};
+
+// Perda/duplicata/ordem pela sequencia das amostras (token CoAP).
+// Janela deslizante de 64 sequencias: bit k = amostra (maior - k) recebida.
+#define SEQ_JANELA 64
+
+struct EstatisticasSequencia {
+    uint64_t janela;
+    uint32_t maior;             // maior sequencia recebida
+    uint32_t recebidas;         // amostras unicas aceitas
+    uint32_t perdidas;          // lacunas que sairam da janela sem chegar
+    uint32_t duplicadas;
+    uint32_t reordenadas;       // chegaram depois de uma sequencia maior
+    uint32_t reinicios;         // saltos grandes (boot a frio do nó)
+    uint32_t iniciada;          // 0 = nó sem sequencia (firmware antigo)
+    uint32_t reservado;
+};
+
+// Enlace do nó na malha: ultimo bloco de enlace recebido (sensor_codec.hpp)
+// e os contadores MAC somados desde que o nó entrou na tabela
+#define ENLACE_SALTOS_DESCONHECIDO 0xff
+
+struct EnlaceNodo {
+    sensor_enlace_t ultimo;
+    uint8_t saltos;             // ate este gateway (0 = o proprio gateway)
+    uint8_t custo;              // custo de rota do gateway ao roteador do nó
+    uint16_t reservado;
+    uint32_t relatos;           // blocos recebidos; 0 = nó sem bloco de enlace
+    uint32_t atualizado_ms;
+    uint32_t quadros;
+    uint32_t retentativas;
+    uint32_t sem_ack;
+    uint32_t cca;
+};
+
 class NodeInfo {
 public:
-    std::string endereco;
+    uint16_t id;                // chave: id curto do nó (cadastro_nodos.hpp)
+    uint16_t reservado;
     sensor_data_t dados;
     uint32_t last_update_ms;
 
-    NodeInfo(const std::string &addr, const sensor_data_t &d, uint32_t ts)
-        : endereco(addr), dados(d), last_update_ms(ts) {}
-};
\ No newline at end of file
+    // Amostras ja gravadas no anel do historico (sequencia absoluta;
+    // slot = seq % tamanho do anel). Os cursores de envio ficam com o envio.
+    uint32_t hist_escritas;
+
+    // Reuso da posicao apos despejo: a sequencia do anel continua, e o
+    // historico deste nó comeca em hist_base
+    uint32_t geracao;
+    uint32_t hist_base;
+    uint32_t ativo;             // 0 = posicao livre (nó despejado)
+
+    EstatisticasSequencia seq;
+    EnlaceNodo enlace;
+
+    NodeInfo() = default;
+
+    NodeInfo(uint16_t id_nodo, const sensor_data_t &d, uint32_t ts)
+        : id(id_nodo), reservado(0), dados(d), last_update_ms(ts), hist_escritas(0),
+          geracao(0), hist_base(0), ativo(1), seq(), enlace() {}
+};
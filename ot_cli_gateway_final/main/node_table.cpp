@@ -1,44 +1,464 @@
 #include "node_table.hpp"
-#include "node_table.hpp"
+#include "cadastro_nodos.hpp"
+#include "sensor_codec.hpp"
+#include "seqlock.hpp"
+#include "roda_temporizadores.hpp"
+#include "metricas.hpp"
+#include "esp_timer.h"
+#if CONFIG_GATEWAY_AGREGACAO
+#include "agregacao.hpp"
+#endif
 #include "esp_log.h"
+#include <string.h>
+#include <math.h>
 
 static const char *TAG_NODES = "NODE_TABLE";
 
-// Vetor dinamico — CRESCE SOZINHO
-static std::vector<NodeInfo> tabela_nodos;
+// Armazenamento denso dos nós (ordem de chegada) — alocado uma unica vez.
+// So escreve quem tem o lock do OpenThread (a task dele ou a amostragem
+// local do gateway); as demais leem por lerNodo (seqlock).
+static NodeInfo tabela_nodos[NODE_TABLE_CAPACIDADE];
+static SeqLock versao_nodo[NODE_TABLE_CAPACIDADE];
+static size_t num_nodos = 0;            // posicoes ja usadas (inclui livres)
+
+// Posicoes liberadas por despejo, reusadas antes de crescer num_nodos
+static int16_t posicoes_livres[NODE_TABLE_CAPACIDADE];
+static size_t num_livres = 0;
+
+// Vivacidade: um temporizador por posicao, so a task que registra mexe
+static RodaTemporizadores roda_vivacidade;
+static uint32_t total_novos = 0;
+static uint32_t total_despejados = 0;
+
+// Arena do historico: um anel fixo por posicao da tabela
+static AmostraSensor historico[NODE_TABLE_CAPACIDADE][NODE_HISTORICO_AMOSTRAS];
+
+// Cursores de envio: so a task de envio le e escreve
+struct CursorEnvio {
+    uint32_t enviadas;
+    uint32_t perdidas;      // amostras sobrescritas antes de serem enviadas
+    uint32_t geracao;       // geracao da posicao a que 'enviadas' se refere
+};
+static CursorEnvio cursor_envio[NODE_TABLE_CAPACIDADE];
+
+// Id curto (cadastro_nodos.hpp) -> posicao em tabela_nodos (ou SEM_POSICAO):
+// o id ja e denso e pequeno, entao o indice e acesso direto, sem hash
+#define SEM_POSICAO (-1)
+static int16_t posicao_do_id[CADASTRO_CAPACIDADE + 1];
+static bool indice_inicializado = false;
+
+static void inicializar_indice()
+{
+    for (size_t id = 0; id <= CADASTRO_CAPACIDADE; id++) {
+        posicao_do_id[id] = SEM_POSICAO;
+    }
+    indice_inicializado = true;
+}
+
+// Converte para centesimos com saturacao (mesma escala do registro binario)
+static inline int32_t centesimos(float v, int32_t min, int32_t max)
+{
+    long c = lroundf(v * 100.0f);
+    if (c < min) c = min;
+    if (c > max) c = max;
+    return (int32_t)c;
+}
+
+// Grava a leitura no anel do nó (n ainda nao publicado); se cheio,
+// sobrescreve a mais antiga
+static void guardar_amostra(size_t i, NodeInfo &n, const sensor_data_t &dados)
+{
+    AmostraSensor a;
+    a.epoch         = (uint32_t)(dados.epoch_ms / 1000);
+    a.milissegundos = (uint16_t)(dados.epoch_ms % 1000);
+    a.temperatura   = (int16_t)centesimos(dados.temperatura, INT16_MIN, INT16_MAX);
+    a.umidadeAr     = (uint16_t)centesimos(dados.umidadeAr, 0, UINT16_MAX);
+    a.umidadeSolo   = (uint16_t)centesimos(dados.umidadeSolo, 0, UINT16_MAX);
+    a.particulas    = (uint32_t)centesimos(dados.particulas, 0, INT32_MAX);
+
+    // Quem copiar algo desta escrita vera hist_escritas >= a sequencia
+    // reescrita (ver historicoAmostra)
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    seqlock_copiar(&historico[i][n.hist_escritas % NODE_HISTORICO_AMOSTRAS], &a);
+    n.hist_escritas++;
+}
+
+// Publica o registro do nó. A barreira de escrita do seqlock vem depois da
+// amostra no anel, entao quem ve o novo hist_escritas ve a amostra gravada.
+static void publicar_nodo(size_t i, const NodeInfo &n)
+{
+    versao_nodo[i].escrever(&tabela_nodos[i], n);
+}
+
+// ==================== VIVACIDADE ====================
+// Relogio da roda em segundos (esp_timer nao da a volta como o de ms)
+static inline uint32_t segundos_agora()
+{
+    return (uint32_t)(esp_timer_get_time() / 1000000);
+}
+
+struct RelogioVivacidade {
+    uint32_t agora_ms;
+    uint32_t agora_s;
+};
+
+// Segundo em que o nó, parado ha 'parado_ms', atinge 'limite_ms'
+static inline uint32_t prazo_em(const RelogioVivacidade &r, uint32_t parado_ms, uint32_t limite_ms)
+{
+    return r.agora_s + (limite_ms - parado_ms + 999) / 1000;
+}
+
+static void despejar(size_t i)
+{
+    NodeInfo n = tabela_nodos[i];
+
+    posicao_do_id[n.id] = SEM_POSICAO;
+    n.ativo = 0;
+    publicar_nodo(i, n);
+    posicoes_livres[num_livres++] = (int16_t)i;
+    __atomic_store_n(&total_despejados, total_despejados + 1, __ATOMIC_RELAXED);
+
+    ESP_LOGI(TAG_NODES, "Nó offline despejado: id %u (posicao %d livre)", (unsigned)n.id, (int)i);
+}
+
+// Temporizador vencido. A roda nao e mexida a cada leitura: aqui o prazo e
+// recalculado a partir de last_update_ms (online -> stale -> offline/despejo)
+static void nodo_venceu(uint16_t id, void *ctx)
+{
+    const RelogioVivacidade &r = *(const RelogioVivacidade *)ctx;
+    const NodeInfo &n = tabela_nodos[id];
+    uint32_t parado = r.agora_ms - n.last_update_ms;
+
+    if (parado < NODO_STALE_MS) {
+        roda_vivacidade.agendar(id, prazo_em(r, parado, NODO_STALE_MS));
+    } else if (parado < NODO_OFFLINE_MS) {
+        ESP_LOGI(TAG_NODES, "Nó stale ha %us: id %u", (unsigned)(parado / 1000), (unsigned)n.id);
+        roda_vivacidade.agendar(id, prazo_em(r, parado, NODO_OFFLINE_MS));
+    } else {
+        despejar(id);
+    }
+}
+
+EstadoNodo estadoNodo(const NodeInfo &n, uint32_t agora_ms)
+{
+    uint32_t parado = agora_ms - n.last_update_ms;
+    if (parado < NODO_STALE_MS) return NODO_ONLINE;
+    if (parado < NODO_OFFLINE_MS) return NODO_STALE;
+    return NODO_OFFLINE;
+}
+
+const char *estadoNodoNome(EstadoNodo e)
+{
+    switch (e) {
+    case NODO_ONLINE: return "online";
+    case NODO_STALE:  return "stale";
+    default:          return "offline";
+    }
+}
+
+void estatisticasNodos(uint32_t agora_ms, EstatisticasNodos *saida)
+{
+    NodeInfo n;
+    size_t total = totalNodos();
+
+    memset(saida, 0, sizeof(*saida));
+    saida->posicoes = (uint32_t)total;
+    for (size_t i = 0; i < total; i++) {
+        if (!lerNodo(i, &n)) continue;
+        switch (estadoNodo(n, agora_ms)) {
+        case NODO_ONLINE: saida->online++; break;
+        case NODO_STALE:  saida->stale++; break;
+        default:          saida->offline++; break;
+        }
+    }
+    saida->novos = __atomic_load_n(&total_novos, __ATOMIC_RELAXED);
+    saida->despejados = __atomic_load_n(&total_despejados, __ATOMIC_RELAXED);
+}
+
+void registrarEstatisticasNodos()
+{
+    EstatisticasNodos e;
+    estatisticasNodos(esp_log_timestamp(), &e);
+    ESP_LOGI(TAG_NODES, "Nós: %u online, %u stale, %u offline; %u/%d posicoes; churn +%u novos -%u despejados",
+             (unsigned)e.online, (unsigned)e.stale, (unsigned)e.offline, (unsigned)e.posicoes,
+             NODE_TABLE_CAPACIDADE, (unsigned)e.novos, (unsigned)e.despejados);
+}
+
+// ==================== SEQUENCIA ====================
+// Atualiza a janela com a sequencia recebida; false para duplicata
+static bool contar_sequencia(EstatisticasSequencia &s, uint32_t seq)
+{
+    int32_t d = (int32_t)(seq - s.maior);
+
+    if (s.iniciada && (d > SEQ_SALTO_REINICIO || d < -SEQ_SALTO_REINICIO)) {
+        s.reinicios++;
+        s.iniciada = 0;
+    }
+    if (!s.iniciada) {
+        // Antes da primeira amostra nada conta como lacuna
+        s.iniciada = 1;
+        s.maior = seq;
+        s.janela = ~0ull;
+        s.recebidas++;
+        return true;
+    }
+
+    if (d > 0) {
+        // Avanca a janela; zeros que saem sao perdas definitivas
+        if (d >= SEQ_JANELA) {
+            s.perdidas += (SEQ_JANELA - __builtin_popcountll(s.janela)) + (uint32_t)(d - SEQ_JANELA);
+            s.janela = 1;
+        } else {
+            uint64_t saindo = s.janela >> (SEQ_JANELA - d);
+            s.perdidas += (uint32_t)d - __builtin_popcountll(saindo);
+            s.janela = (s.janela << d) | 1;
+        }
+        s.maior = seq;
+        s.recebidas++;
+        return true;
+    }
+
+    uint32_t atras = (uint32_t)(-d);
+    if (atras >= SEQ_JANELA) {
+        // Ja tinha saido da janela como perdida: chegou, mas fora de ordem
+        if (s.perdidas > 0) s.perdidas--;
+        s.reordenadas++;
+        s.recebidas++;
+        return true;
+    }
+
+    uint64_t bit = 1ull << atras;
+    if (s.janela & bit) {
+        s.duplicadas++;
+        return false;
+    }
+    s.janela |= bit;
+    s.reordenadas++;
+    s.recebidas++;
+    return true;
+}
+
+uint32_t seqLacunas(const EstatisticasSequencia &s)
+{
+    return s.iniciada ? SEQ_JANELA - __builtin_popcountll(s.janela) : 0;
+}
+
+uint32_t seqPerdaPermil(const EstatisticasSequencia &s)
+{
+    uint32_t faltando = s.perdidas + seqLacunas(s);
+    uint32_t esperadas = s.recebidas + faltando;
+    return esperadas ? (uint32_t)(((uint64_t)faltando * 1000) / esperadas) : 0;
+}
 
 // Adicione em node_table.cpp
 void debug_tabela_nodos() {
-    ESP_LOGI(TAG_NODES, "=== DEBUG TABELA NODOS (%d nós) ===", tabela_nodos.size());
-    for (size_t i = 0; i < tabela_nodos.size(); i++) {
-        const auto& n = tabela_nodos[i];
-        ESP_LOGI(TAG_NODES, "Nó %d: IP=%s", i, n.endereco.c_str());
+    char ip[OT_IP6_ADDRESS_STRING_SIZE];
+    NodeInfo n;
+    size_t total = totalNodos();
+    uint32_t agora = esp_log_timestamp();
+
+    ESP_LOGI(TAG_NODES, "=== DEBUG TABELA NODOS (%d posicoes) ===", (int)total);
+    for (size_t i = 0; i < total; i++) {
+        if (!lerNodo(i, &n)) continue;
+        cadastro_eid_texto(n.id, ip, sizeof(ip));
+        ESP_LOGI(TAG_NODES, "Nó %d: id %u, IP=%s (%s)", (int)i, (unsigned)n.id, ip,
+                 estadoNodoNome(estadoNodo(n, agora)));
         ESP_LOGI(TAG_NODES, "  Temp: %.2f, UAr: %.2f, USolo: %.2f, Part: %.2f",
-                n.dados.temperatura, n.dados.umidadeAr, 
+                n.dados.temperatura, n.dados.umidadeAr,
                 n.dados.umidadeSolo, n.dados.particulas);
     }
 }
 
-// Registrar ou atualizar
-void registrarNodo(const std::string &ipv6, const sensor_data_t &dados)
+// Registrar ou atualizar — O(1) amortizado, sem alocacao
+bool registrarNodo(uint16_t id, const sensor_data_t &dados, bool com_seq, uint32_t seq)
 {
+    MetricaCronometro cronometro(MH_NODO_ATUALIZAR);
     uint32_t agora = esp_log_timestamp();
 
+    if (!indice_inicializado) {
+        inicializar_indice();
+    }
+
+    // Vencimentos pendentes primeiro: um despejo pode liberar a posicao
+    RelogioVivacidade relogio = { agora, segundos_agora() };
+    roda_vivacidade.avancar(relogio.agora_s, nodo_venceu, &relogio);
+
+    if (!cadastro_valido(id)) {
+        ESP_LOGW(TAG_NODES, "Amostra com id %u fora do cadastro, descartada", (unsigned)id);
+        return false;
+    }
+
     // Se ja existe → atualiza
-    for (auto &n : tabela_nodos) {
-        if (n.endereco == ipv6) {
-            n.dados = dados;
-            n.last_update_ms = agora;
-            ESP_LOGI(TAG_NODES, "Atualizado nó: %s", ipv6.c_str());
-            return;
+    if (posicao_do_id[id] != SEM_POSICAO) {
+        size_t i = posicao_do_id[id];
+        NodeInfo n = tabela_nodos[i];   // unico escritor: le direto
+        if (com_seq && !contar_sequencia(n.seq, seq)) {
+            // Duplicata (retransmissao da malha): so as estatisticas mudam
+            publicar_nodo(i, n);
+            ESP_LOGW(TAG_NODES, "Amostra duplicada do id %u (seq %u)", (unsigned)id, (unsigned)seq);
+            return true;
         }
+        n.dados = dados;
+        n.last_update_ms = agora;
+        guardar_amostra(i, n, dados);
+        publicar_nodo(i, n);
+#if CONFIG_GATEWAY_AGREGACAO
+        agregacao_registrar(i, dados, agora);
+#endif
+        ESP_LOGI(TAG_NODES, "Atualizado nó: id %u", (unsigned)id);
+        return true;
+    }
+
+    // Se nao existe → cria novo (posicao livre ou nova, se houver espaco)
+    size_t i;
+    NodeInfo n(id, dados, agora);
+
+    if (num_livres > 0) {
+        i = posicoes_livres[--num_livres];
+        // Reuso: a sequencia do anel continua para os cursores de envio
+        const NodeInfo &anterior = tabela_nodos[i];
+        n.hist_escritas = anterior.hist_escritas;
+        n.hist_base = anterior.hist_escritas;
+        n.geracao = anterior.geracao + 1;
+#if CONFIG_GATEWAY_AGREGACAO
+        agregacao_reiniciar(i);
+#endif
+    } else if (num_nodos < NODE_TABLE_CAPACIDADE) {
+        i = num_nodos;
+    } else {
+        ESP_LOGW(TAG_NODES, "Tabela cheia (%d nós), descartando: id %u",
+                 NODE_TABLE_CAPACIDADE, (unsigned)id);
+        return false;
+    }
+
+    if (com_seq) {
+        contar_sequencia(n.seq, seq);
+    }
+    guardar_amostra(i, n, dados);
+    publicar_nodo(i, n);
+#if CONFIG_GATEWAY_AGREGACAO
+    agregacao_registrar(i, dados, agora);
+#endif
+    posicao_do_id[id] = (int16_t)i;
+    roda_vivacidade.agendar(i, prazo_em(relogio, 0, NODO_STALE_MS));
+    __atomic_store_n(&total_novos, total_novos + 1, __ATOMIC_RELAXED);
+    if (i == num_nodos) {
+        // Posicao pronta antes de aparecer em totalNodos()
+        __atomic_store_n(&num_nodos, num_nodos + 1, __ATOMIC_RELEASE);
     }
+    ESP_LOGI(TAG_NODES, "Adicionado novo nó: id %u (posicao %d)", (unsigned)id, (int)i);
+    return true;
+}
+
+bool registrarEnlace(uint16_t id, const sensor_enlace_t &enlace, uint8_t saltos, uint8_t custo)
+{
+    if (!indice_inicializado || id > CADASTRO_CAPACIDADE || posicao_do_id[id] == SEM_POSICAO) return false;
+
+    size_t i = posicao_do_id[id];
+    NodeInfo n = tabela_nodos[i];       // unico escritor: le direto
+    EnlaceNodo &e = n.enlace;
+    e.ultimo = enlace;
+    e.saltos = saltos;
+    e.custo = custo;
+    e.relatos++;
+    e.atualizado_ms = esp_log_timestamp();
+    e.quadros += enlace.quadros;
+    e.retentativas += enlace.retentativas;
+    e.sem_ack += enlace.sem_ack;
+    e.cca += enlace.cca;
+    publicar_nodo(i, n);
+    return true;
+}
+
+const NodeInfo *buscarNodo(uint16_t id)
+{
+    if (!indice_inicializado || id > CADASTRO_CAPACIDADE) return NULL;
 
-    // Se nao existe → cria novo
-    tabela_nodos.emplace_back(ipv6, dados, agora);
-    ESP_LOGI(TAG_NODES, "Adicionado novo nó: %s", ipv6.c_str());
+    int16_t i = posicao_do_id[id];
+    return (i == SEM_POSICAO) ? NULL : &tabela_nodos[i];
 }
 
-const std::vector<NodeInfo>& getTabelaNodos() {
-    return tabela_nodos;
-}
\ No newline at end of file
+size_t totalNodos()
+{
+    return __atomic_load_n(&num_nodos, __ATOMIC_ACQUIRE);
+}
+
+bool lerNodo(size_t i, NodeInfo *copia)
+{
+    if (i >= totalNodos()) return false;
+    versao_nodo[i].ler(copia, &tabela_nodos[i]);
+    return copia->ativo != 0;
+}
+
+// ==================== HISTORICO (STORE-AND-FORWARD) ====================
+size_t historicoPendente(size_t i, const NodeInfo &nodo, uint32_t *de, uint32_t *ate)
+{
+    CursorEnvio &c = cursor_envio[i];
+
+    // Posicao reusada: o que sobrou do nó despejado nao e deste id
+    if (c.geracao != nodo.geracao) {
+        if ((int32_t)(nodo.hist_base - c.enviadas) > 0) {
+            c.perdidas += nodo.hist_base - c.enviadas;
+            c.enviadas = nodo.hist_base;
+        }
+        c.geracao = nodo.geracao;
+    }
+
+    // Fim da copia (nao o atual): amostras de uma geracao seguinte ficam de fora
+    uint32_t fim = nodo.hist_escritas;
+    uint32_t inicio = c.enviadas;
+
+    // Deixa uma folga de 1 slot: o registrador pode estar reescrevendo
+    // justamente a amostra mais antiga do anel
+    if (fim - inicio > NODE_HISTORICO_AMOSTRAS - 1) {
+        uint32_t novo_inicio = fim - (NODE_HISTORICO_AMOSTRAS - 1);
+        c.perdidas += novo_inicio - inicio;
+        c.enviadas = novo_inicio;
+        inicio = novo_inicio;
+    }
+
+    *de = inicio;
+    *ate = fim;
+    return fim - inicio;
+}
+
+bool historicoAmostra(size_t i, uint32_t seq, uint16_t id, sensor_data_t *saida)
+{
+    AmostraSensor a;
+    seqlock_copiar(&a, &historico[i][seq % NODE_HISTORICO_AMOSTRAS]);
+
+    // Valida depois da copia: se o registrador ja pode ter chegado ao slot
+    // (seq + tamanho do anel), a copia pode estar misturada
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    uint32_t escritas = __atomic_load_n(&tabela_nodos[i].hist_escritas, __ATOMIC_RELAXED);
+    if (escritas - seq > NODE_HISTORICO_AMOSTRAS - 1) {
+        cursor_envio[i].perdidas++;
+        return false;
+    }
+
+    memset(saida, 0, sizeof(*saida));
+    saida->nodo = id;
+    if (a.epoch != 0) {
+        saida->epoch_ms = (int64_t)a.epoch * 1000 + a.milissegundos;
+    }
+    saida->temperatura = a.temperatura / 100.0f;
+    saida->umidadeAr   = a.umidadeAr / 100.0f;
+    saida->umidadeSolo = a.umidadeSolo / 100.0f;
+    saida->particulas  = a.particulas / 100.0f;
+    return true;
+}
+
+void confirmarHistorico(size_t i, uint32_t ate)
+{
+    CursorEnvio &c = cursor_envio[i];
+
+    // Ignora confirmacoes atrasadas (o cursor ja foi adiantado por perda)
+    if ((int32_t)(ate - c.enviadas) > 0) {
+        c.enviadas = ate;
+    }
+}
+
+uint32_t historicoPerdidas(size_t i)
+{
+    return cursor_envio[i].perdidas;
+}
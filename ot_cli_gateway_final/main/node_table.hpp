@@ -1,15 +1,101 @@
 #pragma once
 
-#include <vector>
-#include <string>
+#include <stddef.h>
+#include "sdkconfig.h"
 #include "node_info.hpp"
 
-using namespace std;
+// Numero maximo de nós aceitos pelo gateway (tabela estática, sem heap);
+// o benchmark do host_sim compila com uma capacidade maior
+#ifndef NODE_TABLE_CAPACIDADE
+#define NODE_TABLE_CAPACIDADE 256
+#endif
 
-static vector<NodeInfo> nodes;
+// Amostras guardadas por nó entre dois envios HTTP (anel em arena estática)
+#ifdef CONFIG_GATEWAY_HISTORICO_AMOSTRAS
+#define NODE_HISTORICO_AMOSTRAS CONFIG_GATEWAY_HISTORICO_AMOSTRAS
+#else
+#define NODE_HISTORICO_AMOSTRAS 16
+#endif
+
+// Sem leitura ha NODO_STALE_MS o nó fica "stale" (fora dos envios); ha
+// NODO_OFFLINE_MS e despejado e a posicao volta a ficar livre
+#ifdef CONFIG_GATEWAY_NODO_STALE_S
+#define NODO_STALE_MS   ((uint32_t)CONFIG_GATEWAY_NODO_STALE_S * 1000u)
+#define NODO_OFFLINE_MS ((uint32_t)CONFIG_GATEWAY_NODO_OFFLINE_S * 1000u)
+#else
+#define NODO_STALE_MS   (300u * 1000u)
+#define NODO_OFFLINE_MS (1800u * 1000u)
+#endif
+
+static_assert(NODO_OFFLINE_MS > NODO_STALE_MS, "offline precisa vir depois de stale");
 
 // No http_post_task, antes do loop:
 void debug_tabela_nodos();
 
-void registrarNodo(const std::string &ipv6, const sensor_data_t &dados);
-const std::vector<NodeInfo>& getTabelaNodos();
\ No newline at end of file
+// ==================== ESCRITA (COM O LOCK DO OPENTHREAD) ====================
+// Retorna false se a tabela estiver cheia e o nó for novo. Com com_seq, a
+// sequencia da amostra alimenta as estatisticas e duplicatas sao descartadas.
+// O id (cadastro_nodos.hpp) precisa estar cadastrado.
+bool registrarNodo(uint16_t id, const sensor_data_t &dados, bool com_seq = false, uint32_t seq = 0);
+// Bloco de enlace do nó (ja registrado por registrarNodo), com os saltos e
+// o custo de rota calculados pelo gateway; false se o id nao esta na tabela
+bool registrarEnlace(uint16_t id, const sensor_enlace_t &enlace, uint8_t saltos, uint8_t custo);
+// Ponteiro para o registro vivo: so para a task que registra
+const NodeInfo *buscarNodo(uint16_t id);
+
+// ==================== LEITURA (QUALQUER TASK) ====================
+// Posicoes ja usadas: [0, n), algumas podem estar livres apos despejo
+size_t totalNodos();
+
+// Copia consistente do nó na posicao i, sem bloquear quem registra
+// (seqlock por posicao). false se a posicao nao tem nó.
+bool lerNodo(size_t i, NodeInfo *copia);
+
+// ==================== VIVACIDADE ====================
+enum EstadoNodo {
+    NODO_ONLINE = 0,
+    NODO_STALE,
+    NODO_OFFLINE
+};
+
+// Estado pela idade da ultima leitura (vale para qualquer copia)
+EstadoNodo estadoNodo(const NodeInfo &n, uint32_t agora_ms);
+const char *estadoNodoNome(EstadoNodo e);
+
+struct EstatisticasNodos {
+    uint32_t online;
+    uint32_t stale;
+    uint32_t offline;       // ainda nao despejados pela roda
+    uint32_t posicoes;      // totalNodos() (memoria em uso da tabela)
+    uint32_t novos;         // entradas desde o boot (inclui retornos apos despejo)
+    uint32_t despejados;    // desde o boot
+};
+
+void estatisticasNodos(uint32_t agora_ms, EstatisticasNodos *saida);
+void registrarEstatisticasNodos();
+
+// ==================== SEQUENCIA ====================
+// Salto (para frente ou para tras) tratado como reinicio do nó
+#define SEQ_SALTO_REINICIO 4096
+
+// Lacunas ainda dentro da janela (podem chegar atrasadas)
+uint32_t seqLacunas(const EstatisticasSequencia &s);
+// Perda estimada em permil: (perdidas + lacunas) / esperadas
+uint32_t seqPerdaPermil(const EstatisticasSequencia &s);
+
+// ==================== HISTORICO (STORE-AND-FORWARD) ====================
+// Usadas so pela task de envio, dona dos cursores de envio.
+// Faixa [de, ate) de sequencias ainda nao enviadas do nó na posicao i.
+// Amostras mais antigas que o anel foram perdidas e sao contadas no nó.
+// 'nodo' e a copia de lerNodo usada para montar o envio.
+size_t historicoPendente(size_t i, const NodeInfo &nodo, uint32_t *de, uint32_t *ate);
+
+// Reconstroi a leitura de uma amostra pendente (id do nó vem do chamador).
+// false se a amostra foi sobrescrita durante a copia (conta como perdida).
+bool historicoAmostra(size_t i, uint32_t seq, uint16_t id, sensor_data_t *saida);
+
+// Marca como enviadas as amostras ate (exclusivo) apos um POST aceito
+void confirmarHistorico(size_t i, uint32_t ate);
+
+// Amostras do nó sobrescritas antes de serem enviadas (desde o boot)
+uint32_t historicoPerdidas(size_t i);
@@ -0,0 +1,225 @@
+#include "radio_manager.hpp"
+#include "metricas.hpp"
+#include "esp_log.h"
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+
+#if CONFIG_ESP_COEX_SW_COEXIST_ENABLE
+#include "esp_coexist.h"
+#endif
+
+static const char *TAG_RADIO = "RADIO";
+
+static const char *NOMES_RADIO[RADIO_TOTAL] = { "thread", "wifi" };
+static const char *NOMES_ESTADO[] = { "desligado", "subindo", "ativo" };
+static const char *NOMES_FASE[FASE_TOTAL] = {
+    "ot_parar", "ot_iniciar", "ot_attach", "wifi_ip", "sntp", "sensores", "http", "wifi_parar"
+};
+
+// Bit do event group que acompanha o estado ATIVO de cada radio
+static const uint32_t BIT_ATIVO[RADIO_TOTAL] = { RADIO_BIT_THREAD_ATIVO, RADIO_BIT_WIFI_IP };
+
+static EventGroupHandle_t s_eventos = NULL;
+static RadioFaseContadores s_fases[FASE_TOTAL];
+
+// Eventos chegam da task do OpenThread, do loop de eventos e da task do ciclo
+static portMUX_TYPE s_radio_mux = portMUX_INITIALIZER_UNLOCKED;
+static RadioContadores s_radios[RADIO_TOTAL];
+
+static uint32_t s_coap_ciclo = 0;
+static uint32_t s_coap_total = 0;
+static uint32_t s_ciclo_inicio_ms = 0;
+static uint32_t s_ciclos = 0;
+
+// Parte de uma janela fora do ar [desde, agora) que caiu dentro do ciclo atual
+static inline uint32_t fora_no_ciclo(uint32_t desde, uint32_t agora)
+{
+    uint32_t inicio = ((int32_t)(desde - s_ciclo_inicio_ms) > 0) ? desde : s_ciclo_inicio_ms;
+    return agora - inicio;
+}
+
+void radio_iniciar()
+{
+    if (!s_eventos) {
+        s_eventos = xEventGroupCreate();
+    }
+}
+
+const char *radio_modo_nome()
+{
+#if CONFIG_GATEWAY_RADIO_COEXISTENCIA
+    return "coexistencia";
+#else
+    return "alternancia";
+#endif
+}
+
+void radio_coexistencia_iniciar()
+{
+#if CONFIG_ESP_COEX_SW_COEXIST_ENABLE
+    // Com coexistencia o Wi-Fi precisa de modem sleep: nas brechas do
+    // Wi-Fi o arbitro entrega a antena ao 802.15.4
+    esp_wifi_set_ps(WIFI_PS_MIN_MODEM);
+    esp_err_t err = esp_coex_wifi_i154_enable();
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG_RADIO, "Coexistencia Wi-Fi/802.15.4 habilitada");
+    } else {
+        ESP_LOGE(TAG_RADIO, "Falha ao habilitar coexistencia: %s", esp_err_to_name(err));
+    }
+#else
+    ESP_LOGW(TAG_RADIO, "CONFIG_ESP_COEX_SW_COEXIST_ENABLE desligado; radios sem arbitragem");
+#endif
+}
+
+void radio_definir_estado(RadioId radio, RadioEstado estado)
+{
+    uint32_t agora = esp_log_timestamp();
+    RadioContadores &r = s_radios[radio];
+    RadioEstado anterior;
+
+    portENTER_CRITICAL(&s_radio_mux);
+    anterior = r.estado;
+    if (anterior == RADIO_ATIVO && estado != RADIO_ATIVO) {
+        // Saiu do ar: abre uma janela
+        r.quedas++;
+        r.fora_desde_ms = agora;
+    } else if (anterior != RADIO_ATIVO && estado == RADIO_ATIVO) {
+        // Voltou: fecha a janela
+        uint32_t dur = agora - r.fora_desde_ms;
+        r.fora_total_ms += dur;
+        r.fora_ciclo_ms += fora_no_ciclo(r.fora_desde_ms, agora);
+        if (dur > r.fora_max_ms) r.fora_max_ms = dur;
+    }
+    r.estado = estado;
+    portEXIT_CRITICAL(&s_radio_mux);
+
+    if (estado == RADIO_ATIVO) {
+        radio_sinalizar(BIT_ATIVO[radio]);
+    } else {
+        radio_limpar(BIT_ATIVO[radio]);
+    }
+
+    if (anterior != estado) {
+        ESP_LOGI(TAG_RADIO, "%s: %s -> %s", NOMES_RADIO[radio], NOMES_ESTADO[anterior], NOMES_ESTADO[estado]);
+    }
+}
+
+// ==================== EVENTOS E FASES ====================
+void radio_sinalizar(uint32_t bits)
+{
+    if (s_eventos) xEventGroupSetBits(s_eventos, bits);
+}
+
+void radio_limpar(uint32_t bits)
+{
+    if (s_eventos) xEventGroupClearBits(s_eventos, bits);
+}
+
+void radio_fase_concluida(RadioFase fase, uint32_t inicio_ms, bool ok)
+{
+    uint32_t dur = esp_log_timestamp() - inicio_ms;
+    RadioFaseContadores &f = s_fases[fase];
+
+    f.ultima_ms = dur;
+    f.total_ms += dur;
+    f.execucoes++;
+    if (dur > f.max_ms) f.max_ms = dur;
+    if (!ok) f.timeouts++;
+    metricas_registrar((MetricaHistograma)(MH_FASE_RADIO + fase), dur);
+
+    if (ok) {
+        ESP_LOGI(TAG_RADIO, "Fase %s: %u ms", NOMES_FASE[fase], (unsigned)dur);
+    } else {
+        ESP_LOGW(TAG_RADIO, "Fase %s: timeout apos %u ms", NOMES_FASE[fase], (unsigned)dur);
+    }
+}
+
+bool radio_aguardar(RadioFase fase, uint32_t bits, uint32_t timeout_ms)
+{
+    uint32_t inicio = esp_log_timestamp();
+    bool ok = false;
+
+    if (s_eventos) {
+        EventBits_t obtidos = xEventGroupWaitBits(s_eventos, bits, pdFALSE, pdTRUE, pdMS_TO_TICKS(timeout_ms));
+        ok = (obtidos & bits) == bits;
+    }
+
+    radio_fase_concluida(fase, inicio, ok);
+    return ok;
+}
+
+RadioFaseContadores radio_fase_contadores(RadioFase fase)
+{
+    return s_fases[fase];
+}
+
+RadioEstado radio_estado(RadioId radio)
+{
+    return s_radios[radio].estado;
+}
+
+// Copia os contadores incluindo a janela fora do ar ainda em aberto
+RadioContadores radio_contadores(RadioId radio)
+{
+    uint32_t agora = esp_log_timestamp();
+    RadioContadores c;
+
+    portENTER_CRITICAL(&s_radio_mux);
+    c = s_radios[radio];
+    portEXIT_CRITICAL(&s_radio_mux);
+
+    if (c.estado != RADIO_ATIVO) {
+        uint32_t aberta = agora - c.fora_desde_ms;
+        c.fora_total_ms += aberta;
+        c.fora_ciclo_ms += fora_no_ciclo(c.fora_desde_ms, agora);
+        if (aberta > c.fora_max_ms) c.fora_max_ms = aberta;
+    }
+    return c;
+}
+
+void radio_coap_recebido()
+{
+    portENTER_CRITICAL(&s_radio_mux);
+    s_coap_ciclo++;
+    s_coap_total++;
+    portEXIT_CRITICAL(&s_radio_mux);
+}
+
+void radio_iniciar_ciclo()
+{
+    uint32_t agora = esp_log_timestamp();
+
+    portENTER_CRITICAL(&s_radio_mux);
+    for (int i = 0; i < RADIO_TOTAL; i++) {
+        s_radios[i].fora_ciclo_ms = 0;
+    }
+    s_coap_ciclo = 0;
+    s_ciclo_inicio_ms = agora;
+    s_ciclos++;
+    portEXIT_CRITICAL(&s_radio_mux);
+}
+
+void radio_registrar_estatisticas()
+{
+    uint32_t duracao = esp_log_timestamp() - s_ciclo_inicio_ms;
+
+    ESP_LOGI(TAG_RADIO, "=== Ciclo %u (%s) em %u ms, %u pacotes CoAP (total %u) ===",
+             (unsigned)s_ciclos, radio_modo_nome(), (unsigned)duracao,
+             (unsigned)s_coap_ciclo, (unsigned)s_coap_total);
+
+    for (int i = 0; i < RADIO_TOTAL; i++) {
+        RadioContadores c = radio_contadores((RadioId)i);
+        ESP_LOGI(TAG_RADIO, "  %-6s %-9s fora: ciclo %u ms, total %u ms, max %u ms, quedas %u",
+                 NOMES_RADIO[i], NOMES_ESTADO[c.estado], (unsigned)c.fora_ciclo_ms,
+                 (unsigned)c.fora_total_ms, (unsigned)c.fora_max_ms, (unsigned)c.quedas);
+    }
+
+    for (int i = 0; i < FASE_TOTAL; i++) {
+        const RadioFaseContadores &f = s_fases[i];
+        if (f.execucoes == 0) continue;
+        ESP_LOGI(TAG_RADIO, "  fase %-10s ultima %u ms, media %u ms, max %u ms, timeouts %u/%u",
+                 NOMES_FASE[i], (unsigned)f.ultima_ms, (unsigned)(f.total_ms / f.execucoes),
+                 (unsigned)f.max_ms, (unsigned)f.timeouts, (unsigned)f.execucoes);
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stdint.h>
+#include "sdkconfig.h"
+
+// ==================== GERENCIADOR DE RADIOS ====================
+// Maquina de estados dos dois radios (Thread 802.15.4 e Wi-Fi) que mede
+// quanto tempo cada um fica fora do ar. Serve para comparar o modo de
+// alternancia (derruba o OpenThread a cada ciclo) com o de coexistencia
+// (os dois ligados, compartilhando a antena via coex do ESP32-C6).
+//
+// Tambem concentra os eventos de conectividade (IP obtido, papel Thread,
+// SNTP sincronizado) num event group: cada fase do ciclo espera o seu
+// evento com timeout, em vez de dormir um tempo fixo.
+
+enum RadioId {
+    RADIO_THREAD = 0,
+    RADIO_WIFI,
+    RADIO_TOTAL
+};
+
+enum RadioEstado {
+    RADIO_DESLIGADO = 0,    // radio/stack desligado
+    RADIO_SUBINDO,          // ligado, mas ainda sem rede (attach / associacao + DHCP)
+    RADIO_ATIVO             // Thread com papel (child/router/leader) ou Wi-Fi com IP
+};
+
+// Bits do event group de conectividade
+#define RADIO_BIT_THREAD_ATIVO   (1u << 0)  // papel child/router/leader
+#define RADIO_BIT_WIFI_IP        (1u << 1)  // IP_EVENT_STA_GOT_IP
+#define RADIO_BIT_SNTP           (1u << 2)  // hora sincronizada
+#define RADIO_BIT_OT_RODANDO     (1u << 3)  // mainloop do OpenThread em execucao
+#define RADIO_BIT_OT_PARADO      (1u << 4)  // ot_task_worker terminou
+
+// Fases do ciclo, medidas individualmente
+enum RadioFase {
+    FASE_OT_PARAR = 0,
+    FASE_OT_INICIAR,
+    FASE_OT_ATTACH,
+    FASE_WIFI_IP,
+    FASE_SNTP,
+    FASE_SENSORES,
+    FASE_HTTP,
+    FASE_WIFI_PARAR,
+    FASE_TOTAL
+};
+
+struct RadioFaseContadores {
+    uint32_t ultima_ms;
+    uint32_t max_ms;
+    uint32_t total_ms;
+    uint32_t execucoes;
+    uint32_t timeouts;
+};
+
+struct RadioContadores {
+    RadioEstado estado;
+    uint32_t quedas;            // transicoes ATIVO -> fora
+    uint32_t fora_total_ms;     // tempo fora desde o boot
+    uint32_t fora_ciclo_ms;     // tempo fora no ciclo atual
+    uint32_t fora_max_ms;       // maior janela continua fora
+    uint32_t fora_desde_ms;     // inicio da janela atual (se nao ATIVO)
+};
+
+// Cria o event group (chamar no app_main, antes de ligar os radios)
+void radio_iniciar();
+
+// Modo configurado (CONFIG_GATEWAY_RADIO_*)
+const char *radio_modo_nome();
+
+// Habilita a coexistencia Wi-Fi/802.15.4 (chamar com o Wi-Fi ja iniciado)
+void radio_coexistencia_iniciar();
+
+void radio_definir_estado(RadioId radio, RadioEstado estado);
+RadioEstado radio_estado(RadioId radio);
+RadioContadores radio_contadores(RadioId radio);
+
+// Event group de conectividade
+void radio_sinalizar(uint32_t bits);
+void radio_limpar(uint32_t bits);
+
+// Espera todos os bits (ou o timeout) e registra a duracao da fase
+bool radio_aguardar(RadioFase fase, uint32_t bits, uint32_t timeout_ms);
+
+// Registra uma fase que nao depende de evento (inicio medido pelo chamador)
+void radio_fase_concluida(RadioFase fase, uint32_t inicio_ms, bool ok);
+RadioFaseContadores radio_fase_contadores(RadioFase fase);
+
+// Pacotes CoAP de sensores recebidos pelo gateway (contados por ciclo)
+void radio_coap_recebido();
+
+// Zera os contadores do ciclo / imprime o resumo do ciclo
+void radio_iniciar_ciclo();
+void radio_registrar_estatisticas();
@@ -0,0 +1,92 @@
+#include "roda_temporizadores.hpp"
+
+#define FIM_LISTA (-1)
+
+RodaTemporizadores::RodaTemporizadores() : m_agora(0), m_iniciada(false)
+{
+    for (size_t b = 0; b < RODA_BALDES; b++) {
+        m_cabeca[b] = FIM_LISTA;
+    }
+    for (size_t i = 0; i < NODE_TABLE_CAPACIDADE; i++) {
+        m_prox[i] = FIM_LISTA;
+        m_ant[i] = FIM_LISTA;
+        m_prazo[i] = 0;
+        m_agendado[i] = false;
+    }
+}
+
+void RodaTemporizadores::inserir(uint16_t id)
+{
+    size_t b = m_prazo[id] & (RODA_BALDES - 1);
+    m_ant[id] = FIM_LISTA;
+    m_prox[id] = m_cabeca[b];
+    if (m_cabeca[b] != FIM_LISTA) {
+        m_ant[m_cabeca[b]] = (int16_t)id;
+    }
+    m_cabeca[b] = (int16_t)id;
+    m_agendado[id] = true;
+}
+
+void RodaTemporizadores::remover(uint16_t id)
+{
+    size_t b = m_prazo[id] & (RODA_BALDES - 1);
+    if (m_ant[id] != FIM_LISTA) {
+        m_prox[m_ant[id]] = m_prox[id];
+    } else {
+        m_cabeca[b] = m_prox[id];
+    }
+    if (m_prox[id] != FIM_LISTA) {
+        m_ant[m_prox[id]] = m_ant[id];
+    }
+    m_agendado[id] = false;
+}
+
+void RodaTemporizadores::agendar(uint16_t id, uint32_t prazo_s)
+{
+    if (m_agendado[id]) remover(id);
+
+    // Prazo ja passado vai para o proximo segundo a processar
+    if (m_iniciada && (int32_t)(prazo_s - m_agora) <= 0) {
+        prazo_s = m_agora + 1;
+    }
+    m_prazo[id] = prazo_s;
+    inserir(id);
+}
+
+void RodaTemporizadores::cancelar(uint16_t id)
+{
+    if (m_agendado[id]) remover(id);
+}
+
+size_t RodaTemporizadores::avancar(uint32_t agora_s, RodaDisparo disparo, void *ctx)
+{
+    if (!m_iniciada) {
+        m_iniciada = true;
+        m_agora = agora_s - 1;
+    }
+
+    int32_t decorridos = (int32_t)(agora_s - m_agora);
+    if (decorridos <= 0) return 0;
+
+    // Mais de uma volta: basta visitar cada balde uma vez
+    uint32_t passos = (decorridos > RODA_BALDES) ? RODA_BALDES : (uint32_t)decorridos;
+    uint32_t segundo = agora_s - passos + 1;
+    size_t disparados = 0;
+
+    m_agora = agora_s;
+    for (uint32_t k = 0; k < passos; k++, segundo++) {
+        size_t b = segundo & (RODA_BALDES - 1);
+        int16_t id = m_cabeca[b];
+        while (id != FIM_LISTA) {
+            int16_t proximo = m_prox[id];
+            // Outras voltas ficam no balde
+            if ((int32_t)(m_prazo[id] - agora_s) <= 0) {
+                remover((uint16_t)id);
+                disparo((uint16_t)id, ctx);
+                disparados++;
+            }
+            id = proximo;
+        }
+    }
+    return disparados;
+}
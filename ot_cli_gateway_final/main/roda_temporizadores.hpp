@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "node_table.hpp"
+
+// ==================== RODA DE TEMPORIZADORES ====================
+// Roda hasheada (com voltas) de resolucao de 1 s: um temporizador por id
+// (posicao da tabela de nós), listas duplamente encadeadas por indice e
+// arena estatica. Agendar/cancelar sao O(1); avancar visita so os baldes
+// dos segundos decorridos (no maximo uma volta) e dispara os vencidos.
+// Prazos em segundos com comparacao tolerante a wrap.
+
+#define RODA_BALDES 128
+
+static_assert((RODA_BALDES & (RODA_BALDES - 1)) == 0, "RODA_BALDES precisa ser potencia de 2");
+
+typedef void (*RodaDisparo)(uint16_t id, void *ctx);
+
+class RodaTemporizadores {
+public:
+    RodaTemporizadores();
+
+    // (Re)agenda o id para o segundo 'prazo_s'
+    void agendar(uint16_t id, uint32_t prazo_s);
+    void cancelar(uint16_t id);
+    bool agendado(uint16_t id) const { return m_agendado[id]; }
+
+    // Dispara, em ordem de balde, os temporizadores com prazo <= agora_s.
+    // O disparo pode reagendar o proprio id. Retorna quantos dispararam.
+    size_t avancar(uint32_t agora_s, RodaDisparo disparo, void *ctx);
+
+private:
+    void inserir(uint16_t id);
+    void remover(uint16_t id);
+
+    int16_t m_cabeca[RODA_BALDES];
+    int16_t m_prox[NODE_TABLE_CAPACIDADE];
+    int16_t m_ant[NODE_TABLE_CAPACIDADE];
+    uint32_t m_prazo[NODE_TABLE_CAPACIDADE];
+    bool m_agendado[NODE_TABLE_CAPACIDADE];
+
+    uint32_t m_agora;       // ultimo segundo ja processado
+    bool m_iniciada;
+};
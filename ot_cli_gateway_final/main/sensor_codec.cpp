@@ -0,0 +1,229 @@
+#include "sensor_codec.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+#include <math.h>
+
+// ==================== AUXILIARES ====================
+static inline void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Converte para centesimos com saturacao no intervalo [min, max]
+static inline int32_t to_centi(float v, int32_t min, int32_t max) {
+    long c = lroundf(v * 100.0f);
+    if (c < min) c = min;
+    if (c > max) c = max;
+    return (int32_t)c;
+}
+
+// Dias desde 1970-01-01 para uma data civil (algoritmo de H. Hinnant)
+static int32_t days_from_civil(int y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = (unsigned)(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int32_t)doe - 719468;
+}
+
+// ==================== HORA ====================
+int64_t sensor_agora_ms(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    if (tv.tv_sec < SENSOR_EPOCH_MINIMO) return 0;
+    return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+void encode_sensor_hora(int64_t epoch_ms, uint8_t buf[SENSOR_HORA_TAMANHO]) {
+    put_u32(&buf[0], (uint32_t)epoch_ms);
+    put_u32(&buf[4], (uint32_t)((uint64_t)epoch_ms >> 32));
+}
+
+int64_t decode_sensor_hora(const uint8_t buf[SENSOR_HORA_TAMANHO]) {
+    return (int64_t)((uint64_t)get_u32(&buf[0]) | ((uint64_t)get_u32(&buf[4]) << 32));
+}
+
+void epoch_ms_para_texto(int64_t epoch_ms, char *out, size_t len) {
+    time_t t = (time_t)(epoch_ms / 1000);
+    struct tm tm_local;
+    localtime_r(&t, &tm_local);
+    size_t n = strftime(out, len, "%Y-%m-%dT%H:%M:%S", &tm_local);
+    if (n > 0 && n < len) {
+        snprintf(out + n, len - n, ".%03d", (int)(epoch_ms % 1000));
+    }
+}
+
+// Texto do JSON legado dos nós (milissegundos opcionais). Campos fora da
+// faixa (texto vindo da malha) dao 0, sem estourar a conta dos dias.
+int64_t texto_para_epoch_ms(const char *texto) {
+    int y, mo, d, h, mi, s, ms = 0;
+    if (sscanf(texto, "%4d-%2d-%2dT%2d:%2d:%2d.%3d", &y, &mo, &d, &h, &mi, &s, &ms) < 6 || y < 1970 ||
+        mo < 1 || mo > 12 || d < 1 || d > 31 || h < 0 || h > 23 || mi < 0 || mi > 59 || s < 0 || s > 60 ||
+        ms < 0) {
+        return 0;
+    }
+    int64_t dias = days_from_civil(y, (unsigned)mo, (unsigned)d);
+    return (dias * 86400 + h * 3600 + mi * 60 + s) * 1000 + ms;
+}
+
+// ==================== CODIFICACAO ====================
+size_t encode_sensor_record(const sensor_data_t *data, const otIp6Address *eid, uint8_t *buf, size_t len)
+{
+    if (!data || !buf || len < SENSOR_REGISTRO_TAMANHO) return 0;
+
+    buf[0] = SENSOR_REGISTRO_VERSAO;
+    buf[1] = 0;
+    if (eid) {
+        memcpy(&buf[2], eid->mFields.m8, sizeof(eid->mFields.m8));
+    } else {
+        memset(&buf[2], 0, sizeof(eid->mFields.m8));
+    }
+    encode_sensor_amostra(data, &buf[18]);
+
+    return SENSOR_REGISTRO_TAMANHO;
+}
+
+void encode_sensor_amostra(const sensor_data_t *data, uint8_t buf[SENSOR_AMOSTRA_TAMANHO])
+{
+    put_u32(&buf[0], (uint32_t)(data->epoch_ms / 1000));
+    put_u16(&buf[4], (uint16_t)(int16_t)to_centi(data->temperatura, INT16_MIN, INT16_MAX));
+    put_u16(&buf[6], (uint16_t)to_centi(data->umidadeAr, 0, UINT16_MAX));
+    put_u16(&buf[8], (uint16_t)to_centi(data->umidadeSolo, 0, UINT16_MAX));
+    put_u32(&buf[10], (uint32_t)to_centi(data->particulas, 0, INT32_MAX));
+}
+
+size_t encode_sensor_lote_cabecalho(uint16_t nodo, const otIp6Address *eid, uint8_t n, uint8_t *buf, size_t len)
+{
+    if (!buf || n == 0 || n > SENSOR_LOTE_MAX) return 0;
+
+    if (nodo != 0) {
+        if (len < SENSOR_LOTE_CABECALHO_ID) return 0;
+        buf[0] = SENSOR_LOTE_VERSAO_ID;
+        buf[1] = n;
+        put_u16(&buf[2], nodo);
+        return SENSOR_LOTE_CABECALHO_ID;
+    }
+
+    if (!eid || len < SENSOR_LOTE_CABECALHO) return 0;
+    buf[0] = SENSOR_LOTE_VERSAO;
+    buf[1] = n;
+    memcpy(&buf[2], eid->mFields.m8, sizeof(eid->mFields.m8));
+    return SENSOR_LOTE_CABECALHO;
+}
+
+void encode_sensor_cadastro(const uint8_t eui64[SENSOR_EUI64_TAMANHO], const otIp6Address *eid,
+                            uint8_t buf[SENSOR_CADASTRO_TAMANHO])
+{
+    memcpy(&buf[0], eui64, SENSOR_EUI64_TAMANHO);
+    memcpy(&buf[SENSOR_EUI64_TAMANHO], eid->mFields.m8, sizeof(eid->mFields.m8));
+}
+
+void encode_sensor_id(uint16_t nodo, uint8_t buf[SENSOR_ID_TAMANHO])
+{
+    put_u16(buf, nodo);
+}
+
+void encode_sensor_enlace(const sensor_enlace_t *enlace, uint8_t buf[SENSOR_ENLACE_TAMANHO])
+{
+    put_u16(&buf[0], enlace->rloc16);
+    buf[2] = (uint8_t)enlace->rssi;
+    buf[3] = enlace->margem;
+    buf[4] = (uint8_t)((enlace->qualidade_entrada & 0x0f) | (enlace->qualidade_saida << 4));
+    put_u16(&buf[5], enlace->quadros);
+    put_u16(&buf[7], enlace->retentativas);
+    put_u16(&buf[9], enlace->sem_ack);
+    put_u16(&buf[11], enlace->cca);
+}
+
+// ==================== DECODIFICACAO ====================
+bool decode_sensor_record(const uint8_t *buf, size_t len, sensor_data_t *data, otIp6Address *eid)
+{
+    if (!buf || !data || len < SENSOR_REGISTRO_TAMANHO) return false;
+    if (buf[0] != SENSOR_REGISTRO_VERSAO) return false;
+
+    if (eid) memcpy(eid->mFields.m8, &buf[2], sizeof(eid->mFields.m8));
+    decode_sensor_amostra(&buf[SENSOR_LOTE_CABECALHO], data);
+
+    return true;
+}
+
+void decode_sensor_amostra(const uint8_t buf[SENSOR_AMOSTRA_TAMANHO], sensor_data_t *data)
+{
+    memset(data, 0, sizeof(*data));
+    data->epoch_ms = (int64_t)get_u32(&buf[0]) * 1000;
+
+    data->temperatura = (int16_t)get_u16(&buf[4]) / 100.0f;
+    data->umidadeAr   = get_u16(&buf[6]) / 100.0f;
+    data->umidadeSolo = get_u16(&buf[8]) / 100.0f;
+    data->particulas  = get_u32(&buf[10]) / 100.0f;
+}
+
+size_t decode_sensor_lote_cabecalho(const uint8_t *buf, size_t len, uint16_t *nodo, otIp6Address *eid, uint8_t *n)
+{
+    if (!buf || len < 2 || buf[1] == 0 || buf[1] > SENSOR_LOTE_MAX) return 0;
+
+    if (buf[0] == SENSOR_LOTE_VERSAO_ID && len >= SENSOR_LOTE_CABECALHO_ID) {
+        *nodo = get_u16(&buf[2]);
+        if (*nodo == 0) return 0;
+        *n = buf[1];
+        return SENSOR_LOTE_CABECALHO_ID;
+    }
+    if (buf[0] == SENSOR_LOTE_VERSAO && len >= SENSOR_LOTE_CABECALHO) {
+        *nodo = 0;
+        memcpy(eid->mFields.m8, &buf[2], sizeof(eid->mFields.m8));
+        *n = buf[1];
+        return SENSOR_LOTE_CABECALHO;
+    }
+    return 0;
+}
+
+void decode_sensor_cadastro(const uint8_t buf[SENSOR_CADASTRO_TAMANHO], uint8_t eui64[SENSOR_EUI64_TAMANHO],
+                            otIp6Address *eid)
+{
+    memcpy(eui64, &buf[0], SENSOR_EUI64_TAMANHO);
+    memcpy(eid->mFields.m8, &buf[SENSOR_EUI64_TAMANHO], sizeof(eid->mFields.m8));
+}
+
+uint16_t decode_sensor_id(const uint8_t buf[SENSOR_ID_TAMANHO])
+{
+    return get_u16(buf);
+}
+
+void decode_sensor_enlace(const uint8_t buf[SENSOR_ENLACE_TAMANHO], sensor_enlace_t *enlace)
+{
+    enlace->rloc16            = get_u16(&buf[0]);
+    enlace->rssi              = (int8_t)buf[2];
+    enlace->margem            = buf[3];
+    enlace->qualidade_entrada = buf[4] & 0x0f;
+    enlace->qualidade_saida   = buf[4] >> 4;
+    enlace->quadros           = get_u16(&buf[5]);
+    enlace->retentativas      = get_u16(&buf[7]);
+    enlace->sem_ack           = get_u16(&buf[9]);
+    enlace->cca               = get_u16(&buf[11]);
+}
+
+// ==================== SEQUENCIA ====================
+bool token_para_seq(const uint8_t *token, uint8_t len, uint32_t *seq)
+{
+    if (!token || len < SENSOR_TOKEN_SEQ_TAMANHO) return false;
+    *seq = get_u32(token);
+    return true;
+}
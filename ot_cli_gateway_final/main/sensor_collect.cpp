@@ -1,4 +1,5 @@
 #include "sensor_data.hpp"
+#include "sensor_codec.hpp"
 #include "cJSON.h"
 #include "esp_sntp.h"
 #include <stdio.h>
@@ -8,6 +9,9 @@
 
 #include "openthread/thread.h"
 #include "esp_log.h"
+#include "radio_manager.hpp"
+#include "agregacao.hpp"
+#include "cadastro_nodos.hpp"
 
 // Includes dos sensores
 #include "sensor_umiS.h"   
@@ -22,79 +26,113 @@ TaskHandle_t SensorUmiSTaskHandle = NULL;
 
 bool sensors_initialized = false;
 
-void init_sntp() {
-    ESP_LOGI("SNTP", "Iniciando sincronização de horário...");
-    
-    sntp_setoperatingmode(SNTP_OPMODE_POLL);
-    sntp_setservername(0, "pool.ntp.org");  // servidor NTP público
-    sntp_init();
+// Chamado pelo SNTP quando a hora e ajustada
+static void sntp_sincronizado(struct timeval *tv)
+{
+    time_t now = tv->tv_sec;
+    struct tm timeinfo;
+    localtime_r(&now, &timeinfo);
 
-    // Aguarda o SNTP sincronizar (demora alguns segundos)
-    time_t now = 0;
-    struct tm timeinfo = { 0 };
-
-    int retry = 0;
-    const int retry_count = 10;
-    while (timeinfo.tm_year < (2016 - 1900) && ++retry < retry_count) {
-        ESP_LOGI("SNTP", "Aguardando atualização... (%d/10)", retry);
-        vTaskDelay(2000 / portTICK_PERIOD_MS);
-        time(&now);
-        localtime_r(&now, &timeinfo);
-    }
+    char buf[64];
+    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &timeinfo);
+    ESP_LOGI("SNTP", "Horário local ajustado: %s", buf);
+
+    radio_sinalizar(RADIO_BIT_SNTP);
+}
 
+// Inicia o SNTP sem bloquear; quem precisa da hora espera RADIO_BIT_SNTP
+void init_sntp() {
     // Ajuste de fuso horario ------------------------------
     setenv("TZ", "<03>", 1);  // Brasil UTC-3
     tzset();
 
-    // Recalcula o horario c/fuso
-    time(&now);
+    if (sntp_enabled()) {
+        return;  // Ja roda desde um ciclo anterior
+    }
+
+    ESP_LOGI("SNTP", "Iniciando sincronização de horário...");
+    sntp_setoperatingmode(SNTP_OPMODE_POLL);
+    sntp_setservername(0, "pool.ntp.org");  // servidor NTP público
+    sntp_set_time_sync_notification_cb(sntp_sincronizado);
+    sntp_init();
+}
+
+// A hora do sistema ja e valida (sincronizada antes; o RTC continua contando)
+bool sntp_hora_valida() {
+    time_t now = time(NULL);
+    struct tm timeinfo;
     localtime_r(&now, &timeinfo);
+    return timeinfo.tm_year >= (2016 - 1900);
+}
 
-    char buf[64];
-    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &timeinfo);
-    ESP_LOGI("SNTP", "Horário local ajustado: %s", buf);
+// "e" no uplink continua sendo o EID: sai do cadastro pelo id do nó
+static void adicionar_endereco(cJSON *root, uint16_t nodo) {
+    char endereco[OT_IP6_ADDRESS_STRING_SIZE];
+    cadastro_eid_texto(nodo, endereco, sizeof(endereco));
+    if (endereco[0] != '\0') {
+        cJSON_AddStringToObject(root, "e", endereco);
+    }
 }
 
-char* create_sensor_json(const sensor_data_t* data) {
+cJSON* create_sensor_json_object(const sensor_data_t* data) {
     cJSON *root = cJSON_CreateObject();
     if (!root) return NULL;
 
-    cJSON_AddStringToObject(root, "e", data->endereco);
-    cJSON_AddStringToObject(root, "d", data->dataHora);
+    adicionar_endereco(root, data->nodo);
+    // Unico ponto em que o instante vira texto; sem hora o servidor usa a da chegada
+    if (data->epoch_ms != 0) {
+        char dataHora[32];
+        epoch_ms_para_texto(data->epoch_ms, dataHora, sizeof(dataHora));
+        cJSON_AddStringToObject(root, "d", dataHora);
+    }
     cJSON_AddNumberToObject(root, "t", data->temperatura);
     cJSON_AddNumberToObject(root, "uA", data->umidadeAr);
     cJSON_AddNumberToObject(root, "uS", data->umidadeSolo);
     cJSON_AddNumberToObject(root, "p", data->particulas);
 
+    return root;
+}
+
+#if CONFIG_GATEWAY_AGREGACAO
+// Resumo de uma janela: cada metrica vira [min, max, media, variancia, tendencia/min]
+cJSON* create_resumo_json_object(uint16_t nodo, const ResumoJanela* resumo) {
+    cJSON *root = cJSON_CreateObject();
+    if (!root) return NULL;
+
+    char dataHora[32];
+    struct tm timeinfo;
+    localtime_r(&resumo->fim_epoch, &timeinfo);
+    strftime(dataHora, sizeof(dataHora), "%Y-%m-%dT%H:%M:%S", &timeinfo);
+
+    adicionar_endereco(root, nodo);
+    cJSON_AddStringToObject(root, "d", dataHora);
+    cJSON_AddNumberToObject(root, "n", resumo->amostras);
+    cJSON_AddNumberToObject(root, "w", resumo->duracao_ms / 1000);
+
+    for (int k = 0; k < METRICA_TOTAL; k++) {
+        const ResumoMetrica &m = resumo->m[k];
+        const float v[] = { m.min, m.max, m.media, m.variancia, m.tendencia };
+        cJSON *arr = cJSON_CreateFloatArray(v, 5);
+        if (arr) cJSON_AddItemToObject(root, agregacao_nome_metrica(k), arr);
+    }
+
+    return root;
+}
+#endif
+
+char* create_sensor_json(const sensor_data_t* data) {
+    cJSON *root = create_sensor_json_object(data);
+    if (!root) return NULL;
+
     char *json_string = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
     return json_string;
 }
 
-// 
-void collect_sensor_data(otInstance *instance, sensor_data_t* data) {
-    // Endereço Thread (se disponível)
-    const otIp6Address *addr = NULL;
-    if (instance) {
-        addr = otThreadGetMeshLocalEid(instance);
-    }
-    if (addr) {
-        // Converte para string (se sua funcao otIp6AddressToString existir)
-        otIp6AddressToString(addr, data->endereco, sizeof(data->endereco));
-    } else {
-        // Fallback mais amigavel para o JSON
-        strncpy(data->endereco, "unknown", sizeof(data->endereco));
-        data->endereco[sizeof(data->endereco) - 1] = '\0';
-    }
-
-    time_t now = time(NULL);
-    struct tm *timeinfo = localtime(&now);
-    if (timeinfo) {
-        strftime(data->dataHora, sizeof(data->dataHora), "%Y-%m-%dT%H:%M:%S", timeinfo);
-    } else {
-        strncpy(data->dataHora, "1970-01-01T00:00:00", sizeof(data->dataHora));
-        data->dataHora[sizeof(data->dataHora) - 1] = '\0';
-    }
+// So as medidas: o id do nó (data->nodo) e de quem registra a leitura
+void collect_sensor_data(sensor_data_t* data) {
+    // Inteiro; o texto so e formatado na fronteira JSON/HTTP
+    data->epoch_ms = sensor_agora_ms();
 
     // Usa os GETTERS (eles retornam os valores "bonitos")
     data->temperatura = AHT_GetTemperature();
@@ -112,6 +150,8 @@ bool sensors_are_ready(const sensor_data_t *data) {
 }
 
 void sensors_enable(otInstance *instance_local, sensor_data_t *sensor_data_local) {
+    (void)instance_local;
+
     // Inicializa I2C (AHT20) 
     ESP_ERROR_CHECK(i2cdev_init());
 
@@ -176,7 +216,7 @@ void sensors_enable(otInstance *instance_local, sensor_data_t *sensor_data_local
     const int max_attempts = 3; // 3 segundos no máximo
     
     while (attempts < max_attempts) {
-        collect_sensor_data(instance_local, sensor_data_local);
+        collect_sensor_data(sensor_data_local);
         
         if (sensors_are_ready(sensor_data_local)) {
             ESP_LOGI(TAG_SENSOR, "Sensores prontos após %d tentativas", attempts + 1);
@@ -1,5 +1,6 @@
 #pragma once
 #include "sensor_data.hpp"
+#include "cJSON.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
@@ -13,7 +14,12 @@ extern bool sensors_initialized;
 
 // Funcoes
 char* create_sensor_json(const sensor_data_t* data);
-void collect_sensor_data(otInstance *instance, sensor_data_t* data);
+cJSON* create_sensor_json_object(const sensor_data_t* data);
+struct ResumoJanela;
+cJSON* create_resumo_json_object(uint16_t nodo, const ResumoJanela* resumo);
+void collect_sensor_data(sensor_data_t* data);
 void sensors_enable(otInstance *instance, sensor_data_t *sensor_data);
 void sensors_disable();
-bool sensors_are_ready(const sensor_data_t *data);
\ No newline at end of file
+bool sensors_are_ready(const sensor_data_t *data);
+void init_sntp();
+bool sntp_hora_valida();
\ No newline at end of file
@@ -2,12 +2,23 @@
 #include "openthread/instance.h"
 
 typedef struct { 
-    char endereco[40];
-    char dataHora[64];
+    uint16_t nodo;          // id curto dado pelo gateway (sensor_codec); 0 = sem id
+    int64_t epoch_ms;       // instante da leitura, ms desde 1970 (UTC); 0 = sem hora
     float temperatura;
     float umidadeAr;
     float umidadeSolo;
     float particulas;
 } sensor_data_t;
 
-
+// Telemetria do enlace com a malha (sensor_codec: ENLACE NA MALHA)
+typedef struct {
+    uint16_t rloc16;
+    int8_t rssi;                // dBm, SENSOR_RSSI_INVALIDO = sem pai
+    uint8_t margem;             // dB
+    uint8_t qualidade_entrada;  // 0..3
+    uint8_t qualidade_saida;    // 0..3
+    uint16_t quadros;
+    uint16_t retentativas;
+    uint16_t sem_ack;
+    uint16_t cca;
+} sensor_enlace_t;
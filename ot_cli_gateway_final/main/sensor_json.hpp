@@ -1,3 +1,7 @@
 #pragma once
 #include "sensor_data.hpp"
+#include "cJSON.h"
 char* create_sensor_json(const sensor_data_t* data);
+cJSON* create_sensor_json_object(const sensor_data_t* data);
+struct ResumoJanela;
+cJSON* create_resumo_json_object(uint16_t nodo, const ResumoJanela* resumo);
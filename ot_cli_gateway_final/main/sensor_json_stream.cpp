@@ -0,0 +1,249 @@
+#include "sensor_json_stream.hpp"
+#include "sensor_codec.hpp"
+#include <string.h>
+
+static inline bool espaco(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static inline bool char_numero(char c)
+{
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+// Numero JSON -> float. Conversao propria: o strtod da newlib pode alocar
+// (Bigint) e este caminho roda no handler CoAP sem heap.
+static bool ler_decimal(const char *s, float *saida)
+{
+    bool negativo = false;
+    double v = 0.0;
+    int digitos = 0;
+
+    if (*s == '-') { negativo = true; s++; }
+    while (*s >= '0' && *s <= '9') {
+        v = v * 10.0 + (*s++ - '0');
+        digitos++;
+    }
+    if (*s == '.') {
+        double escala = 0.1;
+        s++;
+        while (*s >= '0' && *s <= '9') {
+            v += (*s++ - '0') * escala;
+            escala *= 0.1;
+            digitos++;
+        }
+    }
+    if (digitos == 0) return false;
+
+    if (*s == 'e' || *s == 'E') {
+        bool exp_negativo = false;
+        int exp = 0;
+        s++;
+        if (*s == '+' || *s == '-') exp_negativo = (*s++ == '-');
+        if (!(*s >= '0' && *s <= '9')) return false;
+        while (*s >= '0' && *s <= '9') {
+            if (exp < 100) exp = exp * 10 + (*s - '0');
+            s++;
+        }
+        while (exp-- > 0) v = exp_negativo ? v / 10.0 : v * 10.0;
+    }
+    if (*s != '\0') return false;
+
+    *saida = (float)(negativo ? -v : v);
+    return true;
+}
+
+DecodificadorJsonSensor::DecodificadorJsonSensor(sensor_data_t *saida)
+    : m_saida(saida), m_estado(INICIO), m_campos(0), m_chave(), m_chave_len(0),
+      m_texto(NULL), m_texto_cap(0), m_texto_len(0), m_numero(NULL), m_data_hora(), m_endereco(),
+      m_campo(0),
+      m_num(), m_num_len(0), m_profundidade(0), m_pilha()
+{
+    memset(m_saida, 0, sizeof(*m_saida));
+}
+
+bool DecodificadorJsonSensor::alimentar(const char *p, size_t n)
+{
+    for (size_t i = 0; i < n && m_estado != ERRO; i++) {
+        if (!processar(p[i])) {
+            m_estado = ERRO;
+        }
+    }
+    return m_estado != ERRO;
+}
+
+// Aponta o destino do valor conforme a chave lida
+void DecodificadorJsonSensor::selecionar_campo()
+{
+    m_texto = NULL;
+    m_numero = NULL;
+    m_campo = 0;
+
+    if (m_chave_len >= sizeof(m_chave)) return;
+    m_chave[m_chave_len] = '\0';
+
+    if (strcmp(m_chave, "e") == 0) {
+        m_texto = m_endereco;
+        m_texto_cap = sizeof(m_endereco);
+        m_campo = JSON_CAMPO_ENDERECO;
+    } else if (strcmp(m_chave, "d") == 0) {
+        m_texto = m_data_hora;
+        m_texto_cap = sizeof(m_data_hora);
+        m_campo = JSON_CAMPO_DATA_HORA;
+    } else if (strcmp(m_chave, "t") == 0) {
+        m_numero = &m_saida->temperatura;
+        m_campo = JSON_CAMPO_TEMPERATURA;
+    } else if (strcmp(m_chave, "uA") == 0) {
+        m_numero = &m_saida->umidadeAr;
+        m_campo = JSON_CAMPO_UMIDADE_AR;
+    } else if (strcmp(m_chave, "uS") == 0) {
+        m_numero = &m_saida->umidadeSolo;
+        m_campo = JSON_CAMPO_UMIDADE_SOLO;
+    } else if (strcmp(m_chave, "p") == 0) {
+        m_numero = &m_saida->particulas;
+        m_campo = JSON_CAMPO_PARTICULAS;
+    }
+}
+
+void DecodificadorJsonSensor::concluir_numero()
+{
+    if (!m_numero) return;
+
+    m_num[m_num_len] = '\0';
+    if (ler_decimal(m_num, m_numero)) {
+        m_campos |= m_campo;
+    }
+}
+
+// Um caractere; retorna false em erro de sintaxe
+bool DecodificadorJsonSensor::processar(char c)
+{
+    switch (m_estado) {
+    case INICIO:
+        if (espaco(c)) return true;
+        if (c != '{') return false;
+        m_estado = ESPERA_CHAVE;
+        return true;
+
+    case ESPERA_CHAVE:
+        if (espaco(c) || c == ',') return true;
+        if (c == '}') { m_estado = FIM; return true; }
+        if (c != '"') return false;
+        m_chave_len = 0;
+        m_estado = CHAVE;
+        return true;
+
+    case CHAVE:
+        if (c == '"') { m_estado = ESPERA_DOIS_PONTOS; return true; }
+        if (c == '\\') { m_estado = CHAVE_ESCAPE; }
+        if (m_chave_len < sizeof(m_chave)) {
+            m_chave[m_chave_len] = c;
+        }
+        if (m_chave_len < 0xFF) m_chave_len++;
+        return true;
+
+    case CHAVE_ESCAPE:
+        m_estado = CHAVE;
+        return true;
+
+    case ESPERA_DOIS_PONTOS:
+        if (espaco(c)) return true;
+        if (c != ':') return false;
+        selecionar_campo();
+        m_estado = ESPERA_VALOR;
+        return true;
+
+    case ESPERA_VALOR:
+        if (espaco(c)) return true;
+        if (c == '"') {
+            m_texto_len = 0;
+            m_estado = VALOR_STRING;
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+            m_num[0] = c;
+            m_num_len = 1;
+            m_estado = VALOR_NUMERO;
+        } else if (c == '{' || c == '[') {
+            m_profundidade = 1;
+            m_pilha[0] = (c == '{') ? '}' : ']';
+            m_estado = IGNORAR;
+        } else if (c == 't' || c == 'f' || c == 'n') {
+            m_estado = VALOR_LITERAL;
+        } else {
+            return false;
+        }
+        return true;
+
+    case VALOR_STRING:
+        if (c == '"') {
+            if (m_texto) {
+                m_texto[m_texto_len] = '\0';
+                m_campos |= m_campo;
+                if (m_campo == JSON_CAMPO_DATA_HORA) {
+                    m_saida->epoch_ms = texto_para_epoch_ms(m_data_hora);
+                }
+            }
+            m_estado = ESPERA_SEPARADOR;
+            return true;
+        }
+        if (c == '\\') { m_estado = VALOR_STRING_ESCAPE; return true; }
+        if (m_texto && m_texto_len < m_texto_cap - 1) m_texto[m_texto_len++] = c;
+        return true;
+
+    case VALOR_STRING_ESCAPE:
+        // \" \\ \/ viram o proprio caractere; os demais escapes sao mantidos como a letra
+        if (m_texto && m_texto_len < m_texto_cap - 1) m_texto[m_texto_len++] = c;
+        m_estado = VALOR_STRING;
+        return true;
+
+    case VALOR_NUMERO:
+        if (char_numero(c)) {
+            if (m_num_len >= sizeof(m_num) - 1) return false;
+            m_num[m_num_len++] = c;
+            return true;
+        }
+        concluir_numero();
+        m_estado = ESPERA_SEPARADOR;
+        return processar(c);
+
+    case VALOR_LITERAL:
+        if (c >= 'a' && c <= 'z') return true;
+        m_estado = ESPERA_SEPARADOR;
+        return processar(c);
+
+    case IGNORAR:
+        if (c == '"') { m_estado = IGNORAR_STRING; return true; }
+        if (c == '{' || c == '[') {
+            if (m_profundidade >= JSON_PROFUNDIDADE_MAX) return false;
+            m_pilha[m_profundidade++] = (c == '{') ? '}' : ']';
+            return true;
+        }
+        if (c == '}' || c == ']') {
+            if (c != m_pilha[m_profundidade - 1]) return false;
+            if (--m_profundidade == 0) m_estado = ESPERA_SEPARADOR;
+        }
+        return true;
+
+    case IGNORAR_STRING:
+        if (c == '"') m_estado = IGNORAR;
+        else if (c == '\\') m_estado = IGNORAR_STRING_ESCAPE;
+        return true;
+
+    case IGNORAR_STRING_ESCAPE:
+        m_estado = IGNORAR_STRING;
+        return true;
+
+    case ESPERA_SEPARADOR:
+        if (espaco(c)) return true;
+        if (c == ',') { m_estado = ESPERA_CHAVE; return true; }
+        if (c == '}') { m_estado = FIM; return true; }
+        return false;
+
+    case FIM:
+        return espaco(c) || c == '\0';
+
+    case ERRO:
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "sensor_data.hpp"
+
+// ==================== DECODIFICADOR JSON INCREMENTAL ====================
+// Le o JSON legado dos nós ({"e":..,"d":..,"t":..,"uA":..,"uS":..,"p":..})
+// em pedacos de qualquer tamanho, preenchendo o sensor_data_t diretamente:
+// sem copia do payload inteiro, sem DOM e sem heap. Chaves desconhecidas
+// (inclusive objetos/arrays aninhados) sao ignoradas; strings maiores que
+// o campo de destino sao truncadas. O "d" (texto) vira epoch_ms ao fechar;
+// o "e" (EID em texto) fica no decodificador para o chamador achar o id.
+
+// Campos encontrados (DecodificadorJsonSensor::campos)
+#define JSON_CAMPO_ENDERECO     (1u << 0)
+#define JSON_CAMPO_DATA_HORA    (1u << 1)
+#define JSON_CAMPO_TEMPERATURA  (1u << 2)
+#define JSON_CAMPO_UMIDADE_AR   (1u << 3)
+#define JSON_CAMPO_UMIDADE_SOLO (1u << 4)
+#define JSON_CAMPO_PARTICULAS   (1u << 5)
+
+// Limite de aninhamento dos valores ignorados
+#define JSON_PROFUNDIDADE_MAX   16
+
+class DecodificadorJsonSensor {
+public:
+    explicit DecodificadorJsonSensor(sensor_data_t *saida);
+
+    // Processa mais um pedaco; false assim que houver erro de sintaxe
+    bool alimentar(const char *p, size_t n);
+
+    // true se um objeto completo foi lido (apenas espacos depois dele)
+    bool concluir() const { return m_estado == FIM; }
+
+    uint32_t campos() const { return m_campos; }
+
+    // Texto do "e" ("" se nao veio)
+    const char *endereco() const { return m_endereco; }
+
+private:
+    enum Estado : uint8_t {
+        INICIO,
+        ESPERA_CHAVE,
+        CHAVE,
+        CHAVE_ESCAPE,
+        ESPERA_DOIS_PONTOS,
+        ESPERA_VALOR,
+        VALOR_STRING,
+        VALOR_STRING_ESCAPE,
+        VALOR_NUMERO,
+        VALOR_LITERAL,
+        IGNORAR,
+        IGNORAR_STRING,
+        IGNORAR_STRING_ESCAPE,
+        ESPERA_SEPARADOR,
+        FIM,
+        ERRO
+    };
+
+    bool processar(char c);
+    void selecionar_campo();
+    void concluir_numero();
+
+    sensor_data_t *m_saida;
+    Estado m_estado;
+    uint32_t m_campos;
+
+    char m_chave[4];          // chaves conhecidas tem no maximo 2 letras
+    uint8_t m_chave_len;      // > sizeof(m_chave) - 1 => chave desconhecida
+
+    // Destino do valor atual
+    char *m_texto;            // campo string (ou NULL)
+    size_t m_texto_cap;
+    size_t m_texto_len;
+    float *m_numero;          // campo numerico (ou NULL)
+    char m_data_hora[32];     // texto do "d" ate virar epoch_ms
+    char m_endereco[40];      // texto do "e" (OT_IP6_ADDRESS_STRING_SIZE)
+    uint32_t m_campo;
+
+    char m_num[24];
+    uint8_t m_num_len;
+
+    uint8_t m_profundidade;
+    char m_pilha[JSON_PROFUNDIDADE_MAX];  // '}' ou ']' esperado em cada nivel
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#else
+#include <sched.h>
+#endif
+
+// ==================== SEQLOCK (UM ESCRITOR) ====================
+// Protege dados escritos por uma unica task (a do OpenThread) e lidos por
+// outras (envio HTTP) sem nunca bloquear o escritor: a versao fica impar
+// durante a escrita e o leitor repete a copia se ela mudou no meio.
+// Os dados sao copiados palavra a palavra com acessos atomicos relaxados,
+// entao uma leitura concorrente nunca e corrida de dados (so descartada).
+
+typedef uint32_t __attribute__((may_alias)) palavra_seqlock_t;
+
+// Copia T com acessos atomicos de 32 bits (T trivial, tamanho multiplo de 4)
+template <typename T>
+inline void seqlock_copiar(T *destino, const T *origem)
+{
+    static_assert(sizeof(T) % sizeof(uint32_t) == 0, "tamanho precisa ser multiplo de 4");
+    palavra_seqlock_t *d = reinterpret_cast<palavra_seqlock_t *>(destino);
+    const palavra_seqlock_t *o = reinterpret_cast<const palavra_seqlock_t *>(origem);
+    for (size_t k = 0; k < sizeof(T) / sizeof(uint32_t); k++) {
+        __atomic_store_n(&d[k], __atomic_load_n(&o[k], __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    }
+}
+
+// Cede a CPU ao escritor (no C6 de um nucleo, girar impediria a escrita terminar)
+inline void seqlock_ceder()
+{
+#ifdef ESP_PLATFORM
+    vTaskDelay(1);
+#else
+    sched_yield();
+#endif
+}
+
+class SeqLock {
+public:
+    SeqLock() : m_versao(0) {}
+
+    // Escritor: publica 'valor' em 'destino'
+    template <typename T>
+    void escrever(T *destino, const T &valor)
+    {
+        uint32_t v = m_versao;
+        __atomic_store_n(&m_versao, v + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        seqlock_copiar(destino, &valor);
+        __atomic_store_n(&m_versao, v + 2, __ATOMIC_RELEASE);
+    }
+
+    // Leitor: copia consistente de 'origem' (repete enquanto houver escrita)
+    template <typename T>
+    void ler(T *copia, const T *origem) const
+    {
+        for (;;) {
+            uint32_t v1 = __atomic_load_n(&m_versao, __ATOMIC_ACQUIRE);
+            if (v1 & 1) {
+                // Escritor preemptado no meio da escrita
+                seqlock_ceder();
+                continue;
+            }
+            seqlock_copiar(copia, origem);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&m_versao, __ATOMIC_RELAXED) == v1) return;
+        }
+    }
+
+private:
+    uint32_t m_versao;
+};
@@ -1,4 +1,6 @@
 #include "wifi_connect.hpp"
+#include "radio_manager.hpp"
+#include "sensor_collect.hpp"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h" 
 #include "driver/gpio.h"
@@ -16,7 +18,6 @@ esp_netif_t *wifi_netif;
 
 int restartControl = 0;
 
-void  init_sntp(); // Atualiza horario
 
 void interfaceWifi() {
     // Cria interface de rede WiFi Station (cliente)
@@ -55,6 +56,7 @@ void wifi_event_handler(void *arg, esp_event_base_t event_base,
             ESP_LOGW(TAG, "Wi-Fi desconectado! (modo desligado)");
             return;
         }
+        radio_definir_estado(RADIO_WIFI, RADIO_SUBINDO);
 
         wifi_event_sta_disconnected_t* event = (wifi_event_sta_disconnected_t*) event_data;
         ESP_LOGW(TAG, "Reiniciando para conectar ao Wi-Fi! Razão: %d", event->reason);
@@ -70,6 +72,10 @@ void wifi_event_handler(void *arg, esp_event_base_t event_base,
         // Quando obtem IP - CONEXAO BEM SUCEDIDA
         ip_event_got_ip_t *event = (ip_event_got_ip_t *) event_data;
         ESP_LOGI(TAG, "Conectado! IP obtido: " IPSTR, IP2STR(&event->ip_info.ip));
+
+        // Com a Thread no ar ao mesmo tempo (coexistencia), garante a rota padrao pelo Wi-Fi
+        esp_netif_set_default_netif(wifi_netif);
+        radio_definir_estado(RADIO_WIFI, RADIO_ATIVO);
     }
 }
 
@@ -85,6 +91,7 @@ void wifi_enable(void) {
     }    
 
     restartControl = 1;
+    radio_definir_estado(RADIO_WIFI, RADIO_SUBINDO);
 
     // Cria interface de rede WiFi Station (cliente)
     wifi_netif = esp_netif_create_default_wifi_sta();
@@ -127,12 +134,13 @@ void wifi_enable(void) {
     esp_wifi_connect();
     ESP_LOGI(TAG, "Wi-Fi ativado e tentando conectar...");
 
-    init_sntp(); // Atualiza horario
+    init_sntp(); // Atualiza horario (assincrono, avisa via RADIO_BIT_SNTP)
 }
 
 // Desabilita o Wi-Fi
 void wifi_disable(void) {
     restartControl = 0;
+    radio_definir_estado(RADIO_WIFI, RADIO_DESLIGADO);
 
     // Para o Wi-Fi
     ESP_ERROR_CHECK(esp_wifi_stop());
@@ -0,0 +1,88 @@
+#include "banda.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include <string.h>
+#include <math.h>
+
+#if CONFIG_NODE_BANDA
+
+static const char *TAG_BANDA = "BANDA";
+
+#define BANDA_MAGICO 0x424e4431u
+
+typedef struct {
+    uint32_t magico;
+    uint32_t com_referencia;    // 0 = nada enviado ainda
+    float referencia[4];        // t, uA, uS, p do ultimo envio aceito
+    uint32_t desde_s;           // tempo desde o ultimo envio aceito
+    uint32_t amostras;
+    uint32_t suprimidas;
+} EstadoBanda;
+
+RTC_DATA_ATTR static EstadoBanda s_banda;
+
+// Bandas em centesimos (Kconfig nao tem float)
+static const float BANDAS[4] = {
+    CONFIG_NODE_BANDA_TEMP / 100.0f,
+    CONFIG_NODE_BANDA_UMIDADE_AR / 100.0f,
+    CONFIG_NODE_BANDA_UMIDADE_SOLO / 100.0f,
+    CONFIG_NODE_BANDA_PARTICULAS / 100.0f,
+};
+
+static void valores(const sensor_data_t *d, float x[4])
+{
+    x[0] = d->temperatura;
+    x[1] = d->umidadeAr;
+    x[2] = d->umidadeSolo;
+    x[3] = d->particulas;
+}
+
+MotivoBanda banda_avaliar(const sensor_data_t *dados)
+{
+    // Boot a frio: sem referencia
+    if (s_banda.magico != BANDA_MAGICO) {
+        memset(&s_banda, 0, sizeof(s_banda));
+        s_banda.magico = BANDA_MAGICO;
+    }
+
+    s_banda.amostras++;
+    s_banda.desde_s += CONFIG_NODE_INTERVALO_AMOSTRA_S;
+
+    if (!s_banda.com_referencia) return BANDA_MUDOU;
+
+    float x[4];
+    valores(dados, x);
+    for (int k = 0; k < 4; k++) {
+        // Banda 0: qualquer mudanca envia
+        if (fabsf(x[k] - s_banda.referencia[k]) > BANDAS[k]) return BANDA_MUDOU;
+    }
+    if (s_banda.desde_s >= CONFIG_NODE_HEARTBEAT_S) {
+        return BANDA_HEARTBEAT;
+    }
+
+    s_banda.suprimidas++;
+    ESP_LOGI(TAG_BANDA, "Amostra dentro da banda, suprimida (%u de %u, heartbeat em %u s)",
+             (unsigned)s_banda.suprimidas, (unsigned)s_banda.amostras,
+             (unsigned)(CONFIG_NODE_HEARTBEAT_S - s_banda.desde_s));
+    return BANDA_ESTAVEL;
+}
+
+void banda_aceitar(const sensor_data_t *dados)
+{
+    valores(dados, s_banda.referencia);
+    s_banda.com_referencia = 1;
+    s_banda.desde_s = 0;
+}
+
+uint32_t banda_amostras(void)
+{
+    return s_banda.amostras;
+}
+
+uint32_t banda_suprimidas(void)
+{
+    return s_banda.suprimidas;
+}
+
+#endif // CONFIG_NODE_BANDA
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sensor_data.h"
+
+// ==================== BANDA MORTA E HEARTBEAT ====================
+// Decide, antes de subir o OpenThread, se a amostra do wake vale um envio:
+// so se alguma metrica saiu da banda morta (NODE_BANDA_*) em torno do
+// ultimo valor enviado, ou se o heartbeat (NODE_HEARTBEAT_S) venceu. Entre
+// envios o gateway segura o ultimo valor. A referencia e os contadores
+// ficam na RTC; boot a frio sempre envia.
+
+typedef enum {
+    BANDA_ESTAVEL = 0,      // dentro da banda: nao envia
+    BANDA_MUDOU,            // alguma metrica saiu da banda
+    BANDA_HEARTBEAT         // nada mudou, mas o heartbeat venceu
+} MotivoBanda;
+
+// Avalia a amostra do wake (um intervalo de amostragem desde a anterior)
+MotivoBanda banda_avaliar(const sensor_data_t *dados);
+
+// A amostra foi aceita (confirmada ou guardada no lote): vira a nova
+// referencia e o heartbeat recomeca
+void banda_aceitar(const sensor_data_t *dados);
+
+// Contadores desde o boot a frio
+uint32_t banda_amostras(void);
+uint32_t banda_suprimidas(void);
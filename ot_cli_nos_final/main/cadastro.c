@@ -0,0 +1,69 @@
+#include "cadastro.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "sdkconfig.h"
+
+#if CONFIG_NODE_COAP_CONFIRMAVEL
+
+static const char *TAG_CADASTRO = "CADASTRO";
+
+#define CADASTRO_NVS_NAMESPACE "egglink"
+#define CADASTRO_NVS_CHAVE     "id"
+#define CADASTRO_MAGICO        0x43414431u
+
+RTC_DATA_ATTR static uint32_t s_magico;
+RTC_DATA_ATTR static uint16_t s_id;
+
+// Grava (ou apaga, com id 0) o id na NVS
+static void gravar(uint16_t id)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(CADASTRO_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+        ESP_LOGW(TAG_CADASTRO, "NVS indisponivel: id %u so ate o proximo boot a frio", (unsigned)id);
+        return;
+    }
+    esp_err_t err = (id != 0) ? nvs_set_u16(nvs, CADASTRO_NVS_CHAVE, id) : nvs_erase_key(nvs, CADASTRO_NVS_CHAVE);
+    if (err == ESP_OK || err == ESP_ERR_NVS_NOT_FOUND) {
+        err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG_CADASTRO, "Falha ao gravar o id na NVS (%d)", err);
+    }
+}
+
+uint16_t cadastro_id(void)
+{
+    // Boot a frio: a RTC veio com lixo, o id vem da NVS
+    if (s_magico != CADASTRO_MAGICO) {
+        nvs_handle_t nvs;
+        s_id = 0;
+        if (nvs_open(CADASTRO_NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK) {
+            if (nvs_get_u16(nvs, CADASTRO_NVS_CHAVE, &s_id) != ESP_OK) s_id = 0;
+            nvs_close(nvs);
+        }
+        s_magico = CADASTRO_MAGICO;
+    }
+    return s_id;
+}
+
+void cadastro_definir(uint16_t id)
+{
+    if (id == cadastro_id()) return;
+
+    s_id = id;
+    gravar(id);
+    ESP_LOGI(TAG_CADASTRO, "Id %u recebido do gateway", (unsigned)id);
+}
+
+void cadastro_esquecer(void)
+{
+    if (cadastro_id() == 0) return;
+
+    ESP_LOGW(TAG_CADASTRO, "Gateway nao conhece o id %u: novo cadastro no proximo envio", (unsigned)s_id);
+    s_id = 0;
+    gravar(0);
+}
+
+#endif // CONFIG_NODE_COAP_CONFIRMAVEL
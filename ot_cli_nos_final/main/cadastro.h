@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+
+// ==================== ID CURTO DO NÓ ====================
+// Id que o gateway deu a este nó no cadastro (ver sensor_codec.h), guardado
+// em NVS e copiado na RTC para os wakes nao abrirem a NVS. Vale ate o
+// gateway responder 4.04 (id desconhecido), quando e esquecido e o proximo
+// envio refaz o cadastro. Usar depois do nvs_flash_init.
+
+// Id atual; 0 = sem id (cadastro pendente)
+uint16_t cadastro_id(void);
+
+// Guarda o id recebido no 2.04 do cadastro
+void cadastro_definir(uint16_t id);
+
+// Gateway nao conhece o id: volta a mandar o EID ate o novo cadastro
+void cadastro_esquecer(void);
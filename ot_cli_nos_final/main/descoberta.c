@@ -0,0 +1,95 @@
+#include "descoberta.h"
+#include "sensor_codec.h"
+#include "openthread/netdata.h"
+#include "openthread/thread.h"
+#include "openthread/coap.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG_DESCOBERTA = "DESCOBERTA";
+
+#define DESCOBERTA_MAGICO 0x44455331u
+
+typedef struct {
+    uint32_t magico;
+    otIp6Address destino;   // ALOC do servico (prefixo mesh-local incluso)
+    uint16_t porta;
+    uint8_t servico_id;
+    uint8_t valido;
+} CacheDescoberta;
+
+// Na RTC: sobrevive ao deep sleep, some no boot a frio
+RTC_DATA_ATTR static CacheDescoberta s_cache;
+
+static bool cache_valido(otInstance *instance)
+{
+    if (s_cache.magico != DESCOBERTA_MAGICO || !s_cache.valido) return false;
+
+    // Prefixo mesh-local novo (outro dataset): o ALOC antigo nao existe mais
+    const otMeshLocalPrefix *prefixo = otThreadGetMeshLocalPrefix(instance);
+    return prefixo && memcmp(prefixo->m8, s_cache.destino.mFields.m8, sizeof(prefixo->m8)) == 0;
+}
+
+static bool procurar_servico(otInstance *instance, uint8_t *servico_id, uint16_t *porta)
+{
+    otNetworkDataIterator it = OT_NETWORK_DATA_ITERATOR_INIT;
+    otServiceConfig servico;
+    const uint8_t tamanho = sizeof(SENSOR_SERVICO_DADOS) - 1;
+
+    while (otNetDataGetNextService(instance, &it, &servico) == OT_ERROR_NONE) {
+        if (servico.mEnterpriseNumber != SENSOR_SERVICO_ENTERPRISE ||
+            servico.mServiceDataLength != tamanho ||
+            memcmp(servico.mServiceData, SENSOR_SERVICO_DADOS, tamanho) != 0) {
+            continue;
+        }
+
+        *servico_id = servico.mServiceId;
+        *porta = OT_DEFAULT_COAP_PORT;
+        if (servico.mServerConfig.mServerDataLength >= 2) {
+            *porta = (uint16_t)((servico.mServerConfig.mServerData[0] << 8) | servico.mServerConfig.mServerData[1]);
+        }
+        return true;
+    }
+    return false;
+}
+
+bool descoberta_resolver(otInstance *instance, otIp6Address *destino, uint16_t *porta)
+{
+    if (!cache_valido(instance)) {
+        uint8_t servico_id;
+        uint16_t porta_servico;
+        const otMeshLocalPrefix *prefixo = otThreadGetMeshLocalPrefix(instance);
+
+        if (!prefixo || !procurar_servico(instance, &servico_id, &porta_servico)) {
+            ESP_LOGW(TAG_DESCOBERTA, "Nenhum gateway anuncia o servico \"%s\"", SENSOR_SERVICO_DADOS);
+            return false;
+        }
+
+        // ALOC: prefixo mesh-local + 0000:00ff:fe00:(fc10 + id)
+        memset(&s_cache, 0, sizeof(s_cache));
+        memcpy(s_cache.destino.mFields.m8, prefixo->m8, sizeof(prefixo->m8));
+        uint16_t aloc16 = (uint16_t)(SENSOR_SERVICO_ALOC16 + servico_id);
+        s_cache.destino.mFields.m8[11] = 0xff;
+        s_cache.destino.mFields.m8[12] = 0xfe;
+        s_cache.destino.mFields.m8[14] = (uint8_t)(aloc16 >> 8);
+        s_cache.destino.mFields.m8[15] = (uint8_t)(aloc16 & 0xff);
+        s_cache.porta = porta_servico;
+        s_cache.servico_id = servico_id;
+        s_cache.valido = 1;
+        s_cache.magico = DESCOBERTA_MAGICO;
+
+        char texto[OT_IP6_ADDRESS_STRING_SIZE];
+        otIp6AddressToString(&s_cache.destino, texto, sizeof(texto));
+        ESP_LOGI(TAG_DESCOBERTA, "Gateway: servico %u em [%s]:%u", servico_id, texto, porta_servico);
+    }
+
+    *destino = s_cache.destino;
+    *porta = s_cache.porta;
+    return true;
+}
+
+void descoberta_invalidar(void)
+{
+    s_cache.valido = 0;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "openthread/instance.h"
+#include "openthread/ip6.h"
+
+// ==================== DESCOBERTA DO GATEWAY ====================
+// Destino das amostras: o ALOC do servico que o gateway publica nos dados
+// de rede (ver sensor_codec.h). O resultado fica na RTC e e reaproveitado
+// nos proximos ciclos sem varrer os dados de rede, ate ser invalidado
+// (troca sem confirmacao) ou o prefixo mesh-local mudar.
+// Chamar com o lock do OpenThread e depois do attach.
+
+// Preenche destino/porta; false se nenhum gateway anuncia o servico
+bool descoberta_resolver(otInstance *instance, otIp6Address *destino, uint16_t *porta);
+
+// Esquece o destino guardado: o proximo ciclo resolve de novo
+void descoberta_invalidar(void);
@@ -0,0 +1,96 @@
+#include "enlace.h"
+#include "esp_attr.h"
+#include "openthread/thread.h"
+#include "openthread/link.h"
+#include "openthread/platform/radio.h"
+#include <string.h>
+
+#define ENLACE_MAGICO 0x454e4c31u
+
+typedef struct {
+    uint32_t quadros;
+    uint32_t retentativas;
+    uint32_t sem_ack;
+    uint32_t cca;
+} ContadoresEnlace;
+
+// Pendente na RTC (sobrevive ao deep sleep); a base e a leitura anterior
+// dos contadores do OpenThread e fica na RAM, como eles (zera junto no boot)
+RTC_DATA_ATTR static uint32_t s_magico;
+RTC_DATA_ATTR static ContadoresEnlace s_pendente;
+static ContadoresEnlace s_base;
+static ContadoresEnlace s_em_voo;       // o que foi no ultimo bloco montado
+
+static inline uint32_t saturar(uint32_t v)
+{
+    return v > UINT16_MAX ? UINT16_MAX : v;
+}
+
+void enlace_acumular(otInstance *instance)
+{
+    // Boot a frio: a RTC veio com lixo
+    if (s_magico != ENLACE_MAGICO) {
+        memset(&s_pendente, 0, sizeof(s_pendente));
+        s_magico = ENLACE_MAGICO;
+    }
+
+    const otMacCounters *c = otLinkGetCounters(instance);
+    ContadoresEnlace atual = {
+        .quadros = c->mTxTotal,
+        .retentativas = c->mTxRetry,
+        .sem_ack = c->mTxDirectMaxRetryExpiry,
+        .cca = c->mTxErrCca,
+    };
+    s_pendente.quadros += atual.quadros - s_base.quadros;
+    s_pendente.retentativas += atual.retentativas - s_base.retentativas;
+    s_pendente.sem_ack += atual.sem_ack - s_base.sem_ack;
+    s_pendente.cca += atual.cca - s_base.cca;
+    s_base = atual;
+}
+
+void enlace_codificar(otInstance *instance, uint8_t buf[SENSOR_ENLACE_TAMANHO])
+{
+    sensor_enlace_t e;
+    otRouterInfo pai;
+    int8_t rssi;
+
+    // Acima de 65535 o resto fica para o proximo bloco
+    enlace_acumular(instance);
+    s_em_voo.quadros = saturar(s_pendente.quadros);
+    s_em_voo.retentativas = saturar(s_pendente.retentativas);
+    s_em_voo.sem_ack = saturar(s_pendente.sem_ack);
+    s_em_voo.cca = saturar(s_pendente.cca);
+
+    memset(&e, 0, sizeof(e));
+    e.rloc16 = otThreadGetRloc16(instance);
+    e.rssi = SENSOR_RSSI_INVALIDO;
+
+    // Roteador nao tem pai: vai so o RLOC16 (os saltos saem do gateway)
+    if (otThreadGetDeviceRole(instance) == OT_DEVICE_ROLE_CHILD &&
+        otThreadGetParentInfo(instance, &pai) == OT_ERROR_NONE) {
+        if (otThreadGetParentAverageRssi(instance, &rssi) == OT_ERROR_NONE && rssi != OT_RADIO_RSSI_INVALID) {
+            // Margem como a do OpenThread: RSSI acima da sensibilidade do radio
+            int margem = rssi - otPlatRadioGetReceiveSensitivity(instance);
+            e.rssi = rssi;
+            e.margem = (uint8_t)(margem < 0 ? 0 : (margem > UINT8_MAX ? UINT8_MAX : margem));
+        }
+        e.qualidade_entrada = pai.mLinkQualityIn;
+        e.qualidade_saida = pai.mLinkQualityOut;
+    }
+
+    e.quadros = (uint16_t)s_em_voo.quadros;
+    e.retentativas = (uint16_t)s_em_voo.retentativas;
+    e.sem_ack = (uint16_t)s_em_voo.sem_ack;
+    e.cca = (uint16_t)s_em_voo.cca;
+    encode_sensor_enlace(&e, buf);
+}
+
+void enlace_confirmar(void)
+{
+    // O que andou depois do bloco continua pendente
+    s_pendente.quadros -= s_em_voo.quadros;
+    s_pendente.retentativas -= s_em_voo.retentativas;
+    s_pendente.sem_ack -= s_em_voo.sem_ack;
+    s_pendente.cca -= s_em_voo.cca;
+    memset(&s_em_voo, 0, sizeof(s_em_voo));
+}
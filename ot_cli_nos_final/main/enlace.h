@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+#include "openthread/instance.h"
+#include "sensor_codec.h"
+
+// ==================== ENLACE NA MALHA ====================
+// Bloco de telemetria do radio que vai no fim de todo payload binario (ver
+// sensor_codec.h): RLOC16, RSSI/margem/qualidade do enlace com o pai e os
+// contadores MAC. Os contadores do OpenThread zeram a cada boot; o que ainda
+// nao foi relatado (inclusive as retentativas do proprio envio, que vem
+// depois de montado o payload) fica acumulado na RTC ate o gateway receber
+// um bloco. Todas com o lock do OpenThread.
+
+// Preenche o bloco com o estado atual e os contadores pendentes
+void enlace_codificar(otInstance *instance, uint8_t buf[SENSOR_ENLACE_TAMANHO]);
+
+// O gateway recebeu o ultimo bloco: os contadores dele saem do pendente
+void enlace_confirmar(void);
+
+// Soma ao pendente o que os contadores andaram desde a ultima leitura
+// (antes do deep sleep, que os zera)
+void enlace_acumular(otInstance *instance);
@@ -1,10 +1,26 @@
 #include "sensor_data.h"
 #include "sensor_collect.h"
 #include "esp_ot_cli.h"
+#include "sensor_codec.h"
+#include "descoberta.h"
+#include "lote.h"
+#include "banda.h"
+#include "cadastro.h"
+#include "enlace.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+#include "openthread/link.h"
+#if CONFIG_OPENTHREAD_RADIO_STATS_ENABLE
+#include "openthread/radio_stats.h"
+#endif
 #include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
 
 #define PINO_ENVIO_COAP 19
 #define PINO_COAP 15
@@ -21,6 +37,645 @@ bool s_ot_active = false;
 volatile bool ot_shutdown_requested = false;
 volatile bool coap_send_shutdown_requested = false;
 
+// Sequencia das amostras (ver sensor_codec.h): na RTC, sobrevive ao deep sleep
+#define SEQ_MAGICO 0x53455131u
+RTC_DATA_ATTR static uint32_t s_seq_magico;
+RTC_DATA_ATTR static uint32_t s_seq;
+
+static uint32_t proxima_seq(void)
+{
+    // Boot a frio: a RTC veio com lixo, recomeca de um valor aleatorio
+    if (s_seq_magico != SEQ_MAGICO) {
+        s_seq = esp_random();
+        s_seq_magico = SEQ_MAGICO;
+    }
+    return s_seq++;
+}
+
+// ==================== TRAFEGO NAO SOLICITADO ====================
+// O nó e so cliente: nao registra recurso nenhum. Pedido que chegar (ex.:
+// multicast de firmware antigo) e contado e descartado sem ler o payload;
+// CON recebe 4.04 para o remetente nao retransmitir.
+RTC_DATA_ATTR static uint32_t s_pedidos_descartados;
+
+static void coap_descartar(void *aContext, otMessage *message, const otMessageInfo *messageInfo)
+{
+    OT_UNUSED_VARIABLE(aContext);
+    s_pedidos_descartados++;
+
+    if (otCoapMessageGetType(message) != OT_COAP_TYPE_CONFIRMABLE) return;
+
+    otMessage *resposta = otCoapNewMessage(instance, NULL);
+    if (resposta == NULL) return;
+    if (otCoapMessageInitResponse(resposta, message, OT_COAP_TYPE_ACKNOWLEDGMENT, OT_COAP_CODE_NOT_FOUND) != OT_ERROR_NONE ||
+        otCoapSendResponse(instance, resposta, messageInfo) != OT_ERROR_NONE) {
+        otMessageFree(resposta);
+    }
+}
+
+#if CONFIG_NODE_LOTE
+// Amostras do lote no POST em voo (liberadas do anel com o ACK)
+static uint8_t s_lote_em_voo = 0;
+#endif
+
+#if CONFIG_NODE_LOTE || !CONFIG_NODE_PAYLOAD_JSON
+// Payload binario: leva o id curto (sensor_codec.h) se houver, senao o EID.
+// So o envio confirmavel usa id: o 4.04 do gateway e que corrige um id que
+// ele nao conhece mais (sem ACK o nó nunca saberia).
+#if CONFIG_NODE_COAP_CONFIRMAVEL
+#define NODE_COM_ID 1
+#endif
+
+static uint16_t id_do_envio(void)
+{
+#if NODE_COM_ID
+    return cadastro_id();
+#else
+    return 0;
+#endif
+}
+#endif
+
+#if CONFIG_NODE_LOTE || CONFIG_NODE_BANDA
+bool coap_amostrar(void)
+{
+    // Sem OpenThread: id ou EID vao uma vez so, no cabecalho do lote
+    collect_sensor_data(&sensor_data);
+#if CONFIG_NODE_BANDA
+    MotivoBanda motivo = banda_avaliar(&sensor_data);
+    if (motivo == BANDA_ESTAVEL) return false;
+#endif
+#if CONFIG_NODE_LOTE
+#if CONFIG_NODE_BANDA
+    // No lote a amostra ja esta entregue ao anel; o heartbeat forca o envio
+    banda_aceitar(&sensor_data);
+    return lote_registrar(&sensor_data, proxima_seq()) || motivo == BANDA_HEARTBEAT;
+#else
+    return lote_registrar(&sensor_data, proxima_seq());
+#endif
+#else
+    // Sem lote a referencia so muda com o ACK (ver enviar_confirmavel)
+    return true;
+#endif
+}
+#endif
+
+// Monta o POST /sensor com a amostra atual ou, com NODE_LOTE, com todas as
+// amostras pendentes do anel (NULL se faltar buffer)
+static otMessage *montar_mensagem_sensor(otInstance *instance, otCoapType tipo)
+{
+    const otIp6Address *eid = otThreadGetMeshLocalEid(instance);
+#if CONFIG_NODE_LOTE
+    uint8_t lote[SENSOR_LOTE_TAMANHO_MAX];
+    uint32_t seq = 0;
+    uint16_t id = id_do_envio();
+    size_t loteLen = (id || eid) ? lote_codificar(id, eid, lote, sizeof(lote), &seq, &s_lote_em_voo) : 0;
+    if (loteLen == 0) {
+        ESP_LOGE(TAG_CLI, "Lote vazio ou sem endereco");
+        return NULL;
+    }
+    ESP_LOGI(TAG_CLI, "Enviando lote de %u amostras (%d bytes)", (unsigned)s_lote_em_voo, (int)loteLen);
+#elif CONFIG_NODE_PAYLOAD_JSON
+    //Cria JSON
+    char endereco[OT_IP6_ADDRESS_STRING_SIZE] = "unknown";
+    if (eid) {
+        otIp6AddressToString(eid, endereco, sizeof(endereco));
+    }
+    char* jsonPayload = create_sensor_json(&sensor_data, endereco);
+    if (jsonPayload == NULL) {
+        ESP_LOGE(TAG_CLI, "Falha ao criar JSON");
+        return NULL;
+    }
+    ESP_LOGI(TAG_CLI, "Enviando JSON: %s", jsonPayload);
+#else
+    // Cria registro binario (cabe num unico quadro 802.15.4). Com id, a
+    // amostra vai sozinha no formato do lote com id: 18 bytes em vez de 32
+    uint8_t registro[SENSOR_REGISTRO_TAMANHO];
+    uint16_t id = id_do_envio();
+    size_t registroLen;
+    if (id != 0) {
+        registroLen = encode_sensor_lote_cabecalho(id, NULL, 1, registro, sizeof(registro));
+        encode_sensor_amostra(&sensor_data, &registro[registroLen]);
+        registroLen += SENSOR_AMOSTRA_TAMANHO;
+    } else {
+        registroLen = encode_sensor_record(&sensor_data, eid, registro, sizeof(registro));
+    }
+    if (registroLen == 0) {
+        ESP_LOGE(TAG_CLI, "Falha ao codificar registro");
+        return NULL;
+    }
+    ESP_LOGI(TAG_CLI, "Enviando registro binario (%d bytes)", (int)registroLen);
+#endif
+
+    otMessage *msg = otCoapNewMessage(instance, NULL);
+    if (msg) {
+        otCoapMessageInit(msg, tipo, OT_COAP_CODE_POST);
+
+        // Token = sequencia da (primeira) amostra + parte aleatoria (ver sensor_codec.h)
+        uint8_t token[SENSOR_TOKEN_TAMANHO];
+#if CONFIG_NODE_LOTE
+        seq_para_token(seq, token);
+#else
+        seq_para_token(proxima_seq(), token);
+#endif
+        esp_fill_random(token + SENSOR_TOKEN_SEQ_TAMANHO, SENSOR_TOKEN_TAMANHO - SENSOR_TOKEN_SEQ_TAMANHO);
+        otCoapMessageSetToken(msg, token, sizeof(token));
+
+        // 1 - Define o URI do recurso do servidor envio + formato do payload
+        otCoapMessageAppendUriPathOptions(msg, "sensor");
+#if CONFIG_NODE_PAYLOAD_JSON
+        otCoapMessageAppendContentFormatOption(msg, OT_COAP_OPTION_CONTENT_FORMAT_JSON);
+#else
+        otCoapMessageAppendContentFormatOption(msg, OT_COAP_OPTION_CONTENT_FORMAT_OCTET_STREAM);
+#endif
+
+        // 2 - Payload Marker
+        otCoapMessageSetPayloadMarker(msg); // <--- ESSENCIAL
+
+        // 3 - Anexa o Payload
+#if CONFIG_NODE_LOTE
+        otMessageAppend(msg, lote, (uint16_t)loteLen);
+#elif CONFIG_NODE_PAYLOAD_JSON
+        otMessageAppend(msg, jsonPayload, strlen(jsonPayload));
+#else
+        otMessageAppend(msg, registro, (uint16_t)registroLen);
+#endif
+#if !CONFIG_NODE_PAYLOAD_JSON
+        // 4 - Bloco de enlace no fim (ver enlace.h)
+        uint8_t enlace[SENSOR_ENLACE_TAMANHO];
+        enlace_codificar(instance, enlace);
+        otMessageAppend(msg, enlace, sizeof(enlace));
+#endif
+    }
+
+#if CONFIG_NODE_PAYLOAD_JSON
+    free(jsonPayload);
+#endif
+    return msg;
+}
+
+// Define o destino: o gateway anunciado nos dados de rede (descoberta.h)
+static bool preencher_destino(otInstance *instance, otMessageInfo *msgInfo)
+{
+    memset(msgInfo, 0, sizeof(*msgInfo));
+    return descoberta_resolver(instance, &msgInfo->mPeerAddr, &msgInfo->mPeerPort);
+}
+
+#if CONFIG_NODE_COAP_CONFIRMAVEL
+// ==================== ENVIO CONFIRMAVEL ====================
+// Uma amostra por ciclo em CON: o OpenThread retransmite com backoff
+// exponencial (ACK_TIMEOUT dobra a cada tentativa, ate NODE_COAP_MAX_RETX)
+// e o nó dorme assim que o gateway confirma. O ACK_TIMEOUT inicial e um
+// RTO adaptativo (SRTT/RTTVAR do RFC 6298, regra de Karn) guardado na RTC:
+// malha lenta ou congestionada => esperas maiores, menos retransmissoes.
+#define ENVIO_MAGICO        0x454e5631u
+#define RTO_INICIAL_MS      2000    // ACK_TIMEOUT do RFC 7252
+#define RTO_MIN_MS          500
+#define RTO_MAX_MS          8000
+#define ATTACH_TIMEOUT_MS   60000
+
+typedef struct {
+    uint32_t magico;
+    uint32_t srtt_ms;       // 0 = ainda sem medida
+    uint32_t rttvar_ms;
+    uint32_t rto_ms;
+    uint32_t ciclos;
+    uint32_t confirmados;
+    uint32_t falhas;
+    uint32_t ultima_troca_ms;
+    uint32_t attach_ms;             // wake -> child/router neste ciclo
+    uint32_t primeiro_envio_ms;     // wake -> ACK neste ciclo (0 = sem ACK)
+    uint64_t acordado_total_ms;
+    uint64_t radio_total_ms;
+    uint64_t attach_total_ms;
+    uint64_t primeiro_envio_total_ms;
+    uint32_t wakes;                 // boots relatados (no SED, um so)
+    uint32_t wakes_com_envio;
+} EstadoEnvio;
+
+RTC_DATA_ATTR static EstadoEnvio s_envio;
+
+static SemaphoreHandle_t s_ciclo_concluido = NULL;
+static SemaphoreHandle_t s_attach = NULL;
+static volatile bool s_ciclo_confirmado = false;
+static int64_t s_radio_inicio_us = 0;
+static int64_t s_ciclo_inicio_us = 0;
+static bool s_relatou_boot = false;
+static uint32_t s_troca_atual = 0;
+#if NODE_COM_ID
+static volatile bool s_id_recusado = false;     // 4.04 na ultima troca
+#endif
+
+static void iniciar_estado_envio(void)
+{
+    // Boot a frio: a RTC veio com lixo
+    if (s_envio.magico != ENVIO_MAGICO) {
+        memset(&s_envio, 0, sizeof(s_envio));
+        s_envio.magico = ENVIO_MAGICO;
+        s_envio.rto_ms = RTO_INICIAL_MS;
+    }
+    s_envio.attach_ms = 0;
+    s_envio.primeiro_envio_ms = 0;
+}
+
+static uint32_t limitar_rto(uint32_t rto_ms)
+{
+    if (rto_ms < RTO_MIN_MS) return RTO_MIN_MS;
+    if (rto_ms > RTO_MAX_MS) return RTO_MAX_MS;
+    return rto_ms;
+}
+
+static void atualizar_rto(uint32_t rtt_ms)
+{
+    if (s_envio.srtt_ms == 0) {
+        s_envio.srtt_ms = rtt_ms;
+        s_envio.rttvar_ms = rtt_ms / 2;
+    } else {
+        uint32_t desvio = (rtt_ms > s_envio.srtt_ms) ? rtt_ms - s_envio.srtt_ms : s_envio.srtt_ms - rtt_ms;
+        s_envio.rttvar_ms = (3 * s_envio.rttvar_ms + desvio) / 4;
+        s_envio.srtt_ms = (7 * s_envio.srtt_ms + rtt_ms) / 8;
+    }
+    s_envio.rto_ms = limitar_rto(s_envio.srtt_ms + 4 * s_envio.rttvar_ms);
+}
+
+// Acerta o relogio com a hora do gateway no ACK (sensor_codec.h), depois
+// de 'antes' bytes de outros campos. A hora saiu do gateway ~meio RTT
+// antes de chegar aqui; o RTC mantem o relogio no deep sleep, entao os
+// proximos ciclos ja amostram com hora
+static void acertar_relogio(const otMessage *resposta, uint16_t antes)
+{
+    uint8_t hora[SENSOR_HORA_TAMANHO];
+    uint16_t offset = otMessageGetOffset(resposta) + antes;
+
+    if (otMessageGetLength(resposta) - offset < sizeof(hora) ||
+        otMessageRead(resposta, offset, hora, sizeof(hora)) != sizeof(hora)) {
+        return;
+    }
+    int64_t gateway_ms = decode_sensor_hora(hora) + s_envio.srtt_ms / 2;
+    if (gateway_ms / 1000 < SENSOR_EPOCH_MINIMO) return;
+
+    int64_t local_ms = sensor_agora_ms();
+    struct timeval tv = {
+        .tv_sec = (time_t)(gateway_ms / 1000),
+        .tv_usec = (suseconds_t)(gateway_ms % 1000) * 1000,
+    };
+    settimeofday(&tv, NULL);
+    if (local_ms == 0 || llabs(gateway_ms - local_ms) > 1000) {
+        ESP_LOGI(TAG_CLI, "Relogio acertado pelo gateway (desvio %lld ms)",
+                 local_ms ? (long long)(gateway_ms - local_ms) : 0LL);
+    }
+}
+
+// Roda na task do OpenThread: ACK (ou fim das retransmissoes) da troca
+static void coap_resposta(void *aContext, otMessage *message, const otMessageInfo *messageInfo, otError resultado)
+{
+    OT_UNUSED_VARIABLE(messageInfo);
+
+    uint32_t troca = (uint32_t)(uintptr_t)aContext;
+    bool ok = (resultado == OT_ERROR_NONE && message != NULL &&
+               (otCoapMessageGetCode(message) >> 5) == 2);   // classe 2.xx
+
+    if (resultado == OT_ERROR_NONE && !ok) {
+        ESP_LOGW(TAG_CLI, "Gateway recusou a amostra (codigo %d)", (int)otCoapMessageGetCode(message));
+#if NODE_COM_ID
+        s_id_recusado = (otCoapMessageGetCode(message) == OT_COAP_CODE_NOT_FOUND);
+#endif
+    }
+    if (ok) {
+        acertar_relogio(message, 0);
+    }
+    if (coap_send_task_handle != NULL) {
+        xTaskNotify(coap_send_task_handle, (troca << 1) | (ok ? 1 : 0), eSetValueWithOverwrite);
+    }
+}
+
+// Espera a resposta da troca (ou o fim das retransmissoes); true se 2.xx
+static bool aguardar_troca(uint32_t troca)
+{
+    // Pior caso da troca: ACK_TIMEOUT * 1.5 * (2^(MAX_RETX+1) - 1), mais folga
+    uint32_t limite_ms = s_envio.rto_ms * 3 / 2 * ((2u << CONFIG_NODE_COAP_MAX_RETX) - 1) + 2000;
+    uint32_t valor = 0;
+    TickType_t inicio = xTaskGetTickCount();
+    TickType_t decorrido;
+    // Notificacao de troca antiga nao reinicia a espera: so o que resta do limite
+    while ((decorrido = xTaskGetTickCount() - inicio) < pdMS_TO_TICKS(limite_ms)) {
+        if (xTaskNotifyWait(0, UINT32_MAX, &valor, pdMS_TO_TICKS(limite_ms) - decorrido) != pdTRUE) break;
+        if ((valor >> 1) == troca) {
+            return (valor & 1) != 0;
+        }
+    }
+    return false;
+}
+
+#if NODE_COM_ID
+// ==================== CADASTRO ====================
+// Sem id, o envio e precedido do cadastro no gateway (sensor_codec.h):
+// mesma troca CON, mesmo RTO. Se falhar, a amostra sai com o EID e o
+// cadastro e tentado de novo no proximo envio.
+static volatile uint16_t s_id_recebido = 0;
+
+static void coap_resposta_cadastro(void *aContext, otMessage *message, const otMessageInfo *messageInfo,
+                                   otError resultado)
+{
+    OT_UNUSED_VARIABLE(messageInfo);
+
+    uint32_t troca = (uint32_t)(uintptr_t)aContext;
+    uint8_t id[SENSOR_ID_TAMANHO];
+    bool ok = (resultado == OT_ERROR_NONE && message != NULL &&
+               otCoapMessageGetCode(message) == OT_COAP_CODE_CHANGED &&
+               otMessageRead(message, otMessageGetOffset(message), id, sizeof(id)) == sizeof(id));
+
+    if (ok) {
+        s_id_recebido = decode_sensor_id(id);
+        acertar_relogio(message, SENSOR_ID_TAMANHO);
+    } else if (resultado == OT_ERROR_NONE && message != NULL) {
+        ESP_LOGW(TAG_CLI, "Gateway recusou o cadastro (codigo %d)", (int)otCoapMessageGetCode(message));
+    }
+    if (coap_send_task_handle != NULL) {
+        xTaskNotify(coap_send_task_handle, (troca << 1) | (ok ? 1 : 0), eSetValueWithOverwrite);
+    }
+}
+
+static bool cadastrar(otInstance *instance, const otCoapTxParameters *parametros)
+{
+    uint8_t pedido[SENSOR_CADASTRO_TAMANHO];
+    otExtAddress eui64;
+    otMessageInfo msgInfo;
+    otError err = OT_ERROR_NO_BUFS;
+    uint32_t troca = ++s_troca_atual;
+
+    esp_openthread_lock_acquire(portMAX_DELAY);
+    const otIp6Address *eid = otThreadGetMeshLocalEid(instance);
+    if (eid == NULL || !preencher_destino(instance, &msgInfo)) {
+        esp_openthread_lock_release();
+        return false;
+    }
+    otLinkGetFactoryAssignedIeeeEui64(instance, &eui64);
+    encode_sensor_cadastro(eui64.m8, eid, pedido);
+
+    otMessage *msg = otCoapNewMessage(instance, NULL);
+    if (msg) {
+        otCoapMessageInit(msg, OT_COAP_TYPE_CONFIRMABLE, OT_COAP_CODE_POST);
+        otCoapMessageGenerateToken(msg, SENSOR_TOKEN_TAMANHO);
+        otCoapMessageAppendUriPathOptions(msg, SENSOR_CADASTRO_RECURSO);
+        otCoapMessageAppendContentFormatOption(msg, OT_COAP_OPTION_CONTENT_FORMAT_OCTET_STREAM);
+        otCoapMessageSetPayloadMarker(msg);
+        otMessageAppend(msg, pedido, sizeof(pedido));
+
+        s_id_recebido = 0;
+        xTaskNotifyStateClear(NULL);
+        err = otCoapSendRequestWithParameters(instance, msg, &msgInfo, coap_resposta_cadastro,
+                                              (void *)(uintptr_t)troca, parametros);
+        if (err != OT_ERROR_NONE) otMessageFree(msg);
+    }
+    esp_openthread_lock_release();
+
+    if (err != OT_ERROR_NONE || !aguardar_troca(troca) || s_id_recebido == 0) {
+        ESP_LOGW(TAG_CLI, "Cadastro sem resposta: a amostra vai com o EID");
+        return false;
+    }
+    cadastro_definir(s_id_recebido);
+    return true;
+}
+#endif
+
+// Papel na malha (task do OpenThread): acorda quem espera o attach. Com o
+// dataset e o pai guardados nas configuracoes do OpenThread (NVS), o nó
+// volta como filho do mesmo pai sem varrer a rede.
+static void ot_estado_alterado(otChangedFlags flags, void *aContext)
+{
+    if (!(flags & OT_CHANGED_THREAD_ROLE)) return;
+
+    otDeviceRole role = otThreadGetDeviceRole((otInstance *)aContext);
+    if (role >= OT_DEVICE_ROLE_CHILD) {
+        if (s_envio.attach_ms == 0) {
+            s_envio.attach_ms = (uint32_t)(esp_timer_get_time() / 1000);
+            ESP_LOGI(TAG_CLI, "Attach como %s em %u ms desde o wake",
+                     role == OT_DEVICE_ROLE_CHILD ? "filho" : "roteador", (unsigned)s_envio.attach_ms);
+        }
+        xSemaphoreGive(s_attach);
+    }
+}
+
+// Espera o nó entrar na malha (child/router) ou o limite estourar
+static bool aguardar_attach(otInstance *instance, uint32_t limite_ms)
+{
+    esp_openthread_lock_acquire(portMAX_DELAY);
+    otDeviceRole role = otThreadGetDeviceRole(instance);
+    esp_openthread_lock_release();
+
+    // Ja anexado antes desta task existir; senao o callback avisa
+    if (role >= OT_DEVICE_ROLE_CHILD) return true;
+    return xSemaphoreTake(s_attach, pdMS_TO_TICKS(limite_ms)) == pdTRUE;
+}
+
+// Uma troca CON completa; retorna true se o gateway confirmou
+static bool enviar_confirmavel(otInstance *instance)
+{
+    otCoapTxParameters parametros = {
+        .mAckTimeout = s_envio.rto_ms,
+        .mAckRandomFactorNumerator = 3,
+        .mAckRandomFactorDenominator = 2,
+        .mMaxRetransmit = CONFIG_NODE_COAP_MAX_RETX,
+    };
+    otMessageInfo msgInfo;
+
+#if NODE_COM_ID
+    if (cadastro_id() == 0) {
+        cadastrar(instance, &parametros);
+    }
+    s_id_recusado = false;
+#endif
+    uint32_t troca = ++s_troca_atual;
+
+    esp_openthread_lock_acquire(portMAX_DELAY);
+    if (!preencher_destino(instance, &msgInfo)) {
+        esp_openthread_lock_release();
+        return false;
+    }
+#if !CONFIG_NODE_LOTE && !CONFIG_NODE_BANDA
+    // Com banda a amostra ja foi lida (e avaliada) no coap_amostrar
+    collect_sensor_data(&sensor_data);
+#endif
+    otMessage *msg = montar_mensagem_sensor(instance, OT_COAP_TYPE_CONFIRMABLE);
+    otError err = OT_ERROR_NO_BUFS;
+    xTaskNotifyStateClear(NULL);
+    int64_t t0 = esp_timer_get_time();
+    if (msg) {
+        err = otCoapSendRequestWithParameters(instance, msg, &msgInfo, coap_resposta,
+                                              (void *)(uintptr_t)troca, &parametros);
+        if (err != OT_ERROR_NONE) otMessageFree(msg);
+    }
+    esp_openthread_lock_release();
+
+    if (err != OT_ERROR_NONE) {
+        ESP_LOGE(TAG_CLI, "Falha ao enviar CON: %d", err);
+        return false;
+    }
+
+    bool ok = aguardar_troca(troca);
+    uint32_t rtt_ms = (uint32_t)((esp_timer_get_time() - t0) / 1000);
+    s_envio.ultima_troca_ms = rtt_ms;
+
+    if (ok) {
+        // Karn: acima do ACK_TIMEOUT houve retransmissao, o RTT e ambiguo
+        if (rtt_ms < s_envio.rto_ms) atualizar_rto(rtt_ms);
+        if (s_envio.primeiro_envio_ms == 0) {
+            s_envio.primeiro_envio_ms = (uint32_t)(esp_timer_get_time() / 1000);
+        }
+#if CONFIG_NODE_LOTE
+        lote_confirmar(s_lote_em_voo);
+#elif CONFIG_NODE_BANDA
+        banda_aceitar(&sensor_data);
+#endif
+#if !CONFIG_NODE_PAYLOAD_JSON
+        enlace_confirmar();
+#endif
+        ESP_LOGI(TAG_CLI, "Amostra confirmada em %u ms (RTO %u ms)", (unsigned)rtt_ms, (unsigned)s_envio.rto_ms);
+#if NODE_COM_ID
+    } else if (s_id_recusado) {
+        // O gateway respondeu (o RTO fica): so o id e que nao vale mais. Com
+        // lote as amostras seguem no anel para o proximo envio
+        cadastro_esquecer();
+#endif
+    } else {
+        // Sem ACK apos todas as tentativas: recua o RTO para o proximo ciclo
+        // e procura o gateway de novo nos dados de rede
+        s_envio.rto_ms = limitar_rto(s_envio.rto_ms * 2);
+        descoberta_invalidar();
+        ESP_LOGW(TAG_CLI, "Amostra sem confirmacao apos %u ms (RTO -> %u ms)",
+                 (unsigned)rtt_ms, (unsigned)s_envio.rto_ms);
+    }
+    return ok;
+}
+
+bool coap_aguardar_ciclo(TickType_t timeout)
+{
+    if (s_ciclo_concluido == NULL) return false;
+    if (xSemaphoreTake(s_ciclo_concluido, timeout) != pdTRUE) return false;
+    return s_ciclo_confirmado;
+}
+
+// Radio ligado (TX + RX) desde o ultimo relato
+static uint32_t radio_ligado_ms(int64_t agora_us)
+{
+#if CONFIG_OPENTHREAD_RADIO_STATS_ENABLE
+    // Medido pelo proprio OpenThread: vale para deep sleep e SED
+    OT_UNUSED_VARIABLE(agora_us);
+    esp_openthread_lock_acquire(portMAX_DELAY);
+    const otRadioTimeStats *t = otRadioTimeStatsGet(instance);
+    uint64_t ligado_us = t ? t->mTxTime + t->mRxTime : 0;
+    otRadioTimeStatsReset(instance);
+    esp_openthread_lock_release();
+    return (uint32_t)(ligado_us / 1000);
+#else
+    // Sem estatisticas do radio: no modo deep sleep ele fica em RX do
+    // ot_enable ate dormir (o SED exige as estatisticas, ver Kconfig)
+    return s_radio_inicio_us ? (uint32_t)((agora_us - s_radio_inicio_us) / 1000) : 0;
+#endif
+}
+
+void coap_relatar_ciclo(void)
+{
+    int64_t agora_us = esp_timer_get_time();
+    uint32_t radio_ms = radio_ligado_ms(agora_us);
+#if !CONFIG_NODE_PAYLOAD_JSON
+    // Retentativas do envio deste ciclo vao no proximo bloco de enlace
+    esp_openthread_lock_acquire(portMAX_DELAY);
+    enlace_acumular(instance);
+    esp_openthread_lock_release();
+#endif
+#if CONFIG_NODE_MODO_SED
+    // Anexado o tempo todo: o ciclo vai de um relato ao seguinte
+    uint32_t acordado_ms = (uint32_t)((agora_us - s_ciclo_inicio_us) / 1000);
+    uint32_t ciclo_ms = acordado_ms;
+    s_ciclo_inicio_us = agora_us;
+#else
+    // Ciclo = acordado (desde o wake) + deep sleep
+    uint32_t acordado_ms = (uint32_t)(agora_us / 1000);
+    uint32_t ciclo_ms = acordado_ms + CONFIG_NODE_INTERVALO_AMOSTRA_S * 1000u;
+#endif
+
+    s_envio.ciclos++;
+    s_envio.acordado_total_ms += acordado_ms;
+    s_envio.radio_total_ms += radio_ms;
+
+    // Attach e primeiro envio so existem uma vez por boot
+    if (!s_relatou_boot) {
+        s_relatou_boot = true;
+        s_envio.wakes++;
+        s_envio.attach_total_ms += s_envio.attach_ms;
+        if (s_envio.primeiro_envio_ms) {
+            s_envio.wakes_com_envio++;
+            s_envio.primeiro_envio_total_ms += s_envio.primeiro_envio_ms;
+        }
+        ESP_LOGI(TAG_CLI, "Wake: attach %u ms, primeiro envio %u ms", (unsigned)s_envio.attach_ms,
+                 (unsigned)s_envio.primeiro_envio_ms);
+    }
+
+    ESP_LOGI(TAG_CLI, "Ciclo %u: acordado %u ms, radio %u ms de %u ms (%u.%u%%), troca %u ms, RTO %u ms",
+             (unsigned)s_envio.ciclos, (unsigned)acordado_ms, (unsigned)radio_ms, (unsigned)ciclo_ms,
+             (unsigned)((uint64_t)radio_ms * 100 / ciclo_ms), (unsigned)((uint64_t)radio_ms * 1000 / ciclo_ms % 10),
+             (unsigned)s_envio.ultima_troca_ms, (unsigned)s_envio.rto_ms);
+    ESP_LOGI(TAG_CLI, "Acumulado: %u confirmados, %u falhas, radio medio %u ms/ciclo, "
+             "wake->envio medio %u ms, %u pedidos descartados",
+             (unsigned)s_envio.confirmados, (unsigned)s_envio.falhas,
+             (unsigned)(s_envio.radio_total_ms / s_envio.ciclos),
+             (unsigned)(s_envio.wakes_com_envio ? s_envio.primeiro_envio_total_ms / s_envio.wakes_com_envio : 0),
+             (unsigned)s_pedidos_descartados);
+#if CONFIG_NODE_BANDA
+    ESP_LOGI(TAG_CLI, "Banda morta: %u de %u amostras suprimidas",
+             (unsigned)banda_suprimidas(), (unsigned)banda_amostras());
+#endif
+}
+
+// Envia uma amostra confirmavel por ciclo e avisa o app_main. No SED a
+// task fica viva e espera o intervalo em vTaskDelay: com tickless idle o
+// chip entra em light sleep e o OpenThread so acorda o radio para os polls.
+void coap_send_task(void *pvParameters) {
+    gpio_reset_pin(PINO_ENVIO_COAP);
+    gpio_set_direction(PINO_ENVIO_COAP, GPIO_MODE_OUTPUT);
+
+    otInstance *instance = (otInstance *)pvParameters;
+    coap_send_task_handle = xTaskGetCurrentTaskHandle();
+
+    while (!coap_send_shutdown_requested) {
+#if CONFIG_NODE_MODO_SED && (CONFIG_NODE_LOTE || CONFIG_NODE_BANDA)
+        // No SED a amostragem e aqui; no deep sleep o app_main ja amostrou
+        bool transmitir = coap_amostrar();
+#else
+        bool transmitir = true;
+#endif
+        if (transmitir) {
+            bool confirmado = false;
+            if (aguardar_attach(instance, ATTACH_TIMEOUT_MS)) {
+                gpio_set_level(PINO_ENVIO_COAP, 1);
+                confirmado = enviar_confirmavel(instance);
+                gpio_set_level(PINO_ENVIO_COAP, 0);
+            } else {
+                ESP_LOGW(TAG_CLI, "Sem attach em %d ms, amostra descartada", ATTACH_TIMEOUT_MS);
+            }
+
+            if (confirmado) {
+                s_envio.confirmados++;
+            } else {
+                s_envio.falhas++;
+            }
+            s_ciclo_confirmado = confirmado;
+            xSemaphoreGive(s_ciclo_concluido);
+        }
+
+#if CONFIG_NODE_MODO_SED
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_NODE_INTERVALO_AMOSTRA_S * 1000u));
+#else
+        break;
+#endif
+    }
+
+    coap_send_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+#else
 // Envia mensagem via CoAP
 void coap_send_task(void *pvParameters) {
     // 1. Reseta o pino para garantir que não tem lixo de configuração
@@ -37,42 +692,19 @@ void coap_send_task(void *pvParameters) {
 
     while(!coap_send_shutdown_requested) {
         // Coleta dados atualizadps       
-        collect_sensor_data(instance, &sensor_data); // Cria JSON        
-        
-        //Cria JSON
-        char* jsonPayload = create_sensor_json(&sensor_data);
-        if (jsonPayload == NULL) {
-            ESP_LOGE(TAG_CLI, "Falha ao criar JSON");
-            break;
-        } 
-        ESP_LOGI(TAG_CLI, "Enviando JSON: %s", jsonPayload);
-        ESP_LOGI(TAG_CLI, "");
-
-        otMessage *msg = otCoapNewMessage(instance, NULL);
-        if(msg) {
-            otCoapMessageInit(msg, OT_COAP_TYPE_NON_CONFIRMABLE, OT_COAP_CODE_POST);
-            otCoapMessageSetToken(msg, (const uint8_t *)"tk", 2);
-
-            // 1 - Define o URI do recurso do servidor envio
-            otCoapMessageAppendUriPathOptions(msg, "sensor");
-            
-            // 2 - Payload Marker
-            otCoapMessageSetPayloadMarker(msg); // <--- ESSENCIAL
-
-            // 3 - Anexa o Payload: 1 byte com o contador
-            //const char *payload = "aquiEstouMaisUmDia";            
-            //otMessageAppend(msg, payload, strlen(payload));                     
-            otMessageAppend(msg, jsonPayload, strlen(jsonPayload));
-            
-            // 4 - Define o destino - ENDERECO            
-            otMessageInfo msgInfo;
-            memset(&msgInfo, 0, sizeof(msgInfo));
-            // "fdde:ad00:beef:0:0:ff:fe00:3c00"            
-            otIp6AddressFromString("fe80::866:d20a:c41d:474b", &msgInfo.mPeerAddr); 
-            // IPv6 do outro nó            
-            msgInfo.mPeerPort = OT_DEFAULT_COAP_PORT;
-            
-            otCoapSendRequest(instance, msg, &msgInfo, NULL, NULL);
+        collect_sensor_data(&sensor_data); // Cria JSON        
+
+        otMessageInfo msgInfo;
+        if (preencher_destino(instance, &msgInfo)) {
+            otMessage *msg = montar_mensagem_sensor(instance, OT_COAP_TYPE_NON_CONFIRMABLE);
+            if (msg && otCoapSendRequest(instance, msg, &msgInfo, NULL, NULL) == OT_ERROR_NONE) {
+#if !CONFIG_NODE_PAYLOAD_JSON
+                // NON: sem ACK, o bloco enviado conta como relatado
+                enlace_confirmar();
+#endif
+            } else if (msg) {
+                otMessageFree(msg);
+            }
         }
 
         // Aguarda um pouquinho para o LED ser visível (ex: 100ms)
@@ -80,8 +712,6 @@ void coap_send_task(void *pvParameters) {
         vTaskDelay(pdMS_TO_TICKS(2000));
         gpio_set_level(PINO_ENVIO_COAP, 0);
 
-        free(jsonPayload);
-
         // delay, mas saí rapidamente se solicitado
         for (int i = 0; i < 100 && !coap_send_shutdown_requested; ++i) {
             vTaskDelay(pdMS_TO_TICKS(100));
@@ -94,6 +724,7 @@ void coap_send_task(void *pvParameters) {
     coap_send_task_handle = NULL;
     vTaskDelete(NULL); // encerra a si mesma
 }
+#endif // CONFIG_NODE_COAP_CONFIRMAVEL
 
 #if CONFIG_OPENTHREAD_CLI_ESP_EXTENSION
 #include "esp_ot_cli_extension.h"
@@ -109,6 +740,17 @@ esp_netif_t *init_openthread_netif(const esp_openthread_platform_config_t *confi
     return netif;
 }
 
+// Compara so o que configure_thread_network define
+static bool dataset_igual(const otOperationalDataset *a, const otOperationalDataset *b)
+{
+    return a->mComponents.mIsPanIdPresent && a->mPanId == b->mPanId &&
+           a->mComponents.mIsChannelPresent && a->mChannel == b->mChannel &&
+           a->mComponents.mIsNetworkNamePresent &&
+           strncmp(a->mNetworkName.m8, b->mNetworkName.m8, sizeof(a->mNetworkName.m8)) == 0 &&
+           a->mComponents.mIsNetworkKeyPresent &&
+           memcmp(a->mNetworkKey.m8, b->mNetworkKey.m8, sizeof(a->mNetworkKey.m8)) == 0;
+}
+
 //------------------------Função para configurar dataset Thread com PANID, nome, canal e chave
 void configure_thread_network(otInstance *instance)
 {
@@ -140,70 +782,45 @@ void configure_thread_network(otInstance *instance)
     memcpy(dataset.mNetworkKey.m8, key, sizeof(key));
     dataset.mComponents.mIsNetworkKeyPresent = true;
 
+    // Dataset igual ao ja gravado nas configuracoes do OpenThread (NVS):
+    // nao regrava a cada wake, e o attach usa o estado guardado (pai, papel)
+    otOperationalDataset atual;
+    if (otDatasetGetActive(instance, &atual) == OT_ERROR_NONE && dataset_igual(&atual, &dataset)) {
+        ESP_LOGI(TAG_CLI, "Dataset ativo ja gravado, mantendo");
+        return;
+    }
+
     // Aplica dataset como ativo
     otDatasetSetActive(instance, &dataset);
 }
 
-// ==================== HANDLER  COAP ====================
-void coap_handler(void *aContext, otMessage *message, const otMessageInfo *messageInfo)
+#if CONFIG_NODE_MODO_SED
+// ==================== SLEEPY END DEVICE ====================
+// Filho com o receptor desligado: o pai guarda os quadros e o nó busca com
+// data poll a cada NODE_SED_POLL_MS, ou (CSL) acorda o receptor em janelas
+// sincronizadas com o pai. Vale a partir do proximo attach.
+static void configurar_sed(otInstance *instance)
 {
-    OT_UNUSED_VARIABLE(aContext);
-
-    char addrString[OT_IP6_ADDRESS_STRING_SIZE];
-    otIp6AddressToString(&messageInfo->mPeerAddr, addrString, sizeof(addrString));
-
-    ESP_LOGI("CoAP", "Mensagem recebida de [%s]:%u", addrString, messageInfo->mPeerPort);
-
-    // Lê todo o payload
-    uint16_t offset = otMessageGetOffset(message);
-    uint16_t msgLength = otMessageGetLength(message);
-    uint16_t payloadLen = msgLength - offset;
-
-    if (payloadLen == 0) {
-        ESP_LOGE("CoAP", "Mensagem vazia");
-        return;
+    otLinkModeConfig modo;
+    memset(&modo, 0, sizeof(modo));
+    modo.mRxOnWhenIdle = false;
+    modo.mDeviceType = false;       // MTD
+    modo.mNetworkData = false;      // so a parte estavel (onde esta o servico)
+
+    otError err = otThreadSetLinkMode(instance, modo);
+    if (err == OT_ERROR_NONE) {
+        err = otLinkSetPollPeriod(instance, CONFIG_NODE_SED_POLL_MS);
     }
-
-    // Lê o conteúdo
-    char buffer[256]; // tamanho razoável pro seu JSON
-    if (payloadLen >= sizeof(buffer)) payloadLen = sizeof(buffer) - 1;
-
-    uint16_t bytesRead = otMessageRead(message, offset, buffer, payloadLen);
-    buffer[bytesRead] = '\0';
-
-    ESP_LOGI("CoAP", "Payload recebido (%d bytes): %s", bytesRead, buffer);
-
-    // ==================== Interpretando JSON ====================
-    cJSON *root = cJSON_Parse(buffer);
-    if (!root) {
-        ESP_LOGE("CoAP", "Erro ao fazer parse do JSON");
-        return;
+#if CONFIG_NODE_SED_CSL
+    if (err == OT_ERROR_NONE) {
+        err = otLinkSetCslPeriod(instance, CONFIG_NODE_SED_CSL_PERIODO_MS * 1000u);   // us
+    }
+#endif
+    if (err != OT_ERROR_NONE) {
+        ESP_LOGE(TAG_CLI, "Falha ao configurar SED: %d", err);
     }
-
-    // Extrai campos
-    const cJSON *endereco = cJSON_GetObjectItemCaseSensitive(root, "e");
-    const cJSON *dataHora = cJSON_GetObjectItemCaseSensitive(root, "d");
-    const cJSON *temperatura = cJSON_GetObjectItemCaseSensitive(root, "t");
-    const cJSON *umidadeAr = cJSON_GetObjectItemCaseSensitive(root, "uA");
-    const cJSON *umidadeSolo = cJSON_GetObjectItemCaseSensitive(root, "uS");
-    const cJSON *particulas = cJSON_GetObjectItemCaseSensitive(root, "p");
-
-    // Verifica e imprime se existir
-    if (cJSON_IsString(endereco) && cJSON_IsString(dataHora)) {
-        ESP_LOGI("JSON", "Endereço: %s", endereco->valuestring);
-        ESP_LOGI("JSON", "Data/Hora: %s", dataHora->valuestring);
-    }
-    if (cJSON_IsNumber(temperatura))
-        ESP_LOGI("JSON", "Temperatura: %.2f", temperatura->valuedouble);
-    if (cJSON_IsNumber(umidadeAr))
-        ESP_LOGI("JSON", "Umidade do Ar: %.2f", umidadeAr->valuedouble);
-    if (cJSON_IsNumber(umidadeSolo))
-        ESP_LOGI("JSON", "Umidade do Solo: %.2f", umidadeSolo->valuedouble);
-    if (cJSON_IsNumber(particulas))
-        ESP_LOGI("JSON", "Particulas: %.2f", particulas->valuedouble);
-
-    cJSON_Delete(root);
 }
+#endif
 
 // ==================== FUNÇÃO PARA INICIAR THREAD ====================
 void start_thread_network(otInstance *instance)
@@ -216,24 +833,13 @@ void start_thread_network(otInstance *instance)
 
     gpio_set_level(PINO_COAP, 1);
 
-    // Método mais simples - apenas habilita a Thread
+#if CONFIG_NODE_MODO_SED
+    configurar_sed(instance);
+#endif
+
+    // Apenas habilita a Thread: o attach so progride depois que o mainloop
+    // roda, entao a espera fica com a task de envio (aguardar_attach)
     otThreadSetEnabled(instance, true);
-        
-    // Aguarda um pouco para inicialização
-    vTaskDelay(pdMS_TO_TICKS(3000));
-    
-    // Verifica o estado
-    otDeviceRole role = otThreadGetDeviceRole(instance);
-    
-    // Se ainda estiver detached, tenta forçar
-    if (role == OT_DEVICE_ROLE_DETACHED) {
-        otThreadSetEnabled(instance, false);
-        vTaskDelay(pdMS_TO_TICKS(1000));
-        otThreadSetEnabled(instance, true);
-        
-        // Aguarda mais um pouco
-        vTaskDelay(pdMS_TO_TICKS(5000));
-    }
 }
 
 // ==================== TASK WORKER ====================
@@ -251,25 +857,22 @@ void ot_task_worker(void *aContext)
     instance = esp_openthread_get_instance();
     global_ot_instance = instance; // Inicializa o global_ot_instance
 
+#if CONFIG_NODE_COAP_CONFIRMAVEL
+    otSetStateChangedCallback(instance, ot_estado_alterado, instance);
+#endif
+
     // Configura a rede Thread
     configure_thread_network(instance);  
     
     // INICIA A REDE THREAD
     start_thread_network(instance);
 
-    // Criar e registrar o recurso CoAP
-    static otCoapResource coap_resource;
-    memset(&coap_resource, 0, sizeof(coap_resource));
-
-    coap_resource.mUriPath = "sensor";
-    coap_resource.mHandler = coap_handler;
-    coap_resource.mContext = NULL;
-    otCoapAddResource(instance, &coap_resource);
-    ESP_LOGI(TAG_CLI, "Recurso /sensor adicionado");
+    // CoAP so como cliente (respostas aos envios); nenhum recurso servido
+    otCoapSetDefaultHandler(instance, coap_descartar, NULL);
 
     otError err = otCoapStart(instance, OT_DEFAULT_COAP_PORT);
     if(err == OT_ERROR_NONE) {    
-        ESP_LOGI(TAG_CLI, "Servidor CoAP iniciado, recurso /sensor/dados");
+        ESP_LOGI(TAG_CLI, "CoAP iniciado (somente cliente)");
     } else {
         ESP_LOGE(TAG_CLI, "Falha ao iniciar CoAP: %d", err);    
     }
@@ -349,6 +952,18 @@ void ot_enable(void) {
     ot_shutdown_requested = false;
     coap_send_shutdown_requested = false;
 
+#if CONFIG_NODE_COAP_CONFIRMAVEL
+    iniciar_estado_envio();
+    if (s_ciclo_concluido == NULL) {
+        s_ciclo_concluido = xSemaphoreCreateBinary();
+    }
+    if (s_attach == NULL) {
+        s_attach = xSemaphoreCreateBinary();
+    }
+    s_radio_inicio_us = esp_timer_get_time();
+    s_ciclo_inicio_us = s_radio_inicio_us;
+#endif
+
     // ==================== INICIALIZAÇÃO OPENTHREAD ====================    
     // Cria tarefa do OpenThread (comunicação mesh)
     if(xTaskCreate(ot_task_worker,        // Função a ser executada
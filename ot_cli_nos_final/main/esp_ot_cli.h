@@ -45,9 +45,21 @@ extern sensor_data_t sensor_data;
 void coap_send_task(void *pvParameters);
 esp_netif_t *init_openthread_netif(const esp_openthread_platform_config_t *config);
 void configure_thread_network(otInstance *instance);
-void coap_handler(void *aContext, otMessage *message, const otMessageInfo *messageInfo);
 void ot_task_worker(void *aContext);
 void ot_enable(void);
 void ot_disable(void);
 
+#if CONFIG_NODE_COAP_CONFIRMAVEL
+// Bloqueia ate a amostra do ciclo ser confirmada (true) ou desistir (false)
+bool coap_aguardar_ciclo(TickType_t timeout);
+// Loga tempo acordado/radio do ciclo e os acumulados (guardados na RTC)
+void coap_relatar_ciclo(void);
+#endif
+
+#if CONFIG_NODE_LOTE || CONFIG_NODE_BANDA
+// Coleta a amostra do wake sem o OpenThread (banda morta e/ou lote na RTC);
+// true se o wake deve subir a rede e enviar
+bool coap_amostrar(void);
+#endif
+
 #endif
\ No newline at end of file
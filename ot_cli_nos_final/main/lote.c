@@ -0,0 +1,106 @@
+#include "lote.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include <string.h>
+
+#if CONFIG_NODE_LOTE
+
+static const char *TAG_LOTE = "LOTE";
+
+#define LOTE_MAGICO 0x4c4f5431u
+
+typedef struct {
+    uint32_t magico;
+    uint32_t primeira_seq;      // sequencia da amostra mais antiga
+    uint32_t sobrescritas;
+    uint8_t inicio;
+    uint8_t n;
+    uint8_t wakes;              // wakes desde o ultimo envio confirmado
+    uint8_t em_alarme;          // estado do alarme na ultima amostra
+    uint8_t amostras[SENSOR_LOTE_MAX][SENSOR_AMOSTRA_TAMANHO];
+} AnelLote;
+
+RTC_DATA_ATTR static AnelLote s_anel;
+
+// Alguma leitura alem dos limites configurados (0 desliga o limite)
+static bool em_alarme(const sensor_data_t *d)
+{
+    if (d->temperatura >= CONFIG_NODE_LOTE_LIMITE_TEMP_C) return true;
+#if CONFIG_NODE_LOTE_LIMITE_UMIS_MIN > 0
+    if (d->umidadeSolo <= CONFIG_NODE_LOTE_LIMITE_UMIS_MIN) return true;
+#endif
+#if CONFIG_NODE_LOTE_LIMITE_PPM > 0
+    if (d->particulas >= CONFIG_NODE_LOTE_LIMITE_PPM) return true;
+#endif
+    return false;
+}
+
+bool lote_registrar(const sensor_data_t *dados, uint32_t seq)
+{
+    // Boot a frio: anel vazio
+    if (s_anel.magico != LOTE_MAGICO) {
+        memset(&s_anel, 0, sizeof(s_anel));
+        s_anel.magico = LOTE_MAGICO;
+    }
+
+    if (s_anel.n == SENSOR_LOTE_MAX) {
+        // Cheio: a mais antiga sai (o gateway conta a lacuna)
+        s_anel.inicio = (s_anel.inicio + 1) % SENSOR_LOTE_MAX;
+        s_anel.n--;
+        s_anel.primeira_seq++;
+        s_anel.sobrescritas++;
+        ESP_LOGW(TAG_LOTE, "Anel cheio, amostra mais antiga sobrescrita (total %u)",
+                 (unsigned)s_anel.sobrescritas);
+    }
+    if (s_anel.n == 0) {
+        s_anel.primeira_seq = seq;
+    }
+
+    encode_sensor_amostra(dados, s_anel.amostras[(s_anel.inicio + s_anel.n) % SENSOR_LOTE_MAX]);
+    s_anel.n++;
+    if (s_anel.wakes < UINT8_MAX) s_anel.wakes++;
+
+    // Alarme dispara na borda (entrada ou saida), nao a cada wake
+    bool alarme = em_alarme(dados);
+    bool cruzou = alarme != (s_anel.em_alarme != 0);
+    s_anel.em_alarme = alarme;
+
+    bool enviar = cruzou || s_anel.wakes >= CONFIG_NODE_LOTE_WAKES;
+    ESP_LOGI(TAG_LOTE, "Amostra %u no lote (wake %u/%d)%s", (unsigned)s_anel.n, (unsigned)s_anel.wakes,
+             CONFIG_NODE_LOTE_WAKES, cruzou ? ", limite cruzado" : "");
+    return enviar;
+}
+
+size_t lote_codificar(uint16_t nodo, const otIp6Address *eid, uint8_t *buf, size_t len,
+                      uint32_t *primeira_seq, uint8_t *n)
+{
+    if (s_anel.magico != LOTE_MAGICO || s_anel.n == 0) return 0;
+
+    size_t pos = encode_sensor_lote_cabecalho(nodo, eid, s_anel.n, buf, len);
+    if (pos == 0 || len < pos + (size_t)s_anel.n * SENSOR_AMOSTRA_TAMANHO) return 0;
+
+    for (uint8_t k = 0; k < s_anel.n; k++) {
+        memcpy(&buf[pos], s_anel.amostras[(s_anel.inicio + k) % SENSOR_LOTE_MAX], SENSOR_AMOSTRA_TAMANHO);
+        pos += SENSOR_AMOSTRA_TAMANHO;
+    }
+    *primeira_seq = s_anel.primeira_seq;
+    *n = s_anel.n;
+    return pos;
+}
+
+void lote_confirmar(uint8_t n)
+{
+    if (n > s_anel.n) n = s_anel.n;
+    s_anel.inicio = (s_anel.inicio + n) % SENSOR_LOTE_MAX;
+    s_anel.n -= n;
+    s_anel.primeira_seq += n;
+    s_anel.wakes = 0;
+}
+
+size_t lote_pendentes(void)
+{
+    return (s_anel.magico == LOTE_MAGICO) ? s_anel.n : 0;
+}
+
+#endif // CONFIG_NODE_LOTE
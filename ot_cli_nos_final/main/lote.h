@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "openthread/ip6.h"
+#include "sensor_data.h"
+#include "sensor_codec.h"
+
+// ==================== LOTE NA RTC ====================
+// Cada wake grava a amostra num anel na memoria RTC (sobrevive ao deep
+// sleep) e so transmite a cada NODE_LOTE_WAKES wakes, ou antes se uma
+// leitura cruzar um limite de alarme. Tudo o que esta pendente vai num
+// payload so (SENSOR_LOTE_VERSAO); o anel so e liberado com o ACK. Anel
+// cheio (gateway fora por muito tempo) sobrescreve a amostra mais antiga,
+// que o gateway ve como lacuna na sequencia.
+
+// Grava a amostra com a sua sequencia; true se o lote deve sair agora
+bool lote_registrar(const sensor_data_t *dados, uint32_t seq);
+
+// Payload com todas as pendentes, com o id curto ou, sem ele (nodo 0),
+// com o EID; retorna o tamanho (0 se vazio)
+size_t lote_codificar(uint16_t nodo, const otIp6Address *eid, uint8_t *buf, size_t len,
+                      uint32_t *primeira_seq, uint8_t *n);
+
+// Libera as n amostras mais antigas (confirmadas pelo gateway)
+void lote_confirmar(uint8_t n);
+
+size_t lote_pendentes(void);
@@ -11,6 +11,7 @@
 #include "freertos/FreeRTOS.h"  // Base do FreeRTOS
 #include "freertos/task.h"      // xTaskCreate, vTaskDelay
 #include "esp_sleep.h"
+#include "esp_pm.h"
 
 // --- OpenThread core ---
 #include "esp_openthread.h"
@@ -23,20 +24,42 @@
 #include "sdkconfig.h" // se usar algo do tipo CONFIG precisa ter
 #include "sensor_data.h"
 #include "sensor_collect.h"
+#include "esp_ot_cli.h"
 
 #define PINO_INICIALIZACAO 18
 
-#define intervaloSono 30   // tempo dormindo
-
-void ot_task_worker(void *aContext);
-void ot_enable();
-void ot_disable();
+#define intervaloSono CONFIG_NODE_INTERVALO_AMOSTRA_S   // tempo dormindo
+#define tempoMaxAcordado 85000  // ms; teto do ciclo se a troca nao terminar
 
 otInstance *global_ot_instance;
 sensor_data_t sensor_data;
 
 
 
+#if CONFIG_NODE_MODO_SED
+// Light sleep automatico sempre que as tasks estiverem bloqueadas
+static void configurar_light_sleep(void)
+{
+#if CONFIG_PM_ENABLE
+    esp_pm_config_t pm = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = 40,     // XTAL
+        .light_sleep_enable = true,
+    };
+    ESP_ERROR_CHECK(esp_pm_configure(&pm));
+#else
+    ESP_LOGW(TAG, "CONFIG_PM_ENABLE desligado: SED sem light sleep");
+#endif
+}
+#endif
+
+// Deep sleep ate a proxima amostra
+static void dormir(void)
+{
+    esp_sleep_enable_timer_wakeup((uint64_t)intervaloSono * 1000000ULL);
+    esp_deep_sleep_start();
+}
+
 void app_main(void)
 {
     // 1. Reseta o pino para garantir que não tem lixo de configuração
@@ -45,6 +68,15 @@ void app_main(void)
     // 2. Define o pino como SAÍDA (Output)
     gpio_set_direction(PINO_INICIALIZACAO, GPIO_MODE_OUTPUT);
     gpio_set_level(PINO_INICIALIZACAO, 1);
+
+#if (CONFIG_NODE_LOTE || CONFIG_NODE_BANDA) && !CONFIG_NODE_MODO_SED
+    // Amostra antes da rede; sem nada a enviar nem sobe o OpenThread
+    if (!coap_amostrar()) {
+        ESP_LOGI(TAG, " ===== Nada a enviar - Indo dormir... ===== ");
+        dormir();
+    }
+#endif
+
     // 1) Inicializacao
     ESP_ERROR_CHECK(nvs_flash_init());
     ESP_ERROR_CHECK(esp_netif_init());
@@ -61,15 +93,36 @@ void app_main(void)
     // sensors_disable();
 
     // 3) Inicializa OpenThread + CoAP
+#if CONFIG_NODE_MODO_SED
+    // SED: fica anexado, uma amostra por intervalo e light sleep entre elas
+    configurar_light_sleep();
     ot_enable();
+    for (;;) {
+        if (!coap_aguardar_ciclo(portMAX_DELAY)) {
+            ESP_LOGW(TAG, "Amostra do ciclo nao confirmada");
+        }
+        coap_relatar_ciclo();
+    }
+#else
+    ot_enable();
+#if CONFIG_NODE_COAP_CONFIRMAVEL
+    // Dorme assim que o gateway confirmar a amostra (ou a troca desistir)
+    if (!coap_aguardar_ciclo(pdMS_TO_TICKS(tempoMaxAcordado))) {
+        ESP_LOGW(TAG, "Amostra do ciclo nao confirmada");
+    }
+    coap_relatar_ciclo();
+
+    ESP_LOGI(TAG, " ===== Ciclo finalizado - Indo dormir... ===== ");
+#else
     vTaskDelay(pdMS_TO_TICKS(70000)); // TEM QUE TER NO MININO 70s
     // ot_disable();
 
     ESP_LOGI(TAG, " ===== Ciclo finalizado - Indo dormir... ===== ");
     
     vTaskDelay(pdMS_TO_TICKS(15000));
+#endif
+#endif
 
     // 4) Deep Sleep
-    esp_sleep_enable_timer_wakeup((uint64_t)intervaloSono * 1000000ULL);
-    esp_deep_sleep_start();
+    dormir();
 }
\ No newline at end of file
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "openthread/ip6.h"
+#include "sensor_data.h"
+
+// ==================== REGISTRO BINARIO DO SENSOR ====================
+// Formato compacto enviado pela malha Thread (Content-Format 42,
+// application/octet-stream). Todos os campos inteiros em little-endian,
+// medidas em ponto fixo (centesimos):
+//
+//  off  tam  campo
+//   0    1   versao (SENSOR_REGISTRO_VERSAO)
+//   1    1   flags (reservado, 0)
+//   2   16   endereco (EID binario do no)
+//  18    4   instante (segundos desde 1970, UTC; 0 = sem hora)
+//  22    2   temperatura  (int16,  0.01 °C)
+//  24    2   umidadeAr    (uint16, 0.01 %)
+//  26    2   umidadeSolo  (uint16, 0.01 %)
+//  28    4   particulas   (uint32, 0.01 ppm)
+//
+// Mantenha identico em ot_cli_gateway_final/main/sensor_codec.hpp
+#define SENSOR_REGISTRO_VERSAO  1
+#define SENSOR_REGISTRO_TAMANHO 32
+
+// ==================== LOTE DE AMOSTRAS ====================
+// Varias amostras do mesmo nó num payload so (Content-Format 42), com o
+// instante original de cada uma. Cabecalho de SENSOR_LOTE_CABECALHO bytes
+// seguido de n amostras de SENSOR_AMOSTRA_TAMANHO bytes (mesmo layout dos
+// bytes 18..31 do registro v1):
+//
+//  off  tam  campo
+//   0    1   versao (SENSOR_LOTE_VERSAO)
+//   1    1   n (1..SENSOR_LOTE_MAX)
+//   2   16   endereco (EID binario do no)
+//  18   14n  amostras: instante(4) temperatura(2) umidadeAr(2)
+//                      umidadeSolo(2) particulas(4)
+//
+// O token leva a sequencia da primeira amostra; a k-esima e seq + k.
+//
+// Nó com id curto (ver ID CURTO DO NÓ) manda a versao SENSOR_LOTE_VERSAO_ID,
+// com o id no lugar do EID (cabecalho de SENSOR_LOTE_CABECALHO_ID bytes);
+// sem lote, a amostra vai sozinha nela (n = 1, 18 bytes em vez de 32):
+//
+//  off  tam  campo
+//   0    1   versao (SENSOR_LOTE_VERSAO_ID)
+//   1    1   n (1..SENSOR_LOTE_MAX)
+//   2    2   id do nó (uint16)
+//   4   14n  amostras
+#define SENSOR_LOTE_VERSAO      2
+#define SENSOR_LOTE_CABECALHO   18
+#define SENSOR_LOTE_VERSAO_ID   3
+#define SENSOR_LOTE_CABECALHO_ID 4
+#define SENSOR_AMOSTRA_TAMANHO  14
+#define SENSOR_LOTE_MAX         16
+#define SENSOR_LOTE_TAMANHO_MAX (SENSOR_LOTE_CABECALHO + SENSOR_LOTE_MAX * SENSOR_AMOSTRA_TAMANHO)
+
+// ==================== SEQUENCIA NO TOKEN COAP ====================
+// Cada amostra leva um numero de sequencia de 32 bits (little-endian) nos
+// primeiros SENSOR_TOKEN_SEQ_TAMANHO bytes do token CoAP, nos dois formatos
+// de payload, seguido de bytes aleatorios (token de SENSOR_TOKEN_TAMANHO
+// bytes, imprevisivel como pede o RFC 7252 para casar a resposta CON).
+// Cresce de 1 em 1 e sobrevive ao deep sleep; no boot a frio recomeca de um
+// valor aleatorio (o gateway trata o salto como reinicio do nó). Um token
+// menor (firmware antigo, "tk") significa "sem sequencia".
+#define SENSOR_TOKEN_SEQ_TAMANHO 4
+#define SENSOR_TOKEN_TAMANHO     8
+
+// ==================== SERVICO THREAD DO GATEWAY ====================
+// O gateway publica nos dados de rede (parte estavel) um servico com
+// enterprise number SENSOR_SERVICO_ENTERPRISE e service data
+// SENSOR_SERVICO_DADOS; o server data e a porta CoAP (uint16 big-endian).
+// O lider atribui um id (0..15) ao servico e os nós mandam as amostras
+// para o ALOC dele, prefixo mesh-local + 0:ff:fe00:(fc10 + id), que a
+// malha entrega ao gateway mais proximo, a qualquer numero de saltos.
+#define SENSOR_SERVICO_ENTERPRISE 44970     // Thread Group
+#define SENSOR_SERVICO_DADOS      "egglink"
+#define SENSOR_SERVICO_ALOC16     0xfc10
+
+// ==================== HORA DA REDE ====================
+// Os nós nao tem SNTP: o gateway manda a propria hora no payload de todo
+// ACK 2.04 (SENSOR_HORA_TAMANHO bytes, ms desde 1970 UTC, int64
+// little-endian) e o nó acerta o relogio com ela. O relogio continua
+// contando no deep sleep, entao so o primeiro ciclo apos o boot a frio sai
+// sem hora (0): o gateway carimba essas amostras com a hora da chegada.
+// Relogio abaixo de SENSOR_EPOCH_MINIMO (2020-01-01) nunca foi acertado.
+#define SENSOR_HORA_TAMANHO  8
+#define SENSOR_EPOCH_MINIMO  1577836800
+
+// ==================== ID CURTO DO NÓ ====================
+// O gateway da a cada nó um id de 16 bits (1..), estavel pela EUI-64 de
+// fabrica e guardado em NVS nos dois lados. O id vai nos payloads e e a
+// chave da tabela de nós; EUI-64 e EID ficam numa tabela lateral do gateway
+// e so aparecem no uplink. Cadastro: POST CON em SENSOR_CADASTRO_RECURSO
+// (Content-Format 42) com
+//
+//  off  tam  campo
+//   0    8   EUI-64 de fabrica do nó
+//   8   16   EID (mesh-local) atual
+//
+// O 2.04 traz o id (uint16 little-endian) seguido da hora da rede; tabela
+// cheia recebe 5.03, e o lote tambem, se a tabela de nós do gateway estiver
+// cheia (o nó guarda o lote). Lote com id desconhecido (NVS do gateway
+// apagada) recebe 4.04 e o nó refaz o cadastro. Sem id (cadastro pendente, envio
+// NON, firmware antigo) o payload leva o EID e o gateway acha o id por ele.
+#define SENSOR_CADASTRO_RECURSO "cadastro"
+#define SENSOR_CADASTRO_TAMANHO 24
+#define SENSOR_EUI64_TAMANHO    8
+#define SENSOR_ID_TAMANHO       2
+
+// ==================== ENLACE NA MALHA ====================
+// Telemetria de radio do nó, anexada ao fim do payload binario (depois das
+// amostras do registro v1 ou do lote); o gateway so a le quando sobram
+// exatamente SENSOR_ENLACE_TAMANHO bytes:
+//
+//  off  tam  campo
+//   0    2   RLOC16 do nó (filho: pai = roteador do RLOC16; roteador: ele)
+//   2    1   RSSI medio do pai (int8, dBm; SENSOR_RSSI_INVALIDO = sem pai)
+//   3    1   margem do enlace com o pai (dB acima da sensibilidade)
+//   4    1   qualidade do enlace com o pai (0..3): entrada (bits 0-3),
+//            saida (bits 4-7)
+//   5    2   quadros MAC transmitidos
+//   7    2   retentativas MAC
+//   9    2   quadros sem ACK depois de todas as retentativas
+//  11    2   falhas de CCA (canal ocupado)
+//
+// Os contadores (uint16, saturados) sao os acumulados desde o ultimo
+// relato confirmado. Os saltos ate o gateway saem da tabela de rotas dele.
+#define SENSOR_ENLACE_TAMANHO   13
+#define SENSOR_RSSI_INVALIDO    127
+#define SENSOR_RLOC16_FILHO     0x03ff      // RLOC16 abaixo do id do roteador
+
+// Codifica em buf com o EID (NULL = zeros); retorna o numero de bytes
+// escritos (0 se nao couber)
+size_t encode_sensor_record(const sensor_data_t *data, const otIp6Address *eid, uint8_t *buf, size_t len);
+
+// Decodifica sem alocar; preenche data (sem id) e o EID binario
+bool decode_sensor_record(const uint8_t *buf, size_t len, sensor_data_t *data, otIp6Address *eid);
+
+// Uma amostra do lote (sem id nem endereco: decode deixa data->nodo em 0)
+void encode_sensor_amostra(const sensor_data_t *data, uint8_t buf[SENSOR_AMOSTRA_TAMANHO]);
+void decode_sensor_amostra(const uint8_t buf[SENSOR_AMOSTRA_TAMANHO], sensor_data_t *data);
+
+// Cabecalho do lote: com id (nodo != 0) ou com o EID. Retorna o tamanho
+// escrito / lido (0 se nao couber ou invalido); no lote com EID, *nodo = 0
+size_t encode_sensor_lote_cabecalho(uint16_t nodo, const otIp6Address *eid, uint8_t n, uint8_t *buf, size_t len);
+size_t decode_sensor_lote_cabecalho(const uint8_t *buf, size_t len, uint16_t *nodo, otIp6Address *eid, uint8_t *n);
+
+// Pedido de cadastro e id da resposta (0 = invalido)
+void encode_sensor_cadastro(const uint8_t eui64[SENSOR_EUI64_TAMANHO], const otIp6Address *eid,
+                            uint8_t buf[SENSOR_CADASTRO_TAMANHO]);
+void decode_sensor_cadastro(const uint8_t buf[SENSOR_CADASTRO_TAMANHO], uint8_t eui64[SENSOR_EUI64_TAMANHO],
+                            otIp6Address *eid);
+void encode_sensor_id(uint16_t nodo, uint8_t buf[SENSOR_ID_TAMANHO]);
+uint16_t decode_sensor_id(const uint8_t buf[SENSOR_ID_TAMANHO]);
+
+// Bloco de enlace (ENLACE NA MALHA)
+void encode_sensor_enlace(const sensor_enlace_t *enlace, uint8_t buf[SENSOR_ENLACE_TAMANHO]);
+void decode_sensor_enlace(const uint8_t buf[SENSOR_ENLACE_TAMANHO], sensor_enlace_t *enlace);
+
+// Roteador que atende o RLOC16: o pai de um filho, o proprio roteador
+static inline uint16_t sensor_rloc16_roteador(uint16_t rloc16)
+{
+    return (uint16_t)(rloc16 & ~SENSOR_RLOC16_FILHO);
+}
+
+// Hora do sistema em ms desde 1970; 0 se o relogio ainda nao foi acertado
+int64_t sensor_agora_ms(void);
+
+// Payload de hora do ACK
+void encode_sensor_hora(int64_t epoch_ms, uint8_t buf[SENSOR_HORA_TAMANHO]);
+int64_t decode_sensor_hora(const uint8_t buf[SENSOR_HORA_TAMANHO]);
+
+// Texto so na fronteira JSON: "YYYY-MM-DDTHH:MM:SS.mmm" na hora local do
+// firmware (nós nao tem TZ: UTC)
+void epoch_ms_para_texto(int64_t epoch_ms, char *out, size_t len);
+
+// Sequencia -> token CoAP
+void seq_para_token(uint32_t seq, uint8_t token[SENSOR_TOKEN_SEQ_TAMANHO]);
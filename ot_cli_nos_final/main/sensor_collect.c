@@ -1,4 +1,5 @@
 #include "sensor_data.h"
+#include "sensor_codec.h"
 #include "cJSON.h"
 #include <stdio.h>
 #include <string.h>
@@ -26,7 +27,8 @@ TaskHandle_t SensorUmiSTaskHandle = NULL;
 
 bool sensors_initialized = false;
 
-char* create_sensor_json(const sensor_data_t* data) {
+// JSON legado: leva o EID em texto ("e"), nao o id curto
+char* create_sensor_json(const sensor_data_t* data, const char* endereco) {
     if (!data) return NULL;
     double t  = round2f(data->temperatura, 2);
     double uA = round2f(data->umidadeAr, 2);
@@ -36,8 +38,13 @@ char* create_sensor_json(const sensor_data_t* data) {
     cJSON *root = cJSON_CreateObject();
     if (!root) return NULL;
 
-    cJSON_AddStringToObject(root, "e", data->endereco);
-    cJSON_AddStringToObject(root, "d", data->dataHora);
+    cJSON_AddStringToObject(root, "e", endereco);
+    // Sem hora (relogio ainda nao acertado): o gateway carimba na chegada
+    if (data->epoch_ms != 0) {
+        char dataHora[32];
+        epoch_ms_para_texto(data->epoch_ms, dataHora, sizeof(dataHora));
+        cJSON_AddStringToObject(root, "d", dataHora);
+    }
     
     cJSON_AddNumberToObject(root, "t", t);
     cJSON_AddNumberToObject(root, "uA", uA);
@@ -49,29 +56,10 @@ char* create_sensor_json(const sensor_data_t* data) {
     return json_string;
 }
 
-void collect_sensor_data(otInstance *instance, sensor_data_t* data) {
-    // Endereço Thread (se disponível)
-    const otIp6Address *addr = NULL;
-    if (instance) {
-        addr = otThreadGetMeshLocalEid(instance);
-    }
-    if (addr) {
-        // Converte para string (se sua funcao otIp6AddressToString existir)
-        otIp6AddressToString(addr, data->endereco, sizeof(data->endereco));
-    } else {
-        // Fallback mais amigavel para o JSON
-        strncpy(data->endereco, "unknown", sizeof(data->endereco));
-        data->endereco[sizeof(data->endereco) - 1] = '\0';
-    }
-
-    time_t now = time(NULL);
-    struct tm *timeinfo = localtime(&now);
-    if (timeinfo) {
-        strftime(data->dataHora, sizeof(data->dataHora), "%Y-%m-%dT%H:%M:%S", timeinfo);
-    } else {
-        strncpy(data->dataHora, "1970-01-01T00:00:00", sizeof(data->dataHora));
-        data->dataHora[sizeof(data->dataHora) - 1] = '\0';
-    }
+// So as medidas: quem identifica o nó (id ou EID) e o payload
+void collect_sensor_data(sensor_data_t* data) {
+    // Inteiro; o texto so e formatado na fronteira JSON/HTTP
+    data->epoch_ms = sensor_agora_ms();
 
     // Usa os GETTERS (eles retornam os valores "bonitos")
     data->temperatura  = AHT_GetTemperature();
@@ -153,7 +141,7 @@ void sensors_enable(otInstance *instance_local, sensor_data_t *sensor_data_local
     const int max_attempts = 3; // 3 segundos no máximo
     
     while (attempts < max_attempts) {
-        collect_sensor_data(instance_local, sensor_data_local);
+        collect_sensor_data(sensor_data_local);
         
         if (sensors_are_ready(sensor_data_local)) {
             ESP_LOGI(TAG_SENSOR, "Sensores prontos após %d tentativas", attempts + 1);
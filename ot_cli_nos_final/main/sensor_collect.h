@@ -12,8 +12,8 @@ extern TaskHandle_t SensorUmiSTaskHandle;
 extern bool sensors_initialized;
 
 // Funcoes
-char* create_sensor_json(const sensor_data_t* data);
-void collect_sensor_data(otInstance *instance, sensor_data_t* data);
+char* create_sensor_json(const sensor_data_t* data, const char* endereco);
+void collect_sensor_data(sensor_data_t* data);
 void sensors_enable(otInstance *instance, sensor_data_t *sensor_data);
 void sensors_disable();
 bool sensors_are_ready(const sensor_data_t *data);
\ No newline at end of file